@@ -12,13 +12,21 @@
 // that has been added to b2nd_concat() that allows for faster concatenation of
 // b2nd arrays when there are no partial (or zero-padded) chunks in the arrays being
 // concatenated.
+//
+// Usage: bench_concatenate [memory|file]
 
 #include <inttypes.h>
 #include "blosc2.h"
 #include "b2nd.h"
 
 
-int main() {
+int main(int argc, char **argv) {
+  const char *storage_mode = argc > 1 ? argv[1] : "memory";
+  bool on_disk = strcmp(storage_mode, "file") == 0;
+  if (!on_disk && strcmp(storage_mode, "memory") != 0) {
+    printf("Usage: %s [memory|file]\n", argv[0]);
+    return 1;
+  }
   blosc2_init();
   const int width = 1000;
   const int height = 1000;
@@ -46,7 +54,10 @@ int main() {
   cparams.typesize = sizeof(image[0]);
   blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
   char *urlpath = "bench_concat.b2nd";
-  //storage.urlpath = urlpath;  // for storing in a file
+  if (on_disk) {
+    storage.urlpath = urlpath;
+    storage.contiguous = true;
+  }
   storage.cparams = &cparams;
 
   char *accel_str;
@@ -74,9 +85,14 @@ int main() {
       return -1;
     }
 
-    // The second array, with the data in buffersize
+    // The second array, with the data in buffersize (always in memory)
+    blosc2_storage storage2 = {.cparams=&cparams};
+    b2nd_context_t *ctx2 = b2nd_create_ctx(&storage2, 3,
+                                           shape, new_chunkshape, blockshape,
+                                           "|u2", DTYPE_NUMPY_FORMAT,
+                                           NULL, 0);
     b2nd_array_t *src2;
-    int ret = b2nd_from_cbuffer(ctx, &src2, image, buffersize);
+    int ret = b2nd_from_cbuffer(ctx2, &src2, image, buffersize);
     if (ret < 0) {
       printf("Error in b2nd_from_cbuffer\n");
       return -1;
@@ -100,11 +116,11 @@ int main() {
     blosc_set_timestamp(&t1);
     if (!accel) {
       t = blosc_elapsed_secs(t0, t1);
-      printf("Time to append (%s): %.4f s\n", accel_str, t);
+      printf("Time to append (%s, %s): %.4f s\n", accel_str, storage_mode, t);
     }
     else {
       t_accel = blosc_elapsed_secs(t0, t1);
-      printf("Time to append (%s): %.4f s\n", accel_str, t_accel);
+      printf("Time to append (%s, %s): %.4f s\n", accel_str, storage_mode, t_accel);
     }
     printf("Number of chunks: %" PRId64 "\n", array->sc->nchunks);
     // printf("Shape of array: (%" PRId64 ", %" PRId64 ", %" PRId64 ")\n",
@@ -115,6 +131,7 @@ int main() {
       b2nd_free(array);
     }
     b2nd_free_ctx(ctx);
+    b2nd_free_ctx(ctx2);
   }
   free(image);
   blosc2_remove_urlpath(urlpath);
@@ -6,14 +6,82 @@
   License: BSD 3-Clause (see LICENSE.txt)
 
   See LICENSE.txt for details about copyright and rights to use.
+
+  Usage: bench_get_slice [memory|file|mmap]
+
+  With `file` or `mmap` the array is stored on disk and reopened, through the
+  default filesystem I/O or through a memory-mapped file respectively.
+
+  After the timing of get_slice with the default number of threads, the same
+  planes are got and set again with 1, 2, 4 and 8 threads, so as to see how
+  slices spanning many chunks scale (sets are skipped for `mmap`, which is
+  opened read-only).
 **********************************************************************/
 
 #define DATA_TYPE int64_t
 
 # include <b2nd.h>
 
-int main() {
+#define URLPATH "bench_get_slice.b2nd"
+
+/* Use nthreads for (de)compressing the chunks of the array */
+static int set_nthreads(b2nd_array_t *arr, int16_t nthreads) {
+  blosc2_cparams cparams = *arr->sc->storage->cparams;
+  cparams.nthreads = nthreads;
+  cparams.schunk = arr->sc;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  dparams.schunk = arr->sc;
+  blosc2_free_ctx(arr->sc->cctx);
+  blosc2_free_ctx(arr->sc->dctx);
+  arr->sc->cctx = blosc2_create_cctx(cparams);
+  arr->sc->dctx = blosc2_create_dctx(dparams);
+  return arr->sc->cctx != NULL && arr->sc->dctx != NULL ? 0 : BLOSC2_ERROR_NULL_POINTER;
+}
+
+/* Get (or set) nslices planes of the array along each of its dimensions */
+static int get_set_planes(b2nd_array_t *arr, int nslices, bool set_slice) {
+  int8_t ndim = arr->ndim;
+  int32_t itemsize = arr->sc->typesize;
+  srand(0);
+  for (int dim = 0; dim < ndim; ++dim) {
+    int64_t slice_start[B2ND_MAX_DIM], slice_stop[B2ND_MAX_DIM], slice_shape[B2ND_MAX_DIM];
+    int64_t buffersize = itemsize;
+    for (int j = 0; j < ndim; ++j) {
+      slice_start[j] = 0;
+      slice_stop[j] = j == dim ? 1 : arr->shape[j];
+      slice_shape[j] = slice_stop[j] - slice_start[j];
+      buffersize *= slice_shape[j];
+    }
+
+    DATA_TYPE *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < buffersize / itemsize; ++i) {
+      buffer[i] = -i;
+    }
+
+    for (int slice = 0; slice < nslices; ++slice) {
+      slice_start[dim] = rand() % arr->shape[dim];
+      slice_stop[dim] = slice_start[dim] + 1;
+      if (set_slice) {
+        BLOSC_ERROR(b2nd_set_slice_cbuffer(buffer, slice_shape, buffersize, slice_start, slice_stop, arr));
+      }
+      else {
+        BLOSC_ERROR(b2nd_get_slice_cbuffer(arr, slice_start, slice_stop, buffer, slice_shape, buffersize));
+      }
+    }
+    free(buffer);
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
   blosc_timestamp_t t0, t1;
+  const char *storage_mode = argc > 1 ? argv[1] : "memory";
+  bool on_disk = strcmp(storage_mode, "file") == 0 || strcmp(storage_mode, "mmap") == 0;
+  if (!on_disk && strcmp(storage_mode, "memory") != 0) {
+    printf("Usage: %s [memory|file|mmap]\n", argv[0]);
+    return 1;
+  }
 
   blosc2_init();
 
@@ -41,6 +109,11 @@ int main() {
   cparams.nthreads = 4;
   cparams.typesize = itemsize;
   blosc2_storage b2_storage = {.cparams=&cparams};
+  if (on_disk) {
+    blosc2_remove_urlpath(URLPATH);
+    b2_storage.contiguous = true;
+    b2_storage.urlpath = URLPATH;
+  }
   b2nd_context_t *ctx = b2nd_create_ctx(&b2_storage, ndim, shape, chunkshape, blockshape, NULL, 0,
                                         NULL, 0);
 
@@ -50,35 +123,53 @@ int main() {
   blosc_set_timestamp(&t1);
   printf("from_buffer: %.4f s\n", blosc_elapsed_secs(t0, t1));
 
-  blosc_set_timestamp(&t0);
-
-  for (int dim = 0; dim < ndim; ++dim) {
-    int64_t slice_start[B2ND_MAX_DIM], slice_stop[B2ND_MAX_DIM], slice_shape[B2ND_MAX_DIM];
-    int64_t buffersize = itemsize;
-    for (int j = 0; j < ndim; ++j) {
-      slice_start[j] = 0;
-      slice_stop[j] = j == dim ? 1 : shape[j];
-      slice_shape[j] = slice_stop[j] - slice_start[j];
-      buffersize *= slice_shape[j];
+  blosc2_stdio_mmap mmap_file = BLOSC2_STDIO_MMAP_DEFAULTS;
+  if (on_disk) {
+    BLOSC_ERROR(b2nd_free(arr));
+    if (strcmp(storage_mode, "mmap") == 0) {
+      mmap_file.mode = "r";
+      blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_MMAP, .name = "filesystem_mmap", .params = &mmap_file};
+      blosc2_schunk *schunk = blosc2_schunk_open_udio(URLPATH, &io);
+      if (schunk == NULL) {
+        return 1;
+      }
+      BLOSC_ERROR(b2nd_from_schunk(schunk, &arr));
     }
-
-    DATA_TYPE *buffer = malloc(buffersize);
-
-    for (int slice = 0; slice < nslices; ++slice) {
-      slice_start[dim] = rand() % shape[dim];
-      slice_stop[dim] = slice_start[dim] + 1;
-      BLOSC_ERROR(b2nd_get_slice_cbuffer(arr, slice_start, slice_stop, buffer, slice_shape, buffersize));
+    else {
+      BLOSC_ERROR(b2nd_open(URLPATH, &arr));
     }
-    free(buffer);
   }
 
+  blosc_set_timestamp(&t0);
+  BLOSC_ERROR(get_set_planes(arr, nslices, false));
   blosc_set_timestamp(&t1);
-  printf("get_slice: %.4f s\n", blosc_elapsed_secs(t0, t1));
+  printf("get_slice (%s): %.4f s\n", storage_mode, blosc_elapsed_secs(t0, t1));
+
+  // Scaling of slices spanning many chunks with the number of threads
+  int16_t nthreads_[] = {1, 2, 4, 8};
+  for (int i = 0; i < (int) (sizeof(nthreads_) / sizeof(nthreads_[0])); ++i) {
+    BLOSC_ERROR(set_nthreads(arr, nthreads_[i]));
+    blosc_set_timestamp(&t0);
+    BLOSC_ERROR(get_set_planes(arr, nslices, false));
+    blosc_set_timestamp(&t1);
+    printf("get_slice (%s, %d threads): %.4f s\n", storage_mode, nthreads_[i], blosc_elapsed_secs(t0, t1));
+    if (strcmp(storage_mode, "mmap") == 0) {
+      continue;
+    }
+    blosc_set_timestamp(&t0);
+    // Sets recompress whole chunks, so do fewer of them
+    BLOSC_ERROR(get_set_planes(arr, 1, true));
+    blosc_set_timestamp(&t1);
+    printf("set_slice (%s, %d threads): %.4f s\n", storage_mode, nthreads_[i], blosc_elapsed_secs(t0, t1));
+  }
 
   free(src);
 
   BLOSC_ERROR(b2nd_free(arr));
   BLOSC_ERROR(b2nd_free_ctx(ctx));
+  if (on_disk) {
+    blosc2_remove_urlpath(URLPATH);
+  }
 
   blosc2_destroy();
 
@@ -0,0 +1,121 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Usage: bench_orthogonal_selection [memory|file]
+
+  Fancy-index reads and writes (orthogonal selections) touching every chunk
+  of an array, with 1, 2, 4 and 8 threads.
+**********************************************************************/
+
+#include <inttypes.h>
+#include <b2nd.h>
+
+#define URLPATH "bench_orthogonal_selection.b2nd"
+#define NDIM 2
+#define NSEL 600
+#define NREPS 5
+
+/* Use nthreads for (de)compressing the chunks of the array */
+static int set_nthreads(b2nd_array_t *arr, int16_t nthreads) {
+  blosc2_cparams cparams = *arr->sc->storage->cparams;
+  cparams.nthreads = nthreads;
+  cparams.schunk = arr->sc;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  dparams.schunk = arr->sc;
+  blosc2_free_ctx(arr->sc->cctx);
+  blosc2_free_ctx(arr->sc->dctx);
+  arr->sc->cctx = blosc2_create_cctx(cparams);
+  arr->sc->dctx = blosc2_create_dctx(dparams);
+  return arr->sc->cctx != NULL && arr->sc->dctx != NULL ? 0 : BLOSC2_ERROR_NULL_POINTER;
+}
+
+int main(int argc, char **argv) {
+  blosc_timestamp_t t0, t1;
+  const char *storage_mode = argc > 1 ? argv[1] : "memory";
+  bool on_disk = strcmp(storage_mode, "file") == 0;
+  if (!on_disk && strcmp(storage_mode, "memory") != 0) {
+    printf("Usage: %s [memory|file]\n", argv[0]);
+    return 1;
+  }
+
+  blosc2_init();
+
+  int64_t shape[NDIM] = {4000, 4000};
+  int32_t chunkshape[NDIM] = {100, 100};
+  int32_t blockshape[NDIM] = {25, 50};
+  int64_t nitems = shape[0] * shape[1];
+
+  int32_t *src = malloc(nitems * sizeof(int32_t));
+  for (int64_t i = 0; i < nitems; ++i) {
+    src[i] = (int32_t) i;
+  }
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage b2_storage = {.cparams=&cparams};
+  if (on_disk) {
+    blosc2_remove_urlpath(URLPATH);
+    b2_storage.contiguous = true;
+    b2_storage.urlpath = URLPATH;
+  }
+  b2nd_context_t *ctx = b2nd_create_ctx(&b2_storage, NDIM, shape, chunkshape, blockshape, NULL, 0,
+                                        NULL, 0);
+  b2nd_array_t *arr;
+  BLOSC_ERROR(b2nd_from_cbuffer(ctx, &arr, src, nitems * sizeof(int32_t)));
+
+  // Random indexes, unsorted and with repetitions, hitting every chunk
+  int64_t *selection[NDIM];
+  int64_t selection_size[NDIM] = {NSEL, NSEL};
+  srand(0);
+  for (int i = 0; i < NDIM; ++i) {
+    selection[i] = malloc(NSEL * sizeof(int64_t));
+    for (int j = 0; j < NSEL; ++j) {
+      selection[i][j] = rand() % shape[i];
+    }
+  }
+  int64_t buffershape[NDIM] = {NSEL, NSEL};
+  int64_t buffersize = NSEL * NSEL * sizeof(int32_t);
+  int32_t *buffer = malloc(buffersize);
+
+  printf("Orthogonal selection of %d x %d items over %" PRId64 " chunks (%s)\n", NSEL, NSEL,
+         arr->sc->nchunks, storage_mode);
+  int16_t nthreads_[] = {1, 2, 4, 8};
+  for (int i = 0; i < (int) (sizeof(nthreads_) / sizeof(nthreads_[0])); ++i) {
+    BLOSC_ERROR(set_nthreads(arr, nthreads_[i]));
+    blosc_set_timestamp(&t0);
+    for (int rep = 0; rep < NREPS; ++rep) {
+      BLOSC_ERROR(b2nd_get_orthogonal_selection(arr, selection, selection_size, buffer, buffershape,
+                                                buffersize));
+    }
+    blosc_set_timestamp(&t1);
+    printf("get (%d threads): %.4f s\n", nthreads_[i], blosc_elapsed_secs(t0, t1) / NREPS);
+
+    blosc_set_timestamp(&t0);
+    BLOSC_ERROR(b2nd_set_orthogonal_selection(arr, selection, selection_size, buffer, buffershape,
+                                              buffersize));
+    blosc_set_timestamp(&t1);
+    printf("set (%d threads): %.4f s\n", nthreads_[i], blosc_elapsed_secs(t0, t1));
+  }
+
+  for (int i = 0; i < NDIM; ++i) {
+    free(selection[i]);
+  }
+  free(buffer);
+  free(src);
+  BLOSC_ERROR(b2nd_free(arr));
+  BLOSC_ERROR(b2nd_free_ctx(ctx));
+  if (on_disk) {
+    blosc2_remove_urlpath(URLPATH);
+  }
+
+  blosc2_destroy();
+
+  return 0;
+}
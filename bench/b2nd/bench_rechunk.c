@@ -0,0 +1,87 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Usage: bench_rechunk [memory|file]
+
+  Re-layout of a space-major array (rows of the first axis in each chunk)
+  into a time-major one (columns of the second axis in each chunk) with
+  different memory budgets.
+**********************************************************************/
+
+#include <b2nd.h>
+
+#define URLPATH "bench_rechunk.b2nd"
+#define NDIM 2
+
+int main(int argc, char **argv) {
+  blosc_timestamp_t t0, t1;
+  const char *storage_mode = argc > 1 ? argv[1] : "memory";
+  bool on_disk = strcmp(storage_mode, "file") == 0;
+  if (!on_disk && strcmp(storage_mode, "memory") != 0) {
+    printf("Usage: %s [memory|file]\n", argv[0]);
+    return 1;
+  }
+
+  blosc2_init();
+
+  int64_t shape[NDIM] = {4096, 4096};
+  int32_t chunkshape[NDIM] = {64, 4096};
+  int32_t blockshape[NDIM] = {16, 1024};
+  int32_t chunkshape2[NDIM] = {4096, 64};
+  int32_t blockshape2[NDIM] = {1024, 16};
+  int64_t nitems = shape[0] * shape[1];
+
+  float *src = malloc(nitems * sizeof(float));
+  for (int64_t i = 0; i < nitems; ++i) {
+    src[i] = (float) (i % 4096) * 0.5f + (float) (i / 4096);
+  }
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(float);
+  cparams.nthreads = 4;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = 4;
+  blosc2_storage b2_storage = {.cparams=&cparams, .dparams=&dparams};
+  b2nd_context_t *ctx = b2nd_create_ctx(&b2_storage, NDIM, shape, chunkshape, blockshape, NULL, 0,
+                                        NULL, 0);
+  b2nd_array_t *arr;
+  BLOSC_ERROR(b2nd_from_cbuffer(ctx, &arr, src, nitems * sizeof(float)));
+
+  if (on_disk) {
+    b2_storage.contiguous = true;
+    b2_storage.urlpath = URLPATH;
+  }
+  b2nd_context_t *ctx2 = b2nd_create_ctx(&b2_storage, NDIM, shape, chunkshape2, blockshape2, NULL, 0,
+                                         NULL, 0);
+
+  printf("Rechunking %d x %d float32 items from %d x %d to %d x %d chunks (%s)\n",
+         (int) shape[0], (int) shape[1], chunkshape[0], chunkshape[1], chunkshape2[0], chunkshape2[1],
+         storage_mode);
+  int64_t budgets[] = {1024 * 1024, 16 * 1024 * 1024, B2ND_DEFAULT_RECHUNK_MEMORY};
+  for (int i = 0; i < (int) (sizeof(budgets) / sizeof(budgets[0])); ++i) {
+    blosc2_remove_urlpath(URLPATH);
+    b2nd_array_t *arr2;
+    blosc_set_timestamp(&t0);
+    BLOSC_ERROR(b2nd_rechunk(ctx2, arr, budgets[i], &arr2));
+    blosc_set_timestamp(&t1);
+    printf("rechunk (%4d MB budget): %.4f s\n", (int) (budgets[i] / (1024 * 1024)),
+           blosc_elapsed_secs(t0, t1));
+    BLOSC_ERROR(b2nd_free(arr2));
+  }
+
+  free(src);
+  BLOSC_ERROR(b2nd_free(arr));
+  BLOSC_ERROR(b2nd_free_ctx(ctx));
+  BLOSC_ERROR(b2nd_free_ctx(ctx2));
+  blosc2_remove_urlpath(URLPATH);
+
+  blosc2_destroy();
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for the speed of the bytedelta filter alone.
+
+  The filter runs directly on the blocks of a buffer of floats, as it does
+  after the shuffle filter inside Blosc (the buffer fits in the L2 cache of
+  most CPUs, as the blocks do).  The kernels are chosen at run-time
+  for the host CPU (AVX512, AVX2, or the 16-byte SSSE3/NEON ones), so this
+  reports the speed of the best one available.  This needs the internal
+  bytedelta.h, so build it along with Blosc (it is in the bench/ directory).
+
+  To run:
+
+  $ ./bytedelta_filter
+  Blocksize 65536, 1.0 MB per round
+  typesize  1: encode  12.59 GB/s, decode  10.04 GB/s
+  typesize  2: encode  11.18 GB/s, decode   8.92 GB/s
+  typesize  4: encode  10.66 GB/s, decode   7.57 GB/s
+  typesize  8: encode  10.26 GB/s, decode   8.77 GB/s
+  typesize 16: encode  10.64 GB/s, decode   8.99 GB/s
+
+  (AVX512 host; the 16-byte SSSE3 kernels give about 9 GB/s for encoding
+  and 5.5 GB/s for decoding on it.)
+
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <blosc2.h>
+#include <blosc2/filters-registry.h>
+#include "bytedelta.h"
+
+#define KB  1024
+#define MB  (1024*KB)
+#define GB  (1024*MB)
+
+/* Blosc filters blocks that are in cache, so keep the buffers small */
+#define NBYTES (1 * MB)
+#define BLOCKSIZE (64 * KB)
+#define NREPS 500
+
+
+int main(void) {
+  blosc2_init();
+
+  float *data = malloc(NBYTES);
+  uint8_t *filtered = malloc(NBYTES);
+  uint8_t *back = malloc(NBYTES);
+  for (int i = 0; i < NBYTES / (int)sizeof(float); i++) {
+    data[i] = (float)i * 0.25f + (float)(i % 17);
+  }
+  const uint8_t *src = (const uint8_t *)data;
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc_timestamp_t last, current;
+  double totalsize = (double)NBYTES * NREPS;
+
+  printf("Blocksize %d, %.1f MB per round\n", BLOCKSIZE, (double)NBYTES / MB);
+  for (int typesize = 1; typesize <= 16; typesize *= 2) {
+    blosc_set_timestamp(&last);
+    for (int rep = 0; rep < NREPS; rep++) {
+      for (int32_t offset = 0; offset < NBYTES; offset += BLOCKSIZE) {
+        bytedelta_forward(src + offset, filtered + offset, BLOCKSIZE, (uint8_t)typesize,
+                          &cparams, BLOSC_FILTER_BYTEDELTA);
+      }
+    }
+    blosc_set_timestamp(&current);
+    double enc_time = blosc_elapsed_secs(last, current);
+
+    blosc_set_timestamp(&last);
+    for (int rep = 0; rep < NREPS; rep++) {
+      for (int32_t offset = 0; offset < NBYTES; offset += BLOCKSIZE) {
+        bytedelta_backward(filtered + offset, back + offset, BLOCKSIZE, (uint8_t)typesize,
+                           &dparams, BLOSC_FILTER_BYTEDELTA);
+      }
+    }
+    blosc_set_timestamp(&current);
+    double dec_time = blosc_elapsed_secs(last, current);
+
+    if (memcmp(src, back, NBYTES) != 0) {
+      printf("Decoded data differs from original!\n");
+      return 1;
+    }
+    printf("typesize %2d: encode %6.2f GB/s, decode %6.2f GB/s\n", typesize,
+           totalsize / (GB * enc_time), totalsize / (GB * dec_time));
+  }
+
+  free(data);
+  free(filtered);
+  free(back);
+  blosc2_destroy();
+  return 0;
+}
@@ -5,16 +5,19 @@
 
   Benchmark showing Blosc filter from C code.
 
-  To compile this program:
-
-  $ gcc -O3 delta_schunk.c -o delta_schunk -lblosc2
+  Besides the super-chunk roundtrip, the speed of the delta filter alone is
+  reported, running it directly on the blocks of a chunk (the first block is
+  the reference one, which decodes as a prefix xor).  This needs the internal
+  delta.h, so build it along with Blosc (it is in the bench/ directory).
 
 */
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 #include <blosc2.h>
+#include "delta.h"
 
 #define KB  1024
 #define MB  (1024*KB)
@@ -24,6 +27,56 @@
 #define NCHUNKS 100
 // Setting NTHREADS > 1 increases the likelihood of a crash.  See #112.
 #define NTHREADS 1
+#define BLOCKSIZE (32 * KB)
+#define NREPS 200
+
+
+/* Run the delta filter alone on the blocks of a chunk */
+static void filter_speed(const uint8_t *chunk, uint8_t *filtered, int32_t nbytes,
+                         int32_t typesize) {
+  blosc_timestamp_t last, current;
+  double totalsize = (double)nbytes * NREPS;
+  int32_t offset;
+
+  blosc_set_timestamp(&last);
+  for (int rep = 0; rep < NREPS; rep++) {
+    for (offset = 0; offset < nbytes; offset += BLOCKSIZE) {
+      int32_t bsize = (nbytes - offset < BLOCKSIZE) ? nbytes - offset : BLOCKSIZE;
+      delta_encoder(chunk, offset, bsize, typesize, chunk + offset, filtered + offset);
+    }
+  }
+  blosc_set_timestamp(&current);
+  double enc_time = blosc_elapsed_secs(last, current);
+
+  // The reference block alone, as it is the one with serial dependencies
+  uint8_t *ref = malloc(BLOCKSIZE);
+  blosc_set_timestamp(&last);
+  for (int rep = 0; rep < NREPS; rep++) {
+    memcpy(ref, filtered, BLOCKSIZE);
+    delta_decoder(ref, 0, BLOCKSIZE, typesize, ref);
+  }
+  blosc_set_timestamp(&current);
+  double ref_time = blosc_elapsed_secs(last, current);
+  free(ref);
+
+  // Decode in place, the same as the decompressor does (it also undoes the
+  // reference block first, so the other blocks can use it)
+  blosc_set_timestamp(&last);
+  for (int rep = 0; rep < NREPS; rep++) {
+    for (offset = BLOCKSIZE; offset < nbytes; offset += BLOCKSIZE) {
+      int32_t bsize = (nbytes - offset < BLOCKSIZE) ? nbytes - offset : BLOCKSIZE;
+      delta_decoder(chunk, offset, bsize, typesize, filtered + offset);
+    }
+  }
+  blosc_set_timestamp(&current);
+  double dec_time = blosc_elapsed_secs(last, current);
+
+  printf("[Filter] typesize %2d: encode %6.2f GB/s, decode %6.2f GB/s "
+         "(reference block %6.2f GB/s)\n", typesize,
+         totalsize / (GB * enc_time),
+         (double)(nbytes - BLOCKSIZE) * NREPS / (GB * dec_time),
+         (double)BLOCKSIZE * NREPS / (GB * ref_time));
+}
 
 
 int main(void) {
@@ -105,6 +158,12 @@ int main(void) {
 
   printf("Successful roundtrip!\n");
 
+  uint8_t *filtered = malloc(isize);
+  for (int32_t typesize = 1; typesize <= 8; typesize *= 2) {
+    filter_speed((uint8_t *)data, filtered, isize, typesize);
+  }
+  free(filtered);
+
   /* Free resources */
   free(data);
   free(data_dest);
@@ -7,7 +7,9 @@
 
   To run from the repository root:
 
-  $ ./build/bench/read-coords bench/sin-1d.b2nd [ncoords]
+  $ ./build/bench/read-coords bench/sin-1d.b2nd [ncoords] [new-first|getitem-only|new-only] [mmap]
+
+  Pass `mmap` for reading the array through a memory-mapped file.
 */
 
 /*
@@ -52,8 +54,24 @@ static void fill_random_coords(int64_t *coords, int64_t ncoords, int64_t nitems)
   }
 }
 
-static int open_array(const char **urlpath, bool use_fallbacks, b2nd_array_t **array) {
-  int rc = b2nd_open(*urlpath, array);
+static blosc2_stdio_mmap mmap_file;
+
+static int open_urlpath(const char *urlpath, bool use_mmap, b2nd_array_t **array) {
+  if (!use_mmap) {
+    return b2nd_open(urlpath, array);
+  }
+  mmap_file = BLOSC2_STDIO_MMAP_DEFAULTS;
+  mmap_file.mode = "r";
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_MMAP, .name = "filesystem_mmap", .params = &mmap_file};
+  blosc2_schunk *schunk = blosc2_schunk_open_udio(urlpath, &io);
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+  return b2nd_from_schunk(schunk, array);
+}
+
+static int open_array(const char **urlpath, bool use_fallbacks, bool use_mmap, b2nd_array_t **array) {
+  int rc = open_urlpath(*urlpath, use_mmap, array);
   if (rc >= 0 || *array != NULL || !use_fallbacks) {
     if (rc < 0) {
       fprintf(stderr, "Cannot open %s (error %d)\n", *urlpath, rc);
@@ -64,7 +82,7 @@ static int open_array(const char **urlpath, bool use_fallbacks, b2nd_array_t **a
   const char *fallbacks[] = {"../bench/sin-1d.b2nd", "../../bench/sin-1d.b2nd"};
   for (size_t i = 0; i < sizeof(fallbacks) / sizeof(fallbacks[0]); ++i) {
     *urlpath = fallbacks[i];
-    rc = b2nd_open(*urlpath, array);
+    rc = open_urlpath(*urlpath, use_mmap, array);
     if (rc >= 0) {
       return rc;
     }
@@ -111,6 +129,10 @@ int main(int argc, char **argv) {
   bool new_first = (argc > 3) && (strcmp(argv[3], "new-first") == 0);
   bool getitem_only = (argc > 3) && (strcmp(argv[3], "getitem-only") == 0);
   bool new_only = (argc > 3) && (strcmp(argv[3], "new-only") == 0);
+  bool use_mmap = false;
+  for (int i = 3; i < argc; ++i) {
+    use_mmap |= strcmp(argv[i], "mmap") == 0;
+  }
   b2nd_array_t *array = NULL;
   int64_t *coords = NULL;
   float *data_getitem = NULL;
@@ -128,7 +150,7 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
-  if (open_array(&urlpath, argc == 1, &array) < 0) {
+  if (open_array(&urlpath, argc == 1, use_mmap, &array) < 0) {
     blosc2_destroy();
     return EXIT_FAILURE;
   }
@@ -221,7 +243,8 @@ int main(int argc, char **argv) {
   }
   }
 
-  printf("Read %" PRId64 " random coordinates from %s (%d threads)\n", ncoords, urlpath, NTHREADS);
+  printf("Read %" PRId64 " random coordinates from %s (%d threads%s)\n", ncoords, urlpath, NTHREADS,
+         use_mmap ? ", mmap" : "");
   int64_t nprint = ncoords < NPRINT ? ncoords : NPRINT;
   printf("First %" PRId64 " retrieved elements:\n", nprint);
   for (int64_t i = 0; i < nprint; ++i) {
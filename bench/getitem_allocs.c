@@ -0,0 +1,190 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for the memory allocations of small reads.  Contexts recycle the
+  temporaries of their calls (see blosc2_ctx_trim_scratch()), so that reading
+  a few items over and over again does not go through malloc/free.  This
+  measures the allocations (on glibc, where malloc can be interposed) and the
+  time per call of:
+
+  - blosc2_getitem_ctx() on an in-memory chunk;
+  - blosc2_schunk_get_lazychunk() + blosc2_getitem_ctx() on an on-disk frame;
+  - a masked out decompression of a lazy chunk;
+  - a 4-thread decompression of a lazy chunk.
+
+  To run:
+
+  $ ./getitem_allocs
+  getitem (mem):                  0.00 allocs/call     1116.3 ns/call
+  lazychunk + getitem (disk):     1.00 allocs/call     5691.6 ns/call
+  maskout lazy decompress:        1.05 allocs/call    53601.1 ns/call
+  lazy decompress (4 threads):    1.07 allocs/call    88556.3 ns/call
+  scratch trimmed: 176702 bytes
+
+  The allocation left in the lazy chunk cases is the lazy chunk itself.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <blosc2.h>
+
+#define NITEMS (200 * 1000)   /* items per chunk (int32_t) */
+#define NCHUNKS 4
+#define BLOCKSIZE (16 * 1024)
+#define NCALLS 10000
+#define URLPATH "getitem_allocs.b2frame"
+
+static int64_t nallocs = 0;
+
+#if defined(__GLIBC__)
+/* Count the allocations of the whole process by interposing the glibc ones */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size) {
+  nallocs++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+  nallocs++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  nallocs++;
+  return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+  nallocs++;
+  *memptr = __libc_memalign(alignment, size);
+  return *memptr != NULL ? 0 : 12;  // ENOMEM
+}
+#define COUNTS_ALLOCS 1
+#else
+#define COUNTS_ALLOCS 0
+#endif
+
+
+static void report(const char *name, int64_t nallocs0, blosc_timestamp_t t0, int ncalls) {
+  blosc_timestamp_t t1;
+  blosc_set_timestamp(&t1);
+  if (COUNTS_ALLOCS) {
+    printf("%-30s %5.2f allocs/call  %9.1f ns/call\n", name,
+           (double)(nallocs - nallocs0) / ncalls, blosc_elapsed_nsecs(t0, t1) / ncalls);
+  }
+  else {
+    printf("%-30s %9.1f ns/call\n", name, blosc_elapsed_nsecs(t0, t1) / ncalls);
+  }
+}
+
+
+int main(void) {
+  blosc2_init();
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = BLOCKSIZE;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_storage storage = {.contiguous = true, .urlpath = URLPATH, .cparams = &cparams,
+                            .dparams = &dparams};
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  int32_t *data = malloc(NITEMS * sizeof(int32_t));
+  for (int i = 0; i < NITEMS; i++) {
+    data[i] = i;
+  }
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    if (blosc2_schunk_append_buffer(schunk, data, NITEMS * sizeof(int32_t)) < 0) {
+      return 1;
+    }
+  }
+
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_chunk(schunk, 1, &chunk, &needs_free);
+  if (cbytes < 0) {
+    return 1;
+  }
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  int32_t item;
+  blosc_timestamp_t t0;
+  int64_t nallocs0;
+
+  blosc2_getitem_ctx(dctx, chunk, cbytes, 0, 1, &item, sizeof(item));  // warm up
+  nallocs0 = nallocs;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NCALLS; i++) {
+    blosc2_getitem_ctx(dctx, chunk, cbytes, (i * 7919) % NITEMS, 1, &item, sizeof(item));
+  }
+  report("getitem (mem):", nallocs0, t0, NCALLS);
+
+  uint8_t *lazychunk;
+  bool lazy_needs_free;
+  nallocs0 = nallocs;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NCALLS; i++) {
+    int lazy_cbytes = blosc2_schunk_get_lazychunk(schunk, i % NCHUNKS, &lazychunk, &lazy_needs_free);
+    blosc2_getitem_ctx(schunk->dctx, lazychunk, lazy_cbytes, (i * 7919) % NITEMS, 1, &item, sizeof(item));
+    if (lazy_needs_free) {
+      free(lazychunk);
+    }
+  }
+  report("lazychunk + getitem (disk):", nallocs0, t0, NCALLS);
+
+  int nblocks = NITEMS * (int)sizeof(int32_t) / BLOCKSIZE + 1;
+  bool *maskout = malloc(nblocks);
+  for (int i = 0; i < nblocks; i++) {
+    maskout[i] = i % 2;
+  }
+  nallocs0 = nallocs;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NCALLS / 100; i++) {
+    blosc2_set_maskout(schunk->dctx, maskout, nblocks);
+    int lazy_cbytes = blosc2_schunk_get_lazychunk(schunk, i % NCHUNKS, &lazychunk, &lazy_needs_free);
+    blosc2_decompress_ctx(schunk->dctx, lazychunk, lazy_cbytes, data, NITEMS * sizeof(int32_t));
+    if (lazy_needs_free) {
+      free(lazychunk);
+    }
+  }
+  report("maskout lazy decompress:", nallocs0, t0, NCALLS / 100);
+
+  blosc2_dparams dparams4 = dparams;
+  dparams4.nthreads = 4;
+  dparams4.schunk = schunk;
+  blosc2_context *dctx4 = blosc2_create_dctx(dparams4);
+  blosc2_decompress_ctx(dctx4, chunk, cbytes, data, NITEMS * sizeof(int32_t));  // warm up
+  nallocs0 = nallocs;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NCALLS / 100; i++) {
+    int lazy_cbytes = blosc2_schunk_get_lazychunk(schunk, i % NCHUNKS, &lazychunk, &lazy_needs_free);
+    blosc2_decompress_ctx(dctx4, lazychunk, lazy_cbytes, data, NITEMS * sizeof(int32_t));
+    if (lazy_needs_free) {
+      free(lazychunk);
+    }
+  }
+  report("lazy decompress (4 threads):", nallocs0, t0, NCALLS / 100);
+
+  int64_t trimmed = blosc2_ctx_trim_scratch(dctx4) + blosc2_ctx_trim_scratch(schunk->dctx) +
+                    blosc2_ctx_trim_scratch(dctx);
+  printf("scratch trimmed: %" PRId64 " bytes\n", trimmed);
+
+  blosc2_free_ctx(dctx4);
+  blosc2_free_ctx(dctx);
+  if (needs_free) {
+    free(chunk);
+  }
+  free(maskout);
+  free(data);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_destroy();
+
+  return 0;
+}
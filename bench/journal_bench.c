@@ -0,0 +1,140 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for the journal of on-disk frames (blosc2_schunk_set_journal()):
+  batches of chunk updates to a contiguous frame, each one within a
+  blosc2_schunk_lock() bracket, done in place, through the journal, or after
+  copying the whole frame aside (so that it can be restored on failure).
+
+  To run:
+
+  $ ./journal_bench [nchunks]
+  Frame of 200 chunks (15 MB), batches of 8 updates
+  mode                   batches/s
+  in place                   466.7
+  journal                    155.7
+  copy first                  64.3
+
+  The journal only keeps the header, the offsets and the trailer (updated
+  chunks go to the end of the frame), and its cost is mostly the sync of the
+  frame after every batch; the copy is not even synced, and it grows with
+  the frame.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <blosc2.h>
+
+#define CHUNKSIZE (40 * 1000)  /* items per chunk (int32_t) */
+#define NUPDATES (8)           /* per batch */
+#define NBATCHES (50)
+#define URLPATH "journal_bench.b2frame"
+#define COPYPATH "journal_bench.copy.b2frame"
+
+
+static void fill_data(int32_t* data, uint32_t seed) {
+  // Not too compressible, so that the frame is big
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    seed = seed * 1103515245u + 12345u;
+    data[i] = (int32_t)(seed >> 20);
+  }
+}
+
+
+static int copy_file(const char* src, const char* dest) {
+  static char buf[1 << 20];
+  FILE* fsrc = fopen(src, "rb");
+  FILE* fdest = fopen(dest, "wb");
+  if (fsrc == NULL || fdest == NULL) {
+    return -1;
+  }
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fsrc)) > 0) {
+    fwrite(buf, 1, n, fdest);
+  }
+  fclose(fsrc);
+  fclose(fdest);
+  return 0;
+}
+
+
+/* Update batches per second */
+static double run(bool journal, bool copy, int nchunks) {
+  blosc2_schunk* schunk = blosc2_schunk_open(URLPATH);
+  if (schunk == NULL || blosc2_schunk_set_journal(schunk, journal) < 0) {
+    return -1;
+  }
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+  int32_t* data = malloc(isize);
+  uint8_t* chunk = malloc(isize + BLOSC2_MAX_OVERHEAD);
+
+  blosc_timestamp_t t0, t1;
+  blosc_set_timestamp(&t0);
+  int rc = 0;
+  for (int batch = 0; batch < NBATCHES && rc == 0; batch++) {
+    if (copy) {
+      rc = copy_file(URLPATH, COPYPATH);
+    }
+    blosc2_schunk_lock(schunk);
+    for (int i = 0; i < NUPDATES && rc == 0; i++) {
+      int64_t nchunk = (batch * NUPDATES + i) * 7 % nchunks;
+      fill_data(data, (uint32_t)(batch * NUPDATES + i));
+      int csize = blosc2_compress_ctx(schunk->cctx, data, isize, chunk, isize + BLOSC2_MAX_OVERHEAD);
+      if (csize < 0 || blosc2_schunk_update_chunk(schunk, nchunk, chunk, true) < 0) {
+        rc = -1;
+      }
+    }
+    blosc2_schunk_unlock(schunk);
+  }
+  blosc_set_timestamp(&t1);
+  blosc2_schunk_free(schunk);
+  free(chunk);
+  free(data);
+  blosc2_remove_urlpath(COPYPATH);
+  if (rc != 0) {
+    return -1;
+  }
+  return NBATCHES / blosc_elapsed_secs(t0, t1);
+}
+
+
+int main(int argc, char *argv[]) {
+  int nchunks = 200;
+  if (argc > 1) {
+    nchunks = atoi(argv[1]);
+  }
+  if (nchunks < NUPDATES) {
+    printf("Usage: %s [nchunks (>= %d)]\n", argv[0], NUPDATES);
+    return 1;
+  }
+  blosc2_init();
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage storage = {.contiguous = true, .urlpath = URLPATH, .cparams = &cparams};
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  int32_t* data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < nchunks; i++) {
+    fill_data(data, (uint32_t)i);
+    if (blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE * sizeof(int32_t)) < 0) {
+      printf("Cannot create the frame\n");
+      return 1;
+    }
+  }
+  free(data);
+  printf("Frame of %d chunks (%d MB), batches of %d updates\n",
+         nchunks, (int)(schunk->cbytes / (1024 * 1024)), NUPDATES);
+  blosc2_schunk_free(schunk);
+
+  printf("mode                   batches/s\n");
+  printf("in place            %12.1f\n", run(false, false, nchunks));
+  printf("journal             %12.1f\n", run(true, false, nchunks));
+  printf("copy first          %12.1f\n", run(false, true, nchunks));
+
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_destroy();
+  return 0;
+}
@@ -0,0 +1,180 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for chunk offset lookups in frames.  Frames keep a decoded copy of
+  their offsets index, so that finding a chunk is a plain array load instead
+  of a blosc2_getitem() on the compressed offsets chunk.  This measures, in
+  ns per random lookup:
+
+  - getitem: the former approach, blosc2_getitem() on the offsets chunk
+    (compressed with the same parameters the frame uses);
+  - decoded: a load from the decoded index;
+  - and blosc2_schunk_get_lazychunk() end to end, which includes the frame
+    header parsing, on an in-memory and an on-disk frame.
+
+  To run:
+
+  $ ./offsets_lookup [nchunks]
+  nchunks: 100000  offsets: 800000 bytes -> 157571 bytes compressed
+  getitem:               2192.9 ns/lookup
+  decoded:                  2.0 ns/lookup
+  get_lazychunk (mem):     79.7 ns/lookup
+  get_lazychunk (disk):  2021.8 ns/lookup
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <blosc2.h>
+
+#define CHUNKSIZE (1000)   /* items per chunk (int32_t) */
+#define NCHUNKS (100 * 1000)
+#define NLOOKUPS (200 * 1000)
+#define URLPATH "offsets_lookup.b2frame"
+
+
+static double elapsed_ns_per_op(blosc_timestamp_t t0, int nops) {
+  blosc_timestamp_t t1;
+  blosc_set_timestamp(&t1);
+  return blosc_elapsed_nsecs(t0, t1) / nops;
+}
+
+
+/* Deterministic pseudo-random chunk numbers (xorshift64*) */
+static void fill_random_nchunks(int64_t *nchunks_, int n, int64_t nchunks) {
+  uint64_t state = UINT64_C(0x20211108);
+  for (int i = 0; i < n; i++) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    nchunks_[i] = (int64_t)((state * UINT64_C(2685821657736338717)) % (uint64_t)nchunks);
+  }
+}
+
+
+static double time_lazychunks(blosc2_schunk *schunk, const int64_t *lookups) {
+  blosc_timestamp_t t0;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NLOOKUPS; i++) {
+    uint8_t *chunk;
+    bool needs_free;
+    int cbytes = blosc2_schunk_get_lazychunk(schunk, lookups[i], &chunk, &needs_free);
+    if (cbytes < 0) {
+      return -1;
+    }
+    if (needs_free) {
+      free(chunk);
+    }
+  }
+  return elapsed_ns_per_op(t0, NLOOKUPS);
+}
+
+
+int main(int argc, char **argv) {
+  int64_t nchunks = (argc > 1) ? strtoll(argv[1], NULL, 10) : NCHUNKS;
+  if (nchunks <= 0) {
+    printf("Usage: %s [nchunks]\n", argv[0]);
+    return 1;
+  }
+  blosc2_init();
+
+  // Build the frame on disk; deferring the index updates keeps this linear
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage storage = {.contiguous = true, .urlpath = URLPATH, .cparams = &cparams};
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  if (schunk == NULL || blosc2_schunk_set_append_batch(schunk, -1) < 0) {
+    return 1;
+  }
+  int32_t *data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+    for (int i = 0; i < CHUNKSIZE; i++) {
+      data[i] = (int32_t)(nchunk * CHUNKSIZE + i);
+    }
+    if (blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE * sizeof(int32_t)) < 0) {
+      return 1;
+    }
+  }
+  free(data);
+  blosc2_schunk_free(schunk);
+
+  int64_t *lookups = malloc(NLOOKUPS * sizeof(int64_t));
+  fill_random_nchunks(lookups, NLOOKUPS, nchunks);
+
+  // The former per-lookup cost: getitem on the compressed offsets
+  schunk = blosc2_schunk_open(URLPATH);
+  if (schunk == NULL) {
+    return 1;
+  }
+  int64_t *offsets = blosc2_frame_get_offsets(schunk);
+  int32_t off_nbytes = (int32_t)(nchunks * sizeof(int64_t));
+  blosc2_cparams off_cparams = BLOSC2_CPARAMS_DEFAULTS;
+  off_cparams.splitmode = BLOSC_NEVER_SPLIT;
+  off_cparams.typesize = sizeof(int64_t);
+  off_cparams.blocksize = 16 * 1024;
+  off_cparams.nthreads = 4;
+  off_cparams.compcode = BLOSC_BLOSCLZ;
+  blosc2_context *cctx = blosc2_create_cctx(off_cparams);
+  uint8_t *coffsets = malloc(off_nbytes + BLOSC2_MAX_OVERHEAD);
+  int32_t off_cbytes = blosc2_compress_ctx(cctx, offsets, off_nbytes, coffsets,
+                                           off_nbytes + BLOSC2_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  if (offsets == NULL || off_cbytes < 0) {
+    return 1;
+  }
+  printf("nchunks: %" PRId64 "  offsets: %d bytes -> %d bytes compressed\n",
+         nchunks, off_nbytes, off_cbytes);
+
+  blosc_timestamp_t t0;
+  int64_t offset;
+  int64_t checksum = 0;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NLOOKUPS; i++) {
+    blosc2_getitem(coffsets, off_cbytes, (int32_t)lookups[i], 1, &offset, sizeof(offset));
+    checksum += offset;
+  }
+  printf("getitem:              %7.1f ns/lookup\n", elapsed_ns_per_op(t0, NLOOKUPS));
+
+  volatile int64_t *doffsets = offsets;
+  blosc_set_timestamp(&t0);
+  for (int i = 0; i < NLOOKUPS; i++) {
+    checksum -= doffsets[lookups[i]];
+  }
+  printf("decoded:              %7.1f ns/lookup\n", elapsed_ns_per_op(t0, NLOOKUPS));
+  if (checksum != 0) {
+    printf("Lookups do not match!\n");
+    return 1;
+  }
+  free(coffsets);
+  free(offsets);
+
+  // End to end, in memory (the frame file loaded in a buffer)...
+  FILE *fp = fopen(URLPATH, "rb");
+  fseek(fp, 0, SEEK_END);
+  int64_t len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  uint8_t *cframe = malloc(len);
+  if (fread(cframe, 1, len, fp) != (size_t)len) {
+    return 1;
+  }
+  fclose(fp);
+  blosc2_schunk *mem_schunk = blosc2_schunk_from_buffer(cframe, len, false);
+  time_lazychunks(mem_schunk, lookups);  // warm up (and build the decoded index)
+  printf("get_lazychunk (mem):  %7.1f ns/lookup\n", time_lazychunks(mem_schunk, lookups));
+  blosc2_schunk_free(mem_schunk);
+  free(cframe);
+
+  // ...and on disk, where lookups also read the chunk headers
+  time_lazychunks(schunk, lookups);
+  printf("get_lazychunk (disk): %7.1f ns/lookup\n", time_lazychunks(schunk, lookups));
+  blosc2_schunk_free(schunk);
+
+  free(lookups);
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_destroy();
+
+  return 0;
+}
@@ -3,7 +3,8 @@
   https://blosc.org
   License: BSD 3-Clause (see LICENSE.txt)
 
-  Benchmark for testing sframe vs frame.
+  Benchmark for testing sframe (a file per chunk, and packed in segment
+  files) vs frame.
   For usage instructions of this benchmark, please see:
     https://www.blosc.org/pages/synthetic-benchmarks/
   We are collecting speeds for different machines, so the output of your
@@ -44,9 +45,9 @@ int io_type = BLOSC2_IO_FILESYSTEM;
 
 
 
-void test_update(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
+void test_update(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_packed, blosc2_schunk* schunk_cframe) {
   blosc_timestamp_t last, current;
-  double cframe_update_time, sframe_update_time;
+  double cframe_update_time, sframe_update_time, packed_update_time, packed_compact_time;
 
   size_t isize = CHUNKSIZE * sizeof(int32_t);
   int32_t* data = malloc(isize);
@@ -64,6 +65,7 @@ void test_update(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
 
   // Update the sframe chunks
   sframe_update_time = 0.0;
+  packed_update_time = 0.0;
   cframe_update_time = 0.0;
   int32_t datasize = sizeof(int32_t) * CHUNKSIZE;
   int32_t chunksize = sizeof(int32_t) * CHUNKSIZE + BLOSC2_MAX_OVERHEAD;
@@ -89,6 +91,15 @@ void test_update(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
     }
     sframe_update_time += blosc_elapsed_secs(current, last);
 
+    // Packed sframe
+    blosc_set_timestamp(&current);
+    _nchunks = blosc2_schunk_update_chunk(schunk_packed, update_chunks[i], chunk, true);
+    blosc_set_timestamp(&last);
+    if (_nchunks < 0){
+      printf("ERROR: chunk cannot be updated correctly\n");
+    }
+    packed_update_time += blosc_elapsed_secs(current, last);
+
     // Frame
     blosc_set_timestamp(&current);
     _nchunks = blosc2_schunk_update_chunk(schunk_cframe, update_chunks[i], chunk, true);
@@ -102,17 +113,30 @@ void test_update(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
 
   printf("[Sframe Update] Elapsed time:\t %6.3f s. Total sframe size: %.3" PRId64 " bytes\n",
          sframe_update_time, schunk_sframe->cbytes);
+  printf("[Packed Update] Elapsed time:\t %6.3f s. Total sframe size: %.3" PRId64 " bytes\n",
+         packed_update_time, schunk_packed->cbytes);
   printf("[Cframe Update] Elapsed time:\t %6.3f s. Total cframe size: %.3" PRId64 " bytes\n",
          cframe_update_time, schunk_cframe->cbytes);
 
+  // The old copies of the updated chunks are still in the segments
+  blosc_set_timestamp(&current);
+  int64_t reclaimed = blosc2_schunk_compact(schunk_packed);
+  blosc_set_timestamp(&last);
+  if (reclaimed < 0) {
+    printf("ERROR: cannot compact the packed sframe\n");
+  }
+  packed_compact_time = blosc_elapsed_secs(current, last);
+  printf("[Packed Compact] Elapsed time:\t %6.3f s. Reclaimed: %.3" PRId64 " bytes\n",
+         packed_compact_time, reclaimed);
+
   /* Free resources */
   free(update_chunks);
   free(data);
 }
 
-void test_insert(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
+void test_insert(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_packed, blosc2_schunk* schunk_cframe) {
   blosc_timestamp_t last, current;
-  double cframe_insert_time, sframe_insert_time;
+  double cframe_insert_time, sframe_insert_time, packed_insert_time;
 
   size_t isize = CHUNKSIZE * sizeof(int32_t);
   int32_t* data = malloc(isize);
@@ -130,6 +154,7 @@ void test_insert(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
 
   // Update the sframe chunks
   sframe_insert_time = 0.0;
+  packed_insert_time = 0.0;
   cframe_insert_time = 0.0;
   int32_t datasize = sizeof(int32_t) * CHUNKSIZE;
   int32_t chunksize = sizeof(int32_t) * CHUNKSIZE + BLOSC2_MAX_OVERHEAD;
@@ -155,6 +180,15 @@ void test_insert(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
     }
     sframe_insert_time += blosc_elapsed_secs(current, last);
 
+    // Packed sframe
+    blosc_set_timestamp(&current);
+    _nchunks = blosc2_schunk_insert_chunk(schunk_packed, insert_chunks[i], chunk, true);
+    blosc_set_timestamp(&last);
+    if (_nchunks < 0){
+      printf("ERROR: chunk cannot be updated correctly\n");
+    }
+    packed_insert_time += blosc_elapsed_secs(current, last);
+
     // Frame
     blosc_set_timestamp(&current);
     _nchunks = blosc2_schunk_update_chunk(schunk_cframe, insert_chunks[i], chunk, true);
@@ -168,6 +202,8 @@ void test_insert(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
 
   printf("[Sframe Insert] Elapsed time:\t %6.3f s.  Total sframe size: %.3" PRId64 " bytes\n",
          sframe_insert_time, schunk_sframe->cbytes);
+  printf("[Packed Insert] Elapsed time:\t %6.3f s.  Total sframe size: %.3" PRId64 " bytes\n",
+         packed_insert_time, schunk_packed->cbytes);
   printf("[Cframe Insert] Elapsed time:\t %6.3f s.  Total cframe size: %.3" PRId64 " bytes\n",
          cframe_insert_time, schunk_cframe->cbytes);
 
@@ -177,9 +213,9 @@ void test_insert(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
   free(data);
 }
 
-void test_reorder(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
+void test_reorder(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_packed, blosc2_schunk* schunk_cframe) {
   blosc_timestamp_t last, current;
-  double cframe_reorder_time, sframe_reorder_time;
+  double cframe_reorder_time, sframe_reorder_time, packed_reorder_time;
 
   // Reorder list
   int64_t *offsets_order = malloc(sizeof(int64_t) * schunk_sframe->nchunks);
@@ -200,6 +236,15 @@ void test_reorder(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
   }
   sframe_reorder_time = blosc_elapsed_secs(current, last);
 
+  // Reorder packed sframe
+  blosc_set_timestamp(&current);
+  err = blosc2_schunk_reorder_offsets(schunk_packed, offsets_order);
+  blosc_set_timestamp(&last);
+  if (err < 0) {
+    printf("ERROR: cannot reorder chunks\n");
+  }
+  packed_reorder_time = blosc_elapsed_secs(current, last);
+
   // Reorder frame
   blosc_set_timestamp(&current);
   err = blosc2_schunk_reorder_offsets(schunk_cframe, offsets_order);
@@ -211,6 +256,8 @@ void test_reorder(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
 
   printf("[Sframe Update] Elapsed time:\t %f s.  Total sframe size: %.3" PRId64 " bytes\n",
          sframe_reorder_time, schunk_sframe->cbytes);
+  printf("[Packed Update] Elapsed time:\t %f s.  Total sframe size: %.3" PRId64 " bytes\n",
+         packed_reorder_time, schunk_packed->cbytes);
   printf("[Cframe Update] Elapsed time:\t %f s.  Total cframe size: %.3" PRId64 " bytes\n",
          cframe_reorder_time, schunk_cframe->cbytes);
 
@@ -220,7 +267,8 @@ void test_reorder(blosc2_schunk* schunk_sframe, blosc2_schunk* schunk_cframe) {
 
 void test_create_sframe_frame(char* operation) {
   blosc_timestamp_t last, current;
-  double cframe_append_time, sframe_append_time, cframe_decompress_time, sframe_decompress_time;
+  double cframe_append_time, sframe_append_time, packed_append_time;
+  double cframe_decompress_time, sframe_decompress_time, packed_decompress_time;
 
   int64_t nbytes, cbytes;
   int32_t isize = CHUNKSIZE * sizeof(int32_t);
@@ -233,6 +281,7 @@ void test_create_sframe_frame(char* operation) {
   blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
 
   blosc2_schunk* schunk_sframe;
+  blosc2_schunk* schunk_packed;
   blosc2_schunk* schunk_cframe;
 
   /* Initialize the Blosc compressor */
@@ -250,6 +299,11 @@ void test_create_sframe_frame(char* operation) {
   blosc2_remove_urlpath(storage.urlpath);
   schunk_sframe = blosc2_schunk_new(&storage);
 
+  blosc2_storage storage_packed = {.contiguous=false, .urlpath="packed.b2frame", .cparams=&cparams,
+                                   .dparams=&dparams, .packed=true};
+  blosc2_remove_urlpath(storage_packed.urlpath);
+  schunk_packed = blosc2_schunk_new(&storage_packed);
+
   blosc2_stdio_mmap mmap_file = BLOSC2_STDIO_MMAP_DEFAULTS;
   mmap_file.mode = "w+";
   blosc2_io io_mmap = {.id = BLOSC2_IO_FILESYSTEM_MMAP, .name = "filesystem_mmap", .params = &mmap_file};
@@ -265,10 +319,11 @@ void test_create_sframe_frame(char* operation) {
   blosc2_remove_urlpath(storage2.urlpath);
   schunk_cframe = blosc2_schunk_new(&storage2);
 
-  printf("Test comparison frame vs sframe with %d chunks.\n", nchunks);
+  printf("Test comparison frame vs sframe vs packed sframe with %d chunks.\n", nchunks);
 
   // Feed it with data
   sframe_append_time=0.0;
+  packed_append_time=0.0;
   cframe_append_time=0.0;
   blosc_set_timestamp(&current);
   for (int nchunk = 0; nchunk < nchunks; nchunk++) {
@@ -280,6 +335,11 @@ void test_create_sframe_frame(char* operation) {
     blosc_set_timestamp(&last);
     sframe_append_time += blosc_elapsed_secs(current, last);
 
+    blosc_set_timestamp(&current);
+    blosc2_schunk_append_buffer(schunk_packed, data, isize);
+    blosc_set_timestamp(&last);
+    packed_append_time += blosc_elapsed_secs(current, last);
+
     blosc_set_timestamp(&current);
     blosc2_schunk_append_buffer(schunk_cframe, data, isize);
     blosc_set_timestamp(&last);
@@ -287,6 +347,8 @@ void test_create_sframe_frame(char* operation) {
   }
   printf("[Sframe Compr] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
          sframe_append_time, totalsize / GB, totalsize / (GB * sframe_append_time));
+  printf("[Packed Compr] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
+         packed_append_time, totalsize / GB, totalsize / (GB * packed_append_time));
   printf("[Cframe Compr] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
          cframe_append_time, totalsize / GB, totalsize / (GB * cframe_append_time));
 
@@ -302,6 +364,7 @@ void test_create_sframe_frame(char* operation) {
 
   // Decompress the data
   sframe_decompress_time = 0;
+  packed_decompress_time = 0;
   cframe_decompress_time = 0;
   for (int nchunk = 0; nchunk < nchunks; nchunk++) {
     // Sframe
@@ -313,6 +376,15 @@ void test_create_sframe_frame(char* operation) {
     }
     assert (dsize == (int)isize);
     sframe_decompress_time += blosc_elapsed_secs(current, last);
+    // Packed sframe
+    blosc_set_timestamp(&current);
+    dsize = blosc2_schunk_decompress_chunk(schunk_packed, nchunk, (void *) data_dest, isize);
+    blosc_set_timestamp(&last);
+    if (dsize < 0) {
+      printf("Decompression error packed sframe.  Error code: %d\n", dsize);
+    }
+    assert (dsize == (int)isize);
+    packed_decompress_time += blosc_elapsed_secs(current, last);
     // Frame
     blosc_set_timestamp(&current);
     dsize = blosc2_schunk_decompress_chunk(schunk_cframe, nchunk, (void *) data_dest, isize);
@@ -326,6 +398,8 @@ void test_create_sframe_frame(char* operation) {
 
   printf("[Sframe Decompr] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
          sframe_decompress_time, totalsize / GB, totalsize / (GB * sframe_decompress_time));
+  printf("[Packed Decompr] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
+         packed_decompress_time, totalsize / GB, totalsize / (GB * packed_decompress_time));
   printf("[Cframe Decompr] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
          cframe_decompress_time, totalsize / GB, totalsize / (GB * cframe_decompress_time));
 
@@ -339,20 +413,22 @@ void test_create_sframe_frame(char* operation) {
 
 if (operation != NULL) {
     if (strcmp(operation, "insert") == 0) {
-        test_insert(schunk_sframe, schunk_cframe);
+        test_insert(schunk_sframe, schunk_packed, schunk_cframe);
     }
     else if (strcmp(operation, "update") == 0) {
-        test_update(schunk_sframe, schunk_cframe);
+        test_update(schunk_sframe, schunk_packed, schunk_cframe);
     }
     else if (strcmp(operation, "reorder") == 0) {
-        test_reorder(schunk_sframe, schunk_cframe);
+        test_reorder(schunk_sframe, schunk_packed, schunk_cframe);
     }
 }
 
 
   blosc2_remove_urlpath(schunk_sframe->storage->urlpath);
+  blosc2_remove_urlpath(schunk_packed->storage->urlpath);
   blosc2_remove_urlpath(schunk_cframe->storage->urlpath);
   blosc2_schunk_free(schunk_sframe);
+  blosc2_schunk_free(schunk_packed);
   blosc2_schunk_free(schunk_cframe);
   /* Destroy the Blosc environment */
   blosc2_destroy();
@@ -9,8 +9,10 @@
 **********************************************************************/
 
 #include "b2nd.h"
+#include "blosc-private.h"
 #include "context.h"
 #include "frame.h"
+#include "schunk-private.h"
 #include "blosc2/blosc2-common.h"
 #include "blosc2.h"
 
@@ -1053,6 +1055,486 @@ int64_t nchunk_fastpath(const b2nd_array_t *array, const int64_t *start,
 }
 
 
+/* Get the index and bounds of the update_nchunk-th chunk of the grid of chunks
+   [update_start, update_start + update_shape).  Returns false if the chunk
+   does not intersect with the slice [start, stop). */
+static bool slice_chunk_bounds(const b2nd_array_t *array, const int64_t *start, const int64_t *stop,
+                               const int64_t *update_start, int64_t *update_shape,
+                               const int64_t *chunks_in_array_strides, int64_t update_nchunk,
+                               int64_t *nchunk, int64_t *chunk_start, int64_t *chunk_stop) {
+  int8_t ndim = array->ndim;
+  int64_t nchunk_ndim[B2ND_MAX_DIM] = {0};
+  blosc2_unidim_to_multidim(ndim, update_shape, update_nchunk, nchunk_ndim);
+  for (int i = 0; i < ndim; ++i) {
+    nchunk_ndim[i] += update_start[i];
+  }
+  blosc2_multidim_to_unidim(nchunk_ndim, ndim, chunks_in_array_strides, nchunk);
+
+  bool chunk_empty = false;
+  for (int i = 0; i < ndim; ++i) {
+    chunk_start[i] = nchunk_ndim[i] * array->chunkshape[i];
+    chunk_stop[i] = chunk_start[i] + array->chunkshape[i];
+    if (chunk_stop[i] > array->shape[i]) {
+      chunk_stop[i] = array->shape[i];
+    }
+    chunk_empty |= (chunk_stop[i] <= start[i] || chunk_start[i] >= stop[i]);
+  }
+  return !chunk_empty;
+}
+
+
+/* Get the bounds of the nblock-th block of a chunk, clipped to the chunk.
+   Returns false if the block does not intersect with the slice [start, stop). */
+static bool slice_block_bounds(const b2nd_array_t *array, const int64_t *start, const int64_t *stop,
+                               const int64_t *chunk_start, const int64_t *chunk_stop, int32_t nblock,
+                               int64_t *block_start, int64_t *block_stop) {
+  int8_t ndim = array->ndim;
+  int64_t blocks_in_chunk[B2ND_MAX_DIM] = {0};
+  for (int i = 0; i < ndim; ++i) {
+    blocks_in_chunk[i] = array->extchunkshape[i] / array->blockshape[i];
+  }
+  int64_t nblock_ndim[B2ND_MAX_DIM] = {0};
+  blosc2_unidim_to_multidim(ndim, blocks_in_chunk, nblock, nblock_ndim);
+
+  bool block_empty = false;
+  for (int i = 0; i < ndim; ++i) {
+    block_start[i] = nblock_ndim[i] * array->blockshape[i];
+    block_stop[i] = block_start[i] + array->blockshape[i];
+    block_start[i] += chunk_start[i];
+    block_stop[i] += chunk_start[i];
+
+    if (block_start[i] > chunk_stop[i]) {
+      block_start[i] = chunk_stop[i];
+    }
+    if (block_stop[i] > chunk_stop[i]) {
+      block_stop[i] = chunk_stop[i];
+    }
+    block_empty |= (block_stop[i] <= start[i] || block_start[i] >= stop[i]);
+  }
+  return !block_empty;
+}
+
+
+/* Mask out the blocks of a chunk that do not intersect with the slice, and
+   return the number of blocks that do. */
+static int32_t slice_block_maskout(const b2nd_array_t *array, const int64_t *start, const int64_t *stop,
+                                   const int64_t *chunk_start, const int64_t *chunk_stop,
+                                   bool *block_maskout) {
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+  int32_t nblocks_needed = 0;
+  for (int32_t nblock = 0; nblock < nblocks; ++nblock) {
+    int64_t block_start[B2ND_MAX_DIM];
+    int64_t block_stop[B2ND_MAX_DIM];
+    block_maskout[nblock] = !slice_block_bounds(array, start, stop, chunk_start, chunk_stop, nblock,
+                                                block_start, block_stop);
+    if (!block_maskout[nblock]) {
+      nblocks_needed++;
+    }
+  }
+  return nblocks_needed;
+}
+
+
+/* Whether to get the needed blocks of a chunk one at a time (the compact path)
+   instead of decompressing them into a chunk-sized scratch with a maskout. */
+static bool slice_use_compact(const b2nd_array_t *array, int32_t nblocks_needed, int32_t data_nbytes) {
+  // Compact get path: when only a fraction of the chunk's blocks is
+  // needed, decompress just those blocks -- one at a time, straight
+  // from the (lazy)chunk -- instead of decompressing into a chunk-sized
+  // scratch.  This keeps the working buffer at one block, so small reads
+  // from arrays with large chunks stay O(request), not O(chunksize).
+  // Larger requests keep the maskout path, which decompresses the needed
+  // blocks in parallel.
+  //
+  // The threshold depends on the storage backend.  On disk, the maskout
+  // path reads the *whole* compressed chunk per call while the compact
+  // path only reads the touched blocks, so compact wins by 10-100x well
+  // past needed == nblocks/4 for typical data.  In memory there is no
+  // I/O to save: for poorly-compressible data the maskout path's
+  // parallel decompression overtakes the compact path's serial one at
+  // around 2-4 needed blocks, so stay conservative there (1/16 keeps
+  // the possible loss window narrow while still capturing the common
+  // 1-2 block reads, where compact always wins or ties).
+  int32_t block_nbytes = (int32_t) (array->blocknitems * array->sc->typesize);
+  bool on_disk = array->sc->storage != NULL && array->sc->storage->urlpath != NULL;
+  int64_t frac = on_disk ? 4 : 16;
+  return ((int64_t) nblocks_needed * block_nbytes) * frac <= (int64_t) data_nbytes;
+}
+
+
+/* Copy the part of a chunk that intersects with the slice from (or, for
+   set_slice, into) the buffer, block by block.  The blocks live in data, a
+   decompressed chunk, or when data is NULL they are decompressed one at a
+   time from chunk into block_data using dctx. */
+static int copy_slice_blocks(b2nd_array_t *array, uint8_t *buffer, const int64_t *shape,
+                             const int64_t *start, const int64_t *stop,
+                             const int64_t *chunk_start, const int64_t *chunk_stop, bool set_slice,
+                             uint8_t *data, blosc2_context *dctx, uint8_t *chunk, int32_t cbytes,
+                             uint8_t *block_data) {
+  int8_t ndim = array->ndim;
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+  int32_t block_nbytes = (int32_t) (array->blocknitems * array->sc->typesize);
+
+  for (int32_t nblock = 0; nblock < nblocks; ++nblock) {
+    // Check if the block needs to be updated
+    int64_t block_start[B2ND_MAX_DIM] = {0};
+    int64_t block_stop[B2ND_MAX_DIM] = {0};
+    if (!slice_block_bounds(array, start, stop, chunk_start, chunk_stop, nblock, block_start, block_stop)) {
+      continue;
+    }
+
+    // Compute the part of the slice inside the block, relative to the buffer and to the block
+    int64_t src_start[B2ND_MAX_DIM] = {0};
+    int64_t src_stop[B2ND_MAX_DIM] = {0};
+    int64_t dst_start[B2ND_MAX_DIM] = {0};
+    int64_t dst_stop[B2ND_MAX_DIM] = {0};
+    int64_t dst_pad_shape[B2ND_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+      int64_t slice_start = block_start[i] > start[i] ? block_start[i] : start[i];
+      int64_t slice_stop = block_stop[i] < stop[i] ? block_stop[i] : stop[i];
+      src_start[i] = slice_start - start[i];
+      src_stop[i] = slice_stop - start[i];
+      dst_start[i] = slice_start - block_start[i];
+      dst_stop[i] = slice_stop - block_start[i];
+      dst_pad_shape[i] = array->blockshape[i];
+    }
+
+    uint8_t *dst;
+    if (data == NULL) {
+      // Decompress just this block from the (lazy)chunk.
+      int grc = blosc2_getitem_bytes_ctx(dctx, chunk, cbytes, nblock * block_nbytes, block_nbytes,
+                                         block_data, block_nbytes);
+      if (grc < 0) {
+        BLOSC_TRACE_ERROR("Error decompressing block");
+        return BLOSC2_ERROR_FAILURE;
+      }
+      dst = block_data;
+    } else {
+      dst = &data[nblock * array->blocknitems * array->sc->typesize];
+    }
+
+    if (set_slice) {
+      b2nd_copy_buffer2(ndim, array->sc->typesize,
+                        buffer, shape, src_start, src_stop,
+                        dst, dst_pad_shape, dst_start);
+    } else {
+      b2nd_copy_buffer2(ndim, array->sc->typesize,
+                        dst, dst_pad_shape, dst_start, dst_stop,
+                        buffer, shape, src_start);
+    }
+  }
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Number of threads for processing nchunks chunks of an array one chunk per
+   thread, or 1 if they are better processed in order with the contexts of the
+   super-chunk (and the threads of those). */
+static int16_t chunk_parallel_nthreads(b2nd_array_t *array, bool set, int64_t nchunks) {
+  blosc2_schunk *sc = array->sc;
+  int16_t nthreads = set ? sc->cctx->nthreads : sc->dctx->nthreads;
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+  // Few big chunks are better served by the block threads of the serial path
+  if (nthreads <= 1 || nchunks < 2 || (nchunks < nthreads && nblocks >= nthreads)) {
+    return 1;
+  }
+  // Cached chunks, filters, tuners and the training of a dict see the chunks
+  // through the contexts of the super-chunk, so they stay serial too
+  if (set) {
+    bool dict_training = sc->cctx->use_dict && sc->cctx->dict_nchunks > 0 &&
+                         schunk_vlmeta_exists(sc, BLOSC2_DICT_VLMETA) < 0;
+    if (sc->cctx->prefilter != NULL || sc->cctx->tuner_params != NULL ||
+        sc->cctx->tuner_id != BLOSC_STUNE || dict_training) {
+      return 1;
+    }
+  } else if (sc->cache != NULL || sc->dctx->postfilter != NULL) {
+    return 1;
+  }
+  return nthreads;
+}
+
+
+/* Create the contexts of a thread processing whole chunks of an array: they
+   use a single thread, and have the dict of the super-chunk already loaded so
+   that the threads do not look it up concurrently.  The compression context
+   is only created for sets. */
+static int create_chunk_worker_ctxs(b2nd_array_t *array, bool set, blosc2_context **dctx,
+                                    blosc2_context **cctx) {
+  blosc2_schunk *sc = array->sc;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = 1;
+  dparams.schunk = sc;
+  *dctx = blosc2_create_dctx(dparams);
+  BLOSC_ERROR_NULL(*dctx, BLOSC2_ERROR_MEMORY_ALLOC);
+  // The threads are for the chunks here, so override a possible BLOSC_NTHREADS
+  (*dctx)->nthreads = 1;
+  (*dctx)->new_nthreads = 1;
+  BLOSC_ERROR(load_schunk_dict(*dctx));
+  if (!set) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  blosc2_cparams cparams = *sc->storage->cparams;
+  cparams.schunk = sc;
+  cparams.nthreads = 1;
+  *cctx = blosc2_create_cctx(cparams);
+  BLOSC_ERROR_NULL(*cctx, BLOSC2_ERROR_MEMORY_ALLOC);
+  (*cctx)->nthreads = 1;
+  (*cctx)->new_nthreads = 1;
+  if ((*cctx)->use_dict) {
+    BLOSC_ERROR(load_schunk_dict(*cctx));
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* A chunk of a slice, as handled by the workers of get_set_slice_parallel() */
+typedef struct {
+  int64_t nchunk;
+  int64_t chunk_start[B2ND_MAX_DIM];
+  int64_t chunk_stop[B2ND_MAX_DIM];
+  uint8_t *chunk;  // the (lazy)chunk to read from; NULL when a set covers the whole chunk
+  int32_t cbytes;
+  bool needs_free;
+  uint8_t *new_chunk;  // the recompressed chunk of a set, committed in order afterwards
+} slice_chunk;
+
+/* Shared state of the workers of get_set_slice_parallel() */
+typedef struct {
+  b2nd_array_t *array;
+  uint8_t *buffer;
+  const int64_t *shape;
+  const int64_t *start;
+  const int64_t *stop;
+  bool set_slice;
+  int32_t data_nbytes;
+  slice_chunk *chunks;
+  int64_t nchunks;
+  int64_t next_chunk;
+  int error;
+  blosc2_pthread_mutex_t mutex;
+} slice_work;
+
+typedef struct {
+  slice_work *work;
+  blosc2_context *dctx;
+  blosc2_context *cctx;
+  uint8_t *data;
+  uint8_t *block_data;
+  bool *block_maskout;
+} slice_worker;
+
+static int slice_worker_chunk(slice_worker *worker, slice_chunk *c) {
+  slice_work *work = worker->work;
+  b2nd_array_t *array = work->array;
+  int32_t data_nbytes = work->data_nbytes;
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+
+  bool use_compact = false;
+  if (!work->set_slice) {
+    int32_t nblocks_needed = slice_block_maskout(array, work->start, work->stop, c->chunk_start,
+                                                 c->chunk_stop, worker->block_maskout);
+    use_compact = slice_use_compact(array, nblocks_needed, data_nbytes);
+  }
+  if (use_compact) {
+    if (worker->block_data == NULL) {
+      worker->block_data = malloc(array->blocknitems * array->sc->typesize);
+      BLOSC_ERROR_NULL(worker->block_data, BLOSC2_ERROR_MEMORY_ALLOC);
+    }
+    return copy_slice_blocks(array, work->buffer, work->shape, work->start, work->stop,
+                             c->chunk_start, c->chunk_stop, false, NULL, worker->dctx,
+                             c->chunk, c->cbytes, worker->block_data);
+  }
+
+  if (worker->data == NULL) {
+    worker->data = malloc(data_nbytes);
+    BLOSC_ERROR_NULL(worker->data, BLOSC2_ERROR_MEMORY_ALLOC);
+  }
+  if (c->chunk != NULL) {
+    if (!work->set_slice) {
+      BLOSC_ERROR(blosc2_set_maskout(worker->dctx, worker->block_maskout, nblocks));
+    }
+    int err = blosc2_decompress_ctx(worker->dctx, c->chunk, c->cbytes, worker->data, data_nbytes);
+    if (err < 0) {
+      BLOSC_TRACE_ERROR("Error decompressing chunk");
+      return BLOSC2_ERROR_FAILURE;
+    }
+  } else {
+    // Avoid writing non zero padding from previous chunk
+    memset(worker->data, 0, data_nbytes);
+  }
+  BLOSC_ERROR(copy_slice_blocks(array, work->buffer, work->shape, work->start, work->stop,
+                                c->chunk_start, c->chunk_stop, work->set_slice, worker->data,
+                                NULL, NULL, 0, NULL));
+  if (!work->set_slice) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  // Recompress the data
+  int32_t chunk_nbytes = data_nbytes + BLOSC2_MAX_OVERHEAD;
+  uint8_t *chunk = malloc(chunk_nbytes);
+  BLOSC_ERROR_NULL(chunk, BLOSC2_ERROR_MEMORY_ALLOC);
+  int brc = blosc2_compress_ctx(worker->cctx, worker->data, data_nbytes, chunk, chunk_nbytes);
+  if (brc < 0) {
+    BLOSC_TRACE_ERROR("Blosc can not compress the data");
+    free(chunk);
+    return BLOSC2_ERROR_FAILURE;
+  }
+  c->new_chunk = chunk;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+static void slice_worker_func(void *arg) {
+  slice_worker *worker = (slice_worker *)arg;
+  slice_work *work = worker->work;
+
+  while (true) {
+    blosc2_pthread_mutex_lock(&work->mutex);
+    int64_t i = work->error < 0 ? work->nchunks : work->next_chunk++;
+    blosc2_pthread_mutex_unlock(&work->mutex);
+    if (i >= work->nchunks) {
+      return;
+    }
+    int rc = slice_worker_chunk(worker, &work->chunks[i]);
+    if (rc < 0) {
+      blosc2_pthread_mutex_lock(&work->mutex);
+      if (work->error == 0) {
+        work->error = rc;
+      }
+      blosc2_pthread_mutex_unlock(&work->mutex);
+      return;
+    }
+  }
+}
+
+
+/* Get or set a slice spanning several chunks with one chunk per thread of the
+   shared pool.  The compressed chunks are fetched, and for sets committed back
+   in order, from the calling thread; the workers decompress, copy and
+   recompress them.  Chunks are processed in batches so that only a few of them
+   are in memory at once.  Returns 1 if the slice has been handled, 0 if it is
+   better left to the serial path, or a negative value on errors. */
+static int get_set_slice_parallel(uint8_t *buffer, const int64_t *shape, const int64_t *start,
+                                  const int64_t *stop, b2nd_array_t *array, bool set_slice,
+                                  int32_t data_nbytes, const int64_t *update_start,
+                                  int64_t *update_shape, int64_t update_nchunks,
+                                  const int64_t *chunks_in_array_strides) {
+  blosc2_schunk *sc = array->sc;
+  int16_t nthreads = chunk_parallel_nthreads(array, set_slice, update_nchunks);
+  int16_t pool_nthreads = nthreads;
+  if (nthreads <= 1) {
+    return 0;
+  }
+
+  int64_t batch_size = 2 * (int64_t) nthreads;
+  if (batch_size > update_nchunks) {
+    batch_size = update_nchunks;
+  }
+  if ((int64_t) nthreads > batch_size) {
+    nthreads = (int16_t) batch_size;
+  }
+  slice_work work = {.array = array, .buffer = buffer, .shape = shape, .start = start, .stop = stop,
+                     .set_slice = set_slice, .data_nbytes = data_nbytes};
+  work.chunks = calloc((size_t) batch_size, sizeof(slice_chunk));
+  slice_worker *workers = calloc((size_t) nthreads, sizeof(slice_worker));
+  if (work.chunks == NULL || workers == NULL) {
+    free(work.chunks);
+    free(workers);
+    BLOSC_ERROR(BLOSC2_ERROR_MEMORY_ALLOC);
+  }
+  blosc2_pthread_mutex_init(&work.mutex, NULL);
+
+  int rc = 0;
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+  for (int16_t i = 0; i < nthreads; i++) {
+    workers[i].work = &work;
+    workers[i].block_maskout = malloc(nblocks);
+    if (workers[i].block_maskout == NULL) {
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto cleanup;
+    }
+    rc = create_chunk_worker_ctxs(array, set_slice, &workers[i].dctx, &workers[i].cctx);
+    if (rc < 0) {
+      goto cleanup;
+    }
+    rc = 0;
+  }
+
+  int64_t update_nchunk = 0;
+  while (update_nchunk < update_nchunks && rc == 0) {
+    // Fetch the next batch of chunks
+    work.nchunks = 0;
+    work.next_chunk = 0;
+    for (; update_nchunk < update_nchunks && work.nchunks < batch_size; ++update_nchunk) {
+      slice_chunk *c = &work.chunks[work.nchunks];
+      memset(c, 0, sizeof(slice_chunk));
+      if (!slice_chunk_bounds(array, start, stop, update_start, update_shape, chunks_in_array_strides,
+                              update_nchunk, &c->nchunk, c->chunk_start, c->chunk_stop)) {
+        continue;
+      }
+      work.nchunks++;
+      bool decompress_chunk = !set_slice;
+      for (int i = 0; i < array->ndim; ++i) {
+        decompress_chunk |= (c->chunk_start[i] < start[i] || c->chunk_stop[i] > stop[i]);
+      }
+      if (!decompress_chunk) {
+        continue;
+      }
+      c->cbytes = set_slice ? blosc2_schunk_get_chunk(sc, c->nchunk, &c->chunk, &c->needs_free) :
+                              blosc2_schunk_get_lazychunk(sc, c->nchunk, &c->chunk, &c->needs_free);
+      if (c->cbytes < 0) {
+        BLOSC_TRACE_ERROR("Error getting chunk %" PRId64, c->nchunk);
+        rc = c->cbytes;
+        break;
+      }
+    }
+
+    if (rc == 0) {
+      rc = blosc2_run_parallel(pool_nthreads, nthreads, slice_worker_func, sizeof(slice_worker), workers);
+      if (rc == 0) {
+        rc = work.error;
+      }
+    }
+
+    // Commit the updated chunks in order (the super-chunk owns them afterwards)
+    for (int64_t i = 0; i < work.nchunks; i++) {
+      slice_chunk *c = &work.chunks[i];
+      if (c->needs_free) {
+        free(c->chunk);
+      }
+      if (rc == 0 && c->new_chunk != NULL) {
+        int64_t brc = blosc2_schunk_update_chunk(sc, c->nchunk, c->new_chunk, false);
+        if (brc < 0) {
+          BLOSC_TRACE_ERROR("Blosc can not update the chunk");
+          rc = (int) brc;
+        }
+        c->new_chunk = NULL;
+      }
+      free(c->new_chunk);
+    }
+  }
+
+  cleanup:
+  for (int16_t i = 0; i < nthreads; i++) {
+    if (workers[i].dctx != NULL) {
+      blosc2_free_ctx(workers[i].dctx);
+    }
+    if (workers[i].cctx != NULL) {
+      blosc2_free_ctx(workers[i].cctx);
+    }
+    free(workers[i].data);
+    free(workers[i].block_data);
+    free(workers[i].block_maskout);
+  }
+  blosc2_pthread_mutex_destroy(&work.mutex);
+  free(work.chunks);
+  free(workers);
+  BLOSC_ERROR(rc);
+  return 1;
+}
+
+
 // Setting and getting slices
 int get_set_slice(void *buffer, int64_t buffersize, const int64_t *start, const int64_t *stop,
                   const int64_t *shape, b2nd_array_t *array, bool set_slice) {
@@ -1158,15 +1640,6 @@ int get_set_slice(void *buffer, int64_t buffersize, const int64_t *start, const
 
   // Slow path for set and get
 
-  // Chunk-sized scratch, allocated lazily: the compact get path below never
-  // needs it, and for large chunks just the malloc/free pair costs
-  // O(chunksize) in page-table work (it is way above the malloc mmap
-  // threshold), which would dominate small reads.
-  uint8_t *data = NULL;
-  // Block-sized scratch for the compact get path (lazily allocated too).
-  uint8_t *block_data = NULL;
-  int32_t block_nbytes = (int32_t) (array->blocknitems * array->sc->typesize);
-
   int64_t chunks_in_array[B2ND_MAX_DIM] = {0};
   for (int i = 0; i < ndim; ++i) {
     chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
@@ -1178,11 +1651,6 @@ int get_set_slice(void *buffer, int64_t buffersize, const int64_t *start, const
     chunks_in_array_strides[i] = chunks_in_array_strides[i + 1] * chunks_in_array[i + 1];
   }
 
-  int64_t blocks_in_chunk[B2ND_MAX_DIM] = {0};
-  for (int i = 0; i < ndim; ++i) {
-    blocks_in_chunk[i] = array->extchunkshape[i] / array->blockshape[i];
-  }
-
   // Compute the number of chunks to update
   int64_t update_start[B2ND_MAX_DIM];
   int64_t update_shape[B2ND_MAX_DIM];
@@ -1201,39 +1669,63 @@ int get_set_slice(void *buffer, int64_t buffersize, const int64_t *start, const
     update_nchunks *= update_shape[i];
   }
 
-  for (int64_t update_nchunk = 0; update_nchunk < update_nchunks; ++update_nchunk) {
-    int64_t nchunk_ndim[B2ND_MAX_DIM] = {0};
-    blosc2_unidim_to_multidim(ndim, update_shape, update_nchunk, nchunk_ndim);
-    for (int i = 0; i < ndim; ++i) {
-      nchunk_ndim[i] += update_start[i];
-    }
-    int64_t nchunk;
-    blosc2_multidim_to_unidim(nchunk_ndim, ndim, chunks_in_array_strides, &nchunk);
+  // Slices over several chunks are processed one chunk per thread if possible
+  int prc = get_set_slice_parallel(buffer_b, shape, start, stop, array, set_slice, data_nbytes,
+                                   update_start, update_shape, update_nchunks, chunks_in_array_strides);
+  BLOSC_ERROR(prc);
+  if (prc > 0) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  // Chunk-sized scratch, allocated lazily: the compact get path below never
+  // needs it, and for large chunks just the malloc/free pair costs
+  // O(chunksize) in page-table work (it is way above the malloc mmap
+  // threshold), which would dominate small reads.
+  uint8_t *data = NULL;
+  // Block-sized scratch for the compact get path (lazily allocated too).
+  uint8_t *block_data = NULL;
+  int32_t block_nbytes = (int32_t) (array->blocknitems * array->sc->typesize);
 
+  for (int64_t update_nchunk = 0; update_nchunk < update_nchunks; ++update_nchunk) {
     // Check if the chunk needs to be updated
+    int64_t nchunk;
     int64_t chunk_start[B2ND_MAX_DIM] = {0};
     int64_t chunk_stop[B2ND_MAX_DIM] = {0};
-    for (int i = 0; i < ndim; ++i) {
-      chunk_start[i] = nchunk_ndim[i] * array->chunkshape[i];
-      chunk_stop[i] = chunk_start[i] + array->chunkshape[i];
-      if (chunk_stop[i] > array->shape[i]) {
-        chunk_stop[i] = array->shape[i];
-      }
-    }
-    bool chunk_empty = false;
-    for (int i = 0; i < ndim; ++i) {
-      chunk_empty |= (chunk_stop[i] <= start[i] || chunk_start[i] >= stop[i]);
-    }
-    if (chunk_empty) {
+    if (!slice_chunk_bounds(array, start, stop, update_start, update_shape, chunks_in_array_strides,
+                            update_nchunk, &nchunk, chunk_start, chunk_stop)) {
       continue;
     }
 
+    // Let the next chunk come from disk while this one is decompressed
+    if (!set_slice && array->sc->frame != NULL && update_nchunk + 1 < update_nchunks) {
+      int64_t next_nchunk_ndim[B2ND_MAX_DIM] = {0};
+      blosc2_unidim_to_multidim(ndim, update_shape, update_nchunk + 1, next_nchunk_ndim);
+      for (int i = 0; i < ndim; ++i) {
+        next_nchunk_ndim[i] += update_start[i];
+      }
+      int64_t next_nchunk;
+      blosc2_multidim_to_unidim(next_nchunk_ndim, ndim, chunks_in_array_strides, &next_nchunk);
+      frame_prefetch_chunk((blosc2_frame_s *) array->sc->frame, next_nchunk);
+    }
+
     int32_t nblocks = (int32_t) array->extchunknitems / array->blocknitems;
-    // Compact get path state for this chunk (see below).
+    // Compact get path state for this chunk (see slice_use_compact()).
     bool use_compact = false;
     uint8_t *lazychunk = NULL;
     bool lazychunk_needs_free = false;
     int32_t lazychunk_cbytes = 0;
+    // Chunk served from the cache of the super-chunk, if any
+    uint8_t *cached_chunk = NULL;
+    if (!set_slice) {
+      int32_t cached_nbytes = schunk_get_cached_chunk(array->sc, nchunk, &cached_chunk);
+      if (cached_nbytes < 0) {
+        BLOSC_TRACE_ERROR("Error getting the chunk from the cache");
+        BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+      }
+      if (cached_nbytes == 0) {
+        cached_chunk = NULL;
+      }
+    }
     if (set_slice) {
       if (data == NULL) {
         data = malloc(data_nbytes);
@@ -1255,61 +1747,13 @@ int get_set_slice(void *buffer, int64_t buffersize, const int64_t *start, const
         // Avoid writing non zero padding from previous chunk
         memset(data, 0, data_nbytes);
       }
-    } else {
+    } else if (cached_chunk == NULL) {
       bool *block_maskout = malloc(nblocks);
       BLOSC_ERROR_NULL(block_maskout, BLOSC2_ERROR_MEMORY_ALLOC);
-      int32_t nblocks_needed = 0;
-      for (int nblock = 0; nblock < nblocks; ++nblock) {
-        int64_t nblock_ndim[B2ND_MAX_DIM] = {0};
-        blosc2_unidim_to_multidim(ndim, blocks_in_chunk, nblock, nblock_ndim);
-
-        // Check if the block needs to be updated
-        int64_t block_start[B2ND_MAX_DIM] = {0};
-        int64_t block_stop[B2ND_MAX_DIM] = {0};
-        for (int i = 0; i < ndim; ++i) {
-          block_start[i] = nblock_ndim[i] * array->blockshape[i];
-          block_stop[i] = block_start[i] + array->blockshape[i];
-          block_start[i] += chunk_start[i];
-          block_stop[i] += chunk_start[i];
-
-          if (block_start[i] > chunk_stop[i]) {
-            block_start[i] = chunk_stop[i];
-          }
-          if (block_stop[i] > chunk_stop[i]) {
-            block_stop[i] = chunk_stop[i];
-          }
-        }
-
-        bool block_empty = false;
-        for (int i = 0; i < ndim; ++i) {
-          block_empty |= (block_stop[i] <= start[i] || block_start[i] >= stop[i]);
-        }
-        block_maskout[nblock] = block_empty ? true : false;
-        if (!block_empty) {
-          nblocks_needed++;
-        }
-      }
+      int32_t nblocks_needed = slice_block_maskout(array, start, stop, chunk_start, chunk_stop,
+                                                   block_maskout);
 
-      // Compact get path: when only a fraction of the chunk's blocks is
-      // needed, decompress just those blocks -- one at a time, straight
-      // from the (lazy)chunk -- instead of decompressing into a chunk-sized
-      // scratch.  This keeps the working buffer at one block, so small reads
-      // from arrays with large chunks stay O(request), not O(chunksize).
-      // Larger requests keep the maskout path, which decompresses the needed
-      // blocks in parallel.
-      //
-      // The threshold depends on the storage backend.  On disk, the maskout
-      // path reads the *whole* compressed chunk per call while the compact
-      // path only reads the touched blocks, so compact wins by 10-100x well
-      // past needed == nblocks/4 for typical data.  In memory there is no
-      // I/O to save: for poorly-compressible data the maskout path's
-      // parallel decompression overtakes the compact path's serial one at
-      // around 2-4 needed blocks, so stay conservative there (1/16 keeps
-      // the possible loss window narrow while still capturing the common
-      // 1-2 block reads, where compact always wins or ties).
-      bool on_disk = array->sc->storage != NULL && array->sc->storage->urlpath != NULL;
-      int64_t frac = on_disk ? 4 : 16;
-      use_compact = ((int64_t) nblocks_needed * block_nbytes) * frac <= (int64_t) data_nbytes;
+      use_compact = slice_use_compact(array, nblocks_needed, data_nbytes);
       if (use_compact) {
         lazychunk_cbytes = blosc2_schunk_get_lazychunk(array->sc, nchunk, &lazychunk,
                                                        &lazychunk_needs_free);
@@ -1352,117 +1796,13 @@ int get_set_slice(void *buffer, int64_t buffersize, const int64_t *start, const
     }
 
     // Iterate over blocks
-
-    for (int nblock = 0; nblock < nblocks; ++nblock) {
-      int64_t nblock_ndim[B2ND_MAX_DIM] = {0};
-      blosc2_unidim_to_multidim(ndim, blocks_in_chunk, nblock, nblock_ndim);
-
-      // Check if the block needs to be updated
-      int64_t block_start[B2ND_MAX_DIM] = {0};
-      int64_t block_stop[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        block_start[i] = nblock_ndim[i] * array->blockshape[i];
-        block_stop[i] = block_start[i] + array->blockshape[i];
-        block_start[i] += chunk_start[i];
-        block_stop[i] += chunk_start[i];
-
-        if (block_start[i] > chunk_stop[i]) {
-          block_start[i] = chunk_stop[i];
-        }
-        if (block_stop[i] > chunk_stop[i]) {
-          block_stop[i] = chunk_stop[i];
-        }
-      }
-      int64_t block_shape[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        block_shape[i] = block_stop[i] - block_start[i];
-      }
-      bool block_empty = false;
-      for (int i = 0; i < ndim; ++i) {
-        block_empty |= (block_stop[i] <= start[i] || block_start[i] >= stop[i]);
-      }
-      if (block_empty) {
-        continue;
-      }
-
-      // compute the start of the slice inside the block
-      int64_t slice_start[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        if (block_start[i] < start[i]) {
-          slice_start[i] = start[i] - block_start[i];
-        } else {
-          slice_start[i] = 0;
-        }
-        slice_start[i] += block_start[i];
-      }
-
-      int64_t slice_stop[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        if (block_stop[i] > stop[i]) {
-          slice_stop[i] = block_shape[i] - (block_stop[i] - stop[i]);
-        } else {
-          slice_stop[i] = block_stop[i] - block_start[i];
-        }
-        slice_stop[i] += block_start[i];
-      }
-
-      int64_t slice_shape[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        slice_shape[i] = slice_stop[i] - slice_start[i];
-      }
-
-      uint8_t *src = &buffer_b[0];
-
-      int64_t src_start[B2ND_MAX_DIM] = {0};
-      int64_t src_stop[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        src_start[i] = slice_start[i] - start[i];
-        src_stop[i] = slice_stop[i] - start[i];
-      }
-
-      uint8_t *dst;
-      if (use_compact) {
-        // Decompress just this block from the (lazy)chunk.
-        int grc = blosc2_getitem_bytes_ctx(array->sc->dctx, lazychunk, lazychunk_cbytes,
-                                           (int32_t) ((int64_t) nblock * block_nbytes), block_nbytes,
-                                           block_data, block_nbytes);
-        if (grc < 0) {
-          BLOSC_TRACE_ERROR("Error decompressing block");
-          if (lazychunk_needs_free) {
-            free(lazychunk);
-          }
-          BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
-        }
-        dst = block_data;
-      } else {
-        dst = &data[nblock * array->blocknitems * array->sc->typesize];
-      }
-      int64_t dst_pad_shape[B2ND_MAX_DIM];
-      for (int i = 0; i < ndim; ++i) {
-        dst_pad_shape[i] = array->blockshape[i];
-      }
-
-      int64_t dst_start[B2ND_MAX_DIM] = {0};
-      int64_t dst_stop[B2ND_MAX_DIM] = {0};
-      for (int i = 0; i < ndim; ++i) {
-        dst_start[i] = slice_start[i] - block_start[i];
-        dst_stop[i] = dst_start[i] + slice_shape[i];
-      }
-
-      if (set_slice) {
-        b2nd_copy_buffer2(ndim, array->sc->typesize,
-                          src, shape, src_start, src_stop,
-                          dst, dst_pad_shape, dst_start);
-      } else {
-        b2nd_copy_buffer2(ndim, array->sc->typesize,
-                          dst, dst_pad_shape, dst_start, dst_stop,
-                          src, shape, src_start);
-      }
-    }
-
+    int crc = copy_slice_blocks(array, buffer_b, shape, start, stop, chunk_start, chunk_stop, set_slice,
+                                use_compact ? NULL : (cached_chunk != NULL ? cached_chunk : data),
+                                array->sc->dctx, lazychunk, lazychunk_cbytes, block_data);
     if (use_compact && lazychunk_needs_free) {
       free(lazychunk);
     }
+    BLOSC_ERROR(crc);
 
     if (set_slice) {
       // Recompress the data
@@ -1524,9 +1864,9 @@ int b2nd_set_slice_cbuffer(const void *buffer, const int64_t *buffershape, int64
   // (plans/todo-locking-swmr.md item 2 / python-blosc2's
   // todo/locking-mwmr.md item 2). A no-op for unlocked handles.
   blosc2_frame_s *frame = (blosc2_frame_s *) array->sc->frame;
-  BLOSC_ERROR(frame_lock(frame, true));
+  BLOSC_ERROR(frame_write_lock(frame));
   int rc = get_set_slice((void*)buffer, buffersize, start, stop, (int64_t *)buffershape, array, true);
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   BLOSC_ERROR(rc);
 
   return BLOSC2_ERROR_SUCCESS;
@@ -1769,7 +2109,187 @@ int b2nd_squeeze_index(b2nd_array_t *array, b2nd_array_t **view, const bool *ind
 }
 
 
-int b2nd_copy(b2nd_context_t *ctx, const b2nd_array_t *src, b2nd_array_t **array) {
+/* Fill the (still chunkless) super-chunk of array with the data of src, producing the chunks of
+ * array in order.  They are staged in slabs made of one chunk along the first dims, a run of
+ * chunks along dim k and all the chunks along the rest, as big as memory_budget allows: every
+ * slab is read from src with a single (parallel) slice, so each source chunk is decompressed
+ * about once, and its chunks are compressed in parallel and appended with one index update. */
+static int rechunk_chunks(b2nd_array_t *array, const b2nd_array_t *src, int64_t memory_budget) {
+  int8_t ndim = array->ndim;
+  int64_t typesize = array->sc->typesize;
+  int32_t chunksize = array->sc->chunksize;
+  int64_t chunks_in_array[B2ND_MAX_DIM];
+  for (int i = 0; i < ndim; ++i) {
+    chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
+  }
+
+  // Choose the first dim k for which a slab with a single chunk along it fits in the budget
+  int8_t k;
+  int64_t unit_nitems = 0;
+  int64_t unit_nchunks = 0;
+  for (k = 0; k < ndim; ++k) {
+    unit_nitems = array->chunkshape[k];
+    unit_nchunks = 1;
+    for (int i = 0; i < ndim; ++i) {
+      if (i < k) {
+        unit_nitems *= array->chunkshape[i];
+      } else if (i > k) {
+        unit_nitems *= array->shape[i];
+        unit_nchunks *= chunks_in_array[i];
+      }
+    }
+    if (unit_nitems * typesize + unit_nchunks * chunksize <= memory_budget) {
+      break;
+    }
+  }
+  if (k == ndim) {
+    // Not even a single chunk fits; stage just one at a time
+    k = (int8_t) (ndim - 1);
+  }
+  int64_t slab_nchunks = memory_budget / (unit_nitems * typesize + unit_nchunks * chunksize);
+  if (slab_nchunks < 1) {
+    slab_nchunks = 1;
+  }
+  if (slab_nchunks > chunks_in_array[k]) {
+    slab_nchunks = chunks_in_array[k];
+  }
+  // Prefer slabs holding whole source chunks along k, so that none of them is read twice
+  int64_t a = array->chunkshape[k];
+  int64_t b = src->chunkshape[k];
+  while (b != 0) {
+    int64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  int64_t slab_step = src->chunkshape[k] / a;
+  if (slab_nchunks >= slab_step && slab_nchunks < chunks_in_array[k]) {
+    slab_nchunks -= slab_nchunks % slab_step;
+  }
+
+  int64_t slabs_in_array[B2ND_MAX_DIM];
+  int64_t nslabs = 1;
+  for (int i = 0; i <= k; ++i) {
+    slabs_in_array[i] = i < k ? chunks_in_array[i] :
+                        (chunks_in_array[k] + slab_nchunks - 1) / slab_nchunks;
+    nslabs *= slabs_in_array[i];
+  }
+  int64_t max_nchunks = slab_nchunks * unit_nchunks;
+  uint8_t *slab = malloc(slab_nchunks * unit_nitems * typesize);
+  uint8_t *chunks = malloc(max_nchunks * chunksize);
+  const void **srcs = malloc(max_nchunks * sizeof(void *));
+  int32_t *nbytes = malloc(max_nchunks * sizeof(int32_t));
+  int rc = BLOSC2_ERROR_SUCCESS;
+  if (slab == NULL || chunks == NULL || srcs == NULL || nbytes == NULL) {
+    rc = BLOSC2_ERROR_MEMORY_ALLOC;
+    goto cleanup;
+  }
+
+  for (int64_t nslab = 0; nslab < nslabs; ++nslab) {
+    int64_t slab_ndim[B2ND_MAX_DIM] = {0};
+    blosc2_unidim_to_multidim((int8_t) (k + 1), slabs_in_array, nslab, slab_ndim);
+    int64_t start[B2ND_MAX_DIM];
+    int64_t stop[B2ND_MAX_DIM];
+    int64_t slab_shape[B2ND_MAX_DIM];
+    int64_t slab_chunks[B2ND_MAX_DIM];
+    int64_t nchunks = 1;
+    int64_t slab_nbytes = typesize;
+    for (int i = 0; i < ndim; ++i) {
+      int64_t span = i < k ? 1 : (i == k ? slab_nchunks : chunks_in_array[i]);
+      start[i] = i <= k ? slab_ndim[i] * span * array->chunkshape[i] : 0;
+      stop[i] = start[i] + span * array->chunkshape[i];
+      if (stop[i] > array->shape[i]) {
+        stop[i] = array->shape[i];
+      }
+      slab_shape[i] = stop[i] - start[i];
+      slab_chunks[i] = (slab_shape[i] + array->chunkshape[i] - 1) / array->chunkshape[i];
+      nchunks *= slab_chunks[i];
+      slab_nbytes *= slab_shape[i];
+    }
+    rc = b2nd_get_slice_cbuffer(src, start, stop, slab, slab_shape, slab_nbytes);
+    if (rc < 0) {
+      goto cleanup;
+    }
+
+    // Lay out the chunks of the slab (these come one after the other in the array)
+    for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+      int64_t chunk_ndim[B2ND_MAX_DIM] = {0};
+      blosc2_unidim_to_multidim(ndim, slab_chunks, nchunk, chunk_ndim);
+      int64_t chunk_start[B2ND_MAX_DIM];
+      int64_t chunk_stop[B2ND_MAX_DIM];
+      bool padded = false;
+      for (int i = 0; i < ndim; ++i) {
+        chunk_start[i] = start[i] + chunk_ndim[i] * array->chunkshape[i];
+        chunk_stop[i] = chunk_start[i] + array->chunkshape[i];
+        if (chunk_stop[i] > array->shape[i]) {
+          chunk_stop[i] = array->shape[i];
+        }
+        padded |= chunk_stop[i] - chunk_start[i] < array->extchunkshape[i];
+      }
+      uint8_t *data = chunks + nchunk * chunksize;
+      if (padded) {
+        memset(data, 0, chunksize);
+      }
+      rc = copy_slice_blocks(array, slab, slab_shape, start, stop, chunk_start, chunk_stop, true,
+                             data, NULL, NULL, 0, NULL);
+      if (rc < 0) {
+        goto cleanup;
+      }
+      srcs[nchunk] = data;
+      nbytes[nchunk] = chunksize;
+    }
+    int64_t nchunks_ = blosc2_schunk_append_buffers(array->sc, nchunks, srcs, nbytes);
+    if (nchunks_ < 0) {
+      rc = (int) nchunks_;
+      goto cleanup;
+    }
+  }
+
+  cleanup:
+  free(nbytes);
+  free(srcs);
+  free(chunks);
+  free(slab);
+  return rc;
+}
+
+
+/* Create array as a copy of src with the chunkshape and blockshape in ctx (see b2nd_rechunk()). */
+static int rechunk_array(b2nd_context_t *ctx, const b2nd_array_t *src, int64_t memory_budget,
+                         b2nd_array_t **array) {
+  int64_t nitems = 1;
+  for (int i = 0; i < src->ndim; ++i) {
+    nitems *= src->shape[i];
+  }
+  if (src->ndim == 0 || nitems == 0) {
+    int64_t start[B2ND_MAX_DIM] = {0};
+    BLOSC_ERROR(b2nd_get_slice(ctx, array, src, start, src->shape));
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  // Start with no chunks at all (instead of special ones), as they are appended afterwards;
+  // the real shape is published only when they are all there
+  ctx->shape[0] = 0;
+  int rc = array_new(ctx, BLOSC2_SPECIAL_ZERO, array);
+  ctx->shape[0] = src->shape[0];
+  BLOSC_ERROR(rc);
+  rc = update_shape_struct(*array, src->ndim, src->shape, (*array)->chunkshape, (*array)->blockshape);
+  if (rc >= 0) {
+    rc = rechunk_chunks(*array, src, memory_budget > 0 ? memory_budget : B2ND_DEFAULT_RECHUNK_MEMORY);
+  }
+  if (rc >= 0) {
+    rc = publish_shape_meta(*array);
+  }
+  if (rc < 0) {
+    b2nd_free(*array);
+    *array = NULL;
+    BLOSC_ERROR(rc);
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+static int copy_array(b2nd_context_t *ctx, const b2nd_array_t *src, int64_t memory_budget,
+                      b2nd_array_t **array) {
   BLOSC_ERROR_NULL(src, BLOSC2_ERROR_NULL_POINTER);
   BLOSC_ERROR_NULL(array, BLOSC2_ERROR_NULL_POINTER);
   BLOSC_ERROR(refresh_if_stale((b2nd_array_t *) src));
@@ -1803,12 +2323,6 @@ int b2nd_copy(b2nd_context_t *ctx, const b2nd_array_t *src, b2nd_array_t **array
     (*array)->sc = new_sc;
 
   } else {
-    int64_t start[B2ND_MAX_DIM] = {0};
-
-    int64_t stop[B2ND_MAX_DIM];
-    for (int i = 0; i < src->ndim; ++i) {
-      stop[i] = src->shape[i];
-    }
     // Copy metalayers
     b2nd_context_t params_meta;
     memcpy(&params_meta, ctx, sizeof(params_meta));
@@ -1827,10 +2341,14 @@ int b2nd_copy(b2nd_context_t *ctx, const b2nd_array_t *src, b2nd_array_t **array
     params_meta.nmetalayers = j;
 
     // Copy data
-    BLOSC_ERROR(b2nd_get_slice(&params_meta, array, src, start, stop));
+    BLOSC_ERROR(rechunk_array(&params_meta, src, memory_budget, array));
 
     // Copy vlmetayers
     for (int i = 0; i < src->sc->nvlmetalayers; ++i) {
+      if (strcmp(src->sc->vlmetalayers[i]->name, BLOSC2_DICT_VLMETA) == 0) {
+        // The recompressed chunks do not use the dictionary of src
+        continue;
+      }
       uint8_t *content;
       int32_t content_len;
       if (blosc2_vlmeta_get(src->sc, src->sc->vlmetalayers[i]->name, &content,
@@ -1846,6 +2364,93 @@ int b2nd_copy(b2nd_context_t *ctx, const b2nd_array_t *src, b2nd_array_t **array
 }
 
 
+int b2nd_copy(b2nd_context_t *ctx, const b2nd_array_t *src, b2nd_array_t **array) {
+  return copy_array(ctx, src, B2ND_DEFAULT_RECHUNK_MEMORY, array);
+}
+
+
+int b2nd_rechunk(b2nd_context_t *ctx, const b2nd_array_t *src, int64_t memory_budget,
+                 b2nd_array_t **array) {
+  return copy_array(ctx, src, memory_budget, array);
+}
+
+
+/* Whether the chunks of src can be stored verbatim in sc, i.e. they do not depend on a shared
+ * dictionary other than the one of sc.  Returns 1 if they can, 0 if not or a negative value on errors. */
+static int chunks_share_dict(blosc2_schunk *sc, blosc2_schunk *src) {
+  if (schunk_vlmeta_exists(src, BLOSC2_DICT_VLMETA) < 0) {
+    return 1;
+  }
+  if (schunk_vlmeta_exists(sc, BLOSC2_DICT_VLMETA) < 0) {
+    return 0;
+  }
+  uint8_t *dict;
+  int32_t dict_size;
+  uint8_t *src_dict;
+  int32_t src_dict_size;
+  BLOSC_ERROR(schunk_vlmeta_get(sc, BLOSC2_DICT_VLMETA, &dict, &dict_size));
+  int rc = schunk_vlmeta_get(src, BLOSC2_DICT_VLMETA, &src_dict, &src_dict_size);
+  if (rc < 0) {
+    free(dict);
+    BLOSC_ERROR(rc);
+  }
+  rc = dict_size == src_dict_size && memcmp(dict, src_dict, dict_size) == 0;
+  free(dict);
+  free(src_dict);
+  return rc;
+}
+
+
+/* Grow array to new_shape by appending the first nchunks chunks of src as they are.  Only valid
+ * when those are exactly the trailing chunks of the grown array, in the same order. */
+static int concatenate_append_chunks(b2nd_array_t *array, blosc2_schunk *src, int64_t nchunks,
+                                     const int64_t *new_shape) {
+  // Commit the offsets index of a disk-based frame only once, when that is crash safe (see
+  // blosc2_schunk_append_buffers())
+  blosc2_frame_s *frame = (blosc2_frame_s *) array->sc->frame;
+  bool defer = frame_can_defer_appends(frame) && frame->append_batch == 0;
+  if (defer) {
+    BLOSC_ERROR(frame_set_append_batch(frame, -1));
+  }
+  // As in b2nd_resize(), locked handles see the whole growth at once
+  int64_t rc = frame_write_lock(frame);
+  if (rc < 0) {
+    if (defer) {
+      frame_set_append_batch(frame, 0);
+    }
+    BLOSC_ERROR((int) rc);
+  }
+  for (int64_t nchunk = 0; nchunk < nchunks && rc >= 0; ++nchunk) {
+    bool needs_free;
+    uint8_t *chunk;
+    rc = blosc2_schunk_get_chunk(src, nchunk, &chunk, &needs_free);
+    if (rc >= 0) {
+      // A chunk of our own is handed over to the destination; one owned by src is copied
+      rc = blosc2_schunk_append_chunk(array->sc, chunk, !needs_free);
+    }
+  }
+  if (defer) {
+    int rc2 = frame_set_append_batch(frame, 0);
+    if (rc >= 0 && rc2 < 0) {
+      rc = rc2;
+    }
+  }
+  // The chunks are in place; publish the grown shape last (see extend_shape())
+  if (rc >= 0) {
+    rc = update_shape_struct(array, array->ndim, new_shape, array->chunkshape, array->blockshape);
+  }
+  if (rc >= 0) {
+    rc = publish_shape_meta(array);
+  }
+  frame_write_unlock(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Error appending the chunks of the second array");
+    BLOSC_ERROR((int) rc);
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
 int b2nd_concatenate(b2nd_context_t *ctx, const b2nd_array_t *src1, const b2nd_array_t *src2,
                      int8_t axis, bool copy, b2nd_array_t **array) {
   BLOSC_ERROR_NULL(src1, BLOSC2_ERROR_NULL_POINTER);
@@ -1904,101 +2509,117 @@ int b2nd_concatenate(b2nd_context_t *ctx, const b2nd_array_t *src1, const b2nd_a
     *array = (b2nd_array_t *)src1;
   }
 
-  // Extend the array, we don't need to specify the start in resize, as we are extending the shape from the end
-  BLOSC_ERROR(b2nd_resize(*array, newshape, NULL));
+  int64_t src2_nchunks = src2->sc->nchunks;
 
-  // Copy the data from the second array
-  int64_t start[B2ND_MAX_DIM];
-  int64_t stop[B2ND_MAX_DIM];
+  // The compressed chunks of src2 can be reused verbatim when its chunk grid lines up with the
+  // destination one
+  bool aligned = src1_shape[axis] % (*array)->chunkshape[axis] == 0;
+  for (int8_t i = 0; i < src2->ndim && aligned; ++i) {
+    aligned = src2->chunkshape[i] == (*array)->chunkshape[i] &&
+              src2->blockshape[i] == (*array)->blockshape[i];
+  }
+  if (aligned) {
+    int rc = chunks_share_dict((*array)->sc, src2->sc);
+    BLOSC_ERROR(rc);
+    aligned = rc == 1;
+  }
 
-  // Check if the chunk is aligned with dest chunks, and has the same blockshape
-  bool aligned = true;
-  for (int8_t i = 0; i < src2->ndim; ++i) {
-    if (src1->chunkshape[i] != src2->chunkshape[i] ||
-        src2->blockshape[i] != (*array)->blockshape[i] ||
-        (i == axis && (src1_shape[i]) % (*array)->chunkshape[i] != 0)
-        ) {
-      aligned = false;
-      break;
-        }
+  // If the chunks of src2 also come after the ones of src1 in the destination, just append them
+  bool tail = aligned;
+  for (int8_t i = 0; i < axis && tail; ++i) {
+    tail = (*array)->extshape[i] == (*array)->chunkshape[i];
   }
-  // ...and get the chunk index in the dest array if aligned
-  int64_t chunks_in_array_strides[B2ND_MAX_DIM];
-  // Calculate strides for destination array
-  chunks_in_array_strides[(*array)->ndim - 1] = 1;
-  for (int i = (*array)->ndim - 2; i >= 0; --i) {
-    chunks_in_array_strides[i] = chunks_in_array_strides[i + 1] *
-                                ((*array)->extshape[i + 1] / (*array)->chunkshape[i + 1]);
+  if (tail) {
+    BLOSC_ERROR(concatenate_append_chunks(*array, src2->sc, src2_nchunks, newshape));
+    return BLOSC2_ERROR_SUCCESS;
   }
 
-  // Copy chunk by chunk
-  void *buffer = malloc(src2->sc->typesize * src2->extchunknitems);
-  BLOSC_ERROR_NULL(buffer, BLOSC2_ERROR_MEMORY_ALLOC);
-  for (int64_t nchunk = 0; nchunk < src2->sc->nchunks; ++nchunk) {
-    // Get multidimensional chunk position
-    int64_t nchunk_ndim[B2ND_MAX_DIM] = {0};
-    int64_t chunkshape[B2ND_MAX_DIM] = {0};
-    for (int8_t i = 0; i < src2->ndim; ++i) {
-      chunkshape[i] = src2->chunkshape[i];
+  // Extend the array, we don't need to specify the start in resize, as we are extending the shape from the end
+  BLOSC_ERROR(b2nd_resize(*array, newshape, NULL));
+
+  if (aligned) {
+    int64_t chunks_in_array_strides[B2ND_MAX_DIM];
+    chunks_in_array_strides[(*array)->ndim - 1] = 1;
+    for (int i = (*array)->ndim - 2; i >= 0; --i) {
+      chunks_in_array_strides[i] = chunks_in_array_strides[i + 1] *
+                                   ((*array)->extshape[i + 1] / (*array)->chunkshape[i + 1]);
     }
-    int64_t chunks_in_dim[B2ND_MAX_DIM] = {0};
+    int64_t chunks_in_dim[B2ND_MAX_DIM];
     for (int8_t i = 0; i < src2->ndim; ++i) {
       chunks_in_dim[i] = src2->extshape[i] / src2->chunkshape[i];
     }
-    blosc2_unidim_to_multidim(src2->ndim, chunks_in_dim, nchunk, nchunk_ndim);
-
-    if (aligned) {
-      // Get the uncompressed chunk buffer from the source array
-      bool needs_free = false;
+    for (int64_t nchunk = 0; nchunk < src2_nchunks; ++nchunk) {
+      int64_t nchunk_ndim[B2ND_MAX_DIM];
+      blosc2_unidim_to_multidim(src2->ndim, chunks_in_dim, nchunk, nchunk_ndim);
+      nchunk_ndim[axis] += src1_shape[axis] / (*array)->chunkshape[axis];
+      int64_t nchunk_dest = 0;
+      for (int i = 0; i < src2->ndim; i++) {
+        nchunk_dest += nchunk_ndim[i] * chunks_in_array_strides[i];
+      }
+      bool needs_free;
       uint8_t *chunk;
       int32_t cbytes = blosc2_schunk_get_chunk(src2->sc, nchunk, &chunk, &needs_free);
       if (cbytes < 0) {
         BLOSC_TRACE_ERROR("Error getting chunk from source array");
         BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
       }
-      // Update the chunk in the destination array
-      // We need to free only if needs_free is true or copy is false
-      // bool needs_copy = !needs_free || copy;
-      // BLOSC_ERROR(blosc2_schunk_update_chunk((*array)->sc, nchunk_dest, chunk, needs_copy));
-      // if (needs_free && !copy) {
-      //   free(chunk);
-      // }
-      // TODO: the above makes some tests to crash, so always force a copy; try to optimize this later
-      int64_t nchunk_dest = 0;
-      nchunk_ndim[axis] += src1_shape[axis] / (*array)->chunkshape[axis];
-      for ( int i =0; i< src2->ndim; i++) {
-        nchunk_dest += nchunk_ndim[i] * chunks_in_array_strides[i];
-      }
-      BLOSC_ERROR(blosc2_schunk_update_chunk((*array)->sc, nchunk_dest, chunk, true));
-      if (needs_free) {
-        free(chunk);
+      // A chunk of our own is handed over to the destination; one owned by src2 is copied
+      int64_t rc = blosc2_schunk_update_chunk((*array)->sc, nchunk_dest, chunk, !needs_free);
+      if (rc < 0) {
+        BLOSC_ERROR((int) rc);
       }
     }
-    else {
-
-      // Set positions for each dimension
-      for (int8_t i = 0; i < src2->ndim; ++i) {
-        start[i] = nchunk_ndim[i] * src2->chunkshape[i];
-        stop[i] = start[i] + src2->chunkshape[i];
-        if (stop[i] > src2->shape[i]) {
-          stop[i] = src2->shape[i];  // Handle boundary chunks
-        }
-      }
-      // Load chunk into buffer
-      BLOSC_ERROR(b2nd_get_slice_cbuffer(src2, start, stop, buffer, chunkshape, src2->sc->chunksize));
-
-      // Apply chunk offset only for concatenation axis
-      start[axis] += src1_shape[axis];
-      stop[axis] += src1_shape[axis];
+    return BLOSC2_ERROR_SUCCESS;
+  }
 
-      // Copy the chunk to the correct position
-      BLOSC_ERROR(b2nd_set_slice_cbuffer(buffer, chunkshape,
-                                         src2->sc->typesize * src2->extchunknitems,
-                                         start, stop, *array));
+  // Otherwise, fill every destination chunk overlapping src2 with a single slice from it, so each
+  // one is compressed just once (only the ones straddling src1 have to be decompressed too)
+  int8_t ndim = (*array)->ndim;
+  int64_t chunks_in_dim[B2ND_MAX_DIM];
+  int64_t first_chunk[B2ND_MAX_DIM] = {0};
+  int64_t nchunks = 1;
+  for (int8_t i = 0; i < ndim; ++i) {
+    first_chunk[i] = i == axis ? src1_shape[axis] / (*array)->chunkshape[axis] : 0;
+    chunks_in_dim[i] = (*array)->extshape[i] / (*array)->chunkshape[i] - first_chunk[i];
+    nchunks *= chunks_in_dim[i];
+  }
+  int64_t buffersize = (int64_t) (*array)->sc->typesize * (*array)->chunknitems;
+  void *buffer = malloc(buffersize);
+  BLOSC_ERROR_NULL(buffer, BLOSC2_ERROR_MEMORY_ALLOC);
+  int rc = BLOSC2_ERROR_SUCCESS;
+  for (int64_t nchunk = 0; nchunk < nchunks && rc >= 0; ++nchunk) {
+    int64_t nchunk_ndim[B2ND_MAX_DIM];
+    blosc2_unidim_to_multidim(ndim, chunks_in_dim, nchunk, nchunk_ndim);
+    int64_t start[B2ND_MAX_DIM];
+    int64_t stop[B2ND_MAX_DIM];
+    int64_t src_start[B2ND_MAX_DIM];
+    int64_t src_stop[B2ND_MAX_DIM];
+    int64_t slice_shape[B2ND_MAX_DIM];
+    int64_t slice_nbytes = (*array)->sc->typesize;
+    for (int8_t i = 0; i < ndim; ++i) {
+      start[i] = (nchunk_ndim[i] + first_chunk[i]) * (*array)->chunkshape[i];
+      stop[i] = start[i] + (*array)->chunkshape[i];
+      if (stop[i] > newshape[i]) {
+        stop[i] = newshape[i];
+      }
+      if (i == axis && start[i] < src1_shape[axis]) {
+        start[i] = src1_shape[axis];
+      }
+      src_start[i] = i == axis ? start[i] - src1_shape[axis] : start[i];
+      src_stop[i] = i == axis ? stop[i] - src1_shape[axis] : stop[i];
+      slice_shape[i] = stop[i] - start[i];
+      slice_nbytes *= slice_shape[i];
+    }
+    if (slice_nbytes == 0) {
+      continue;
+    }
+    rc = b2nd_get_slice_cbuffer(src2, src_start, src_stop, buffer, slice_shape, slice_nbytes);
+    if (rc >= 0) {
+      rc = b2nd_set_slice_cbuffer(buffer, slice_shape, slice_nbytes, start, stop, *array);
     }
   }
-
   free(buffer);
+  BLOSC_ERROR(rc);
 
   return BLOSC2_ERROR_SUCCESS;
 }
@@ -2269,12 +2890,12 @@ int b2nd_resize(b2nd_array_t *array, const int64_t *new_shape,
   // For unlocked handles this is a no-op and the data-first/shape-last
   // ordering in extend_shape/shrink_shape keeps readers safe.
   blosc2_frame_s *frame = (blosc2_frame_s *) array->sc->frame;
-  BLOSC_ERROR(frame_lock(frame, true));
+  BLOSC_ERROR(frame_write_lock(frame));
   int rc = shrink_shape(array, shrunk_shape, start);
   if (rc >= 0) {
     rc = extend_shape(array, new_shape, start);
   }
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   BLOSC_ERROR(rc);
 
   return BLOSC2_ERROR_SUCCESS;
@@ -2548,12 +3169,9 @@ int iter_block_copy(b2nd_array_t *array, int8_t ndim,
       for (int i = 0; i < array->ndim; ++i) {
         nblock += block_index[i] * block_chunk_strides[i];
       }
-      b2nd_selection_t **p_block_selection_0 = malloc(array->ndim * sizeof(b2nd_selection_t *));
-      BLOSC_ERROR_NULL(p_block_selection_0, BLOSC2_ERROR_MEMORY_ALLOC);
-      b2nd_selection_t **p_block_selection_1 = malloc(array->ndim * sizeof(b2nd_selection_t *));
-      BLOSC_ERROR_NULL(p_block_selection_1, BLOSC2_ERROR_MEMORY_ALLOC);
-      int64_t *block_selection_size = malloc(array->ndim * sizeof(int64_t));
-      BLOSC_ERROR_NULL(block_selection_size, BLOSC2_ERROR_MEMORY_ALLOC);
+      b2nd_selection_t *p_block_selection_0[B2ND_MAX_DIM];
+      b2nd_selection_t *p_block_selection_1[B2ND_MAX_DIM];
+      int64_t block_selection_size[B2ND_MAX_DIM];
       for (int i = 0; i < array->ndim; ++i) {
         block_selection_size[i] = chunk_selection_1[i] - chunk_selection_0[i];
       }
@@ -2570,9 +3188,6 @@ int iter_block_copy(b2nd_array_t *array, int8_t ndim,
                                          bufferstrides,
                                          get)
       );
-      free(p_block_selection_0);
-      free(p_block_selection_1);
-      free(block_selection_size);
     } else {
       BLOSC_ERROR(iter_block_copy(array, (int8_t) (ndim + 1), chunk_selection_size,
                                   ordered_selection, chunk_selection_0, chunk_selection_1,
@@ -2630,17 +3245,32 @@ int iter_block_maskout(b2nd_array_t *array, int8_t ndim,
 }
 
 
+/* A chunk visited by an orthogonal selection, with the part of the (ordered)
+   selection that falls inside it */
+typedef struct {
+  int64_t nchunk;
+  b2nd_selection_t *selection[B2ND_MAX_DIM];
+  int64_t selection_size[B2ND_MAX_DIM];
+  uint8_t *chunk;  // the (lazy)chunk fetched for the workers, if any
+  int32_t cbytes;
+  bool needs_free;
+  uint8_t *new_chunk;  // the recompressed chunk of a set, committed in order afterwards
+} orthogonal_chunk;
+
+typedef struct {
+  orthogonal_chunk *chunks;
+  int64_t nchunks;
+  int64_t nalloc;
+} orthogonal_plan;
+
+
+/* Collect the chunks visited by the selection, in order */
 int iter_chunk(b2nd_array_t *array, int8_t ndim,
                int64_t *selection_size,
                b2nd_selection_t **ordered_selection,
                b2nd_selection_t **p_ordered_selection_0,
                b2nd_selection_t **p_ordered_selection_1,
-               uint8_t *buffer,
-               int64_t *buffershape,
-               int64_t *bufferstrides,
-               bool get,
-               uint8_t *chunk_data,
-               int32_t chunk_data_nbytes) {
+               orthogonal_plan *plan) {
   p_ordered_selection_0[ndim] = ordered_selection[ndim];
   p_ordered_selection_1[ndim] = ordered_selection[ndim];
   while (p_ordered_selection_1[ndim] - ordered_selection[ndim] < selection_size[ndim]) {
@@ -2665,74 +3295,233 @@ int iter_chunk(b2nd_array_t *array, int8_t ndim,
         nchunk += chunk_index[i] * chunk_array_strides[i];
       }
 
-      int64_t nblocks = array->extchunknitems / array->blocknitems;
-      b2nd_selection_t **p_chunk_selection_0 = malloc(array->ndim * sizeof(b2nd_selection_t *));
-      BLOSC_ERROR_NULL(p_chunk_selection_0, BLOSC2_ERROR_MEMORY_ALLOC);
-      b2nd_selection_t **p_chunk_selection_1 = malloc(array->ndim * sizeof(b2nd_selection_t *));
-      BLOSC_ERROR_NULL(p_chunk_selection_1, BLOSC2_ERROR_MEMORY_ALLOC);
-      int64_t *chunk_selection_size = malloc(array->ndim * sizeof(int64_t));
-      BLOSC_ERROR_NULL(chunk_selection_size, BLOSC2_ERROR_MEMORY_ALLOC);
+      if (plan->nchunks == plan->nalloc) {
+        int64_t nalloc = plan->nalloc == 0 ? 64 : 2 * plan->nalloc;
+        orthogonal_chunk *chunks = realloc(plan->chunks, nalloc * sizeof(orthogonal_chunk));
+        BLOSC_ERROR_NULL(chunks, BLOSC2_ERROR_MEMORY_ALLOC);
+        plan->chunks = chunks;
+        plan->nalloc = nalloc;
+      }
+      orthogonal_chunk *c = &plan->chunks[plan->nchunks++];
+      memset(c, 0, sizeof(orthogonal_chunk));
+      c->nchunk = nchunk;
       for (int i = 0; i < array->ndim; ++i) {
-        chunk_selection_size[i] = p_ordered_selection_1[i] - p_ordered_selection_0[i];
+        c->selection[i] = p_ordered_selection_0[i];
+        c->selection_size[i] = p_ordered_selection_1[i] - p_ordered_selection_0[i];
       }
+    } else {
+      BLOSC_ERROR(iter_chunk(array, (int8_t) (ndim + 1), selection_size,
+                             ordered_selection, p_ordered_selection_0, p_ordered_selection_1, plan));
+    }
 
-      if (get) {
-        bool *maskout = calloc(nblocks, sizeof(bool));
-        for (int i = 0; i < nblocks; ++i) {
-          maskout[i] = true;
-        }
+    p_ordered_selection_0[ndim] = p_ordered_selection_1[ndim];
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
 
-        BLOSC_ERROR(iter_block_maskout(array, (int8_t) 0,
-                                       chunk_selection_size,
-                                       p_ordered_selection_0,
-                                       p_chunk_selection_0,
-                                       p_chunk_selection_1,
-                                       maskout));
 
-        if (blosc2_set_maskout(array->sc->dctx, maskout, (int) nblocks) !=
-            BLOSC2_ERROR_SUCCESS) {
-          BLOSC_TRACE_ERROR("Error setting the maskout");
-          BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+/* Shared state of the threads of orthogonal_selection_chunks() */
+typedef struct {
+  b2nd_array_t *array;
+  uint8_t *buffer;
+  int64_t *buffershape;
+  int64_t *bufferstrides;
+  bool get;
+  int32_t data_nbytes;
+  orthogonal_chunk *chunks;
+  int64_t nchunks;
+  int64_t next_chunk;
+  int error;
+  blosc2_pthread_mutex_t mutex;
+} orthogonal_work;
+
+/* A thread of orthogonal_selection_chunks(), with the scratch it reuses across chunks */
+typedef struct {
+  orthogonal_work *work;
+  blosc2_context *dctx;
+  blosc2_context *cctx;
+  uint8_t *data;
+  bool *maskout;
+} orthogonal_worker;
+
+static int orthogonal_worker_chunk(orthogonal_worker *worker, orthogonal_chunk *c) {
+  orthogonal_work *work = worker->work;
+  b2nd_array_t *array = work->array;
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+  b2nd_selection_t *p_chunk_selection_0[B2ND_MAX_DIM];
+  b2nd_selection_t *p_chunk_selection_1[B2ND_MAX_DIM];
+
+  if (work->get) {
+    memset(worker->maskout, true, nblocks * sizeof(bool));
+    BLOSC_ERROR(iter_block_maskout(array, (int8_t) 0, c->selection_size, c->selection,
+                                   p_chunk_selection_0, p_chunk_selection_1, worker->maskout));
+    if (blosc2_set_maskout(worker->dctx, worker->maskout, nblocks) != BLOSC2_ERROR_SUCCESS) {
+      BLOSC_TRACE_ERROR("Error setting the maskout");
+      BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+    }
+  }
+  int err;
+  if (c->chunk != NULL) {
+    err = blosc2_decompress_ctx(worker->dctx, c->chunk, c->cbytes, worker->data, work->data_nbytes);
+  } else {
+    err = blosc2_schunk_decompress_chunk(array->sc, c->nchunk, worker->data, work->data_nbytes);
+  }
+  if (err < 0) {
+    BLOSC_TRACE_ERROR("Error decompressing chunk");
+    BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+  }
+  BLOSC_ERROR(iter_block_copy(array, 0, c->selection_size, c->selection,
+                              p_chunk_selection_0, p_chunk_selection_1, worker->data,
+                              work->buffer, work->buffershape, work->bufferstrides, work->get));
+
+  if (!work->get) {
+    int32_t chunk_size = work->data_nbytes + BLOSC_EXTENDED_HEADER_LENGTH;
+    uint8_t *chunk = malloc(chunk_size);
+    BLOSC_ERROR_NULL(chunk, BLOSC2_ERROR_MEMORY_ALLOC);
+    err = blosc2_compress_ctx(worker->cctx, worker->data, work->data_nbytes, chunk, chunk_size);
+    if (err < 0) {
+      BLOSC_TRACE_ERROR("Error compressing data");
+      free(chunk);
+      BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+    }
+    c->new_chunk = chunk;
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+static void orthogonal_worker_func(void *arg) {
+  orthogonal_worker *worker = (orthogonal_worker *)arg;
+  orthogonal_work *work = worker->work;
+
+  while (true) {
+    blosc2_pthread_mutex_lock(&work->mutex);
+    int64_t i = work->error < 0 ? work->nchunks : work->next_chunk++;
+    blosc2_pthread_mutex_unlock(&work->mutex);
+    if (i >= work->nchunks) {
+      return;
+    }
+    int rc = orthogonal_worker_chunk(worker, &work->chunks[i]);
+    if (rc < 0) {
+      blosc2_pthread_mutex_lock(&work->mutex);
+      if (work->error == 0) {
+        work->error = rc;
+      }
+      blosc2_pthread_mutex_unlock(&work->mutex);
+      return;
+    }
+  }
+}
+
+
+/* Get (or set) the items of the selection in the chunks of the plan.  When
+   possible, the chunks go one per thread of the shared pool, in batches: the
+   calling thread fetches them and, for sets, commits the updated ones in
+   order, while the threads decompress, copy and recompress them.  Otherwise
+   they are processed in order with the contexts of the super-chunk. */
+static int orthogonal_selection_chunks(b2nd_array_t *array, orthogonal_plan *plan, uint8_t *buffer,
+                                       int64_t *buffershape, int64_t *bufferstrides, bool get,
+                                       int32_t data_nbytes) {
+  blosc2_schunk *sc = array->sc;
+  int16_t nthreads = chunk_parallel_nthreads(array, !get, plan->nchunks);
+  int16_t pool_nthreads = nthreads;
+  int64_t batch_size = nthreads > 1 ? 2 * (int64_t) nthreads : 1;
+  if (nthreads > 1 && batch_size > plan->nchunks) {
+    batch_size = plan->nchunks;
+  }
+  if ((int64_t) nthreads > batch_size) {
+    nthreads = (int16_t) batch_size;
+  }
+  int32_t nblocks = (int32_t) (array->extchunknitems / array->blocknitems);
+
+  orthogonal_work work = {.array = array, .buffer = buffer, .buffershape = buffershape,
+                          .bufferstrides = bufferstrides, .get = get, .data_nbytes = data_nbytes};
+  orthogonal_worker *workers = calloc((size_t) nthreads, sizeof(orthogonal_worker));
+  BLOSC_ERROR_NULL(workers, BLOSC2_ERROR_MEMORY_ALLOC);
+  blosc2_pthread_mutex_init(&work.mutex, NULL);
+
+  int rc = 0;
+  for (int16_t i = 0; i < nthreads; i++) {
+    workers[i].work = &work;
+    workers[i].data = malloc(data_nbytes);
+    workers[i].maskout = malloc(nblocks * sizeof(bool));
+    if (workers[i].data == NULL || workers[i].maskout == NULL) {
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto cleanup;
+    }
+    if (nthreads == 1) {
+      workers[i].dctx = sc->dctx;
+      workers[i].cctx = sc->cctx;
+    } else {
+      rc = create_chunk_worker_ctxs(array, !get, &workers[i].dctx, &workers[i].cctx);
+      if (rc < 0) {
+        goto cleanup;
+      }
+      rc = 0;
+    }
+  }
+
+  for (int64_t first = 0; first < plan->nchunks && rc == 0; first += batch_size) {
+    work.chunks = &plan->chunks[first];
+    work.nchunks = plan->nchunks - first < batch_size ? plan->nchunks - first : batch_size;
+    work.next_chunk = 0;
+    if (nthreads > 1) {
+      for (int64_t i = 0; i < work.nchunks; i++) {
+        orthogonal_chunk *c = &work.chunks[i];
+        c->cbytes = get ? blosc2_schunk_get_lazychunk(sc, c->nchunk, &c->chunk, &c->needs_free) :
+                          blosc2_schunk_get_chunk(sc, c->nchunk, &c->chunk, &c->needs_free);
+        if (c->cbytes < 0) {
+          BLOSC_TRACE_ERROR("Error getting chunk %" PRId64, c->nchunk);
+          rc = c->cbytes;
+          c->chunk = NULL;
+          break;
         }
-        free(maskout);
       }
-      int data_nbytes = chunk_data_nbytes;
-      uint8_t *data = chunk_data;
-      int err = blosc2_schunk_decompress_chunk(array->sc, nchunk, data, data_nbytes);
-      if (err < 0) {
-        BLOSC_TRACE_ERROR("Error decompressing chunk");
-        BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+      if (rc == 0) {
+        rc = blosc2_run_parallel(pool_nthreads, nthreads, orthogonal_worker_func, sizeof(orthogonal_worker), workers);
       }
-      BLOSC_ERROR(iter_block_copy(array, 0, chunk_selection_size,
-                                  p_ordered_selection_0, p_chunk_selection_0, p_chunk_selection_1,
-                                  data, buffer, buffershape, bufferstrides, get));
+    } else {
+      orthogonal_worker_func(&workers[0]);
+    }
+    if (rc == 0) {
+      rc = work.error;
+    }
 
-      if (!get) {
-        int32_t chunk_size = data_nbytes + BLOSC_EXTENDED_HEADER_LENGTH;
-        uint8_t *chunk = malloc(chunk_size);
-        BLOSC_ERROR_NULL(chunk, BLOSC2_ERROR_MEMORY_ALLOC);
-        err = blosc2_compress_ctx(array->sc->cctx, data, data_nbytes, chunk, chunk_size);
-        if (err < 0) {
-          BLOSC_TRACE_ERROR("Error compressing data");
-          BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
-        }
-        err = (int) blosc2_schunk_update_chunk(array->sc, nchunk, chunk, false);
-        if (err < 0) {
+    // Commit the updated chunks in order (the super-chunk owns them afterwards)
+    for (int64_t i = 0; i < work.nchunks; i++) {
+      orthogonal_chunk *c = &work.chunks[i];
+      if (c->needs_free) {
+        free(c->chunk);
+      }
+      c->chunk = NULL;
+      if (rc == 0 && c->new_chunk != NULL) {
+        int64_t brc = blosc2_schunk_update_chunk(sc, c->nchunk, c->new_chunk, false);
+        if (brc < 0) {
           BLOSC_TRACE_ERROR("Error updating chunk");
-          BLOSC_ERROR(BLOSC2_ERROR_FAILURE);
+          rc = BLOSC2_ERROR_FAILURE;
         }
+        c->new_chunk = NULL;
       }
-      free(chunk_selection_size);
-      free(p_chunk_selection_0);
-      free(p_chunk_selection_1);
-    } else {
-      BLOSC_ERROR(iter_chunk(array, (int8_t) (ndim + 1), selection_size,
-                             ordered_selection, p_ordered_selection_0, p_ordered_selection_1,
-                             buffer, buffershape, bufferstrides, get, chunk_data, chunk_data_nbytes));
+      free(c->new_chunk);
+      c->new_chunk = NULL;
     }
+  }
 
-    p_ordered_selection_0[ndim] = p_ordered_selection_1[ndim];
+  cleanup:
+  for (int16_t i = 0; i < nthreads; i++) {
+    if (nthreads > 1) {
+      if (workers[i].dctx != NULL) {
+        blosc2_free_ctx(workers[i].dctx);
+      }
+      if (workers[i].cctx != NULL) {
+        blosc2_free_ctx(workers[i].cctx);
+      }
+    }
+    free(workers[i].data);
+    free(workers[i].maskout);
   }
+  blosc2_pthread_mutex_destroy(&work.mutex);
+  free(workers);
+  BLOSC_ERROR(rc);
   return BLOSC2_ERROR_SUCCESS;
 }
 
@@ -2766,7 +3555,7 @@ int orthogonal_selection(b2nd_array_t *array, int64_t **selection, int64_t *sele
     BLOSC_ERROR(BLOSC2_ERROR_INVALID_PARAM);
   }
 
-  // Size of the reusable chunk buffer allocated further down.  Computed here,
+  // Size of the chunk buffers allocated further down.  Computed here,
   // before any allocation, so the error path has nothing to unwind: the cast
   // used to truncate an int64 product into the malloc size while the copy
   // offsets kept using the full extent (see #795).
@@ -2801,33 +3590,31 @@ int orthogonal_selection(b2nd_array_t *array, int64_t **selection, int64_t *sele
     bufferstrides[i] = bufferstrides[i + 1] * buffershape[i + 1];
   }
 
-  // Pre-allocate a single chunk decompression buffer, reused for every
-  // chunk visited by iter_chunk, instead of malloc/free per chunk.
-  int32_t chunk_data_nbytes = (int32_t) chunk_data_nbytes_64;
-  uint8_t *chunk_data = malloc(chunk_data_nbytes);
-  BLOSC_ERROR_NULL(chunk_data, BLOSC2_ERROR_MEMORY_ALLOC);
-
-  BLOSC_ERROR(iter_chunk(array, 0,
-                         selection_size, ordered_selection,
-                         p_ordered_selection_0,
-                         p_ordered_selection_1,
-                         buffer, buffershape, bufferstrides, get,
-                         chunk_data, chunk_data_nbytes));
-
-  free(chunk_data);
+  // Collect the chunks to visit first, so that they can be processed in parallel
+  orthogonal_plan plan = {0};
+  int rc = iter_chunk(array, 0,
+                      selection_size, ordered_selection,
+                      p_ordered_selection_0,
+                      p_ordered_selection_1,
+                      &plan);
+  if (rc == BLOSC2_ERROR_SUCCESS) {
+    rc = orthogonal_selection_chunks(array, &plan, buffer, buffershape, bufferstrides, get,
+                                     (int32_t) chunk_data_nbytes_64);
+  }
 
   // Free allocated memory
+  free(plan.chunks);
   free(p_ordered_selection_0);
   free(p_ordered_selection_1);
   for (int i = 0; i < ndim; ++i) {
     free(ordered_selection[i]);
   }
   free(ordered_selection);
+  BLOSC_ERROR(rc);
 
   return BLOSC2_ERROR_SUCCESS;
 }
 
-
 int b2nd_get_orthogonal_selection(const b2nd_array_t *array, int64_t **selection, int64_t *selection_size, void *buffer,
                                   int64_t *buffershape, int64_t buffersize) {
   return orthogonal_selection((b2nd_array_t *)array, selection, selection_size, buffer, buffershape, buffersize, true);
@@ -29,9 +29,20 @@
 int blosc2_decompress_block_ctx(blosc2_context* context, const void* src,
                                 int32_t srcsize, int32_t nblock, void* dest,
                                 int32_t destsize);
-int blosc2_run_parallel(int16_t nthreads, void (*dojob)(void *),
+/* Run `njobs` jobs (the one at jobdata + i * jobdata_elsize gets job i) on the shared pool of
+ * `nthreads` threads; pass the nthreads of the context so that every job count reuses its pool. */
+int blosc2_run_parallel(int16_t nthreads, int16_t njobs, void (*dojob)(void *),
                         size_t jobdata_elsize, void *jobdata);
 
+/* The variable-length metalayer keeping the dictionary shared by the chunks of a super-chunk */
+#define BLOSC2_DICT_VLMETA "b2dict"
+
+int load_schunk_dict(blosc2_context* context);
+
+/* Check that a chunk using the dictionary of a super-chunk refers to the one of the super-chunk of
+ * context.  Returns 0 if so (or if the chunk does not use such a dict) or a negative value if not. */
+int check_schunk_dict_chunk(blosc2_context* context, const uint8_t* chunk, int32_t cbytes);
+
 #define to_little(dest, src, itemsize)    endian_handler(true, dest, src, itemsize)
 #define from_little(dest, src, itemsize)  endian_handler(true, dest, src, itemsize)
 #define to_big(dest, src, itemsize)       endian_handler(false, dest, src, itemsize)
@@ -205,6 +216,31 @@ int register_tuner_private(blosc2_tuner *tuner);
 
 int fill_tuner(blosc2_tuner *tuner);
 
+/* Fill the hooks of a tuner shipped with Blosc whose external plugin
+ * cannot be loaded (see plugins/tuners/tuners-registry.c). */
+int fill_builtin_tuner(blosc2_tuner *tuner);
+
+/* A generic job queued on a shared thread pool (see pool_task_submit()) */
+typedef struct blosc_pool_task blosc_pool_task;
+
+/**
+ * @brief Queue dojob(jobdata) on the shared pool with @p nthreads workers,
+ * without waiting for it.
+ *
+ * @return The queued job, to be passed to pool_task_wait(), or NULL when
+ * there is no pool for it (on Windows or with a threads callback); the
+ * caller has to run the job itself then.
+ */
+blosc_pool_task* pool_task_submit(int16_t nthreads, void (*dojob)(void *), void *jobdata);
+
+/**
+ * @brief Wait for a job queued with pool_task_submit() and free it.
+ *
+ * @param cancel Whether a job that no worker has picked up yet is dropped
+ * (otherwise the caller runs it).
+ */
+void pool_task_wait(blosc_pool_task *task, bool cancel);
+
 extern blosc2_tuner g_tuners[256];
 extern int g_ntuners;
 
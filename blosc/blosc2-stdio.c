@@ -275,6 +275,37 @@ int64_t blosc2_stdio_read(void **ptr, int64_t size, int64_t nitems, int64_t posi
   return nitems_;
 }
 
+int64_t blosc2_stdio_readv(const blosc2_io_range *ranges, int64_t nranges, void *stream) {
+  if (stream == NULL || ranges == NULL || nranges < 0) {
+    BLOSC_TRACE_ERROR("Invalid arguments for stdio readv.");
+    return 0;
+  }
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *) stream;
+  if (my_fp->file == NULL) {
+    BLOSC_TRACE_ERROR("Invalid arguments for stdio readv.");
+    return 0;
+  }
+
+  /* Positioned reads do not move any file offset, so there is no seek in between */
+  int64_t nbytes = 0;
+  for (int64_t i = 0; i < nranges; i++) {
+    const blosc2_io_range *range = &ranges[i];
+    if (range->size < 0 || range->position < 0 || (range->size > 0 && range->ptr == NULL) ||
+        (uint64_t)range->size > SIZE_MAX) {
+      BLOSC_TRACE_ERROR("Invalid range for stdio readv.");
+      return nbytes;
+    }
+    int64_t nbytes_ = stdio_pio(my_fp->file, range->ptr, (size_t) range->size, range->position, false);
+    nbytes += nbytes_;
+    if (nbytes_ != range->size) {
+      BLOSC_TRACE_ERROR("Short read at position %" PRId64 ": requested %" PRId64 " bytes, read %" PRId64
+                        " (error: %s).", range->position, range->size, nbytes_, strerror(errno));
+      return nbytes;
+    }
+  }
+  return nbytes;
+}
+
 int blosc2_stdio_truncate(void *stream, int64_t size) {
   if (stream == NULL || size < 0) {
     BLOSC_TRACE_ERROR("Invalid arguments for stdio truncate.");
@@ -299,6 +330,35 @@ int blosc2_stdio_truncate(void *stream, int64_t size) {
   return rc;
 }
 
+int blosc2_stdio_sync(void *stream) {
+  if (stream == NULL) {
+    BLOSC_TRACE_ERROR("Invalid arguments for stdio sync.");
+    return -1;
+  }
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *) stream;
+  if (my_fp->file == NULL) {
+    BLOSC_TRACE_ERROR("Invalid arguments for stdio sync.");
+    return -1;
+  }
+  /* Writes bypass the FILE buffer (see stdio_pio), but be safe */
+  if (fflush(my_fp->file) != 0) {
+    return -1;
+  }
+  int rc;
+#if defined(_WIN32)
+  rc = _commit(_fileno(my_fp->file));
+#elif defined(__linux__)
+  /* The size is synced too when it changed, which is all that reads need */
+  rc = fdatasync(fileno(my_fp->file));
+#else
+  rc = fsync(fileno(my_fp->file));
+#endif
+  if (rc != 0) {
+    BLOSC_TRACE_ERROR("Cannot sync the file to disk (error: %s).", strerror(errno));
+  }
+  return rc;
+}
+
 int blosc2_stdio_destroy(void* params) {
   BLOSC_UNUSED_PARAM(params);
   return 0;
@@ -795,6 +855,47 @@ int64_t blosc2_stdio_mmap_read(void **ptr, int64_t size, int64_t nitems, int64_t
   return nitems;
 }
 
+int blosc2_stdio_mmap_prefetch(const blosc2_io_range *ranges, int64_t nranges, void *stream) {
+  blosc2_stdio_mmap *mmap_file = (blosc2_stdio_mmap *) stream;
+  if (ranges == NULL || nranges < 0 || mmap_file == NULL || mmap_file->addr == NULL) {
+    return 0;
+  }
+
+#if defined(_WIN32)
+  /* Pages of the mapping are faulted in on demand */
+  return 0;
+#else
+  size_t pagesize = (size_t) sysconf(_SC_PAGESIZE);
+  int nhinted = 0;
+  for (int64_t i = 0; i < nranges; i++) {
+    if (ranges[i].position < 0 || ranges[i].size <= 0 ||
+        (uint64_t)ranges[i].position >= mmap_file->file_size) {
+      continue;
+    }
+    size_t start = (size_t)ranges[i].position;
+    size_t end = mmap_file->file_size;
+    if ((uint64_t)ranges[i].size < end - start) {
+      end = start + (size_t)ranges[i].size;
+    }
+    /* madvise() wants page-aligned addresses */
+    size_t start_page = start - start % pagesize;
+    char *addr = mmap_file->addr + start_page;
+    size_t length = end - start_page;
+    /* A hint overlapping the end of the previous one comes from a scan going forward: let the kernel
+       read further ahead and drop the pages behind */
+    if (ranges[i].position > mmap_file->prefetch_start && ranges[i].position <= mmap_file->prefetch_end) {
+      madvise(addr, length, MADV_SEQUENTIAL);
+    }
+    if (madvise(addr, length, MADV_WILLNEED) == 0) {
+      nhinted++;
+    }
+    mmap_file->prefetch_start = ranges[i].position;
+    mmap_file->prefetch_end = (int64_t)end;
+  }
+  return nhinted;
+#endif
+}
+
 int blosc2_stdio_mmap_truncate(void *stream, int64_t size) {
   blosc2_stdio_mmap *mmap_file = (blosc2_stdio_mmap *) stream;
 
@@ -829,6 +930,43 @@ int blosc2_stdio_mmap_truncate(void *stream, int64_t size) {
 #endif
 }
 
+int blosc2_stdio_mmap_sync(void *stream) {
+  blosc2_stdio_mmap *mmap_file = (blosc2_stdio_mmap *) stream;
+  if (mmap_file == NULL || mmap_file->addr == NULL) {
+    BLOSC_TRACE_ERROR("Invalid arguments for memory-mapped sync.");
+    return -1;
+  }
+  /* Nothing goes to disk in c mode, and there is nothing to write in r mode */
+  if (mmap_file->is_memory_only || mmap_file->file_size == 0) {
+    return 0;
+  }
+#if defined(_WIN32)
+  if (mmap_file->access_flags != PAGE_READWRITE) {
+    return 0;
+  }
+  if (!FlushViewOfFile(mmap_file->addr, mmap_file->file_size)) {
+    _print_last_error();
+    BLOSC_TRACE_ERROR("Cannot flush the memory-mapped view to disk.");
+    return -1;
+  }
+  HANDLE file_handle = (HANDLE) _get_osfhandle(mmap_file->fd);
+  if (!FlushFileBuffers(file_handle)) {
+    _print_last_error();
+    BLOSC_TRACE_ERROR("Cannot flush the memory-mapped file to disk.");
+    return -1;
+  }
+#else
+  if (!(mmap_file->access_flags & PROT_WRITE)) {
+    return 0;
+  }
+  if (msync(mmap_file->addr, mmap_file->file_size, MS_SYNC) < 0) {
+    BLOSC_TRACE_ERROR("Cannot sync the memory-mapped file to disk (error: %s).", strerror(errno));
+    return -1;
+  }
+#endif
+  return 0;
+}
+
 int blosc2_stdio_mmap_destroy(void* params) {
   if (params == NULL) {
     BLOSC_TRACE_ERROR("Invalid arguments for memory-mapped destroy.");
@@ -0,0 +1,466 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  Filesystem I/O backend on top of io_uring (#BLOSC2_IO_FILESYSTEM_URING).
+
+  Files are opened, written and truncated just like with the default
+  filesystem backend (the handles are blosc2_stdio_file ones), but reads
+  go through an io_uring owned by the calling thread, so that all the
+  ranges of a vectored read are in flight at the same time, and
+  prefetch hints are queued without waiting for them.  Where io_uring
+  is not available (other platforms, builds with DEACTIVATE_IO_URING,
+  or kernels that refuse to set up a ring) the backend behaves exactly
+  like the default one.
+**********************************************************************/
+
+#if defined(__linux__)
+  /* Must be defined before anything else is included */
+  #define _GNU_SOURCE
+#endif
+
+#include "blosc2/blosc2-stdio.h"
+#include "blosc2.h"
+
+#if defined(USING_CMAKE)
+  #include "config.h"
+#endif /*  USING_CMAKE */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(HAVE_IO_URING)
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <pthread.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #include <linux/io_uring.h>
+#endif
+
+
+#if defined(HAVE_IO_URING)
+
+/* Entries of the submission queue.  The completion one gets twice as many, so
+   that a batch of reads always fits in along with the pending hints. */
+#define URING_ENTRIES 64
+/* The user_data of the prefetch hints, whose completions are just reaped */
+#define URING_HINT UINT64_MAX
+/* Retries of a drain that the kernel turns down for a while (EAGAIN, EBUSY) */
+#define URING_DRAIN_RETRIES 1000
+/* uring_read_batch() returns this when reads may still be in flight */
+#define URING_READS_IN_FLIGHT (-2)
+
+typedef struct {
+  int fd;
+  pid_t pid;  // the process that set up the ring
+  unsigned entries;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  size_t sqes_size;
+  unsigned nhints;  // prefetch hints whose completions are still to be reaped
+} uring;
+
+static pthread_once_t uring_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t uring_key;
+/* Marks the threads that could not set up a ring, so that they do not retry */
+static uring uring_unavailable;
+
+
+static void uring_free(uring *ring) {
+  if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr) {
+    munmap(ring->cq_ptr, ring->cq_size);
+  }
+  if (ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED) {
+    munmap(ring->sq_ptr, ring->sq_size);
+  }
+  if (ring->fd >= 0) {
+    close(ring->fd);
+  }
+  free(ring);
+}
+
+static void uring_destructor(void *ring) {
+  if (ring != &uring_unavailable) {
+    uring_free((uring *)ring);
+  }
+}
+
+static void uring_key_create(void) {
+  pthread_key_create(&uring_key, uring_destructor);
+}
+
+static uring *uring_new(void) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+  if (fd < 0) {
+    BLOSC_TRACE_INFO("Cannot set up an io_uring (%s); using plain reads instead.", strerror(errno));
+    return NULL;
+  }
+  uring *ring = calloc(1, sizeof(uring));
+  if (ring == NULL) {
+    close(fd);
+    return NULL;
+  }
+  ring->fd = fd;
+  ring->pid = getpid();
+  ring->entries = params.sq_entries;
+  ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_size > ring->sq_size) {
+      ring->sq_size = ring->cq_size;
+    }
+    ring->cq_size = ring->sq_size;
+  }
+  ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED) {
+    uring_free(ring);
+    return NULL;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ptr = ring->sq_ptr;
+  }
+  else {
+    ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED) {
+      uring_free(ring);
+      return NULL;
+    }
+  }
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    uring_free(ring);
+    return NULL;
+  }
+  uint8_t *sq = ring->sq_ptr;
+  ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+  uint8_t *cq = ring->cq_ptr;
+  ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+  return ring;
+}
+
+/* The ring of the calling thread, or NULL if there cannot be one */
+static uring *uring_get(void) {
+  pthread_once(&uring_key_once, uring_key_create);
+  uring *ring = pthread_getspecific(uring_key);
+  if (ring != NULL && ring != &uring_unavailable && ring->pid != getpid()) {
+    // A forked child shares the queues with its parent, so it needs a ring of its own
+    uring_free(ring);
+    ring = NULL;
+  }
+  if (ring == NULL) {
+    ring = uring_new();
+    if (ring == NULL) {
+      ring = &uring_unavailable;
+    }
+    pthread_setspecific(uring_key, ring);
+  }
+  return ring != &uring_unavailable ? ring : NULL;
+}
+
+/* Queue a new entry, which is submitted by the next uring_enter() */
+static struct io_uring_sqe *uring_sqe(uring *ring) {
+  unsigned tail = *ring->sq_tail;
+  if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->entries) {
+    return NULL;
+  }
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[index] = index;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  return sqe;
+}
+
+/* Drop the entries queued but not taken by the kernel (it only takes them in io_uring_enter),
+   and return how many they were */
+static unsigned uring_unqueue(uring *ring) {
+  unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  unsigned ndropped = *ring->sq_tail - head;
+  __atomic_store_n(ring->sq_tail, head, __ATOMIC_RELEASE);
+  return ndropped;
+}
+
+static int uring_enter(uring *ring, unsigned nsubmit, unsigned nwait) {
+  unsigned flags = nwait > 0 ? IORING_ENTER_GETEVENTS : 0;
+  while (nsubmit > 0 || nwait > 0) {
+    int rc = (int)syscall(__NR_io_uring_enter, ring->fd, nsubmit, nwait, flags, NULL, 0);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    // The completions we wait for have been counted already
+    nsubmit -= (unsigned)rc < nsubmit ? (unsigned)rc : nsubmit;
+    nwait = 0;
+  }
+  return 0;
+}
+
+/* Reap a completion, if any.  Hints are accounted for here. */
+static bool uring_cqe(uring *ring, uint64_t *user_data, int32_t *res) {
+  unsigned head = *ring->cq_head;
+  if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+  *user_data = cqe->user_data;
+  *res = cqe->res;
+  __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+  if (*user_data == URING_HINT) {
+    ring->nhints--;
+  }
+  return true;
+}
+
+/* Make room for new entries by reaping the completions of past hints */
+static void uring_reap_hints(uring *ring) {
+  uint64_t user_data;
+  int32_t res;
+  while (ring->nhints > 0 && uring_cqe(ring, &user_data, &res)) {
+  }
+}
+
+/* Wait for the completions of the reads still in flight, so that nothing writes to their buffers anymore */
+static int uring_drain(uring *ring, unsigned ninflight) {
+  int nretries = 0;
+  while (ninflight > 0) {
+    uint64_t user_data;
+    int32_t res;
+    if (uring_cqe(ring, &user_data, &res)) {
+      if (user_data != URING_HINT) {
+        ninflight--;
+      }
+      continue;
+    }
+    int rc = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (rc < 0 && errno != EINTR) {
+      if ((errno != EAGAIN && errno != EBUSY) || ++nretries > URING_DRAIN_RETRIES) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Read a batch of (at most ring->entries) ranges, and return the bytes read.  On errors, the ring is
+   dropped and -1 is returned, or URING_READS_IN_FLIGHT if the buffers may still be written to. */
+static int64_t uring_read_batch(uring *ring, const blosc2_io_range *ranges, unsigned nranges, int fd,
+                                void *stream) {
+  // Every entry queued before has been submitted already
+  unsigned first = *ring->sq_tail;
+  for (unsigned i = 0; i < nranges; i++) {
+    struct io_uring_sqe *sqe = uring_sqe(ring);
+    if (sqe == NULL) {
+      // Cannot happen with the room made by the caller, but be safe (nothing has been submitted yet)
+      uring_unqueue(ring);
+      return -1;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)ranges[i].ptr;
+    sqe->len = (uint32_t)ranges[i].size;
+    sqe->off = (uint64_t)ranges[i].position;
+    sqe->user_data = i;
+  }
+
+  int64_t nbytes = 0;
+  unsigned ndone = 0;
+  bool submitted = uring_enter(ring, nranges, nranges) == 0;
+  while (submitted && ndone < nranges) {
+    uint64_t user_data;
+    int32_t res;
+    if (!uring_cqe(ring, &user_data, &res)) {
+      if (uring_enter(ring, 0, 1) < 0) {
+        break;
+      }
+      continue;
+    }
+    if (user_data == URING_HINT) {
+      continue;
+    }
+    ndone++;
+    const blosc2_io_range *range = &ranges[user_data];
+    int64_t res_ = res > 0 ? res : 0;
+    if (res_ < range->size) {
+      // Short reads and errors get a second chance with plain reads, which also report the errors
+      blosc2_io_range rest = {(uint8_t *)range->ptr + res_, range->size - res_, range->position + res_};
+      res_ += blosc2_stdio_readv(&rest, 1, stream);
+    }
+    nbytes += res_;
+  }
+  if (ndone < nranges) {
+    // The ring is in an unknown state, so do not use it anymore in this thread
+    BLOSC_TRACE_ERROR("Error waiting for io_uring completions (%s).", strerror(errno));
+    pthread_setspecific(uring_key, &uring_unavailable);
+    // The reads taken by the kernel may still be writing to their buffers
+    unsigned nsubmitted = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) - first;
+    uring_unqueue(ring);
+    if (uring_drain(ring, nsubmitted - ndone) < 0) {
+      // Leak the ring rather than tearing it down under the reads
+      BLOSC_TRACE_ERROR("Cannot wait for the io_uring reads in flight (%s).", strerror(errno));
+      return URING_READS_IN_FLIGHT;
+    }
+    uring_free(ring);
+    return -1;
+  }
+  return nbytes;
+}
+
+#endif  /* HAVE_IO_URING */
+
+
+void *blosc2_uring_open(const char *urlpath, const char *mode, void *params) {
+  return blosc2_stdio_open(urlpath, mode, params);
+}
+
+int blosc2_uring_close(void *stream) {
+  return blosc2_stdio_close(stream);
+}
+
+int64_t blosc2_uring_size(void *stream) {
+  return blosc2_stdio_size(stream);
+}
+
+int64_t blosc2_uring_write(const void *ptr, int64_t size, int64_t nitems, int64_t position, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, position, stream);
+}
+
+int64_t blosc2_uring_read(void **ptr, int64_t size, int64_t nitems, int64_t position, void *stream) {
+#if defined(HAVE_IO_URING)
+  if (stream != NULL && ptr != NULL && *ptr != NULL && size > 0 && nitems > 0 && position >= 0 &&
+      nitems <= UINT32_MAX / size) {
+    blosc2_io_range range = {*ptr, size * nitems, position};
+    int64_t nbytes = blosc2_uring_readv(&range, 1, stream);
+    return nbytes >= 0 ? nbytes / size : nbytes;
+  }
+#endif
+  // Invalid arguments are reported by the plain read
+  return blosc2_stdio_read(ptr, size, nitems, position, stream);
+}
+
+int64_t blosc2_uring_readv(const blosc2_io_range *ranges, int64_t nranges, void *stream) {
+#if defined(HAVE_IO_URING)
+  uring *ring = uring_get();
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *)stream;
+  bool valid = ring != NULL && my_fp != NULL && my_fp->file != NULL && ranges != NULL && nranges >= 0;
+  for (int64_t i = 0; valid && i < nranges; i++) {
+    valid = ranges[i].ptr != NULL && ranges[i].size > 0 && ranges[i].size <= UINT32_MAX &&
+            ranges[i].position >= 0;
+  }
+  if (valid) {
+    int fd = fileno(my_fp->file);
+    int64_t nbytes = 0;
+    while (nranges > 0) {
+      // The completion queue has room for a full batch on top of the pending hints
+      uring_reap_hints(ring);
+      unsigned nbatch = nranges < ring->entries ? (unsigned)nranges : ring->entries;
+      int64_t nbytes_ = uring_read_batch(ring, ranges, nbatch, fd, stream);
+      if (nbytes_ == URING_READS_IN_FLIGHT) {
+        // Reading into the buffers again would race with the kernel
+        return BLOSC2_ERROR_FILE_READ;
+      }
+      if (nbytes_ < 0) {
+        // Go on with plain reads
+        return nbytes + blosc2_stdio_readv(ranges, nranges, stream);
+      }
+      nbytes += nbytes_;
+      ranges += nbatch;
+      nranges -= nbatch;
+    }
+    return nbytes;
+  }
+#endif
+  return blosc2_stdio_readv(ranges, nranges, stream);
+}
+
+int blosc2_uring_prefetch(const blosc2_io_range *ranges, int64_t nranges, void *stream) {
+#if defined(HAVE_IO_URING)
+  uring *ring = uring_get();
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *)stream;
+  if (ring == NULL || my_fp == NULL || my_fp->file == NULL || ranges == NULL) {
+    return 0;
+  }
+  int fd = fileno(my_fp->file);
+  uring_reap_hints(ring);
+  unsigned nsubmit = 0;
+  // Leave half of the completion queue for the reads
+  for (int64_t i = 0; i < nranges && ring->nhints < ring->entries; i++) {
+    if (ranges[i].size <= 0 || ranges[i].size > UINT32_MAX || ranges[i].position < 0) {
+      continue;
+    }
+    struct io_uring_sqe *sqe = uring_sqe(ring);
+    if (sqe == NULL) {
+      break;
+    }
+    sqe->opcode = IORING_OP_FADVISE;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)ranges[i].position;
+    sqe->len = (uint32_t)ranges[i].size;
+    sqe->fadvise_advice = POSIX_FADV_WILLNEED;
+    sqe->user_data = URING_HINT;
+    ring->nhints++;
+    nsubmit++;
+  }
+  // The kernel holds a reference to the file, so it can be closed before the hints complete
+  if (nsubmit > 0 && uring_enter(ring, nsubmit, 0) < 0) {
+    // The hints that the kernel did not take are not in flight
+    ring->nhints -= uring_unqueue(ring);
+    return 0;
+  }
+  return (int)nsubmit;
+#else
+  BLOSC_UNUSED_PARAM(ranges);
+  BLOSC_UNUSED_PARAM(nranges);
+  BLOSC_UNUSED_PARAM(stream);
+  return 0;
+#endif
+}
+
+int blosc2_uring_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(stream, size);
+}
+
+int blosc2_uring_sync(void *stream) {
+  return blosc2_stdio_sync(stream);
+}
+
+int blosc2_uring_destroy(void *params) {
+  return blosc2_stdio_destroy(params);
+}
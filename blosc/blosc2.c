@@ -91,6 +91,7 @@ static blosc2_filter g_filters[256] = {0};
 static uint64_t g_nfilters = 0;
 
 static blosc2_io_cb g_ios[256] = {0};
+static blosc2_io_cb_ext g_io_exts[256] = {0};  /* the optional callbacks of g_ios */
 static uint64_t g_nio = 0;
 
 blosc2_tuner g_tuners[256] = {0};
@@ -116,8 +117,19 @@ struct blosc_job_group {
   blosc2_pthread_cond_t completion_cv;
 };
 
+/* A batch of generic jobs submitted to a shared pool (see blosc2_run_parallel) */
+struct blosc_task_group {
+  void (*dojob)(void *);
+  int32_t pending;  /* jobs handed to workers and not finished yet */
+  blosc2_pthread_mutex_t mutex;
+  blosc2_pthread_cond_t completion_cv;
+};
+
+/* Pool queue entries carry either a (de)compression job or a generic task */
 struct blosc_job_queue_entry {
   struct blosc_job_group *job;
+  struct blosc_task_group *tasks;
+  void *jobdata;  /* argument for tasks->dojob */
   int32_t logical_tid;
   struct blosc_job_queue_entry *next;
 };
@@ -125,6 +137,7 @@ struct blosc_job_queue_entry {
 struct blosc_shared_pool {
   int16_t nthreads;
   int16_t shutdown;
+  int16_t pinned;  /* kept alive for generic tasks until blosc2_destroy() */
   int32_t context_refs;
   int32_t active_jobs;
   blosc2_pthread_t *threads;
@@ -144,6 +157,11 @@ struct blosc_shared_pool {
 static int init_callback_threads(blosc2_context *context);
 static int release_thread_backend(blosc2_context *context);
 static int attach_shared_pool(blosc2_context *context);
+#if !defined(_WIN32)
+static int run_shared_pool_tasks(int16_t nthreads, int16_t njobs, void (*dojob)(void *),
+                                 size_t jobdata_elsize, void *jobdata);
+static bool in_shared_pool_worker(void);
+#endif
 #if defined(_WIN32)
 static int init_threadpool(blosc2_context *context);
 #endif
@@ -195,22 +213,9 @@ static void *blosc2_parallel_pthread_entry(void *arg) {
   return NULL;
 }
 
-int blosc2_run_parallel(int16_t nthreads, void (*dojob)(void *),
-                        size_t jobdata_elsize, void *jobdata) {
-  if (nthreads <= 0 || dojob == NULL || jobdata == NULL || jobdata_elsize == 0) {
-    return BLOSC2_ERROR_INVALID_PARAM;
-  }
-
-  if (nthreads == 1) {
-    dojob(jobdata);
-    return BLOSC2_ERROR_SUCCESS;
-  }
-
-  if (threads_callback != NULL) {
-    threads_callback(threads_callback_data, dojob, nthreads, jobdata_elsize, jobdata);
-    return BLOSC2_ERROR_SUCCESS;
-  }
-
+/* Run the jobs on threads of their own, created and joined for this call */
+static int run_parallel_threads(int16_t nthreads, void (*dojob)(void *),
+                                size_t jobdata_elsize, void *jobdata) {
   blosc2_pthread_t *threads = malloc((size_t)nthreads * sizeof(blosc2_pthread_t));
   blosc2_parallel_job_data *jobs = malloc((size_t)nthreads * sizeof(blosc2_parallel_job_data));
   if (threads == NULL || jobs == NULL) {
@@ -238,6 +243,35 @@ int blosc2_run_parallel(int16_t nthreads, void (*dojob)(void *),
   return started == nthreads ? BLOSC2_ERROR_SUCCESS : BLOSC2_ERROR_THREAD_CREATE;
 }
 
+int blosc2_run_parallel(int16_t nthreads, int16_t njobs, void (*dojob)(void *),
+                        size_t jobdata_elsize, void *jobdata) {
+  if (nthreads <= 0 || njobs <= 0 || dojob == NULL || jobdata == NULL || jobdata_elsize == 0) {
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  if (nthreads == 1 || njobs == 1) {
+    for (int16_t i = 0; i < njobs; ++i) {
+      dojob((uint8_t *)jobdata + (size_t)i * jobdata_elsize);
+    }
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  if (threads_callback != NULL) {
+    threads_callback(threads_callback_data, dojob, njobs, jobdata_elsize, jobdata);
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+#if !defined(_WIN32)
+  /* Reuse the warm workers of the shared pool with nthreads threads (the one
+     of the contexts with that many); only fall back to fresh threads if the
+     pool cannot be set up */
+  if (run_shared_pool_tasks(nthreads, njobs, dojob, jobdata_elsize, jobdata) == 0) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+#endif
+  return run_parallel_threads(njobs, dojob, jobdata_elsize, jobdata);
+}
+
 
 /* A function for aligned malloc that is portable */
 static uint8_t* my_malloc(size_t size) {
@@ -557,15 +591,21 @@ static int zlib_wrap_decompress(const char* input, size_t compressed_length,
 
 
 #if defined(HAVE_ZSTD)
+/* Map a Blosc clevel into a ZSTD one */
+static int zstd_clevel(int clevel) {
+  clevel = (clevel < 9) ? clevel * 2 - 1 : ZSTD_maxCLevel();
+  /* Make the level 8 close enough to maxCLevel */
+  if (clevel == 8) clevel = ZSTD_maxCLevel() - 2;
+  return clevel;
+}
+
 static int zstd_wrap_compress(struct thread_context* thread_context,
                               const char* input, size_t input_length,
                               char* output, size_t maxout, int clevel) {
   size_t code;
   blosc2_context* context = thread_context->parent_context;
 
-  clevel = (clevel < 9) ? clevel * 2 - 1 : ZSTD_maxCLevel();
-  /* Make the level 8 close enough to maxCLevel */
-  if (clevel == 8) clevel = ZSTD_maxCLevel() - 2;
+  clevel = zstd_clevel(clevel);
 
   if (thread_context->zstd_cctx == NULL) {
     thread_context->zstd_cctx = ZSTD_createCCtx();
@@ -835,7 +875,7 @@ int read_chunk_header(const uint8_t* src, int32_t srcsize, bool extended_header,
     flags_to_filters(header->flags, header->filters);
   }
   if (header->version > BLOSC2_VERSION_FORMAT &&
-      (header->blosc2_flags2 & (uint8_t)~BLOSC2_VL_BLOCKS) != 0) {
+      (header->blosc2_flags2 & (uint8_t)~(BLOSC2_VL_BLOCKS | BLOSC2_SCHUNK_DICT)) != 0) {
     /* Version from future with unsupported chunk features. */
     return BLOSC2_ERROR_VERSION_SUPPORT;
   }
@@ -975,11 +1015,21 @@ int fill_tuner(blosc2_tuner *tuner) {
   char libpath[PATH_MAX] = {0};
   void *lib = load_lib(tuner->name, libpath);
   if(lib == NULL) {
+    // Tuners shipped with Blosc have a built-in version to fall back to
+    if (fill_builtin_tuner(tuner) == BLOSC2_ERROR_SUCCESS) {
+      BLOSC_TRACE_INFO("Using the built-in %s tuner", tuner->name);
+      return BLOSC2_ERROR_SUCCESS;
+    }
     BLOSC_TRACE_ERROR("Error while loading the library");
     return BLOSC2_ERROR_FAILURE;
   }
 
   tuner_info *info = dlsym(lib, "info");
+  if (info == NULL) {
+    BLOSC_TRACE_ERROR("Wrong library loaded");
+    dlclose(lib);
+    return BLOSC2_ERROR_FAILURE;
+  }
   tuner->init = dlsym(lib, info->init);
   tuner->update = dlsym(lib, info->update);
   tuner->next_blocksize = dlsym(lib, info->next_blocksize);
@@ -997,6 +1047,8 @@ int fill_tuner(blosc2_tuner *tuner) {
 }
 
 
+static bool uses_schunk_dict(const blosc2_context* context);
+
 static int blosc2_initialize_header_from_context(blosc2_context* context, blosc_header* header, bool extended_header) {
   int32_t header_blocksize = (int32_t)(context->header_blocksize > 0 ? context->header_blocksize : context->blocksize);
   if ((context->blosc2_flags2 & BLOSC2_VL_BLOCKS) == 0 &&
@@ -1040,6 +1092,11 @@ static int blosc2_initialize_header_from_context(blosc2_context* context, blosc_
     if (context->blosc2_flags & BLOSC2_INSTR_CODEC) {
       header->blosc2_flags |= BLOSC2_INSTR_CODEC;
     }
+    if (uses_schunk_dict(context)) {
+      /* Readers not knowing about the dicts of super-chunks have to turn the chunk down */
+      header->version = BLOSC2_VERSION_FORMAT_SCHUNK_DICT;
+      header->blosc2_flags2 |= BLOSC2_SCHUNK_DICT;
+    }
   }
 
   return 0;
@@ -1780,10 +1837,8 @@ static int blosc_d(
       BLOSC_TRACE_ERROR("Lazy trailer exceeds source buffer.");
       return BLOSC2_ERROR_READ_BUFFER;
     }
-    int32_t nchunk;
     int64_t chunk_offset;
-    // The nchunk and the offset of the current chunk are in the trailer
-    memcpy(&nchunk, src + trailer_offset, sizeof(nchunk));
+    // The offset of the current chunk is in the trailer, after its nchunk
     memcpy(&chunk_offset, src + trailer_offset + sizeof(int32_t), sizeof(chunk_offset));
     // Get the csize of the nblock
     if (nblock < 0 || nblock >= context->nblocks) {
@@ -1801,62 +1856,68 @@ static int blosc_d(
       BLOSC_TRACE_ERROR("Lazy VL block compressed size is too small.");
       return BLOSC2_ERROR_INVALID_HEADER;
     }
-    // Read the lazy block on disk
-    void* fp = NULL;
-    blosc2_io_cb *io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
-    if (io_cb == NULL) {
-      BLOSC_TRACE_ERROR("Error getting the input/output API");
-      return BLOSC2_ERROR_PLUGIN_IO;
-    }
-
-    int64_t io_pos = 0;
-    if (frame->sframe) {
-      // The chunk is not in the frame
-      fp = sframe_open_chunk(frame->urlpath, nchunk, "rb", context->schunk->storage->io);
-      BLOSC_ERROR_NULL(fp, BLOSC2_ERROR_FILE_OPEN);
-      // The offset of the block is src_offset
-      if (src_offset < 0) {
-        frame_reader_release(frame, io_cb, fp);
-        BLOSC_TRACE_ERROR("Lazy block offset cannot be negative.");
-        return BLOSC2_ERROR_INVALID_HEADER;
-      }
-      io_pos = src_offset;
+    if (context->lazy_blocks_ready && context->lazy_block_offsets[nblock] >= 0) {
+      // The block has already been read by prefetch_lazy_blocks()
+      src = context->lazy_blocks + context->lazy_block_offsets[nblock];
     }
     else {
-      fp = frame_reader_acquire(frame, context->schunk->storage->io);
-      BLOSC_ERROR_NULL(fp, BLOSC2_ERROR_FILE_OPEN);
-      // The offset of the block is src_offset
-      if (src_offset < 0) {
-        frame_reader_release(frame, io_cb, fp);
-        BLOSC_TRACE_ERROR("Lazy block offset cannot be negative.");
-        return BLOSC2_ERROR_INVALID_HEADER;
+      // Read the lazy block on disk
+      void* fp = NULL;
+      blosc2_io_cb *io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
+      if (io_cb == NULL) {
+        BLOSC_TRACE_ERROR("Error getting the input/output API");
+        return BLOSC2_ERROR_PLUGIN_IO;
       }
-      if (chunk_offset < 0) {
-        frame_reader_release(frame, io_cb, fp);
-        BLOSC_TRACE_ERROR("Lazy chunk offset cannot be negative.");
-        return BLOSC2_ERROR_INVALID_HEADER;
+
+      int64_t io_pos = 0;
+      if (frame->sframe) {
+        // The chunk is not in the frame
+        fp = sframe_acquire_chunk(frame, chunk_offset, context->schunk->storage->io, &io_pos);
+        BLOSC_ERROR_NULL(fp, BLOSC2_ERROR_FILE_OPEN);
+        // The offset of the block is src_offset
+        if (src_offset < 0) {
+          frame_reader_release(frame, io_cb, fp);
+          BLOSC_TRACE_ERROR("Lazy block offset cannot be negative.");
+          return BLOSC2_ERROR_INVALID_HEADER;
+        }
+        io_pos += src_offset;
       }
-      if (frame->file_offset > INT64_MAX - chunk_offset) {
-        frame_reader_release(frame, io_cb, fp);
-        BLOSC_TRACE_ERROR("Lazy chunk offset overflows file position.");
-        return BLOSC2_ERROR_INVALID_HEADER;
+      else {
+        fp = frame_reader_acquire(frame, context->schunk->storage->io);
+        BLOSC_ERROR_NULL(fp, BLOSC2_ERROR_FILE_OPEN);
+        // The offset of the block is src_offset
+        if (src_offset < 0) {
+          frame_reader_release(frame, io_cb, fp);
+          BLOSC_TRACE_ERROR("Lazy block offset cannot be negative.");
+          return BLOSC2_ERROR_INVALID_HEADER;
+        }
+        if (chunk_offset < 0) {
+          frame_reader_release(frame, io_cb, fp);
+          BLOSC_TRACE_ERROR("Lazy chunk offset cannot be negative.");
+          return BLOSC2_ERROR_INVALID_HEADER;
+        }
+        if (frame->file_offset > INT64_MAX - chunk_offset) {
+          frame_reader_release(frame, io_cb, fp);
+          BLOSC_TRACE_ERROR("Lazy chunk offset overflows file position.");
+          return BLOSC2_ERROR_INVALID_HEADER;
+        }
+        io_pos = frame->file_offset + chunk_offset;
+        if (io_pos > INT64_MAX - src_offset) {
+          frame_reader_release(frame, io_cb, fp);
+          BLOSC_TRACE_ERROR("Lazy block offset overflows file position.");
+          return BLOSC2_ERROR_INVALID_HEADER;
+        }
+        io_pos += src_offset;
       }
-      io_pos = frame->file_offset + chunk_offset;
-      if (io_pos > INT64_MAX - src_offset) {
-        frame_reader_release(frame, io_cb, fp);
-        BLOSC_TRACE_ERROR("Lazy block offset overflows file position.");
-        return BLOSC2_ERROR_INVALID_HEADER;
+      // We can make use of tmp3 because it will be used after src is not needed anymore
+      int64_t rbytes = io_cb->read((void**)&tmp3, 1, block_csize, io_pos, fp);
+      frame_reader_release(frame, io_cb, fp);
+      if ((int32_t)rbytes != block_csize) {
+        BLOSC_TRACE_ERROR("Cannot read the (lazy) block out of the fileframe.");
+        return BLOSC2_ERROR_READ_BUFFER;
       }
-      io_pos += src_offset;
-    }
-    // We can make use of tmp3 because it will be used after src is not needed anymore
-    int64_t rbytes = io_cb->read((void**)&tmp3, 1, block_csize, io_pos, fp);
-    frame_reader_release(frame, io_cb, fp);
-    if ((int32_t)rbytes != block_csize) {
-      BLOSC_TRACE_ERROR("Cannot read the (lazy) block out of the fileframe.");
-      return BLOSC2_ERROR_READ_BUFFER;
+      src = tmp3;
     }
-    src = tmp3;
     src_offset = 0;
     srcsize = block_csize;
   }
@@ -2359,10 +2420,17 @@ static int do_job(blosc2_context* context) {
      The failed pool creation already emitted a TRACE_ERROR, and the next
      do_job() re-attempts the attach, so the fallback is self-healing. */
   int rc = check_nthreads(context);
+  bool nested = false;
+#if !defined(_WIN32)
+  /* A pool worker (e.g. running a blosc2_run_parallel() job) that waited for
+     pool workers could deadlock the pool; do the work inline instead */
+  nested = context->thread_backend == BLOSC_BACKEND_SHARED_POOL && in_shared_pool_worker();
+#endif
 
   /* Run the serial version when nthreads is 1, when the buffers are not larger
-     than blocksize, or when the parallel backend failed to start */
-  if (context->nthreads == 1 || (context->sourcesize / context->blocksize) <= 1 || rc < 0) {
+     than blocksize, when the parallel backend failed to start, or when nested
+     in a shared pool worker */
+  if (context->nthreads == 1 || (context->sourcesize / context->blocksize) <= 1 || rc < 0 || nested) {
     /* The context for this 'thread' has no been initialized yet */
     if (context->serial_context == NULL) {
       context->serial_context = create_thread_context(context, 0);
@@ -2382,6 +2450,17 @@ static int do_job(blosc2_context* context) {
 }
 
 
+/* Give the per-block sizes of a previous VL-block chunk back to the scratch arena */
+static void release_vl_block_sizes(blosc2_context* context) {
+  scratch_release(&context->scratch, context->blocknbytes);
+  scratch_release(&context->scratch, context->blockoffsets);
+  scratch_release(&context->scratch, context->blockcbytes);
+  context->blocknbytes = NULL;
+  context->blockoffsets = NULL;
+  context->blockcbytes = NULL;
+}
+
+
 static int initialize_context_compression(
         blosc2_context* context, const void* src, int32_t srcsize, void* dest,
         int32_t destsize, int clevel, uint8_t const *filters,
@@ -2415,18 +2494,7 @@ static int initialize_context_compression(
   context->splitmode = splitmode;
   context->header_blocksize = (int32_t)blocksize;
   context->blosc2_flags2 = 0;
-  if (context->blocknbytes != NULL) {
-    free(context->blocknbytes);
-    context->blocknbytes = NULL;
-  }
-  if (context->blockoffsets != NULL) {
-    free(context->blockoffsets);
-    context->blockoffsets = NULL;
-  }
-  if (context->blockcbytes != NULL) {
-    free(context->blockcbytes);
-    context->blockcbytes = NULL;
-  }
+  release_vl_block_sizes(context);
   context->vlblock_sources = NULL;
   context->vlblock_dests = NULL;
   /* tuner some compression parameters */
@@ -2551,70 +2619,270 @@ static void clear_context_decompression_dict(blosc2_context* context) {
   context->use_dict = 0;
   release_context_dict_buffer(context);
 #if defined(HAVE_ZSTD)
-  if (context->dict_ddict != NULL) {
+  // The digested dict of the super-chunk is kept for the next chunks
+  if (context->dict_ddict != NULL && context->dict_ddict != context->schunk_ddict) {
     ZSTD_freeDDict(context->dict_ddict);
-    context->dict_ddict = NULL;
   }
-#else
+#endif
   context->dict_ddict = NULL;
+}
+
+
+/* The checksum (FNV-1a) identifying the dictionary of a super-chunk in the chunks using it */
+static uint32_t schunk_dict_checksum(const uint8_t* dict, int32_t dict_size) {
+  uint32_t hash = 2166136261u;
+  for (int32_t i = 0; i < dict_size; i++) {
+    hash = (hash ^ dict[i]) * 16777619u;
+  }
+  return hash;
+}
+
+
+/* Load the dictionary shared by the chunks of the associated super-chunk.
+ * Returns 1 if loaded, 0 if the super-chunk does not have one (yet) or a negative value on errors. */
+int load_schunk_dict(blosc2_context* context) {
+  if (context->schunk_dict != NULL) {
+    return 1;
+  }
+  context->schunk_dict_checked = true;
+  if (context->schunk == NULL) {
+    return 0;
+  }
+  int rc = schunk_vlmeta_exists(context->schunk, BLOSC2_DICT_VLMETA);
+  if (rc == BLOSC2_ERROR_NOT_FOUND) {
+    return 0;
+  }
+  if (rc < 0) {
+    return rc;
+  }
+  uint8_t* dict;
+  int32_t dict_size;
+  rc = schunk_vlmeta_get(context->schunk, BLOSC2_DICT_VLMETA, &dict, &dict_size);
+  if (rc < 0) {
+    return rc;
+  }
+  if (dict_size <= 0 || dict_size > BLOSC2_MAXDICTSIZE) {
+    BLOSC_TRACE_ERROR("Dictionary of the super-chunk has a wrong size (%d).", dict_size);
+    free(dict);
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  context->schunk_dict = dict;
+  context->schunk_dict_size = dict_size;
+  context->schunk_dict_id = schunk_dict_checksum(dict, dict_size);
+  return 1;
+}
+
+
+static void free_schunk_cdict(blosc2_context* context) {
+  if (context->schunk_cdict == NULL) {
+    return;
+  }
+  if (context->schunk_cdict_compcode == BLOSC_LZ4) {
+    LZ4_freeStream((LZ4_stream_t*)context->schunk_cdict);
+  } else if (context->schunk_cdict_compcode == BLOSC_LZ4HC) {
+    LZ4_freeStreamHC((LZ4_streamHC_t*)context->schunk_cdict);
+  }
+#ifdef HAVE_ZSTD
+  else if (context->schunk_cdict_compcode == BLOSC_ZSTD) {
+    ZSTD_freeCDict(context->schunk_cdict);
+  }
 #endif
+  context->schunk_cdict = NULL;
 }
 
 
-static int read_lazy_chunk_bytes(blosc2_context* context, int32_t offset, uint8_t* buffer, int32_t nbytes,
-                                 const char* open_error, const char* read_error) {
+/* Set up the dictionary of the super-chunk (digesting it only once) for compressing the next chunk.
+ * Returns 1 if set up, 0 if there is no such a dictionary or a negative value on errors. */
+static int use_schunk_cdict(blosc2_context* context) {
+  if (context->schunk_dict == NULL) {
+    // Other than our own training, a dictionary only comes from an existing super-chunk
+    if (context->schunk_dict_checked) {
+      return 0;
+    }
+    int rc = load_schunk_dict(context);
+    if (rc <= 0) {
+      return rc;
+    }
+  }
+  if (context->schunk_cdict != NULL && context->schunk_cdict_compcode != context->compcode) {
+    free_schunk_cdict(context);
+  }
+  if (context->schunk_cdict == NULL) {
+    if (context->compcode == BLOSC_LZ4) {
+      LZ4_stream_t* lz4_cdict = LZ4_createStream();
+      if (lz4_cdict != NULL) {
+        LZ4_loadDict(lz4_cdict, (const char*)context->schunk_dict, context->schunk_dict_size);
+      }
+      context->schunk_cdict = lz4_cdict;
+    } else if (context->compcode == BLOSC_LZ4HC) {
+      LZ4_streamHC_t* lz4hc_cdict = LZ4_createStreamHC();
+      if (lz4hc_cdict != NULL) {
+        LZ4_loadDictHC(lz4hc_cdict, (const char*)context->schunk_dict, context->schunk_dict_size);
+      }
+      context->schunk_cdict = lz4hc_cdict;
+    }
+#ifdef HAVE_ZSTD
+    else if (context->compcode == BLOSC_ZSTD) {
+      context->schunk_cdict = ZSTD_createCDict(context->schunk_dict, (size_t)context->schunk_dict_size,
+                                               zstd_clevel(context->clevel));
+    }
+#endif
+    else {
+      return 0;
+    }
+    if (context->schunk_cdict == NULL) {
+      BLOSC_TRACE_ERROR("Cannot digest the dictionary of the super-chunk.");
+      return BLOSC2_ERROR_CODEC_DICT;
+    }
+    context->schunk_cdict_compcode = context->compcode;
+  }
+  context->dict_buffer = context->schunk_dict;
+  context->dict_buffer_owned = false;
+  context->dict_size = context->schunk_dict_size;
+  context->dict_cdict = context->schunk_cdict;
+  return 1;
+}
+
+
+/* Set up the dictionary of the super-chunk (digesting it only once) for decompressing a chunk
+ * that references it by dict_id */
+static int use_schunk_ddict(blosc2_context* context, uint32_t dict_id) {
+  int rc = load_schunk_dict(context);
+  if (rc < 0) {
+    return rc;
+  }
+  if (rc == 0) {
+    BLOSC_TRACE_ERROR("Chunk needs the dictionary of its super-chunk, but there is none"
+                      " (decompress it through its super-chunk).");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  if (context->schunk_dict_id != dict_id) {
+    BLOSC_TRACE_ERROR("Chunk was compressed with the dictionary of another super-chunk.");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+#if defined(HAVE_ZSTD)
+  if (context->compcode == BLOSC_ZSTD_FORMAT) {
+    if (context->schunk_ddict == NULL) {
+      context->schunk_ddict = ZSTD_createDDict(context->schunk_dict, (size_t)context->schunk_dict_size);
+      if (context->schunk_ddict == NULL) {
+        BLOSC_TRACE_ERROR("Cannot create ZSTD dictionary for the super-chunk.");
+        return BLOSC2_ERROR_CODEC_DICT;
+      }
+    }
+    context->dict_ddict = context->schunk_ddict;
+  }
+#endif
+  context->use_dict = 1;
+  context->dict_buffer = context->schunk_dict;
+  context->dict_buffer_owned = false;
+  context->dict_size = context->schunk_dict_size;
+  return 0;
+}
+
+
+static bool uses_schunk_dict(const blosc2_context* context) {
+  return context->use_dict && context->dict_cdict != NULL && context->dict_cdict == context->schunk_cdict;
+}
+
+
+/* Chunks without a dict section (memcpyed or special) do not use the dictionary of the super-chunk */
+static void clear_schunk_dict_flags(uint8_t* dest) {
+  dest[BLOSC2_CHUNK_BLOSC2_FLAGS] &= ~(uint8_t)BLOSC2_USEDICT;
+  dest[BLOSC2_CHUNK_BLOSC2_FLAGS2] &= ~(uint8_t)BLOSC2_SCHUNK_DICT;
+  dest[BLOSC2_CHUNK_VERSION] = BLOSC2_VERSION_FORMAT_STABLE;
+}
+
+
+int check_schunk_dict_chunk(blosc2_context* context, const uint8_t* chunk, int32_t cbytes) {
+  blosc_header header;
+  int rc = read_chunk_header(chunk, cbytes, true, &header);
+  if (rc < 0) {
+    return rc;
+  }
+  if ((header.blosc2_flags2 & BLOSC2_SCHUNK_DICT) == 0 || (header.blosc2_flags & 0x08)) {
+    // Lazy chunks come from the super-chunk itself
+    return 0;
+  }
+  int32_t nblocks = header.nbytes / header.blocksize + (header.nbytes % header.blocksize > 0);
+  int64_t dict_offset = BLOSC_EXTENDED_HEADER_LENGTH + (int64_t)nblocks * (int64_t)sizeof(int32_t);
+  if (dict_offset + 2 * (int64_t)sizeof(int32_t) > cbytes) {
+    BLOSC_TRACE_ERROR("Dictionary section exceeds chunk length.");
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  rc = load_schunk_dict(context);
+  if (rc < 0) {
+    return rc;
+  }
+  if (rc == 0 || context->schunk_dict_id != (uint32_t)sw32_(chunk + dict_offset + sizeof(int32_t))) {
+    BLOSC_TRACE_ERROR("Chunk uses the dictionary of another super-chunk.");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  return 0;
+}
+
+
+/* Open the file where the lazy chunk in context->src lives, and get the position of the chunk there */
+static int open_lazy_chunk(blosc2_context* context, blosc2_io_cb** io_cb, void** fp, int64_t* chunk_pos) {
   if (context->schunk == NULL || context->schunk->frame == NULL) {
     BLOSC_TRACE_ERROR("Lazy chunk needs an associated super-chunk with a frame.");
     return BLOSC2_ERROR_INVALID_PARAM;
   }
 
   blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
-  blosc2_io_cb* io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
-  if (io_cb == NULL) {
+  *io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
+  if (*io_cb == NULL) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
     return BLOSC2_ERROR_PLUGIN_IO;
   }
 
   int32_t trailer_offset = BLOSC_EXTENDED_HEADER_LENGTH +
                            context->nblocks * (int32_t)sizeof(int32_t);
-  int32_t nchunk_lazy;
   int64_t chunk_offset;
-  memcpy(&nchunk_lazy, context->src + trailer_offset, sizeof(nchunk_lazy));
   memcpy(&chunk_offset, context->src + trailer_offset + (int32_t)sizeof(int32_t), sizeof(chunk_offset));
 
-  void* fp = NULL;
-  int64_t io_pos;
   if (frame->sframe) {
-    fp = sframe_open_chunk(frame->urlpath, nchunk_lazy, "rb", context->schunk->storage->io);
-    io_pos = offset;
+    *fp = sframe_acquire_chunk(frame, chunk_offset, context->schunk->storage->io, chunk_pos);
   }
   else {
-    if (chunk_offset < 0 || offset < 0) {
+    if (chunk_offset < 0) {
       BLOSC_TRACE_ERROR("Lazy chunk offset cannot be negative.");
       return BLOSC2_ERROR_INVALID_HEADER;
     }
-    fp = frame_reader_acquire(frame, context->schunk->storage->io);
     if (frame->file_offset > INT64_MAX - chunk_offset) {
       BLOSC_TRACE_ERROR("Lazy chunk offset overflows file position.");
-      if (fp != NULL) {
-        frame_reader_release(frame, io_cb, fp);
-      }
       return BLOSC2_ERROR_INVALID_HEADER;
     }
-    io_pos = frame->file_offset + chunk_offset;
-    if (io_pos > INT64_MAX - offset) {
-      BLOSC_TRACE_ERROR("Lazy block offset overflows file position.");
-      if (fp != NULL) {
-        frame_reader_release(frame, io_cb, fp);
-      }
-      return BLOSC2_ERROR_INVALID_HEADER;
-    }
-    io_pos += offset;
+    *fp = frame_reader_acquire(frame, context->schunk->storage->io);
+    *chunk_pos = frame->file_offset + chunk_offset;
+  }
+  return 0;
+}
+
+
+static int read_lazy_chunk_bytes(blosc2_context* context, int32_t offset, uint8_t* buffer, int32_t nbytes,
+                                 const char* open_error, const char* read_error) {
+  blosc2_io_cb* io_cb;
+  void* fp = NULL;
+  int64_t io_pos;
+  if (offset < 0) {
+    BLOSC_TRACE_ERROR("Lazy chunk offset cannot be negative.");
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  int rc = open_lazy_chunk(context, &io_cb, &fp, &io_pos);
+  if (rc < 0) {
+    return rc;
   }
   if (fp == NULL) {
     BLOSC_TRACE_ERROR("%s", open_error);
     return BLOSC2_ERROR_FILE_OPEN;
   }
+  blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
+  if (io_pos > INT64_MAX - offset) {
+    BLOSC_TRACE_ERROR("Lazy block offset overflows file position.");
+    frame_reader_release(frame, io_cb, fp);
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  io_pos += offset;
 
   uint8_t* read_buffer = buffer;
   int64_t rbytes = io_cb->read((void**)&read_buffer, 1, nbytes, io_pos, fp);
@@ -2632,6 +2900,178 @@ static int read_lazy_chunk_bytes(blosc2_context* context, int32_t offset, uint8_
 }
 
 
+/* Blocks of a lazy chunk that are closer than this on disk are read together */
+#define LAZY_BLOCKS_MAX_GAP (4 * 1024)
+
+typedef struct {
+  int32_t offset;
+  int32_t csize;
+  int32_t nblock;
+} lazy_block;
+
+static int compare_lazy_blocks(const void* a, const void* b) {
+  int32_t offset_a = ((const lazy_block*)a)->offset;
+  int32_t offset_b = ((const lazy_block*)b)->offset;
+  return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+/* Read all the blocks of a lazy chunk that are going to be decompressed in
+   one go, merging the ones that are close on disk into a single range.  The
+   ranges go to the readv() hook of the io backend in a single call, and
+   blosc_d() picks the blocks from context->lazy_blocks afterwards.  Chunks
+   that do not qualify are left alone, so that blosc_d() reads (and checks)
+   their blocks one by one as usual. */
+static int prefetch_lazy_blocks(blosc2_context* context) {
+  context->lazy_blocks_ready = false;
+  bool is_lazy = ((context->header_overhead == BLOSC_EXTENDED_HEADER_LENGTH) &&
+                  (context->blosc2_flags & 0x08u) && !context->special_type);
+  bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
+  if (!is_lazy || memcpyed || context->nblocks < 2 ||
+      context->schunk == NULL || context->schunk->frame == NULL) {
+    return 0;
+  }
+  blosc2_io_cb* io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
+  if (io_cb == NULL || !io_cb->is_allocation_necessary) {
+    // Backends that hand out their own memory (e.g. mmap) do not need this
+    return 0;
+  }
+  int32_t trailer_offset = BLOSC_EXTENDED_HEADER_LENGTH + context->nblocks * (int32_t)sizeof(int32_t);
+  int32_t csizes_offset = trailer_offset + (int32_t)(sizeof(int32_t) + sizeof(int64_t));
+  if (context->srcsize < csizes_offset + context->nblocks * (int32_t)sizeof(int32_t)) {
+    return 0;
+  }
+
+  lazy_block* blocks = scratch_alloc(&context->scratch, context->nblocks * sizeof(lazy_block));
+  BLOSC_ERROR_NULL(blocks, BLOSC2_ERROR_MEMORY_ALLOC);
+  int32_t max_lazy_block_csize = context->blocksize + context->typesize * (signed)sizeof(int32_t);
+  int32_t nneeded = 0;
+  for (int32_t nblock = 0; nblock < context->nblocks; nblock++) {
+    if (context->block_maskout != NULL && context->block_maskout[nblock]) {
+      continue;
+    }
+    int32_t offset = sw32_(context->bstarts + nblock);
+    int32_t csize = sw32_(context->src + csizes_offset + nblock * (int32_t)sizeof(int32_t));
+    if (offset < 0 || csize <= 0 || csize > max_lazy_block_csize || offset > INT32_MAX - csize) {
+      // Let blosc_d() complain about it
+      scratch_release(&context->scratch, blocks);
+      return 0;
+    }
+    blocks[nneeded].offset = offset;
+    blocks[nneeded].csize = csize;
+    blocks[nneeded].nblock = nblock;
+    nneeded++;
+  }
+  if (nneeded < 2) {
+    scratch_release(&context->scratch, blocks);
+    return 0;
+  }
+  qsort(blocks, (size_t)nneeded, sizeof(lazy_block), compare_lazy_blocks);
+
+  // Merge the blocks into ranges, and lay them out in lazy_blocks
+  blosc2_io_range* ranges = scratch_alloc(&context->scratch, nneeded * sizeof(blosc2_io_range));
+  if (ranges == NULL) {
+    scratch_release(&context->scratch, blocks);
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  if (context->lazy_block_noffsets < context->nblocks) {
+    free(context->lazy_block_offsets);
+    context->lazy_block_offsets = malloc(context->nblocks * sizeof(int32_t));
+    context->lazy_block_noffsets = context->lazy_block_offsets != NULL ? context->nblocks : 0;
+  }
+  if (context->lazy_block_offsets == NULL) {
+    scratch_release(&context->scratch, blocks);
+    scratch_release(&context->scratch, ranges);
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  for (int32_t nblock = 0; nblock < context->nblocks; nblock++) {
+    context->lazy_block_offsets[nblock] = -1;
+  }
+  int64_t nranges = 0;
+  int64_t nbytes = 0;
+  int32_t range_start = 0;
+  int32_t range_end = 0;
+  for (int32_t i = 0; i < nneeded; i++) {
+    lazy_block* block = &blocks[i];
+    if (i == 0 || block->offset - range_end > LAZY_BLOCKS_MAX_GAP) {
+      if (i > 0) {
+        ranges[nranges].size = range_end - range_start;
+        nbytes += ranges[nranges].size;
+        nranges++;
+      }
+      ranges[nranges].position = block->offset;
+      range_start = block->offset;
+      range_end = block->offset;
+    }
+    context->lazy_block_offsets[block->nblock] = (int32_t)(nbytes + block->offset - range_start);
+    if (block->offset + block->csize > range_end) {
+      range_end = block->offset + block->csize;
+    }
+  }
+  ranges[nranges].size = range_end - range_start;
+  nbytes += ranges[nranges].size;
+  nranges++;
+  scratch_release(&context->scratch, blocks);
+  if (nbytes > INT32_MAX) {
+    scratch_release(&context->scratch, ranges);
+    return 0;
+  }
+  if (context->lazy_blocks_size < (size_t)nbytes) {
+    free(context->lazy_blocks);
+    context->lazy_blocks = malloc((size_t)nbytes);
+    context->lazy_blocks_size = context->lazy_blocks != NULL ? (size_t)nbytes : 0;
+  }
+  if (context->lazy_blocks == NULL) {
+    scratch_release(&context->scratch, ranges);
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+
+  // The ranges are laid out one after the other in lazy_blocks
+  blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
+  void* fp = NULL;
+  int64_t chunk_pos;
+  int rc = open_lazy_chunk(context, &io_cb, &fp, &chunk_pos);
+  if (rc < 0 || fp == NULL) {
+    // Let blosc_d() complain about it
+    scratch_release(&context->scratch, ranges);
+    return 0;
+  }
+  uint8_t* ptr = context->lazy_blocks;
+  for (int64_t i = 0; i < nranges; i++) {
+    ranges[i].ptr = ptr;
+    ranges[i].position += chunk_pos;
+    ptr += ranges[i].size;
+  }
+
+  int64_t rbytes = 0;
+  blosc2_io_cb_ext* io_ext = blosc2_get_io_cb_ext(context->schunk->storage->io->id);
+  if (io_ext != NULL && io_ext->readv != NULL) {
+    rbytes = io_ext->readv(ranges, nranges, fp);
+  }
+  else {
+    for (int64_t i = 0; i < nranges; i++) {
+      void* buffer = ranges[i].ptr;
+      int64_t rbytes_ = io_cb->read(&buffer, 1, ranges[i].size, ranges[i].position, fp);
+      if (rbytes_ != ranges[i].size) {
+        break;
+      }
+      rbytes += rbytes_;
+    }
+  }
+  frame_reader_release(frame, io_cb, fp);
+  scratch_release(&context->scratch, ranges);
+  if (rbytes != nbytes) {
+    BLOSC_TRACE_ERROR("Cannot read the (lazy) blocks out of the fileframe.");
+    return BLOSC2_ERROR_FILE_READ;
+  }
+  context->lazy_blocks_ready = true;
+
+  return 0;
+}
+
+
 static int load_lazy_chunk_dict(blosc2_context* context, blosc_header* header, int32_t bstarts_end) {
   int32_t dict_offset = bstarts_end;
   if (header->cbytes < dict_offset + (int32_t)sizeof(int32_t)) {
@@ -2646,8 +3086,23 @@ static int load_lazy_chunk_dict(blosc2_context* context, blosc_header* header, i
   if (rc < 0) {
     return rc;
   }
-
-  context->dict_size = sw32_(dict_size_buf);
+
+  context->dict_size = sw32_(dict_size_buf);
+  if (header->blosc2_flags2 & BLOSC2_SCHUNK_DICT) {
+    // The chunk uses the dictionary of its super-chunk, and keeps its checksum after the (zero) size
+    if (context->dict_size != 0 || header->cbytes < dict_offset + 2 * (int32_t)sizeof(int32_t)) {
+      BLOSC_TRACE_ERROR("Wrong dictionary section for a chunk using the dictionary of its super-chunk.");
+      return BLOSC2_ERROR_CODEC_DICT;
+    }
+    rc = read_lazy_chunk_bytes(context, dict_offset + (int32_t)sizeof(int32_t), dict_size_buf,
+                               (int32_t)sizeof(dict_size_buf),
+                               "Cannot open frame file for lazy chunk dictionary read.",
+                               "Cannot read lazy chunk dictionary checksum from disk.");
+    if (rc < 0) {
+      return rc;
+    }
+    return use_schunk_ddict(context, (uint32_t)sw32_(dict_size_buf));
+  }
   if (context->dict_size <= 0 || context->dict_size > BLOSC2_MAXDICTSIZE) {
     BLOSC_TRACE_ERROR("Dictionary size is smaller than minimum or larger than maximum allowed.");
     return BLOSC2_ERROR_CODEC_DICT;
@@ -2698,18 +3153,7 @@ static int initialize_context_decompression(blosc2_context* context, blosc_heade
   context->output_bytes = 0;
   context->vlblock_sources = NULL;
   context->vlblock_dests = NULL;
-  if (context->blocknbytes != NULL) {
-    free(context->blocknbytes);
-    context->blocknbytes = NULL;
-  }
-  if (context->blockoffsets != NULL) {
-    free(context->blockoffsets);
-    context->blockoffsets = NULL;
-  }
-  if (context->blockcbytes != NULL) {
-    free(context->blockcbytes);
-    context->blockcbytes = NULL;
-  }
+  release_vl_block_sizes(context);
 
   int rc = blosc2_initialize_context_from_header(context, header);
   if (rc < 0) {
@@ -2798,30 +3242,44 @@ static int initialize_context_decompression(blosc2_context* context, blosc_heade
     srcsize -= sizeof(int32_t);
     // Read dictionary size
     context->dict_size = sw32_(context->src + bstarts_end);
-    if (context->dict_size <= 0 || context->dict_size > BLOSC2_MAXDICTSIZE) {
+    if (context->blosc2_flags2 & BLOSC2_SCHUNK_DICT) {
+      // The chunk uses the dictionary of its super-chunk: [int32 0 | uint32 dict checksum]
+      if (context->dict_size != 0 || srcsize < (signed)sizeof(int32_t)) {
+        BLOSC_TRACE_ERROR("Wrong dictionary section for a chunk using the dictionary of its super-chunk.");
+        return BLOSC2_ERROR_CODEC_DICT;
+      }
+      srcsize -= sizeof(int32_t);
+      rc = use_schunk_ddict(context, (uint32_t)sw32_(context->src + bstarts_end + sizeof(int32_t)));
+      if (rc < 0) {
+        return rc;
+      }
+    }
+    else if (context->dict_size <= 0 || context->dict_size > BLOSC2_MAXDICTSIZE) {
       BLOSC_TRACE_ERROR("Dictionary size is smaller than minimum or larger than maximum allowed.");
       return BLOSC2_ERROR_CODEC_DICT;
     }
-    if (srcsize < (int32_t)context->dict_size) {
-      BLOSC_TRACE_ERROR("Not enough space to read entire dictionary.");
-      return BLOSC2_ERROR_READ_BUFFER;
-    }
-    srcsize -= context->dict_size;
-    // dict_buffer points directly into the source chunk — no copy needed
-    context->dict_buffer = (void*)(context->src + bstarts_end + sizeof(int32_t));
-    context->dict_buffer_owned = false;
+    else {
+      if (srcsize < (int32_t)context->dict_size) {
+        BLOSC_TRACE_ERROR("Not enough space to read entire dictionary.");
+        return BLOSC2_ERROR_READ_BUFFER;
+      }
+      srcsize -= context->dict_size;
+      // dict_buffer points directly into the source chunk — no copy needed
+      context->dict_buffer = (void*)(context->src + bstarts_end + sizeof(int32_t));
+      context->dict_buffer_owned = false;
 #if defined(HAVE_ZSTD)
-    // context->compcode during decompression holds the format code (flags >> 5),
-    // so compare against BLOSC_ZSTD_FORMAT (not BLOSC_ZSTD).
-    if (context->compcode == BLOSC_ZSTD_FORMAT) {
-      context->dict_ddict = ZSTD_createDDict(context->dict_buffer, context->dict_size);
-      if (context->dict_ddict == NULL) {
-        BLOSC_TRACE_ERROR("Cannot create ZSTD dictionary for chunk.");
-        return BLOSC2_ERROR_CODEC_DICT;
+      // context->compcode during decompression holds the format code (flags >> 5),
+      // so compare against BLOSC_ZSTD_FORMAT (not BLOSC_ZSTD).
+      if (context->compcode == BLOSC_ZSTD_FORMAT) {
+        context->dict_ddict = ZSTD_createDDict(context->dict_buffer, context->dict_size);
+        if (context->dict_ddict == NULL) {
+          BLOSC_TRACE_ERROR("Cannot create ZSTD dictionary for chunk.");
+          return BLOSC2_ERROR_CODEC_DICT;
+        }
       }
-    }
 #endif   // HAVE_ZSTD
-    // For LZ4/LZ4HC: dict_buffer and dict_size are sufficient; no digested object needed.
+      // For LZ4/LZ4HC: dict_buffer and dict_size are sufficient; no digested object needed.
+    }
   }
   else if ((context->blosc2_flags & BLOSC2_USEDICT) && is_lazy) {
     rc = load_lazy_chunk_dict(context, header, bstarts_end);
@@ -2831,11 +3289,12 @@ static int initialize_context_decompression(blosc2_context* context, blosc_heade
   }
 
   if (vlblocks && !context->special_type && !memcpyed) {
-    context->blocknbytes = malloc((size_t)context->nblocks * sizeof(int32_t));
+    size_t sizes_nbytes = (size_t)context->nblocks * sizeof(int32_t);
+    context->blocknbytes = scratch_alloc(&context->scratch, sizes_nbytes);
     BLOSC_ERROR_NULL(context->blocknbytes, BLOSC2_ERROR_MEMORY_ALLOC);
-    context->blockoffsets = malloc((size_t)context->nblocks * sizeof(int32_t));
+    context->blockoffsets = scratch_alloc(&context->scratch, sizes_nbytes);
     BLOSC_ERROR_NULL(context->blockoffsets, BLOSC2_ERROR_MEMORY_ALLOC);
-    context->blockcbytes = malloc((size_t)context->nblocks * sizeof(int32_t));
+    context->blockcbytes = scratch_alloc(&context->scratch, sizes_nbytes);
     BLOSC_ERROR_NULL(context->blockcbytes, BLOSC2_ERROR_MEMORY_ALLOC);
 
     if (is_lazy) {
@@ -2956,6 +3415,16 @@ static int write_compression_header(blosc2_context* context, bool extended_heade
     }
   }
 
+  /* Chunks using the dictionary of the super-chunk just keep a zero-sized dict section,
+     followed by the checksum of the dict */
+  if (!memcpyed && uses_schunk_dict(context)) {
+    if (context->output_bytes + 2 * (int32_t)sizeof(int32_t) <= context->destsize) {
+      _sw32(context->dest + context->output_bytes, 0);
+      _sw32(context->dest + context->output_bytes + sizeof(int32_t), (int32_t)context->schunk_dict_id);
+    }
+    context->output_bytes += 2 * (int32_t)sizeof(int32_t);
+  }
+
   /* If the header + block starts don't fit in destsize, fall back to memcpy */
   if (!memcpyed && context->output_bytes > context->destsize) {
     context->header_flags |= (uint8_t)BLOSC_MEMCPYED;
@@ -2996,6 +3465,9 @@ static int write_compression_header(blosc2_context* context, bool extended_heade
 
   memcpy(context->dest, &header, (extended_header) ?
     BLOSC_EXTENDED_HEADER_LENGTH : BLOSC_MIN_HEADER_LENGTH);
+  if (memcpyed && uses_schunk_dict(context)) {
+    clear_schunk_dict_flags(context->dest);
+  }
 
   return 1;
 }
@@ -3046,6 +3518,10 @@ static int blosc_compress_context(blosc2_context* context) {
       }
       // Success!  update the memcpy bit in header
       context->dest[BLOSC2_CHUNK_FLAGS] = context->header_flags;
+      if (uses_schunk_dict(context)) {
+        // memcpyed chunks do not have a dict section
+        clear_schunk_dict_flags(context->dest);
+      }
       // and clear the memcpy bit in context (for next reuse)
       context->header_flags &= ~(uint8_t)BLOSC_MEMCPYED;
     }
@@ -3054,9 +3530,16 @@ static int blosc_compress_context(blosc2_context* context) {
     // Check whether we have a run for the whole chunk
     int dict_training = context->use_dict && (context->dict_cdict == NULL);
     int start_csizes = context->header_overhead + 4 * context->nblocks;
+    if (uses_schunk_dict(context)) {
+      start_csizes += 2 * (int)sizeof(int32_t);
+    }
     if (!dict_training && ntbytes == (int)(start_csizes + nstreams * sizeof(int32_t))) {
       // The streams are all zero runs (by construction).  Encode it...
       context->dest[BLOSC2_CHUNK_BLOSC2_FLAGS] |= BLOSC2_SPECIAL_ZERO << 4;
+      context->dest[BLOSC2_CHUNK_BLOSC2_FLAGS] &= ~(uint8_t)BLOSC2_USEDICT;
+      if (uses_schunk_dict(context)) {
+        clear_schunk_dict_flags(context->dest);
+      }
       // ...and assign the new chunk length
       ntbytes = context->header_overhead;
     }
@@ -3117,6 +3600,119 @@ static int blosc_compress_context_without_dict(blosc2_context* context) {
 }
 
 
+/* Keep samples of a chunk filtered by a dict training pass (they are at the start of dest)
+   for training the dictionary of the super-chunk later on */
+static int sample_schunk_dict(blosc2_context* context) {
+  unsigned nsamples = (unsigned)context->nblocks;
+  int dont_split = (context->header_flags & 0x10) >> 4;
+  if (!dont_split) {
+    nsamples = nsamples * context->typesize;
+  }
+  if (nsamples < 8) {
+    nsamples = 8;
+  }
+  // Same sampling than for dicts per chunk, but spread over the whole chunk
+  size_t sample_size = (size_t)context->sourcesize / nsamples / 16;
+  if (sample_size == 0) {
+    return 0;
+  }
+  size_t stride = (size_t)context->sourcesize / nsamples;
+
+  uint8_t* samples = realloc(context->dict_samples, context->dict_samples_nbytes + nsamples * sample_size);
+  BLOSC_ERROR_NULL(samples, BLOSC2_ERROR_MEMORY_ALLOC);
+  context->dict_samples = samples;
+  size_t* sizes = realloc(context->dict_samples_sizes, (context->dict_nsamples + nsamples) * sizeof(size_t));
+  BLOSC_ERROR_NULL(sizes, BLOSC2_ERROR_MEMORY_ALLOC);
+  context->dict_samples_sizes = sizes;
+
+  const uint8_t* filtered = context->dest + context->header_overhead;
+  for (unsigned i = 0; i < nsamples; i++) {
+    memcpy(samples + context->dict_samples_nbytes, filtered + i * stride, sample_size);
+    context->dict_samples_nbytes += sample_size;
+    sizes[context->dict_nsamples++] = sample_size;
+  }
+  context->dict_nchunks_sampled++;
+  return 0;
+}
+
+
+static void free_schunk_dict_samples(blosc2_context* context) {
+  free(context->dict_samples);
+  context->dict_samples = NULL;
+  free(context->dict_samples_sizes);
+  context->dict_samples_sizes = NULL;
+  context->dict_nsamples = 0;
+  context->dict_samples_nbytes = 0;
+  context->dict_nchunks_sampled = 0;
+}
+
+
+/* Train the dictionary of the super-chunk out of the samples and store it there */
+static int train_schunk_dict(blosc2_context* context) {
+  // Like for dicts per chunk, do not make it larger than 5% of the sampled data (1/16 of it)
+  int32_t dict_maxsize = BLOSC2_MAXDICTSIZE;
+  if ((size_t)dict_maxsize > context->dict_samples_nbytes * 16 / 20) {
+    dict_maxsize = (int32_t)(context->dict_samples_nbytes * 16 / 20);
+  }
+  if (dict_maxsize < BLOSC2_MINUSEFULDICT) {
+    // Wait for more samples
+    return 0;
+  }
+
+  uint8_t* dict = malloc((size_t)dict_maxsize);
+  BLOSC_ERROR_NULL(dict, BLOSC2_ERROR_MEMORY_ALLOC);
+  int32_t dict_size = 0;
+  if (context->compcode == BLOSC_LZ4 || context->compcode == BLOSC_LZ4HC) {
+    // LZ4/LZ4HC: use raw samples (evenly picked from all the chunks) as the dictionary
+    uint32_t step = (uint32_t)((context->dict_samples_nbytes + dict_maxsize - 1) / dict_maxsize);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < context->dict_nsamples; i++) {
+      size_t sample_size = context->dict_samples_sizes[i];
+      if (i % step == 0 && dict_size + sample_size <= (size_t)dict_maxsize) {
+        memcpy(dict + dict_size, context->dict_samples + offset, sample_size);
+        dict_size += (int32_t)sample_size;
+      }
+      offset += sample_size;
+    }
+  }
+#ifdef HAVE_ZSTD
+  else {
+    size_t code = ZDICT_trainFromBuffer(dict, (size_t)dict_maxsize, context->dict_samples,
+                                        context->dict_samples_sizes, context->dict_nsamples);
+    if (ZDICT_isError(code)) {
+      BLOSC_TRACE_WARNING("ZDICT_trainFromBuffer() failed: '%s'."
+                          "  Sampling the next chunks for another try.", ZDICT_getErrorName(code));
+      free(dict);
+      free_schunk_dict_samples(context);
+      return 0;
+    }
+    dict_size = (int32_t)code;
+  }
+#endif  // HAVE_ZSTD
+  free_schunk_dict_samples(context);
+  if (dict_size <= 0) {
+    free(dict);
+    return 0;
+  }
+
+  // Another handle could have stored its own dict in the meanwhile; use that one then
+  int rc = schunk_vlmeta_exists(context->schunk, BLOSC2_DICT_VLMETA);
+  if (rc >= 0) {
+    free(dict);
+    return load_schunk_dict(context);
+  }
+  rc = schunk_vlmeta_add(context->schunk, BLOSC2_DICT_VLMETA, dict, dict_size, NULL);
+  if (rc < 0) {
+    free(dict);
+    return rc;
+  }
+  context->schunk_dict = dict;
+  context->schunk_dict_size = dict_size;
+  context->schunk_dict_id = schunk_dict_checksum(dict, dict_size);
+  return 1;
+}
+
+
 /* The public secure routine for compression with context. */
 int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsize,
                         void* dest, int32_t destsize) {
@@ -3137,6 +3733,23 @@ int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsiz
     return error;
   }
 
+  if (src != NULL && context->use_dict && context->clevel > 0 && context->schunk != NULL) {
+    /* Use the dictionary of the super-chunk, if any */
+    error = use_schunk_cdict(context);
+    if (error < 0) {
+      return error;
+    }
+    if (error > 0) {
+      error = write_compression_header(context, true);
+      cbytes = error < 0 ? error : blosc_compress_context(context);
+      // The dictionary (and its digested form) is kept for the next chunks
+      context->dict_buffer = NULL;
+      context->dict_size = 0;
+      context->dict_cdict = NULL;
+      return cbytes;
+    }
+  }
+
   /* Write the extended header */
   error = write_compression_header(context, true);
   if (error < 0) {
@@ -3148,6 +3761,28 @@ int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsiz
     return cbytes;
   }
 
+  if (context->use_dict && context->dict_cdict == NULL && context->schunk != NULL &&
+      context->dict_nchunks > 0) {
+    /* Sample the first chunks for the dictionary of the super-chunk, and compress them without dicts */
+    context->destsize = destsize;
+    if (cbytes >= context->header_overhead + context->sourcesize) {
+      error = sample_schunk_dict(context);
+      if (error < 0) {
+        return error;
+      }
+    }
+    context->bstarts = (int32_t*)(context->dest + context->header_overhead);
+    context->output_bytes = context->header_overhead + (int32_t)sizeof(int32_t) * context->nblocks;
+    cbytes = blosc_compress_context_without_dict(context);
+    if (cbytes >= 0 && context->dict_nchunks_sampled >= context->dict_nchunks) {
+      error = train_schunk_dict(context);
+      if (error < 0) {
+        return error;
+      }
+    }
+    return cbytes;
+  }
+
   if (context->use_dict && context->dict_cdict == NULL) {
     /* blosc_compress_context() overwrites context->destsize with the training-pass output
      * size.  Restore it so that the real compression pass has the correct output-buffer size. */
@@ -3464,7 +4099,7 @@ int blosc2_vlcompress_ctx(blosc2_context* context, const void* const* srcs, cons
   context->leftover = 0;
   context->blocksize = max_blocksize;
   context->vlblock_sources = (const uint8_t**)srcs;
-  context->blocknbytes = malloc((size_t)nblocks * sizeof(int32_t));
+  context->blocknbytes = scratch_alloc(&context->scratch, (size_t)nblocks * sizeof(int32_t));
   BLOSC_ERROR_NULL(context->blocknbytes, BLOSC2_ERROR_MEMORY_ALLOC);
   memcpy(context->blocknbytes, srcsizes, (size_t)nblocks * sizeof(int32_t));
 
@@ -3928,8 +4563,14 @@ static int blosc_run_decompression_with_context(blosc2_context* context, const v
     return rc;
   }
 
+  rc = prefetch_lazy_blocks(context);
+  if (rc < 0) {
+    return rc;
+  }
+
   /* Do the actual decompression */
   ntbytes = do_job(context);
+  context->lazy_blocks_ready = false;
   if (ntbytes < 0) {
     return ntbytes;
   }
@@ -3952,10 +4593,8 @@ int blosc2_decompress_ctx(blosc2_context* context, const void* src, int32_t srcs
   result = blosc_run_decompression_with_context(context, src, srcsize, dest, destsize);
 
   // Reset a possible block_maskout
-  if (context->block_maskout != NULL) {
-    free(context->block_maskout);
-    context->block_maskout = NULL;
-  }
+  scratch_release(&context->scratch, context->block_maskout);
+  context->block_maskout = NULL;
   context->block_maskout_nitems = 0;
 
   return result;
@@ -4053,9 +4692,7 @@ static int decompress_single_vlblock(blosc2_context* context, int32_t nblock,
       BLOSC_TRACE_ERROR("Malformed lazy trailer exceeds chunk bounds.");
       return BLOSC2_ERROR_INVALID_HEADER;
     }
-    int32_t nchunk_lazy;
     int64_t chunk_offset;
-    memcpy(&nchunk_lazy, context->src + trailer_offset, sizeof(nchunk_lazy));
     memcpy(&chunk_offset, context->src + trailer_offset + (int32_t)sizeof(int32_t), sizeof(chunk_offset));
     int32_t block_csize = *(const int32_t*)(context->src + block_csize_pos);
     if (block_csize < (int32_t)sizeof(int32_t)) {
@@ -4071,8 +4708,8 @@ static int decompress_single_vlblock(blosc2_context* context, int32_t nblock,
     void* fp = NULL;
     int64_t io_pos;
     if (frame->sframe) {
-      fp = sframe_open_chunk(frame->urlpath, nchunk_lazy, "rb", context->schunk->storage->io);
-      io_pos = bstart;
+      fp = sframe_acquire_chunk(frame, chunk_offset, context->schunk->storage->io, &io_pos);
+      io_pos += bstart;
     }
     else {
       fp = frame_reader_acquire(frame, context->schunk->storage->io);
@@ -4598,18 +5235,7 @@ int blosc2_decompress_block_ctx(blosc2_context* context, const void* src,
   context->output_bytes = 0;
   context->vlblock_sources = NULL;
   context->vlblock_dests = NULL;
-  if (context->blocknbytes != NULL) {
-    free(context->blocknbytes);
-    context->blocknbytes = NULL;
-  }
-  if (context->blockoffsets != NULL) {
-    free(context->blockoffsets);
-    context->blockoffsets = NULL;
-  }
-  if (context->blockcbytes != NULL) {
-    free(context->blockcbytes);
-    context->blockcbytes = NULL;
-  }
+  release_vl_block_sizes(context);
 
   result = blosc2_initialize_context_from_header(context, &header);
   if (result < 0) {
@@ -5102,10 +5728,40 @@ static void job_group_destroy(struct blosc_job_group *job) {
   blosc2_pthread_cond_destroy(&job->completion_cv);
 }
 
+#if !defined(_WIN32)
+/* Marks the threads of the shared pools, so that nested parallel work can
+   tell it would be waiting on the workers it is running on */
+static pthread_key_t pool_worker_key;
+static pthread_once_t pool_worker_key_once = PTHREAD_ONCE_INIT;
+
+static void create_pool_worker_key(void) {
+  pthread_key_create(&pool_worker_key, NULL);
+}
+
+static bool in_shared_pool_worker(void) {
+  pthread_once(&pool_worker_key_once, create_pool_worker_key);
+  return pthread_getspecific(pool_worker_key) != NULL;
+}
+#endif
+
+/* Run one generic task and report it to its (stack-allocated) group */
+static void run_pool_task(struct blosc_task_group *tasks, void *jobdata) {
+  tasks->dojob(jobdata);
+  blosc2_pthread_mutex_lock(&tasks->mutex);
+  if (--tasks->pending == 0) {
+    blosc2_pthread_cond_broadcast(&tasks->completion_cv);
+  }
+  blosc2_pthread_mutex_unlock(&tasks->mutex);
+}
+
 static void* shared_pool_worker(void* arg) {
   struct thread_context* thcontext = (struct thread_context*)arg;
   struct blosc_shared_pool* pool = thcontext->owner_pool;
 
+#if !defined(_WIN32)
+  pthread_once(&pool_worker_key_once, create_pool_worker_key);
+  pthread_setspecific(pool_worker_key, thcontext);
+#endif
   while (1) {
     struct blosc_job_group* job = NULL;
     struct blosc_job_queue_entry* entry = NULL;
@@ -5125,7 +5781,13 @@ static void* shared_pool_worker(void* arg) {
     }
     blosc2_pthread_mutex_unlock(&pool->mutex);
     int32_t logical_tid = entry->logical_tid;
-    my_free(entry);
+    struct blosc_task_group *tasks = entry->tasks;
+    void *jobdata = entry->jobdata;
+
+    if (tasks != NULL) {
+      run_pool_task(tasks, jobdata);
+      goto job_done;
+    }
 
     thcontext->parent_context = job->context;
     thcontext->tid = logical_tid;
@@ -5146,6 +5808,7 @@ static void* shared_pool_worker(void* arg) {
     }
     blosc2_pthread_mutex_unlock(&job->mutex);
 
+  job_done:
     blosc2_pthread_mutex_lock(&pool->mutex);
     pool->active_jobs--;
     if (pool->active_jobs == 0 && pool->context_refs == 0 && pool->job_queue_head == NULL) {
@@ -5301,6 +5964,223 @@ static int attach_shared_pool(blosc2_context *context) {
   return 0;
 }
 
+#if !defined(_WIN32)
+/* Unlink the first still queued entry of `tasks`, if any (pool mutex held) */
+static struct blosc_job_queue_entry* claim_pool_task_locked(struct blosc_shared_pool *pool,
+                                                            struct blosc_task_group *tasks) {
+  struct blosc_job_queue_entry *prev = NULL;
+  for (struct blosc_job_queue_entry *e = pool->job_queue_head; e != NULL; prev = e, e = e->next) {
+    if (e->tasks != tasks) {
+      continue;
+    }
+    if (prev == NULL) {
+      pool->job_queue_head = e->next;
+    }
+    else {
+      prev->next = e->next;
+    }
+    if (pool->job_queue_tail == e) {
+      pool->job_queue_tail = prev;
+    }
+    pool->active_jobs--;
+    return e;
+  }
+  return NULL;
+}
+
+/* Queue entries of run_shared_pool_tasks() that live on the caller's stack */
+#define POOL_TASKS_STACK_ENTRIES 16
+
+/* Get the shared pool with `nthreads` workers for generic tasks, creating it
+ * on first use and keeping it until blosc2_destroy() */
+static int get_task_pool(int16_t nthreads, struct blosc_shared_pool **pool_out) {
+  struct blosc_shared_pool *pool;
+
+  if (!g_initlib) blosc2_init();
+  blosc2_pthread_mutex_lock(&pool_registry_mutex);
+  pool = find_shared_pool_locked(nthreads);
+  if (pool == NULL) {
+    int rc = create_shared_pool(nthreads, &pool);
+    if (rc < 0) {
+      blosc2_pthread_mutex_unlock(&pool_registry_mutex);
+      return rc;
+    }
+    pool->next = shared_pools;
+    shared_pools = pool;
+  }
+  if (!pool->pinned) {
+    // Keep the workers warm for the next submission
+    pool->pinned = 1;
+    pool->context_refs++;
+  }
+  blosc2_pthread_mutex_unlock(&pool_registry_mutex);
+
+  *pool_out = pool;
+  return 0;
+}
+
+/* Run `njobs` generic jobs on the shared pool with `nthreads` workers (the
+ * same pool the contexts with `nthreads` threads attach to, whatever the
+ * number of jobs).  The pool is created on first use and kept until
+ * blosc2_destroy(), so repeated calls find warm workers.  The caller runs the first job itself
+ * and then any of its jobs that no worker has picked up yet, which keeps
+ * submissions from inside pool workers (nested parallelism) deadlock free.
+ * Returns < 0 only when the pool cannot be set up, before any job has run. */
+static int run_shared_pool_tasks(int16_t nthreads, int16_t njobs, void (*dojob)(void *),
+                                 size_t jobdata_elsize, void *jobdata) {
+  struct blosc_shared_pool *pool;
+  int rc = get_task_pool(nthreads, &pool);
+  if (rc < 0) {
+    return rc;
+  }
+
+  struct blosc_task_group tasks;
+  tasks.dojob = dojob;
+  tasks.pending = 0;
+  blosc2_pthread_mutex_init(&tasks.mutex, NULL);
+  blosc2_pthread_cond_init(&tasks.completion_cv, NULL);
+
+  // The entries stay ours; every one of them is out of the queue before we return
+  struct blosc_job_queue_entry entries_stack[POOL_TASKS_STACK_ENTRIES];
+  struct blosc_job_queue_entry *entries = entries_stack;
+  if (njobs > POOL_TASKS_STACK_ENTRIES) {
+    entries = malloc((size_t)njobs * sizeof(*entries));
+  }
+
+  blosc2_pthread_mutex_lock(&pool->mutex);
+  int32_t enqueued = 0;
+  for (int32_t i = 1; i < njobs && entries != NULL; ++i) {
+    // The jobs left out (if the entries cannot be allocated) are run by the caller below
+    struct blosc_job_queue_entry *entry = &entries[i];
+    memset(entry, 0, sizeof(*entry));
+    entry->tasks = &tasks;
+    entry->jobdata = (uint8_t *)jobdata + (size_t)i * jobdata_elsize;
+    entry->logical_tid = i;
+    if (pool->job_queue_tail != NULL) {
+      pool->job_queue_tail->next = entry;
+    }
+    else {
+      pool->job_queue_head = entry;
+    }
+    pool->job_queue_tail = entry;
+    pool->active_jobs++;
+    enqueued++;
+  }
+  tasks.pending = enqueued;
+  blosc2_pthread_cond_broadcast(&pool->work_cv);
+  blosc2_pthread_mutex_unlock(&pool->mutex);
+
+  dojob(jobdata);
+  for (int32_t i = 1 + enqueued; i < njobs; ++i) {
+    dojob((uint8_t *)jobdata + (size_t)i * jobdata_elsize);
+  }
+
+  // Help with our own jobs that are still waiting for a worker
+  while (1) {
+    blosc2_pthread_mutex_lock(&pool->mutex);
+    struct blosc_job_queue_entry *entry = claim_pool_task_locked(pool, &tasks);
+    blosc2_pthread_mutex_unlock(&pool->mutex);
+    if (entry == NULL) {
+      break;
+    }
+    run_pool_task(&tasks, entry->jobdata);
+  }
+
+  blosc2_pthread_mutex_lock(&tasks.mutex);
+  while (tasks.pending > 0) {
+    blosc2_pthread_cond_wait(&tasks.completion_cv, &tasks.mutex);
+  }
+  blosc2_pthread_mutex_unlock(&tasks.mutex);
+  blosc2_pthread_cond_destroy(&tasks.completion_cv);
+  blosc2_pthread_mutex_destroy(&tasks.mutex);
+  if (entries != entries_stack) {
+    free(entries);
+  }
+
+  return 0;
+}
+#endif
+
+/* A generic job queued on a shared pool by pool_task_submit() */
+struct blosc_pool_task {
+  struct blosc_shared_pool *pool;
+  struct blosc_task_group tasks;
+  struct blosc_job_queue_entry entry;
+};
+
+blosc_pool_task* pool_task_submit(int16_t nthreads, void (*dojob)(void *), void *jobdata) {
+#if defined(_WIN32)
+  BLOSC_UNUSED_PARAM(nthreads);
+  BLOSC_UNUSED_PARAM(dojob);
+  BLOSC_UNUSED_PARAM(jobdata);
+  return NULL;
+#else
+  if (threads_callback != NULL || nthreads <= 0) {
+    return NULL;
+  }
+  struct blosc_shared_pool *pool;
+  if (get_task_pool(nthreads, &pool) < 0) {
+    return NULL;
+  }
+  blosc_pool_task *task = malloc(sizeof(blosc_pool_task));
+  if (task == NULL) {
+    return NULL;
+  }
+  task->pool = pool;
+  task->tasks.dojob = dojob;
+  task->tasks.pending = 1;
+  blosc2_pthread_mutex_init(&task->tasks.mutex, NULL);
+  blosc2_pthread_cond_init(&task->tasks.completion_cv, NULL);
+  memset(&task->entry, 0, sizeof(task->entry));
+  task->entry.tasks = &task->tasks;
+  task->entry.jobdata = jobdata;
+
+  blosc2_pthread_mutex_lock(&pool->mutex);
+  if (pool->job_queue_tail != NULL) {
+    pool->job_queue_tail->next = &task->entry;
+  }
+  else {
+    pool->job_queue_head = &task->entry;
+  }
+  pool->job_queue_tail = &task->entry;
+  pool->active_jobs++;
+  blosc2_pthread_cond_signal(&pool->work_cv);
+  blosc2_pthread_mutex_unlock(&pool->mutex);
+
+  return task;
+#endif
+}
+
+void pool_task_wait(blosc_pool_task *task, bool cancel) {
+#if defined(_WIN32)
+  BLOSC_UNUSED_PARAM(task);
+  BLOSC_UNUSED_PARAM(cancel);
+#else
+  struct blosc_shared_pool *pool = task->pool;
+  blosc2_pthread_mutex_lock(&pool->mutex);
+  struct blosc_job_queue_entry *entry = claim_pool_task_locked(pool, &task->tasks);
+  blosc2_pthread_mutex_unlock(&pool->mutex);
+  if (entry != NULL) {
+    // No worker has picked it up yet
+    if (cancel) {
+      task->tasks.pending = 0;
+    }
+    else {
+      run_pool_task(&task->tasks, entry->jobdata);
+    }
+  }
+
+  blosc2_pthread_mutex_lock(&task->tasks.mutex);
+  while (task->tasks.pending > 0) {
+    blosc2_pthread_cond_wait(&task->tasks.completion_cv, &task->tasks.mutex);
+  }
+  blosc2_pthread_mutex_unlock(&task->tasks.mutex);
+  blosc2_pthread_cond_destroy(&task->tasks.completion_cv);
+  blosc2_pthread_mutex_destroy(&task->tasks.mutex);
+  free(task);
+#endif
+}
+
 #if defined(_WIN32)
 /* Per-context worker thread for Windows (BLOSC_BACKEND_PER_CONTEXT).
  * Sleeps between jobs using a job_seq counter; wakes when main increments
@@ -5535,34 +6415,21 @@ static int parallel_blosc(blosc2_context* context) {
   }
   else {
     struct blosc_shared_pool *pool = context->thread_pool;
+    /* The entries are owned by the context, and workers are done with them
+       by the time the job completes */
+    struct blosc_job_queue_entry *entries = scratch_realloc(
+        &context->scratch, context->pool_entries, (size_t)context->nthreads * sizeof(*entries));
+    context->pool_entries = entries;
+    if (entries == NULL) {
+      context->job = NULL;
+      job_group_destroy(&job);
+      BLOSC_TRACE_ERROR("Error allocating memory!");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
     blosc2_pthread_mutex_lock(&pool->mutex);
     int32_t enqueued = 0;
     for (int32_t tid = 0; tid < context->nthreads; ++tid) {
-      struct blosc_job_queue_entry *entry = (struct blosc_job_queue_entry *)my_malloc(sizeof(*entry));
-      if (entry == NULL) {
-        /* Drain already-enqueued entries so they don't reference the
-           stack-allocated job after we return. */
-        struct blosc_job_queue_entry **pp = &pool->job_queue_head;
-        while (*pp != NULL) {
-          if ((*pp)->job == &job) {
-            struct blosc_job_queue_entry *victim = *pp;
-            *pp = victim->next;
-            my_free(victim);
-            pool->active_jobs--;
-          } else {
-            pp = &(*pp)->next;
-          }
-        }
-        pool->job_queue_tail = NULL;
-        /* Recompute tail */
-        for (struct blosc_job_queue_entry *e = pool->job_queue_head; e != NULL; e = e->next) {
-          pool->job_queue_tail = e;
-        }
-        blosc2_pthread_mutex_unlock(&pool->mutex);
-        context->job = NULL;
-        job_group_destroy(&job);
-        return BLOSC2_ERROR_MEMORY_ALLOC;
-      }
+      struct blosc_job_queue_entry *entry = &entries[tid];
       memset(entry, 0, sizeof(*entry));
       entry->job = &job;
       entry->logical_tid = tid;
@@ -5942,8 +6809,13 @@ void blosc_set_schunk(blosc2_schunk* schunk) {
 blosc2_io *blosc2_io_global = NULL;
 blosc2_io_cb BLOSC2_IO_CB_DEFAULTS;
 blosc2_io_cb BLOSC2_IO_CB_MMAP;
+blosc2_io_cb BLOSC2_IO_CB_URING;
+static blosc2_io_cb_ext BLOSC2_IO_CB_EXT_DEFAULTS;
+static blosc2_io_cb_ext BLOSC2_IO_CB_EXT_MMAP;
+static blosc2_io_cb_ext BLOSC2_IO_CB_EXT_URING;
 
 int _blosc2_register_io_cb(const blosc2_io_cb *io);
+static int _blosc2_register_io_cb_ext(uint8_t id, const blosc2_io_cb_ext *ext);
 
 void blosc2_init(void) {
   /* Return if Blosc is already initialized */
@@ -5960,7 +6832,22 @@ void blosc2_init(void) {
   BLOSC2_IO_CB_DEFAULTS.truncate = (blosc2_truncate_cb) blosc2_stdio_truncate;
   BLOSC2_IO_CB_DEFAULTS.destroy = (blosc2_destroy_cb) blosc2_stdio_destroy;
 
+  /* Check for a BLOSC_IO_URING environment variable, for reading through io_uring by default */
+  char* envvar = getenv("BLOSC_IO_URING");
+  if (envvar != NULL && envvar[0] != '\0' && strcmp(envvar, "0") != 0) {
+    BLOSC2_IO_CB_DEFAULTS.read = (blosc2_read_cb) blosc2_uring_read;
+  }
+
+  BLOSC2_IO_CB_EXT_DEFAULTS.readv = (blosc2_readv_cb) blosc2_stdio_readv;
+  BLOSC2_IO_CB_EXT_DEFAULTS.prefetch = NULL;
+  BLOSC2_IO_CB_EXT_DEFAULTS.sync = (blosc2_sync_cb) blosc2_stdio_sync;
+  if (BLOSC2_IO_CB_DEFAULTS.read == (blosc2_read_cb) blosc2_uring_read) {
+    BLOSC2_IO_CB_EXT_DEFAULTS.readv = (blosc2_readv_cb) blosc2_uring_readv;
+    BLOSC2_IO_CB_EXT_DEFAULTS.prefetch = (blosc2_prefetch_cb) blosc2_uring_prefetch;
+  }
+
   _blosc2_register_io_cb(&BLOSC2_IO_CB_DEFAULTS);
+  _blosc2_register_io_cb_ext(BLOSC2_IO_FILESYSTEM, &BLOSC2_IO_CB_EXT_DEFAULTS);
 
   BLOSC2_IO_CB_MMAP.id = BLOSC2_IO_FILESYSTEM_MMAP;
   BLOSC2_IO_CB_MMAP.name = "filesystem_mmap";
@@ -5973,7 +6860,29 @@ void blosc2_init(void) {
   BLOSC2_IO_CB_MMAP.truncate = (blosc2_truncate_cb) blosc2_stdio_mmap_truncate;
   BLOSC2_IO_CB_MMAP.destroy = (blosc2_destroy_cb) blosc2_stdio_mmap_destroy;
 
+  BLOSC2_IO_CB_EXT_MMAP.prefetch = (blosc2_prefetch_cb) blosc2_stdio_mmap_prefetch;
+  BLOSC2_IO_CB_EXT_MMAP.sync = (blosc2_sync_cb) blosc2_stdio_mmap_sync;
+
   _blosc2_register_io_cb(&BLOSC2_IO_CB_MMAP);
+  _blosc2_register_io_cb_ext(BLOSC2_IO_FILESYSTEM_MMAP, &BLOSC2_IO_CB_EXT_MMAP);
+
+  BLOSC2_IO_CB_URING.id = BLOSC2_IO_FILESYSTEM_URING;
+  BLOSC2_IO_CB_URING.name = "filesystem_uring";
+  BLOSC2_IO_CB_URING.is_allocation_necessary = true;
+  BLOSC2_IO_CB_URING.open = (blosc2_open_cb) blosc2_uring_open;
+  BLOSC2_IO_CB_URING.close = (blosc2_close_cb) blosc2_uring_close;
+  BLOSC2_IO_CB_URING.size = (blosc2_size_cb) blosc2_uring_size;
+  BLOSC2_IO_CB_URING.write = (blosc2_write_cb) blosc2_uring_write;
+  BLOSC2_IO_CB_URING.read = (blosc2_read_cb) blosc2_uring_read;
+  BLOSC2_IO_CB_URING.truncate = (blosc2_truncate_cb) blosc2_uring_truncate;
+  BLOSC2_IO_CB_URING.destroy = (blosc2_destroy_cb) blosc2_uring_destroy;
+
+  BLOSC2_IO_CB_EXT_URING.readv = (blosc2_readv_cb) blosc2_uring_readv;
+  BLOSC2_IO_CB_EXT_URING.prefetch = (blosc2_prefetch_cb) blosc2_uring_prefetch;
+  BLOSC2_IO_CB_EXT_URING.sync = (blosc2_sync_cb) blosc2_uring_sync;
+
+  _blosc2_register_io_cb(&BLOSC2_IO_CB_URING);
+  _blosc2_register_io_cb_ext(BLOSC2_IO_FILESYSTEM_URING, &BLOSC2_IO_CB_EXT_URING);
 
   g_ncodecs = 0;
   g_nfilters = 0;
@@ -6045,6 +6954,7 @@ blosc2_context* blosc2_create_cctx(blosc2_cparams cparams) {
   memset(context, 0, sizeof(blosc2_context));
   context->do_compress = 1;   /* meant for compression */
   context->use_dict = cparams.use_dict;
+  context->dict_nchunks = cparams.dict_nchunks;
   if (cparams.instr_codec) {
     context->blosc2_flags = BLOSC2_INSTR_CODEC;
   }
@@ -6310,11 +7220,21 @@ void blosc2_free_ctx(blosc2_context* context) {
     }
 #endif
   }
-  if (context->dict_ddict != NULL) {
+  if (context->dict_ddict != NULL && context->dict_ddict != context->schunk_ddict) {
 #ifdef HAVE_ZSTD
     ZSTD_freeDDict(context->dict_ddict);
 #endif
   }
+  free_schunk_cdict(context);
+#ifdef HAVE_ZSTD
+  if (context->schunk_ddict != NULL) {
+    ZSTD_freeDDict(context->schunk_ddict);
+  }
+#endif
+  free(context->schunk_dict);
+  free_schunk_dict_samples(context);
+  free(context->lazy_blocks);
+  free(context->lazy_block_offsets);
   if (context->tuner_params != NULL) {
     int rc;
     if (context->tuner_id < BLOSC_LAST_TUNER && context->tuner_id == BLOSC_STUNE) {
@@ -6379,18 +7299,10 @@ void blosc2_free_ctx(blosc2_context* context) {
     my_free(context->postparams);
   }
 
-  if (context->block_maskout != NULL) {
-    free(context->block_maskout);
-  }
-  if (context->blocknbytes != NULL) {
-    free(context->blocknbytes);
-  }
-  if (context->blockoffsets != NULL) {
-    free(context->blockoffsets);
-  }
-  if (context->blockcbytes != NULL) {
-    free(context->blockcbytes);
-  }
+  scratch_release(&context->scratch, context->block_maskout);
+  release_vl_block_sizes(context);
+  scratch_release(&context->scratch, context->pool_entries);
+  scratch_destroy(&context->scratch);
   my_free(context);
 }
 
@@ -6400,6 +7312,7 @@ int blosc2_ctx_get_cparams(blosc2_context *ctx, blosc2_cparams *cparams) {
   cparams->compcode_meta = ctx->compcode_meta;
   cparams->clevel = ctx->clevel;
   cparams->use_dict = ctx->use_dict;
+  cparams->dict_nchunks = ctx->dict_nchunks;
   cparams->instr_codec = ctx->blosc2_flags & BLOSC2_INSTR_CODEC;
   cparams->typesize = ctx->typesize;
   cparams->nthreads = ctx->nthreads;
@@ -6433,12 +7346,10 @@ int blosc2_ctx_get_dparams(blosc2_context *ctx, blosc2_dparams *dparams) {
 /* Set a maskout in decompression context */
 int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblocks) {
 
-  if (ctx->block_maskout != NULL) {
-    // Get rid of a possible mask here
-    free(ctx->block_maskout);
-  }
-
-  bool *maskout_ = malloc(nblocks);
+  // Reuse the buffer of a possible previous mask
+  bool *maskout_ = scratch_realloc(&ctx->scratch, ctx->block_maskout, nblocks);
+  ctx->block_maskout = NULL;
+  ctx->block_maskout_nitems = 0;
   BLOSC_ERROR_NULL(maskout_, BLOSC2_ERROR_MEMORY_ALLOC);
   memcpy(maskout_, maskout, nblocks);
   ctx->block_maskout = maskout_;
@@ -6448,6 +7359,31 @@ int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblocks) {
 }
 
 
+int64_t blosc2_ctx_trim_scratch(blosc2_context *ctx) {
+  int64_t nbytes = 0;
+  if (ctx->serial_context != NULL) {
+    // Created again (with the temporaries for the blocksize at hand) on next use
+    nbytes += (int64_t)ctx->serial_context->tmp_nbytes;
+    free_thread_context(ctx->serial_context);
+    ctx->serial_context = NULL;
+  }
+  nbytes += (int64_t)ctx->lazy_blocks_size;
+  free(ctx->lazy_blocks);
+  ctx->lazy_blocks = NULL;
+  ctx->lazy_blocks_size = 0;
+  ctx->lazy_blocks_ready = false;
+  nbytes += (int64_t)ctx->lazy_block_noffsets * (int64_t)sizeof(int32_t);
+  free(ctx->lazy_block_offsets);
+  ctx->lazy_block_offsets = NULL;
+  ctx->lazy_block_noffsets = 0;
+  scratch_release(&ctx->scratch, ctx->pool_entries);
+  ctx->pool_entries = NULL;
+  nbytes += scratch_trim(&ctx->scratch);
+
+  return nbytes;
+}
+
+
 /* Create a chunk made of zeros */
 int blosc2_chunk_zeros(blosc2_cparams cparams, const int32_t nbytes, void* dest, int32_t destsize) {
   if (destsize < BLOSC_EXTENDED_HEADER_LENGTH) {
@@ -6797,12 +7733,35 @@ int _blosc2_register_io_cb(const blosc2_io_cb *io) {
     }
   }
 
-  blosc2_io_cb *io_new = &g_ios[g_nio++];
+  blosc2_io_cb *io_new = &g_ios[g_nio];
   memcpy(io_new, io, sizeof(blosc2_io_cb));
+  memset(&g_io_exts[g_nio], 0, sizeof(blosc2_io_cb_ext));
+  g_nio++;
 
   return BLOSC2_ERROR_SUCCESS;
 }
 
+static int _blosc2_register_io_cb_ext(uint8_t id, const blosc2_io_cb_ext *ext) {
+  for (uint64_t i = 0; i < g_nio; ++i) {
+    if (g_ios[i].id == id) {
+      memcpy(&g_io_exts[i], ext, sizeof(blosc2_io_cb_ext));
+      return BLOSC2_ERROR_SUCCESS;
+    }
+  }
+  BLOSC_TRACE_ERROR("The IO (ID: %d) is not registered.", id);
+  return BLOSC2_ERROR_PLUGIN_IO;
+}
+
+int blosc2_register_io_cb_ext(uint8_t id, const blosc2_io_cb_ext *ext) {
+  BLOSC_ERROR_NULL(ext, BLOSC2_ERROR_INVALID_PARAM);
+  if (id < BLOSC2_IO_REGISTERED) {
+    BLOSC_TRACE_ERROR("The IO id must be greater or equal than %d", BLOSC2_IO_REGISTERED);
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+
+  return _blosc2_register_io_cb_ext(id, ext);
+}
+
 int blosc2_register_io_cb(const blosc2_io_cb *io) {
   BLOSC_ERROR_NULL(io, BLOSC2_ERROR_INVALID_PARAM);
   if (g_nio == UINT8_MAX) {
@@ -6830,22 +7789,40 @@ blosc2_io_cb *blosc2_get_io_cb(uint8_t id) {
     }
   }
   if (id == BLOSC2_IO_FILESYSTEM) {
-    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_DEFAULTS) < 0) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_DEFAULTS) < 0 ||
+        _blosc2_register_io_cb_ext(id, &BLOSC2_IO_CB_EXT_DEFAULTS) < 0) {
       BLOSC_TRACE_ERROR("Error registering the default IO API");
       return NULL;
     }
     return blosc2_get_io_cb(id);
   }
   else if (id == BLOSC2_IO_FILESYSTEM_MMAP) {
-    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_MMAP) < 0) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_MMAP) < 0 ||
+        _blosc2_register_io_cb_ext(id, &BLOSC2_IO_CB_EXT_MMAP) < 0) {
       BLOSC_TRACE_ERROR("Error registering the mmap IO API");
       return NULL;
     }
     return blosc2_get_io_cb(id);
   }
+  else if (id == BLOSC2_IO_FILESYSTEM_URING) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_URING) < 0 ||
+        _blosc2_register_io_cb_ext(id, &BLOSC2_IO_CB_EXT_URING) < 0) {
+      BLOSC_TRACE_ERROR("Error registering the io_uring IO API");
+      return NULL;
+    }
+    return blosc2_get_io_cb(id);
+  }
   return NULL;
 }
 
+blosc2_io_cb_ext *blosc2_get_io_cb_ext(uint8_t id) {
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(id);
+  if (io_cb == NULL) {
+    return NULL;
+  }
+  return &g_io_exts[io_cb - g_ios];
+}
+
 void blosc2_unidim_to_multidim(uint8_t ndim, int64_t *shape, int64_t i, int64_t *index) {
   if (ndim == 0) {
     return;
@@ -0,0 +1,69 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "blosclz-avx2.h"
+#include <stdlib.h>
+
+/* Make sure AVX2 is available for the compilation target and compiler. */
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include <stdint.h>
+
+
+static uint8_t *get_match_32(uint8_t *ip, const uint8_t *ip_bound, const uint8_t *ref) {
+
+  while (ip < (ip_bound - sizeof(__m256i))) {
+    __m256i value, value2, cmp;
+    value = _mm256_loadu_si256((__m256i *) ip);
+    value2 = _mm256_loadu_si256((__m256i *)ref);
+    cmp = _mm256_cmpeq_epi64(value, value2);
+    if ((unsigned)_mm256_movemask_epi8(cmp) != 0xFFFFFFFF) {
+      /* Return the byte that starts to differ */
+      while (*ref++ == *ip++) {}
+      return ip;
+    }
+    else {
+      ip += sizeof(__m256i);
+      ref += sizeof(__m256i);
+    }
+  }
+  /* Look into the remainder */
+  while ((ip < ip_bound) && (*ref++ == *ip++)) {}
+  return ip;
+}
+
+
+#define BLOSCLZ_COMPRESS blosclz_compress_avx2
+#define BLOSCLZ_DECOMPRESS blosclz_decompress_avx2
+/* Experiments say that the portable get_run is faster than vectorized ones */
+#define BLOSCLZ_GET_RUN get_run
+#define BLOSCLZ_GET_MATCH get_match_32
+/* Short overlapping matches are decoded with SSSE3 shuffles */
+#define BLOSCLZ_COPY_MATCH_16
+#include "blosclz-impl.h"
+
+const bool is_blosclz_avx2 = true;
+
+#else /* defined(__AVX2__) */
+
+const bool is_blosclz_avx2 = false;
+
+int blosclz_compress_avx2(int clevel, const void* input, int length,
+                          void* output, int maxout, blosc2_context* ctx) {
+  abort();
+}
+
+int blosclz_decompress_avx2(const void* input, int length, void* output, int maxout) {
+  abort();
+}
+
+#endif /* defined(__AVX2__) */
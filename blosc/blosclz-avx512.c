@@ -0,0 +1,67 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "blosclz-avx512.h"
+#include <stdlib.h>
+
+/* Make sure AVX512 is available for the compilation target and compiler. */
+#if defined(__AVX512BW__)
+
+#include <immintrin.h>
+
+#include <stdint.h>
+
+
+static uint8_t *get_match_64(uint8_t *ip, const uint8_t *ip_bound, const uint8_t *ref) {
+
+  while (ip < (ip_bound - sizeof(__m512i))) {
+    __m512i value = _mm512_loadu_si512((const void *) ip);
+    __m512i value2 = _mm512_loadu_si512((const void *) ref);
+    if (_mm512_cmpneq_epi8_mask(value, value2) != 0) {
+      /* Return the byte that starts to differ */
+      while (*ref++ == *ip++) {}
+      return ip;
+    }
+    else {
+      ip += sizeof(__m512i);
+      ref += sizeof(__m512i);
+    }
+  }
+  /* Look into the remainder */
+  while ((ip < ip_bound) && (*ref++ == *ip++)) {}
+  return ip;
+}
+
+
+#define BLOSCLZ_COMPRESS blosclz_compress_avx512
+#define BLOSCLZ_DECOMPRESS blosclz_decompress_avx512
+/* Experiments say that the portable get_run is faster than vectorized ones */
+#define BLOSCLZ_GET_RUN get_run
+#define BLOSCLZ_GET_MATCH get_match_64
+/* Short overlapping matches are decoded with SSSE3 shuffles */
+#define BLOSCLZ_COPY_MATCH_16
+#include "blosclz-impl.h"
+
+const bool is_blosclz_avx512 = true;
+
+#else /* defined(__AVX512BW__) */
+
+const bool is_blosclz_avx512 = false;
+
+int blosclz_compress_avx512(int clevel, const void* input, int length,
+                            void* output, int maxout, blosc2_context* ctx) {
+  abort();
+}
+
+int blosclz_decompress_avx512(const void* input, int length, void* output, int maxout) {
+  abort();
+}
+
+#endif /* defined(__AVX512BW__) */
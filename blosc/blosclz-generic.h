@@ -0,0 +1,30 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/* Generic (non-hardware-accelerated) BloscLZ codec. */
+
+#ifndef BLOSC_BLOSCLZ_GENERIC_H
+#define BLOSC_BLOSCLZ_GENERIC_H
+
+#include "context.h"
+#include "blosc2/blosc2-common.h"
+
+/**
+  blosclz_compress() with the portable match finder.
+*/
+BLOSC_NO_EXPORT int blosclz_compress_generic(int clevel, const void* input, int length,
+                                             void* output, int maxout, blosc2_context* ctx);
+
+/**
+  blosclz_decompress() without hardware acceleration.
+*/
+BLOSC_NO_EXPORT int blosclz_decompress_generic(const void* input, int length, void* output, int maxout);
+
+#endif /* BLOSC_BLOSCLZ_GENERIC_H */
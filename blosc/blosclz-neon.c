@@ -0,0 +1,64 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "blosclz-neon.h"
+#include <stdlib.h>
+
+/* Make sure NEON is available for the compilation target and compiler. */
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#include <stdint.h>
+
+
+static uint8_t *get_match_neon(uint8_t *ip, const uint8_t *ip_bound, const uint8_t *ref) {
+
+  while (ip < (ip_bound - sizeof(uint8x16_t))) {
+    uint64x2_t cmp = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(ip), vld1q_u8(ref)));
+    if ((vgetq_lane_u64(cmp, 0) & vgetq_lane_u64(cmp, 1)) != UINT64_MAX) {
+      /* Return the byte that starts to differ */
+      while (*ref++ == *ip++) {}
+      return ip;
+    }
+    else {
+      ip += sizeof(uint8x16_t);
+      ref += sizeof(uint8x16_t);
+    }
+  }
+  /* Look into the remainder */
+  while ((ip < ip_bound) && (*ref++ == *ip++)) {}
+  return ip;
+}
+
+
+#define BLOSCLZ_COMPRESS blosclz_compress_neon
+#define BLOSCLZ_DECOMPRESS blosclz_decompress_neon
+/* Experiments say that the portable get_run is faster than vectorized ones */
+#define BLOSCLZ_GET_RUN get_run
+#define BLOSCLZ_GET_MATCH get_match_neon
+#include "blosclz-impl.h"
+
+const bool is_blosclz_neon = true;
+
+#else /* defined(__ARM_NEON) */
+
+const bool is_blosclz_neon = false;
+
+int blosclz_compress_neon(int clevel, const void* input, int length,
+                          void* output, int maxout, blosc2_context* ctx) {
+  abort();
+}
+
+int blosclz_decompress_neon(const void* input, int length, void* output, int maxout) {
+  abort();
+}
+
+#endif /* defined(__ARM_NEON) */
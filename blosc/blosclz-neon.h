@@ -0,0 +1,37 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/* NEON-accelerated BloscLZ codec. */
+
+#ifndef BLOSC_BLOSCLZ_NEON_H
+#define BLOSC_BLOSCLZ_NEON_H
+
+#include "context.h"
+#include "blosc2/blosc2-common.h"
+
+#include <stdbool.h>
+
+/**
+ * NEON-accelerated BloscLZ availability.
+*/
+extern const bool is_blosclz_neon;
+
+/**
+  blosclz_compress() with the NEON match finder.
+*/
+BLOSC_NO_EXPORT int blosclz_compress_neon(int clevel, const void* input, int length,
+                                          void* output, int maxout, blosc2_context* ctx);
+
+/**
+  blosclz_decompress() compiled for NEON.
+*/
+BLOSC_NO_EXPORT int blosclz_decompress_neon(const void* input, int length, void* output, int maxout);
+
+#endif /* BLOSC_BLOSCLZ_NEON_H */
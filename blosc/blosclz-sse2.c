@@ -0,0 +1,67 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "blosclz-sse2.h"
+#include <stdlib.h>
+
+/* Make sure SSE2 is available for the compilation target and compiler. */
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#include <stdint.h>
+
+
+static uint8_t *get_match_16(uint8_t *ip, const uint8_t *ip_bound, const uint8_t *ref) {
+  __m128i value, value2, cmp;
+
+  while (ip < (ip_bound - sizeof(__m128i))) {
+    value = _mm_loadu_si128((__m128i *) ip);
+    value2 = _mm_loadu_si128((__m128i *) ref);
+    cmp = _mm_cmpeq_epi32(value, value2);
+    if (_mm_movemask_epi8(cmp) != 0xFFFF) {
+      /* Return the byte that starts to differ */
+      while (*ref++ == *ip++) {}
+      return ip;
+    }
+    else {
+      ip += sizeof(__m128i);
+      ref += sizeof(__m128i);
+    }
+  }
+  /* Look into the remainder */
+  while ((ip < ip_bound) && (*ref++ == *ip++)) {}
+  return ip;
+}
+
+
+#define BLOSCLZ_COMPRESS blosclz_compress_sse2
+#define BLOSCLZ_DECOMPRESS blosclz_decompress_sse2
+/* Experiments say that the portable get_run is faster than vectorized ones */
+#define BLOSCLZ_GET_RUN get_run
+#define BLOSCLZ_GET_MATCH get_match_16
+#include "blosclz-impl.h"
+
+const bool is_blosclz_sse2 = true;
+
+#else /* defined(__SSE2__) */
+
+const bool is_blosclz_sse2 = false;
+
+int blosclz_compress_sse2(int clevel, const void* input, int length,
+                          void* output, int maxout, blosc2_context* ctx) {
+  abort();
+}
+
+int blosclz_decompress_sse2(const void* input, int length, void* output, int maxout) {
+  abort();
+}
+
+#endif /* defined(__SSE2__) */
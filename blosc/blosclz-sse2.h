@@ -0,0 +1,37 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/* SSE2-accelerated BloscLZ codec. */
+
+#ifndef BLOSC_BLOSCLZ_SSE2_H
+#define BLOSC_BLOSCLZ_SSE2_H
+
+#include "context.h"
+#include "blosc2/blosc2-common.h"
+
+#include <stdbool.h>
+
+/**
+ * SSE2-accelerated BloscLZ availability.
+*/
+extern const bool is_blosclz_sse2;
+
+/**
+  blosclz_compress() with the SSE2 match finder.
+*/
+BLOSC_NO_EXPORT int blosclz_compress_sse2(int clevel, const void* input, int length,
+                                          void* output, int maxout, blosc2_context* ctx);
+
+/**
+  blosclz_decompress() compiled for SSE2.
+*/
+BLOSC_NO_EXPORT int blosclz_decompress_sse2(const void* input, int length, void* output, int maxout);
+
+#endif /* BLOSC_BLOSCLZ_SSE2_H */
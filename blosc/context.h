@@ -13,6 +13,7 @@
 
 #include "b2nd.h"
 #include "blosc2.h"
+#include "scratch.h"
 
 #if defined(HAVE_ZSTD)
 #include "zstd.h"
@@ -110,6 +111,28 @@ struct blosc2_context_s {
   blosc2_pthread_mutex_t jobs_mutex;    /* guards job_seq, end_threads, active_workers */
   blosc2_pthread_cond_t jobs_ready;     /* workers sleep here between jobs */
   blosc2_pthread_cond_t jobs_done;      /* main sleeps here until job completes */
+  /* Dictionary shared by all the chunks of the associated super-chunk */
+  int32_t dict_nchunks;  /* Number of chunks to train the shared dictionary from */
+  bool schunk_dict_checked;  /* Whether the super-chunk has been looked up for a shared dictionary */
+  void* schunk_dict;  /* The shared dictionary (NULL if not trained or loaded yet) */
+  int32_t schunk_dict_size;  /* The size of the shared dictionary */
+  uint32_t schunk_dict_id;  /* The checksum of the shared dictionary, kept by the chunks using it */
+  void* schunk_cdict;  /* The shared dictionary in digested form for compression */
+  int schunk_cdict_compcode;  /* The codec schunk_cdict has been digested for */
+  void* schunk_ddict;  /* The shared dictionary in digested form for decompression */
+  uint8_t* dict_samples;  /* Samples from the first chunks for training the shared dictionary */
+  size_t* dict_samples_sizes;  /* The sizes of the samples */
+  uint32_t dict_nsamples;  /* The number of samples */
+  size_t dict_samples_nbytes;  /* The total size of the samples */
+  int32_t dict_nchunks_sampled;  /* The number of chunks sampled so far */
+  /* Blocks of a lazy chunk read in advance by prefetch_lazy_blocks() */
+  uint8_t* lazy_blocks;  /* The (merged) ranges of blocks read */
+  size_t lazy_blocks_size;  /* The allocated size of lazy_blocks */
+  int32_t* lazy_block_offsets;  /* The offset of every block in lazy_blocks (-1 if not read) */
+  int32_t lazy_block_noffsets;  /* The allocated items in lazy_block_offsets */
+  bool lazy_blocks_ready;  /* Whether the blocks of the current lazy chunk are in lazy_blocks */
+  scratch_arena scratch;  /* Recycled temporaries of the (de)compression calls */
+  void* pool_entries;  /* The shared pool queue entries of the jobs (from scratch) */
   // Add new fields here to avoid breaking the ABI.
 };
 
@@ -0,0 +1,132 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "delta-avx2.h"
+#include <stdlib.h>
+
+/* Make sure AVX2 is available for the compilation target and compiler. */
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include <stdint.h>
+
+
+void delta_xor_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dest, int32_t nbytes) {
+  int32_t i;
+  for (i = 0; i + 4 * (int32_t)sizeof(__m256i) <= nbytes; i += 4 * (int32_t)sizeof(__m256i)) {
+    __m256i ymm[4];
+    int k;
+    for (k = 0; k < 4; k++) {
+      ymm[k] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i) + k),
+                                _mm256_loadu_si256((const __m256i *)(b + i) + k));
+    }
+    for (k = 0; k < 4; k++) {
+      _mm256_storeu_si256((__m256i *)(dest + i) + k, ymm[k]);
+    }
+  }
+  for (; i + (int32_t)sizeof(__m256i) <= nbytes; i += (int32_t)sizeof(__m256i)) {
+    _mm256_storeu_si256((__m256i *)(dest + i),
+                        _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                         _mm256_loadu_si256((const __m256i *)(b + i))));
+  }
+  for (; i < nbytes; i++) {
+    dest[i] = a[i] ^ b[i];
+  }
+}
+
+/* Broadcast the last element (of 1, 2, 4 or 8 bytes) of each 128-bit lane
+   to the whole lane */
+static inline __m256i broadcast_last1(__m256i ymm) {
+  return _mm256_shuffle_epi8(ymm, _mm256_set1_epi8(15));
+}
+
+static inline __m256i broadcast_last2(__m256i ymm) {
+  return _mm256_shuffle_epi32(_mm256_shufflehi_epi16(ymm, 0xff), 0xff);
+}
+
+static inline __m256i broadcast_last4(__m256i ymm) {
+  return _mm256_shuffle_epi32(ymm, 0xff);
+}
+
+static inline __m256i broadcast_last8(__m256i ymm) {
+  return _mm256_unpackhi_epi64(ymm, ymm);
+}
+
+/* Byte shifts only work inside 128-bit lanes, so each lane is scanned on its
+   own, and then the last element of the low lane is xor-ed to the high one.
+   As in the SSE2 version, the carry between registers is computed from the
+   carry and the scan of the current register, off the critical path. */
+#define DEFINE_XOR_SCAN(STRIDE)                                                 \
+static void xor_scan##STRIDE(uint8_t *buf, int32_t nbytes) {                    \
+  __m256i carry = _mm256_setzero_si256();                                       \
+  int32_t i;                                                                    \
+  for (i = 0; i + 32 <= nbytes; i += 32) {                                      \
+    __m256i ymm = _mm256_loadu_si256((const __m256i *)(buf + i));               \
+    ymm = _mm256_xor_si256(ymm, _mm256_slli_si256(ymm, STRIDE));                \
+    if (STRIDE < 8) {                                                           \
+      ymm = _mm256_xor_si256(ymm, _mm256_slli_si256(ymm, 2 * STRIDE));          \
+    }                                                                           \
+    if (STRIDE < 4) {                                                           \
+      ymm = _mm256_xor_si256(ymm, _mm256_slli_si256(ymm, 4 * STRIDE));          \
+    }                                                                           \
+    if (STRIDE < 2) {                                                           \
+      ymm = _mm256_xor_si256(ymm, _mm256_slli_si256(ymm, 8 * STRIDE));          \
+    }                                                                           \
+    /* Low lane's last element to the high lane (the low lane gets zeros) */    \
+    __m256i last = broadcast_last##STRIDE(ymm);                                 \
+    ymm = _mm256_xor_si256(ymm, _mm256_permute2x128_si256(last, last, 0x08));   \
+    _mm256_storeu_si256((__m256i *)(buf + i), _mm256_xor_si256(ymm, carry));    \
+    last = broadcast_last##STRIDE(ymm);                                         \
+    carry = _mm256_xor_si256(carry, _mm256_permute2x128_si256(last, last, 0x11)); \
+  }                                                                             \
+  /* The remainder (and buffers shorter than a register) */                     \
+  for (i = (i > 0) ? i : STRIDE; i < nbytes; i++) {                             \
+    buf[i] ^= buf[i - STRIDE];                                                  \
+  }                                                                             \
+}
+
+DEFINE_XOR_SCAN(1)
+DEFINE_XOR_SCAN(2)
+DEFINE_XOR_SCAN(4)
+DEFINE_XOR_SCAN(8)
+
+void delta_xor_scan_avx2(int32_t stride, uint8_t *buf, int32_t nbytes) {
+  switch (stride) {
+    case 1:
+      xor_scan1(buf, nbytes);
+      break;
+    case 2:
+      xor_scan2(buf, nbytes);
+      break;
+    case 4:
+      xor_scan4(buf, nbytes);
+      break;
+    default:
+      xor_scan8(buf, nbytes);
+      break;
+  }
+}
+
+const bool is_delta_avx2 = true;
+
+#else /* defined(__AVX2__) */
+
+const bool is_delta_avx2 = false;
+
+void delta_xor_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dest, int32_t nbytes) {
+  abort();
+}
+
+void delta_xor_scan_avx2(int32_t stride, uint8_t *buf, int32_t nbytes) {
+  abort();
+}
+
+#endif /* defined(__AVX2__) */
@@ -0,0 +1,38 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/* AVX2-accelerated kernels for the delta filter. */
+
+#ifndef BLOSC_DELTA_AVX2_H
+#define BLOSC_DELTA_AVX2_H
+
+#include "blosc2/blosc2-common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * AVX2-accelerated delta kernels availability.
+*/
+extern const bool is_delta_avx2;
+
+/**
+  Set dest[i] = a[i] ^ b[i] for nbytes bytes.  dest may be the same as a.
+*/
+BLOSC_NO_EXPORT void delta_xor_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dest,
+                                    int32_t nbytes);
+
+/**
+  Set buf[i] ^= buf[i - stride] in place for i = stride .. nbytes - 1, in
+  increasing order.  stride must be 1, 2, 4 or 8 and nbytes a multiple of it.
+*/
+BLOSC_NO_EXPORT void delta_xor_scan_avx2(int32_t stride, uint8_t *buf, int32_t nbytes);
+
+#endif /* BLOSC_DELTA_AVX2_H */
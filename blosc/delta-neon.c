@@ -0,0 +1,125 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "delta-neon.h"
+#include <stdlib.h>
+
+/* Make sure NEON is available for the compilation target and compiler. */
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#include <stdint.h>
+
+
+void delta_xor_neon(const uint8_t *a, const uint8_t *b, uint8_t *dest, int32_t nbytes) {
+  int32_t i;
+  for (i = 0; i + 64 <= nbytes; i += 64) {
+    uint8x16_t v[4];
+    int k;
+    for (k = 0; k < 4; k++) {
+      v[k] = veorq_u8(vld1q_u8(a + i + k * 16), vld1q_u8(b + i + k * 16));
+    }
+    for (k = 0; k < 4; k++) {
+      vst1q_u8(dest + i + k * 16, v[k]);
+    }
+  }
+  for (; i + 16 <= nbytes; i += 16) {
+    vst1q_u8(dest + i, veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+  }
+  for (; i < nbytes; i++) {
+    dest[i] = a[i] ^ b[i];
+  }
+}
+
+/* Broadcast the last element (of 1, 2, 4 or 8 bytes) of a register */
+static inline uint8x16_t broadcast_last1(uint8x16_t v) {
+  return vdupq_n_u8(vgetq_lane_u8(v, 15));
+}
+
+static inline uint8x16_t broadcast_last2(uint8x16_t v) {
+  return vreinterpretq_u8_u16(vdupq_n_u16(vgetq_lane_u16(vreinterpretq_u16_u8(v), 7)));
+}
+
+static inline uint8x16_t broadcast_last4(uint8x16_t v) {
+  return vreinterpretq_u8_u32(vdupq_n_u32(vgetq_lane_u32(vreinterpretq_u32_u8(v), 3)));
+}
+
+static inline uint8x16_t broadcast_last8(uint8x16_t v) {
+  uint64x1_t hi = vget_high_u64(vreinterpretq_u64_u8(v));
+  return vreinterpretq_u8_u64(vcombine_u64(hi, hi));
+}
+
+/* Same scheme as the SSE2 version: a shift and xor scan of each register
+   (vextq_u8 with a zero register shifts bytes up), plus a carry holding the
+   last element so far. */
+#define DEFINE_XOR_SCAN(STRIDE)                                                 \
+static void xor_scan##STRIDE(uint8_t *buf, int32_t nbytes) {                    \
+  const uint8x16_t zero = vdupq_n_u8(0);                                        \
+  uint8x16_t carry = zero;                                                      \
+  int32_t i;                                                                    \
+  for (i = 0; i + 16 <= nbytes; i += 16) {                                      \
+    uint8x16_t v = vld1q_u8(buf + i);                                           \
+    v = veorq_u8(v, vextq_u8(zero, v, 16 - STRIDE));                            \
+    if (STRIDE < 8) {                                                           \
+      v = veorq_u8(v, vextq_u8(zero, v, (16 - 2 * STRIDE) & 15));               \
+    }                                                                           \
+    if (STRIDE < 4) {                                                           \
+      v = veorq_u8(v, vextq_u8(zero, v, (16 - 4 * STRIDE) & 15));               \
+    }                                                                           \
+    if (STRIDE < 2) {                                                           \
+      v = veorq_u8(v, vextq_u8(zero, v, (16 - 8 * STRIDE) & 15));               \
+    }                                                                           \
+    vst1q_u8(buf + i, veorq_u8(v, carry));                                      \
+    carry = veorq_u8(carry, broadcast_last##STRIDE(v));                         \
+  }                                                                             \
+  /* The remainder (and buffers shorter than a register) */                     \
+  for (i = (i > 0) ? i : STRIDE; i < nbytes; i++) {                             \
+    buf[i] ^= buf[i - STRIDE];                                                  \
+  }                                                                             \
+}
+
+DEFINE_XOR_SCAN(1)
+DEFINE_XOR_SCAN(2)
+DEFINE_XOR_SCAN(4)
+DEFINE_XOR_SCAN(8)
+
+void delta_xor_scan_neon(int32_t stride, uint8_t *buf, int32_t nbytes) {
+  switch (stride) {
+    case 1:
+      xor_scan1(buf, nbytes);
+      break;
+    case 2:
+      xor_scan2(buf, nbytes);
+      break;
+    case 4:
+      xor_scan4(buf, nbytes);
+      break;
+    default:
+      xor_scan8(buf, nbytes);
+      break;
+  }
+}
+
+const bool is_delta_neon = true;
+
+#else /* defined(__ARM_NEON) */
+
+const bool is_delta_neon = false;
+
+void delta_xor_neon(const uint8_t *a, const uint8_t *b, uint8_t *dest, int32_t nbytes) {
+  abort();
+}
+
+void delta_xor_scan_neon(int32_t stride, uint8_t *buf, int32_t nbytes) {
+  abort();
+}
+
+#endif /* defined(__ARM_NEON) */
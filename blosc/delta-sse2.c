@@ -0,0 +1,130 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "delta-sse2.h"
+#include <stdlib.h>
+
+/* Make sure SSE2 is available for the compilation target and compiler. */
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#include <stdint.h>
+
+
+void delta_xor_sse2(const uint8_t *a, const uint8_t *b, uint8_t *dest, int32_t nbytes) {
+  int32_t i;
+  for (i = 0; i + 4 * (int32_t)sizeof(__m128i) <= nbytes; i += 4 * (int32_t)sizeof(__m128i)) {
+    __m128i xmm[4];
+    int k;
+    for (k = 0; k < 4; k++) {
+      xmm[k] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i) + k),
+                             _mm_loadu_si128((const __m128i *)(b + i) + k));
+    }
+    for (k = 0; k < 4; k++) {
+      _mm_storeu_si128((__m128i *)(dest + i) + k, xmm[k]);
+    }
+  }
+  for (; i + (int32_t)sizeof(__m128i) <= nbytes; i += (int32_t)sizeof(__m128i)) {
+    _mm_storeu_si128((__m128i *)(dest + i),
+                     _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i)),
+                                   _mm_loadu_si128((const __m128i *)(b + i))));
+  }
+  for (; i < nbytes; i++) {
+    dest[i] = a[i] ^ b[i];
+  }
+}
+
+/* Broadcast the last element of a register (of 1, 2, 4 or 8 bytes) */
+static inline __m128i broadcast_last1(__m128i xmm) {
+  xmm = _mm_unpackhi_epi8(xmm, xmm);
+  return _mm_shuffle_epi32(_mm_shufflehi_epi16(xmm, 0xff), 0xff);
+}
+
+static inline __m128i broadcast_last2(__m128i xmm) {
+  return _mm_shuffle_epi32(_mm_shufflehi_epi16(xmm, 0xff), 0xff);
+}
+
+static inline __m128i broadcast_last4(__m128i xmm) {
+  return _mm_shuffle_epi32(xmm, 0xff);
+}
+
+static inline __m128i broadcast_last8(__m128i xmm) {
+  return _mm_unpackhi_epi64(xmm, xmm);
+}
+
+/* The scan of one register (elements of STRIDE bytes) is done in log2(16 / STRIDE)
+   shift and xor steps.  Elements of a register only depend on the previous one
+   through the last element of the previous register, which is xor-ed to all of
+   them (the carry).  The carry for the next register is computed from the
+   carry and the scan of this register alone, so it is the only dependency
+   between iterations. */
+#define DEFINE_XOR_SCAN(STRIDE)                                                 \
+static void xor_scan##STRIDE(uint8_t *buf, int32_t nbytes) {                    \
+  __m128i carry = _mm_setzero_si128();                                          \
+  int32_t i;                                                                    \
+  for (i = 0; i + 16 <= nbytes; i += 16) {                                      \
+    __m128i xmm = _mm_loadu_si128((const __m128i *)(buf + i));                  \
+    xmm = _mm_xor_si128(xmm, _mm_slli_si128(xmm, STRIDE));                      \
+    if (STRIDE < 8) {                                                           \
+      xmm = _mm_xor_si128(xmm, _mm_slli_si128(xmm, 2 * STRIDE));                \
+    }                                                                           \
+    if (STRIDE < 4) {                                                           \
+      xmm = _mm_xor_si128(xmm, _mm_slli_si128(xmm, 4 * STRIDE));                \
+    }                                                                           \
+    if (STRIDE < 2) {                                                           \
+      xmm = _mm_xor_si128(xmm, _mm_slli_si128(xmm, 8 * STRIDE));                \
+    }                                                                           \
+    _mm_storeu_si128((__m128i *)(buf + i), _mm_xor_si128(xmm, carry));          \
+    carry = _mm_xor_si128(carry, broadcast_last##STRIDE(xmm));                  \
+  }                                                                             \
+  /* The remainder (and buffers shorter than a register) */                     \
+  for (i = (i > 0) ? i : STRIDE; i < nbytes; i++) {                             \
+    buf[i] ^= buf[i - STRIDE];                                                  \
+  }                                                                             \
+}
+
+DEFINE_XOR_SCAN(1)
+DEFINE_XOR_SCAN(2)
+DEFINE_XOR_SCAN(4)
+DEFINE_XOR_SCAN(8)
+
+void delta_xor_scan_sse2(int32_t stride, uint8_t *buf, int32_t nbytes) {
+  switch (stride) {
+    case 1:
+      xor_scan1(buf, nbytes);
+      break;
+    case 2:
+      xor_scan2(buf, nbytes);
+      break;
+    case 4:
+      xor_scan4(buf, nbytes);
+      break;
+    default:
+      xor_scan8(buf, nbytes);
+      break;
+  }
+}
+
+const bool is_delta_sse2 = true;
+
+#else /* defined(__SSE2__) */
+
+const bool is_delta_sse2 = false;
+
+void delta_xor_sse2(const uint8_t *a, const uint8_t *b, uint8_t *dest, int32_t nbytes) {
+  abort();
+}
+
+void delta_xor_scan_sse2(int32_t stride, uint8_t *buf, int32_t nbytes) {
+  abort();
+}
+
+#endif /* defined(__SSE2__) */
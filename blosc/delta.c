@@ -9,14 +9,30 @@
 **********************************************************************/
 
 #include "delta.h"
+#include "shuffle.h"
+
+/*  Include hardware-accelerated kernels based on the target architecture,
+    with the same symbols that shuffle.c uses. */
+#if defined(SHUFFLE_AVX2_ENABLED)
+  #include "delta-avx2.h"
+#endif  /* defined(SHUFFLE_AVX2_ENABLED) */
+
+#if defined(SHUFFLE_SSE2_ENABLED)
+  #include "delta-sse2.h"
+#endif  /* defined(SHUFFLE_SSE2_ENABLED) */
+
+#if defined(SHUFFLE_NEON_ENABLED)
+  #include "delta-neon.h"
+#endif  /* defined(SHUFFLE_NEON_ENABLED) */
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 
-/* Apply the delta filters to src.  This can never fail. */
-void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes, int32_t typesize,
-                   const uint8_t* src, uint8_t* dest) {
+/* Apply the delta filters to src (scalar version).  This can never fail. */
+static void delta_encoder_generic(const uint8_t* dref, int32_t offset, int32_t nbytes,
+                                  int32_t typesize, const uint8_t* src, uint8_t* dest) {
   int32_t i;
   if (offset == 0) {
     /* This is the reference block, use delta coding in elements */
@@ -50,9 +66,9 @@ void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes, int32_t
         break;
       default:
         if ((typesize % 8) == 0) {
-          delta_encoder(dref, offset, nbytes, 8, src, dest);
+          delta_encoder_generic(dref, offset, nbytes, 8, src, dest);
         } else {
-          delta_encoder(dref, offset, nbytes, 1, src, dest);
+          delta_encoder_generic(dref, offset, nbytes, 1, src, dest);
         }
     }
   } else {
@@ -83,18 +99,18 @@ void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes, int32_t
         break;
       default:
         if ((typesize % 8) == 0) {
-          delta_encoder(dref, offset, nbytes, 8, src, dest);
+          delta_encoder_generic(dref, offset, nbytes, 8, src, dest);
         } else {
-          delta_encoder(dref, offset, nbytes, 1, src, dest);
+          delta_encoder_generic(dref, offset, nbytes, 1, src, dest);
         }
     }
   }
 }
 
 
-/* Undo the delta filter in dest.  This can never fail. */
-void delta_decoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
-                   int32_t typesize, uint8_t* dest) {
+/* Undo the delta filter in dest (scalar version).  This can never fail. */
+static void delta_decoder_generic(const uint8_t* dref, int32_t offset, int32_t nbytes,
+                                  int32_t typesize, uint8_t* dest) {
   int32_t i;
 
   if (offset == 0) {
@@ -122,9 +138,9 @@ void delta_decoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
         break;
       default:
         if ((typesize % 8) == 0) {
-          delta_decoder(dref, offset, nbytes, 8, dest);
+          delta_decoder_generic(dref, offset, nbytes, 8, dest);
         } else {
-          delta_decoder(dref, offset, nbytes, 1, dest);
+          delta_decoder_generic(dref, offset, nbytes, 1, dest);
         }
     }
   } else {
@@ -152,10 +168,141 @@ void delta_decoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
         break;
       default:
         if ((typesize % 8) == 0) {
-          delta_decoder(dref, offset, nbytes, 8, dest);
+          delta_decoder_generic(dref, offset, nbytes, 8, dest);
         } else {
-          delta_decoder(dref, offset, nbytes, 1, dest);
+          delta_decoder_generic(dref, offset, nbytes, 1, dest);
         }
     }
   }
 }
+
+
+/*  Define function pointer types for the accelerated kernels. */
+typedef void(* delta_xor_func)(const uint8_t*, const uint8_t*, uint8_t*, int32_t);
+typedef void(* delta_xor_scan_func)(int32_t, uint8_t*, int32_t);
+
+/* An implementation of the delta kernels. */
+typedef struct delta_implementation {
+  /* Name of this implementation. */
+  const char* name;
+  /* Function pointer to the xor routine (NULL for the scalar filter). */
+  delta_xor_func xor_bytes;
+  /* Function pointer to the xor scan routine (NULL for the scalar filter). */
+  delta_xor_scan_func xor_scan;
+} delta_implementation_t;
+
+static delta_implementation_t get_delta_implementation(void) {
+  delta_implementation_t impl = {"generic", NULL, NULL};
+#if defined(SHUFFLE_AVX2_ENABLED) || defined(SHUFFLE_SSE2_ENABLED) || defined(SHUFFLE_NEON_ENABLED)
+  blosc_cpu_features cpu_features = blosc_get_cpu_features();
+#endif
+#if defined(SHUFFLE_AVX2_ENABLED)
+  if (cpu_features & BLOSC_HAVE_AVX2 && is_delta_avx2) {
+    impl.name = "avx2";
+    impl.xor_bytes = delta_xor_avx2;
+    impl.xor_scan = delta_xor_scan_avx2;
+    return impl;
+  }
+#endif  /* defined(SHUFFLE_AVX2_ENABLED) */
+
+#if defined(SHUFFLE_SSE2_ENABLED)
+  if (cpu_features & BLOSC_HAVE_SSE2 && is_delta_sse2) {
+    impl.name = "sse2";
+    impl.xor_bytes = delta_xor_sse2;
+    impl.xor_scan = delta_xor_scan_sse2;
+    return impl;
+  }
+#endif  /* defined(SHUFFLE_SSE2_ENABLED) */
+
+#if defined(SHUFFLE_NEON_ENABLED)
+  if (cpu_features & BLOSC_HAVE_NEON && is_delta_neon) {
+    impl.name = "neon";
+    impl.xor_bytes = delta_xor_neon;
+    impl.xor_scan = delta_xor_scan_neon;
+    return impl;
+  }
+#endif  /* defined(SHUFFLE_NEON_ENABLED) */
+
+  return impl;
+}
+
+
+/* Flag indicating whether the implementation has been initialized.
+   As for shuffle, a concurrent initialization is harmless because every
+   thread would choose the same implementation. */
+static int32_t implementation_initialized;
+
+/* The dynamically-chosen delta implementation. */
+static delta_implementation_t host_implementation;
+
+static inline void init_delta_implementation(void) {
+  if (!implementation_initialized) {
+    host_implementation = get_delta_implementation();
+    implementation_initialized = 1;
+  }
+}
+
+/* The delta filter works on elements of 1, 2, 4 or 8 bytes; other type sizes
+   use 8-byte elements when they are a multiple of 8, bytes otherwise. */
+static inline int32_t delta_element_size(int32_t typesize) {
+  switch (typesize) {
+    case 1:
+    case 2:
+    case 4:
+    case 8:
+      return typesize;
+    default:
+      return (typesize % 8) == 0 ? 8 : 1;
+  }
+}
+
+
+/* Apply the delta filters to src.  This can never fail.
+
+   This xors every element with the one at the same position in the reference
+   block (dref), or with the previous element for the reference block itself.
+   Since xor works bitwise, the accelerated kernels only need to know the
+   element size for the reference block.  Trailing bytes that do not make a
+   whole element are left alone, as the scalar filter does. */
+void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes, int32_t typesize,
+                   const uint8_t* src, uint8_t* dest) {
+  init_delta_implementation();
+  int32_t elsize = delta_element_size(typesize);
+  if (host_implementation.xor_bytes == NULL || nbytes < elsize) {
+    delta_encoder_generic(dref, offset, nbytes, typesize, src, dest);
+    return;
+  }
+  nbytes -= nbytes % elsize;
+  if (offset == 0) {
+    memcpy(dest, dref, elsize);
+    host_implementation.xor_bytes(src + elsize, dref, dest + elsize, nbytes - elsize);
+  } else {
+    host_implementation.xor_bytes(src, dref, dest, nbytes);
+  }
+}
+
+
+/* Undo the delta filter in dest.  This can never fail.
+
+   dref must be either dest (for the reference block) or a buffer that does not
+   overlap it.  The reference block decodes in place: each element depends on
+   the previous one, decoded just before, which makes it a prefix xor. */
+void delta_decoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
+                   int32_t typesize, uint8_t* dest) {
+  init_delta_implementation();
+  int32_t elsize = delta_element_size(typesize);
+  if (host_implementation.xor_bytes == NULL || nbytes < elsize) {
+    delta_decoder_generic(dref, offset, nbytes, typesize, dest);
+    return;
+  }
+  nbytes -= nbytes % elsize;
+  if (offset == 0) {
+    if (dref == dest) {
+      host_implementation.xor_scan(elsize, dest, nbytes);
+    } else {
+      host_implementation.xor_bytes(dest + elsize, dref, dest + elsize, nbytes - elsize);
+    }
+  } else {
+    host_implementation.xor_bytes(dest, dref, dest, nbytes);
+  }
+}
@@ -226,13 +226,16 @@ int blosc2_remove_urlpath(const char* urlpath){
       BLOSC_TRACE_ERROR("Could not remove %s", urlpath);
       return BLOSC2_ERROR_FILE_REMOVE;
     }
-    // Also remove the sidecar lock file of a cframe, if any
-    char* lockpath = malloc(strlen(urlpath) + strlen(".b2lock") + 1);
-    if (lockpath != NULL) {
-      strcpy(lockpath, urlpath);
-      strcat(lockpath, ".b2lock");
-      remove(lockpath);  // best-effort; may not exist
-      free(lockpath);
+    // Also remove the sidecar lock file and journal of a cframe, if any
+    const char* sidecars[] = {".b2lock", ".b2journal"};
+    for (int i = 0; i < 2; i++) {
+      char* sidecar = malloc(strlen(urlpath) + strlen(sidecars[i]) + 1);
+      if (sidecar != NULL) {
+        strcpy(sidecar, urlpath);
+        strcat(sidecar, sidecars[i]);
+        remove(sidecar);  // best-effort; may not exist
+        free(sidecar);
+      }
     }
   }
   return BLOSC2_ERROR_SUCCESS;
@@ -31,6 +31,7 @@
 
 #include "frame.h"
 #include "sframe.h"
+#include "journal.h"
 #include "context.h"
 #include "blosc-private.h"
 #include "blosc2.h"
@@ -121,8 +122,8 @@ static int reader_cache_max(void) {
   return cached_max;
 }
 
-/* Claim a slot for one more cached handle, or report that the cache is full */
-static bool reader_cache_claim(void) {
+/* See frame.h */
+bool frame_reader_cache_claim(void) {
   bool claimed = false;
   blosc2_pthread_mutex_lock(&reader_cache_mutex);
   if (reader_cache_count < reader_cache_max()) {
@@ -133,26 +134,50 @@ static bool reader_cache_claim(void) {
   return claimed;
 }
 
-static void reader_cache_return(void) {
+/* See frame.h */
+void frame_reader_cache_return(void) {
   blosc2_pthread_mutex_lock(&reader_cache_mutex);
   if (reader_cache_count > 0) {
     reader_cache_count--;
   }
   blosc2_pthread_mutex_unlock(&reader_cache_mutex);
 }
+#else
+bool frame_reader_cache_claim(void) {
+  return false;
+}
+
+void frame_reader_cache_return(void) {
+}
 #endif  /* !_WIN32 */
 
 
-/* Allocate a zeroed frame with its internal mutex ready */
+/* Allocate a zeroed frame with its internal mutexes ready */
 static blosc2_frame_s* frame_alloc(void) {
   blosc2_frame_s* frame = calloc(1, sizeof(blosc2_frame_s));
   if (frame != NULL) {
     blosc2_pthread_mutex_init(&frame->read_fp_mutex, NULL);
+    // Recursive, for blosc2_schunk_lock() brackets and nested mutations
+    blosc2_pthread_mutex_init_recursive(&frame->write_mutex);
+    blosc2_pthread_mutex_init(&frame->sync_mutex, NULL);
+    blosc2_pthread_cond_init(&frame->sync_cv, NULL);
+    blosc2_pthread_cond_init(&frame->syncer_cv, NULL);
   }
   return frame;
 }
 
 
+/* Undo frame_alloc() */
+static void frame_dealloc(blosc2_frame_s* frame) {
+  blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
+  blosc2_pthread_mutex_destroy(&frame->write_mutex);
+  blosc2_pthread_mutex_destroy(&frame->sync_mutex);
+  blosc2_pthread_cond_destroy(&frame->sync_cv);
+  blosc2_pthread_cond_destroy(&frame->syncer_cv);
+  free(frame);
+}
+
+
 /* See frame.h */
 void* frame_reader_acquire(blosc2_frame_s* frame, const blosc2_io* io) {
   blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
@@ -160,7 +185,7 @@ void* frame_reader_acquire(blosc2_frame_s* frame, const blosc2_io* io) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
     return NULL;
   }
-  if (io->id != BLOSC2_IO_FILESYSTEM) {
+  if (io->id != BLOSC2_IO_FILESYSTEM && io->id != BLOSC2_IO_FILESYSTEM_URING) {
     // Third-party backends keep the documented one-handle-per-reader contract
     // (and the mmap one already makes open() a cheap pointer return).
     return io_cb->open(frame->urlpath, "rb", io->params);
@@ -185,10 +210,10 @@ void* frame_reader_acquire(blosc2_frame_s* frame, const blosc2_io* io) {
   // handful of ns against the ~600 ns pread this hands a handle to.
   blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
   if (frame->read_fp == NULL && !frame->read_fp_nocache) {
-    if (reader_cache_claim()) {
+    if (frame_reader_cache_claim()) {
       frame->read_fp = io_cb->open(frame->urlpath, "rb", io->params);
       if (frame->read_fp == NULL) {
-        reader_cache_return();
+        frame_reader_cache_return();
       }
     }
     else {
@@ -219,6 +244,11 @@ void frame_reader_release(blosc2_frame_s* frame, const blosc2_io_cb* io_cb, void
   if (fp == NULL) {
     return;
   }
+  if (frame->sframe) {
+    // Chunk files come from their own cache
+    sframe_release_chunk(frame, io_cb, fp);
+    return;
+  }
   // Same reasoning as in frame_reader_acquire(): read_fp is only ever read
   // under the mutex, so a concurrent first open cannot race this comparison.
   blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
@@ -255,7 +285,7 @@ static bool frame_reader_close_locked(blosc2_frame_s* frame, bool force) {
   frame->read_fp = NULL;
   frame->read_fp_refs = 0;
 #if !defined(_WIN32)
-  reader_cache_return();
+  frame_reader_cache_return();
 #endif
   return true;
 }
@@ -330,8 +360,7 @@ blosc2_frame_s* frame_new(const char* urlpath) {
   if (urlpath != NULL) {
     char* new_urlpath = malloc(strlen(urlpath) + 1);  // + 1 for the trailing NULL
     if (new_urlpath == NULL) {
-      blosc2_pthread_mutex_destroy(&new_frame->read_fp_mutex);
-      free(new_frame);
+      frame_dealloc(new_frame);
       return NULL;
     }
     new_frame->urlpath = strcpy(new_urlpath, urlpath);
@@ -346,7 +375,7 @@ blosc2_frame_s* frame_new(const char* urlpath) {
    frame_set_locking() so callers without a frame object yet (e.g. the open
    path's pre-frame bootstrap read) can also ask the question. */
 bool frame_locking_requested(const blosc2_io* io) {
-  if (io == NULL || io->id != BLOSC2_IO_FILESYSTEM) {
+  if (io == NULL || (io->id != BLOSC2_IO_FILESYSTEM && io->id != BLOSC2_IO_FILESYSTEM_URING)) {
     return false;
   }
   bool locking = io->params != NULL && ((blosc2_stdio_params*)io->params)->locking;
@@ -556,11 +585,295 @@ int frame_unlock(blosc2_frame_s* frame) {
 }
 
 
+int frame_write_lock(blosc2_frame_s* frame) {
+  if (frame == NULL) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  blosc2_pthread_mutex_lock(&frame->write_mutex);
+  int rc = frame_lock(frame, true);
+  if (rc < 0) {
+    blosc2_pthread_mutex_unlock(&frame->write_mutex);
+    return rc;
+  }
+  frame->write_depth++;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* See frame.h */
+void frame_sync_dir(const char* urlpath, bool sframe) {
+#if defined(_WIN32)
+  BLOSC_UNUSED_PARAM(urlpath);
+  BLOSC_UNUSED_PARAM(sframe);
+#else
+  char* dir = NULL;
+  if (sframe) {
+    dir = strdup(urlpath);
+  }
+  else {
+    const char* slash = strrchr(urlpath, '/');
+    dir = slash == NULL ? strdup(".") : strndup(urlpath, (size_t)(slash - urlpath) + 1);
+  }
+  int fd = dir == NULL ? -1 : open(dir, O_RDONLY | O_CLOEXEC);
+  free(dir);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+#endif
+}
+
+
+/* See frame.h */
+int frame_sync_files(blosc2_frame_s* frame, const int64_t* ids, int64_t nids) {
+  const blosc2_io* io = frame->schunk->storage->io;
+  int rc = BLOSC2_ERROR_SUCCESS;
+  if (frame->sframe) {
+    rc = sframe_sync_files(frame, ids, nids);
+  }
+  else {
+    blosc2_io_cb* io_cb = blosc2_get_io_cb(io->id);
+    blosc2_io_cb_ext* io_ext = blosc2_get_io_cb_ext(io->id);
+    if (io_cb == NULL || io_ext == NULL) {
+      BLOSC_TRACE_ERROR("Error getting the input/output API");
+      rc = BLOSC2_ERROR_PLUGIN_IO;
+    }
+    else if (io_ext->sync != NULL) {
+      // Writable, as Windows cannot flush the others
+      void* fp = io_cb->open(frame->urlpath, "rb+", io->params);
+      if (fp == NULL) {
+        rc = BLOSC2_ERROR_FILE_OPEN;
+      }
+      else {
+        rc = io_ext->sync(fp) < 0 ? BLOSC2_ERROR_FILE_WRITE : BLOSC2_ERROR_SUCCESS;
+        io_cb->close(fp);
+      }
+    }
+  }
+  // New files (the frame itself, or sframe chunks and segments) are only
+  // there after a crash once their directory entries are synced too
+  if (rc >= 0 && (io->id == BLOSC2_IO_FILESYSTEM || io->id == BLOSC2_IO_FILESYSTEM_URING)) {
+    frame_sync_dir(frame->urlpath, frame->sframe);
+  }
+  return rc;
+}
+
+
+/* Make the files of the frame durable.  With @p commit, the deferred appends
+   are committed first (the INTERVAL syncer does not, so that it never changes
+   the frame under the feet of the threads using it).  Without @p wait, give
+   up when another sync is in flight: the operations since are left for the
+   next one, which is what groups them. */
+static int frame_sync_now(blosc2_frame_s* frame, bool wait, bool commit) {
+  if (frame->cframe != NULL || frame->urlpath == NULL) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  // The writer lock goes first: whoever is syncing has released it already
+  blosc2_pthread_mutex_lock(&frame->write_mutex);
+  blosc2_pthread_mutex_lock(&frame->sync_mutex);
+  if (frame->syncing && !wait) {
+    blosc2_pthread_mutex_unlock(&frame->sync_mutex);
+    blosc2_pthread_mutex_unlock(&frame->write_mutex);
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  while (frame->syncing) {
+    blosc2_pthread_cond_wait(&frame->sync_cv, &frame->sync_mutex);
+  }
+  frame->syncing = true;
+  blosc2_pthread_mutex_unlock(&frame->sync_mutex);
+
+  int rc = BLOSC2_ERROR_SUCCESS;
+  if (commit) {
+    rc = frame_flush_appends(frame);
+  }
+  int64_t* dirty_ids = frame->dirty_ids;
+  int64_t ndirty = frame->ndirty;
+  frame->dirty_ids = NULL;
+  frame->ndirty = 0;
+  frame->dirty_nalloc = 0;
+  frame->nunsynced = 0;
+  blosc2_pthread_mutex_unlock(&frame->write_mutex);
+
+  if (rc >= 0) {
+    rc = frame_sync_files(frame, dirty_ids, ndirty);
+  }
+  free(dirty_ids);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot make the writes to the frame durable.");
+  }
+
+  blosc2_pthread_mutex_lock(&frame->sync_mutex);
+  frame->syncing = false;
+  blosc2_pthread_cond_broadcast(&frame->sync_cv);
+  blosc2_pthread_mutex_unlock(&frame->sync_mutex);
+  return rc;
+}
+
+
+int frame_write_unlock(blosc2_frame_s* frame) {
+  if (frame == NULL) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  int rc = BLOSC2_ERROR_SUCCESS;
+  bool sync = false;
+  if (--frame->write_depth == 0) {
+    // The operation is over: commit it before other handles can see it (the
+    // deferred appends are committed along with their index)
+    if (frame->npending == 0) {
+      rc = journal_commit(frame);
+    }
+    frame->nunsynced++;
+    sync = frame->durability == BLOSC2_DURABILITY_EVERY_OPS && frame->nunsynced >= frame->durability_every;
+  }
+  int rc2 = frame_unlock(frame);
+  rc = rc < 0 ? rc : rc2;
+  blosc2_pthread_mutex_unlock(&frame->write_mutex);
+  if (sync) {
+    rc2 = frame_sync_now(frame, false, true);
+    if (rc == 0) {
+      rc = rc2;
+    }
+  }
+  return rc;
+}
+
+
+int frame_sync(blosc2_frame_s* frame) {
+  if (frame == NULL || frame->durability == BLOSC2_DURABILITY_NONE) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  return frame_sync_now(frame, true, true);
+}
+
+
+int frame_mark_dirty(blosc2_frame_s* frame, int64_t id) {
+  // Contiguous frames are synced as a whole
+  if ((frame->durability == BLOSC2_DURABILITY_NONE && !frame->journal) || !frame->sframe) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  // Packed frames keep appending to the same segment
+  if (frame->ndirty > 0 && frame->dirty_ids[frame->ndirty - 1] == id) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  if (frame->ndirty == frame->dirty_nalloc) {
+    int64_t nalloc = frame->dirty_nalloc == 0 ? 64 : 2 * frame->dirty_nalloc;
+    int64_t* dirty_ids = realloc(frame->dirty_ids, (size_t)nalloc * sizeof(int64_t));
+    if (dirty_ids == NULL) {
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    frame->dirty_ids = dirty_ids;
+    frame->dirty_nalloc = nalloc;
+  }
+  frame->dirty_ids[frame->ndirty++] = id;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* The thread of the INTERVAL policy */
+static void* frame_syncer(void* arg) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)arg;
+  blosc2_pthread_mutex_lock(&frame->sync_mutex);
+  while (!frame->syncer_stop) {
+    blosc2_pthread_cond_timedwait_ms(&frame->syncer_cv, &frame->sync_mutex, frame->durability_every);
+    if (frame->syncer_stop) {
+      break;
+    }
+    blosc2_pthread_mutex_unlock(&frame->sync_mutex);
+    blosc2_pthread_mutex_lock(&frame->write_mutex);
+    bool idle = frame->nunsynced == 0;
+    blosc2_pthread_mutex_unlock(&frame->write_mutex);
+    if (!idle) {
+      frame_sync_now(frame, false, false);
+    }
+    blosc2_pthread_mutex_lock(&frame->sync_mutex);
+  }
+  blosc2_pthread_mutex_unlock(&frame->sync_mutex);
+  return NULL;
+}
+
+
+static void frame_stop_syncer(blosc2_frame_s* frame) {
+  if (!frame->syncer_running) {
+    return;
+  }
+  blosc2_pthread_mutex_lock(&frame->sync_mutex);
+  frame->syncer_stop = true;
+  blosc2_pthread_cond_signal(&frame->syncer_cv);
+  blosc2_pthread_mutex_unlock(&frame->sync_mutex);
+  blosc2_pthread_join(frame->syncer, NULL);
+  frame->syncer_running = false;
+  frame->syncer_stop = false;
+}
+
+
+int frame_set_durability(blosc2_frame_s* frame, uint8_t policy, int64_t every) {
+  if (policy > BLOSC2_DURABILITY_EVERY_OPS ||
+      ((policy == BLOSC2_DURABILITY_INTERVAL || policy == BLOSC2_DURABILITY_EVERY_OPS) && every <= 0)) {
+    BLOSC_TRACE_ERROR("Invalid durability policy (%d, every %" PRId64 ").", policy, every);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (frame == NULL || frame->cframe != NULL || frame->urlpath == NULL) {
+    if (policy == BLOSC2_DURABILITY_NONE) {
+      return BLOSC2_ERROR_SUCCESS;
+    }
+    BLOSC_TRACE_ERROR("Durability policies are only supported on disk-based frames.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  if (policy == BLOSC2_DURABILITY_NONE && frame->durability == BLOSC2_DURABILITY_NONE) {
+    // Do not bump the generation of the sidecar lock for nothing
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  // The syncer uses the writer lock, so it is stopped outside of it
+  frame_stop_syncer(frame);
+  int rc = frame_write_lock(frame);
+  if (rc < 0) {
+    return rc;
+  }
+  // Close the books of the previous policy
+  if (frame->durability != BLOSC2_DURABILITY_NONE) {
+    rc = frame_sync_now(frame, true, true);
+  }
+  if (frame->durability_defers && policy != BLOSC2_DURABILITY_EVERY_OPS) {
+    int rc2 = frame_set_append_batch(frame, 0);
+    rc = rc < 0 ? rc : rc2;
+    frame->durability_defers = false;
+  }
+  frame->durability = policy;
+  frame->durability_every = every;
+  if (policy == BLOSC2_DURABILITY_EVERY_OPS && frame->append_batch == 0 &&
+      frame_can_defer_appends(frame)) {
+    // Commit the index, header and trailer once per group too
+    frame->append_batch = -1;
+    frame->durability_defers = true;
+  }
+  // Not an operation of its own, but what it committed has to be
+  frame->write_depth--;
+  int rc2 = journal_commit(frame);
+  rc = rc < 0 ? rc : rc2;
+  frame_unlock(frame);
+  blosc2_pthread_mutex_unlock(&frame->write_mutex);
+
+  if (rc >= 0 && policy == BLOSC2_DURABILITY_INTERVAL) {
+    if (blosc2_pthread_create(&frame->syncer, NULL, frame_syncer, frame) != 0) {
+      BLOSC_TRACE_ERROR("Cannot start the syncer thread.");
+      return BLOSC2_ERROR_THREAD_CREATE;
+    }
+    frame->syncer_running = true;
+  }
+  return rc;
+}
+
+
 /* Free memory from a frame. */
 int frame_free(blosc2_frame_s* frame) {
 
+  // Normally stopped (after a last sync) by blosc2_schunk_free() already
+  frame_stop_syncer(frame);
+  journal_free(frame);
   frame_reader_invalidate(frame);
-  blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
+  sframe_free_handles(frame);
 
   if (frame->locking && frame->lock_fd != -1) {
 #if defined(_WIN32)
@@ -577,12 +890,14 @@ int frame_free(blosc2_frame_s* frame) {
   if (frame->coffsets != NULL && frame->coffsets_needs_free) {
     free(frame->coffsets);
   }
+  free(frame->doffsets);
+  free(frame->dirty_ids);
 
   if (frame->urlpath != NULL) {
     free(frame->urlpath);
   }
 
-  free(frame);
+  frame_dealloc(frame);
 
   return 0;
 }
@@ -653,7 +968,10 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
 
   // Frame type
   // We only support contiguous and sparse directories frames currently
-  *h2p = frame->sframe ? 1 : 0;
+  *h2p = FRAME_CONTIGUOUS_TYPE;
+  if (frame->sframe) {
+    *h2p = frame->packed ? FRAME_PACKED_DIRECTORY_TYPE : FRAME_DIRECTORY_TYPE;
+  }
   h2p += 1;
   if (h2p - h2 >= FRAME_HEADER_MINLEN) {
     return NULL;
@@ -952,7 +1270,7 @@ int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_l
     return BLOSC2_ERROR_VERSION_SUPPORT;
   }
   if (frame->sframe) {
-    if (frame_type != FRAME_DIRECTORY_TYPE) {
+    if (frame_type != (frame->packed ? FRAME_PACKED_DIRECTORY_TYPE : FRAME_DIRECTORY_TYPE)) {
       return BLOSC2_ERROR_FRAME_TYPE;
     }
   } else {
@@ -1028,6 +1346,20 @@ int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_l
     }
   }
 
+  if (frame->npending > 0) {
+    // Appends are being deferred (see frame_set_append_batch): the on-disk
+    // header still describes the last committed index, so report the
+    // in-memory state that includes the pending chunks instead.
+    *frame_len = frame->len;
+    *nbytes = frame->pending_nbytes;
+    *cbytes = frame->pending_cbytes;
+    if (chunksize != NULL) {
+      *chunksize = frame->pending_chunksize;
+    }
+    *nchunks = frame->doffsets_nchunks;
+    return 0;
+  }
+
   if (*nbytes > 0) {
     if (*chunksize > 0) {
       // We can compute the number of chunks directly when there is a fixed chunk size.
@@ -1083,6 +1415,23 @@ int64_t get_trailer_offset(blosc2_frame_s *frame, int32_t header_len, bool has_c
 }
 
 
+/* Drop the cached offsets: both the compressed chunk read from the frame and
+ * the decoded index kept for deferred appends.  Call whenever the on-disk
+ * offsets change other than through a deferred append. */
+static void frame_drop_offsets_cache(blosc2_frame_s *frame) {
+  if (frame->coffsets != NULL) {
+    if (frame->coffsets_needs_free) {
+      free(frame->coffsets);
+    }
+    frame->coffsets = NULL;
+  }
+  free(frame->doffsets);
+  frame->doffsets = NULL;
+  frame->doffsets_nchunks = 0;
+  frame->doffsets_nalloc = 0;
+}
+
+
 /* If the on-disk frame length (as just re-read by get_header_info) differs from the
  * cached one, another handle (or process) has rewritten the frame behind our back.
  * Drop the cached offsets index and refresh len/trailer_len so that subsequent
@@ -1090,8 +1439,10 @@ int64_t get_trailer_offset(blosc2_frame_s *frame, int32_t header_len, bool has_c
  * this way, and single-handle flows always match, so this is a no-op for them.
  * Returns 1 if a refresh took place, 0 if none was needed, or a negative error. */
 static int frame_refresh_if_stale(blosc2_frame_s *frame, int64_t frame_len_on_disk) {
-  if (frame->cframe != NULL || frame->schunk == NULL ||
+  if (frame->cframe != NULL || frame->schunk == NULL || frame->npending > 0 ||
       (!frame->force_refresh && frame_len_on_disk == frame->len)) {
+    // Deferred appends require a single writer, and the on-disk length lags
+    // behind frame->len until they are committed, so never refresh over them.
     return 0;
   }
   // Saved so the metalayer-reload retry loop below can roll back to a fully
@@ -1243,11 +1594,11 @@ static int frame_refresh_if_stale(blosc2_frame_s *frame, int64_t frame_len_on_di
 
   // Cached offsets index invalidated only now, after a fully successful
   // refresh: recomputed lazily from the fresh trailer on demand.
-  if (frame->coffsets != NULL) {
-    if (frame->coffsets_needs_free) {
-      free(frame->coffsets);
-    }
-    frame->coffsets = NULL;
+  frame_drop_offsets_cache(frame);
+  schunk_clear_cache(frame->schunk);
+  if (frame->sframe) {
+    // Chunk files may have been removed and created again
+    sframe_invalidate_chunks(frame, -1);
   }
 
   return 1;
@@ -1380,6 +1731,28 @@ static int get_coffsets_nbytes(blosc2_frame_s *frame, int32_t header_len, int64_
 }
 
 
+/* io_cb->write() to the frame file (or the index of an sframe), saving what
+   it overwrites to the journal first */
+static int64_t frame_io_write(blosc2_frame_s* frame, blosc2_io_cb* io_cb, const void* ptr,
+                              int64_t size, int64_t nitems, int64_t position, void* fp) {
+  if (journal_save(frame, JOURNAL_MAIN_FILE, position, size * nitems) < 0) {
+    BLOSC_TRACE_ERROR("Cannot journal the update of the frame.");
+    return 0;
+  }
+  return io_cb->write(ptr, size, nitems, position, fp);
+}
+
+
+/* Same for io_cb->truncate() */
+static int frame_io_truncate(blosc2_frame_s* frame, blosc2_io_cb* io_cb, void* fp, int64_t size) {
+  if (journal_save(frame, JOURNAL_MAIN_FILE, size, INT64_MAX) < 0) {
+    BLOSC_TRACE_ERROR("Cannot journal the update of the frame.");
+    return BLOSC2_ERROR_FILE_TRUNCATE;
+  }
+  return io_cb->truncate(fp, size);
+}
+
+
 // Update the length in the header
 int update_frame_len(blosc2_frame_s* frame, int64_t len) {
   int rc = 1;
@@ -1408,7 +1781,7 @@ int update_frame_len(blosc2_frame_s* frame, int64_t len) {
     int64_t io_pos = frame->file_offset + FRAME_LEN;
     int64_t swap_len;
     to_big(&swap_len, &len, sizeof(int64_t));
-    int64_t wbytes = io_cb->write(&swap_len, 1, sizeof(int64_t), io_pos, fp);
+    int64_t wbytes = frame_io_write(frame, io_cb, &swap_len, 1, sizeof(int64_t), io_pos, fp);
     io_cb->close(fp);
     if (wbytes != sizeof(int64_t)) {
       BLOSC_TRACE_ERROR("Cannot write the frame length in header.");
@@ -1419,7 +1792,7 @@ int update_frame_len(blosc2_frame_s* frame, int64_t len) {
 }
 
 
-int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
+static int write_frame_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
   if (frame != NULL && frame->len == 0) {
     BLOSC_TRACE_ERROR("The trailer cannot be updated on empty frames.");
   }
@@ -1615,12 +1988,12 @@ int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
       return BLOSC2_ERROR_FILE_OPEN;
     }
     int64_t io_pos = frame->file_offset + trailer_offset;
-    int64_t wbytes = io_cb->write(trailer, 1, trailer_len, io_pos, fp);
+    int64_t wbytes = frame_io_write(frame, io_cb, trailer, 1, trailer_len, io_pos, fp);
     if (wbytes != trailer_len) {
       BLOSC_TRACE_ERROR("Cannot write the trailer length in trailer.");
       return BLOSC2_ERROR_FILE_WRITE;
     }
-    if (io_cb->truncate(fp, trailer_offset + trailer_len) != 0) {
+    if (frame_io_truncate(frame, io_cb, fp, trailer_offset + trailer_len) != 0) {
       BLOSC_TRACE_ERROR("Cannot truncate the frame.");
       return BLOSC2_ERROR_FILE_TRUNCATE;
     }
@@ -1640,6 +2013,16 @@ int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
 }
 
 
+int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
+  // The trailer goes at the end of the committed index, so commit it first
+  int rc = frame_flush_appends(frame);
+  if (rc < 0) {
+    return rc;
+  }
+  return write_frame_trailer(frame, schunk);
+}
+
+
 // Remove a file:/// prefix
 // This is a temporary workaround for allowing to use proper URLs for local files/dirs
 static char* normalize_urlpath(const char* urlpath) {
@@ -1828,6 +2211,7 @@ blosc2_frame_s* frame_from_file_offset(const char* urlpath, const blosc2_io *io,
     frame->urlpath = urlpath_cpy;
     frame->len = frame_len;
     frame->sframe = sframe;
+    frame->packed = sframe && header_ptr[FRAME_TYPE] == FRAME_PACKED_DIRECTORY_TYPE;
     frame->file_offset = offset;
 
     // Now, the trailer length
@@ -1839,16 +2223,14 @@ blosc2_frame_s* frame_from_file_offset(const char* urlpath, const blosc2_io *io,
     if (rbytes != FRAME_TRAILER_MINLEN) {
         BLOSC_TRACE_ERROR("Cannot read from file '%s'.", urlpath);
         free(urlpath_cpy);
-        blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
-        free(frame);
+        frame_dealloc(frame);
         return NULL;
     }
     int trailer_offset = FRAME_TRAILER_MINLEN - FRAME_TRAILER_LEN_OFFSET;
     if (trailer_ptr[trailer_offset - 1] != 0xce) {
         BLOSC_TRACE_ERROR("Invalid trailer in file '%s'.", urlpath);
         free(urlpath_cpy);
-        blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
-        free(frame);
+        frame_dealloc(frame);
         return NULL;
     }
     uint32_t trailer_len;
@@ -1858,12 +2240,12 @@ blosc2_frame_s* frame_from_file_offset(const char* urlpath, const blosc2_io *io,
         (int64_t)trailer_len > frame_len - FRAME_HEADER_MINLEN) {
       BLOSC_TRACE_ERROR("Invalid trailer length (%" PRIu32 ") in file '%s'.", trailer_len, urlpath);
       free(urlpath_cpy);
-      blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
-      free(frame);
+      frame_dealloc(frame);
       return NULL;
     }
     frame->trailer_len = trailer_len;
     frame_set_locking(frame, io);
+    journal_enable(frame, io);
 
     return frame;
 }
@@ -1894,8 +2276,7 @@ blosc2_frame_s* frame_from_cframe(uint8_t *cframe, int64_t len, bool copy) {
   const uint8_t* trailer = cframe + frame_len - FRAME_TRAILER_MINLEN;
   int trailer_offset = FRAME_TRAILER_MINLEN - FRAME_TRAILER_LEN_OFFSET;
   if (trailer[trailer_offset - 1] != 0xce) {
-    blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
-    free(frame);
+    frame_dealloc(frame);
     return NULL;
   }
   uint32_t trailer_len;
@@ -1903,8 +2284,7 @@ blosc2_frame_s* frame_from_cframe(uint8_t *cframe, int64_t len, bool copy) {
   if (trailer_len < FRAME_TRAILER_MINLEN || trailer_len > INT32_MAX ||
       (int64_t)trailer_len > frame_len ||
       (int64_t)trailer_len > frame_len - FRAME_HEADER_MINLEN) {
-    blosc2_pthread_mutex_destroy(&frame->read_fp_mutex);
-    free(frame);
+    frame_dealloc(frame);
     return NULL;
   }
   frame->trailer_len = trailer_len;
@@ -2241,10 +2621,16 @@ int64_t* blosc2_frame_get_offsets(blosc2_schunk *schunk) {
   int32_t blocksize;
   int32_t chunksize;
   int64_t nchunks;
-  int ret = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
-                            &blocksize, &chunksize, &nchunks,
-                            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                            frame->schunk->storage->io);
+  // Work on the committed index: write out any deferred appends first
+  int ret = frame_flush_appends(frame);
+  if (ret < 0) {
+    BLOSC_TRACE_ERROR("Cannot commit the pending appends.");
+    return NULL;
+  }
+  ret = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                        &blocksize, &chunksize, &nchunks,
+                        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                        frame->schunk->storage->io);
   if (ret < 0) {
     BLOSC_TRACE_ERROR("Cannot get the header info for the frame.");
     return NULL;
@@ -2282,7 +2668,7 @@ int64_t* blosc2_frame_get_offsets(blosc2_schunk *schunk) {
 }
 
 
-int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new) {
+static int write_frame_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new) {
   uint8_t* framep = frame->cframe;
   uint8_t* header_ptr;
   uint8_t header[FRAME_HEADER_MINLEN];
@@ -2370,7 +2756,7 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
       return BLOSC2_ERROR_FILE_OPEN;
     }
     int64_t io_pos = frame->file_offset;
-    io_cb->write(h2, h2len, 1, io_pos, fp);
+    frame_io_write(frame, io_cb, h2, h2len, 1, io_pos, fp);
     io_cb->close(fp);
   }
   else {
@@ -2385,6 +2771,17 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
 }
 
 
+int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new) {
+  // A header describing the in-memory state must not point at an index that
+  // has not been written yet, so commit any deferred appends first
+  int rc = frame_flush_appends(frame);
+  if (rc < 0) {
+    return rc;
+  }
+  return write_frame_header(frame, schunk, new);
+}
+
+
 static int get_meta_from_header(blosc2_frame_s* frame, blosc2_schunk* schunk, uint8_t* header,
                                 int32_t header_len) {
   BLOSC_UNUSED_PARAM(frame);
@@ -2917,7 +3314,8 @@ static int validate_offsets_chunk(blosc2_frame_s* frame, int32_t header_len, int
 
   for (int64_t i = 0; i < nchunks; ++i) {
     int64_t offset = offsets[i];
-    if (offset < 0) {
+    if (offset < 0 || frame->packed) {
+      // Packed sframes hold a segment and a position in it, not a frame offset
       continue;
     }
     if (offset > INT64_MAX - header_len || offset > cbytes - BLOSC_EXTENDED_HEADER_LENGTH) {
@@ -3156,7 +3554,8 @@ blosc2_schunk* frame_to_schunk(blosc2_frame_s* frame, bool copy, const blosc2_io
       if (rc < 0) {
         break;
       }
-      if (offsets[i] >= 0 &&
+      // The offsets of sframes are not positions in the frame
+      if (offsets[i] >= 0 && !frame->sframe &&
           (chunk_cbytes < BLOSC_EXTENDED_HEADER_LENGTH ||
            offsets[i] > INT64_MAX - chunk_cbytes ||
            offsets[i] + chunk_cbytes > cbytes)) {
@@ -3267,6 +3666,9 @@ void frame_avoid_cframe_free(blosc2_frame_s* frame, bool avoid_cframe_free) {
 }
 
 
+/* Lazy chunks with up to this many blocks sort their bstarts on the stack */
+#define LAZYCHUNK_STACK_NBLOCKS 256
+
 struct csize_idx {
     int32_t val;
     int32_t idx;
@@ -3280,21 +3682,29 @@ int sort_offset(const void* a, const void* b) {
 }
 
 
+static int load_doffsets(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                         int64_t nchunks);
+
 int get_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
                 int64_t nchunk, int64_t nchunks, int64_t *offset) {
-  int32_t off_cbytes;
-  // Get the offset to nchunk
-  uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &off_cbytes);
-  if (coffsets == NULL) {
-    BLOSC_TRACE_ERROR("Cannot get the offset for chunk %" PRId64 " for the frame.", nchunk);
-    return BLOSC2_ERROR_DATA;
+  // Lookups are served from the decoded offsets index, which is built on first
+  // use and kept until the offsets change (see frame_drop_offsets_cache), so
+  // random access pays an array load rather than a block decompression.  The
+  // offsets of deferred appends only live there.
+  if (frame->doffsets == NULL ||
+      (frame->npending == 0 && frame->doffsets_nchunks != nchunks)) {
+    int rc = load_doffsets(frame, header_len, cbytes, nchunks);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot get the offset for chunk %" PRId64 " for the frame.", nchunk);
+      return BLOSC2_ERROR_DATA;
+    }
   }
-
-  // Get the 64-bit offset
-  int rc = blosc2_getitem(coffsets, off_cbytes, (int32_t)nchunk, 1, offset, (int32_t)sizeof(int64_t));
-  if (rc < 0) {
+  if (nchunk < 0 || nchunk >= frame->doffsets_nchunks) {
     BLOSC_TRACE_ERROR("Problems retrieving a chunk offset.");
-  } else if (!frame->sframe && *offset >= 0) {
+    return BLOSC2_ERROR_DATA;
+  }
+  *offset = frame->doffsets[nchunk];
+  if (!frame->sframe && *offset >= 0) {
     if (cbytes < 0 || cbytes > INT64_MAX - header_len) {
       BLOSC_TRACE_ERROR("Invalid compressed size in frame header.");
       return BLOSC2_ERROR_INVALID_HEADER;
@@ -3313,7 +3723,7 @@ int get_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
     }
   }
 
-  return rc;
+  return (int)sizeof(int64_t);
 }
 
 
@@ -3518,12 +3928,80 @@ int frame_get_chunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk, bool
 }
 
 
+/* See frame.h */
+int frame_prefetch_chunk(blosc2_frame_s* frame, int64_t nchunk) {
+  if (frame->cframe != NULL || frame->urlpath == NULL) {
+    return 0;
+  }
+  blosc2_io* io = frame->schunk->storage->io;
+  blosc2_io_cb* io_cb = blosc2_get_io_cb(io->id);
+  blosc2_io_cb_ext* io_ext = blosc2_get_io_cb_ext(io->id);
+  if (io_cb == NULL || io_ext == NULL || io_ext->prefetch == NULL) {
+    return 0;
+  }
+
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int64_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, &chunksize, &nchunks,
+                           NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, io);
+  if (rc < 0) {
+    return rc;
+  }
+  if (nchunk < 0 || nchunk >= nchunks) {
+    return 0;
+  }
+  int64_t offset;
+  rc = get_coffset(frame, header_len, cbytes, nchunk, nchunks, &offset);
+  if (rc < 0) {
+    return rc;
+  }
+  if (offset < 0) {
+    // Special chunks are not on disk
+    return 0;
+  }
+
+  void* fp;
+  blosc2_io_range range = {NULL, 0, 0};
+  if (frame->sframe) {
+    fp = sframe_acquire_chunk(frame, offset, io, &range.position);
+    if (fp == NULL) {
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    range.size = io_cb->size(fp) - range.position;
+    if (frame->packed && chunksize > 0 && range.size > (int64_t)chunksize + BLOSC2_MAX_OVERHEAD) {
+      range.size = (int64_t)chunksize + BLOSC2_MAX_OVERHEAD;
+    }
+  }
+  else {
+    fp = frame_reader_acquire(frame, io);
+    if (fp == NULL) {
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    // The size of the chunk is in its header, but reading it would defeat the purpose
+    range.position = frame->file_offset + header_len + offset;
+    range.size = (int64_t)chunksize + BLOSC2_MAX_OVERHEAD;
+    if (range.size > frame_len - header_len - offset) {
+      range.size = frame_len - header_len - offset;
+    }
+  }
+  rc = range.size > 0 ? io_ext->prefetch(&range, 1, fp) : 0;
+  frame_reader_release(frame, io_cb, fp);
+
+  return rc;
+}
+
+
 /* Return a compressed chunk that is part of a frame in the `chunk` parameter.
  * If the frame is disk-based, a buffer is allocated for the (lazy) chunk,
  * and hence a free is needed.  You can check if the chunk requires a free with the `needs_free`
  * parameter.
- * If the chunk does not need a free, it means that the frame is in memory and that just a
- * pointer to the location of the chunk in memory is returned.
+ * If the chunk does not need a free, it means that the frame is in memory (or mapped in memory
+ * by its io) and that just a pointer to the location of the chunk in memory is returned.
  *
  * The size of the (compressed, potentially lazy) chunk is returned.  If some problem is detected,
  * a negative code is returned instead.
@@ -3540,7 +4018,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
   int32_t lazychunk_cbytes;
   int64_t offset;
   void* fp = NULL;
-  int32_t* block_csizes = NULL;
+  struct csize_idx csize_idx_stack[LAZYCHUNK_STACK_NBLOCKS];
   struct csize_idx *csize_idx = NULL;
 
   *chunk = NULL;
@@ -3599,19 +4077,53 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
     goto end;
   }
 
-  if (frame->cframe == NULL) {
-    // TODO: make this portable across different endianness
-    // Get info for building a lazy chunk
-    int32_t chunk_nbytes;
-    int32_t chunk_cbytes;
-    int32_t chunk_blocksize;
-    uint8_t* header_ptr;
-    uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
+  if (frame->cframe == NULL && !frame->sframe && !io_cb->is_allocation_necessary) {
+    // The io hands out pointers into its own memory (e.g. a mapping of the file), so there is
+    // no need for a lazy chunk: the whole chunk is decompressed in place, and the blocks that
+    // are not needed are never touched (nor paged in)
+    fp = frame_reader_acquire(frame, frame->schunk->storage->io);
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Error opening file in: %s", frame->urlpath);
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    int64_t io_pos = frame->file_offset + header_len + offset;
+    uint8_t* header_ptr;
+    int64_t rbytes = io_cb->read((void**)&header_ptr, 1, BLOSC_EXTENDED_HEADER_LENGTH, io_pos, fp);
+    if (rbytes != BLOSC_EXTENDED_HEADER_LENGTH) {
+      BLOSC_TRACE_ERROR("Cannot read the header for chunk in the frame.");
+      rc = BLOSC2_ERROR_FILE_READ;
+      goto end;
+    }
+    rc = blosc2_cbuffer_sizes(header_ptr, NULL, &lazychunk_cbytes, NULL);
+    if (rc < 0) {
+      goto end;
+    }
+    if (lazychunk_cbytes < BLOSC_EXTENDED_HEADER_LENGTH ||
+        offset > INT64_MAX - lazychunk_cbytes ||
+        offset + lazychunk_cbytes > cbytes) {
+      BLOSC_TRACE_ERROR("Invalid chunk size in frame for chunk %" PRId64 ".", nchunk);
+      rc = BLOSC2_ERROR_INVALID_HEADER;
+      goto end;
+    }
+    rbytes = io_cb->read((void**)chunk, 1, lazychunk_cbytes, io_pos, fp);
+    if (rbytes != lazychunk_cbytes) {
+      BLOSC_TRACE_ERROR("Cannot read the chunk out of the frame.");
+      rc = BLOSC2_ERROR_FILE_READ;
+      goto end;
+    }
+  }
+  else if (frame->cframe == NULL) {
+    // TODO: make this portable across different endianness
+    // Get info for building a lazy chunk
+    int32_t chunk_nbytes;
+    int32_t chunk_cbytes;
+    int32_t chunk_blocksize;
+    uint8_t* header_ptr;
+    uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
     int64_t io_pos = 0;
     if (frame->sframe) {
       // The chunk is not in the frame
-      fp = sframe_open_chunk(frame->urlpath, offset, "rb",
-                             frame->schunk->storage->io);
+      fp = sframe_acquire_chunk(frame, offset, frame->schunk->storage->io, &io_pos);
       if (fp == NULL) {
         BLOSC_TRACE_ERROR("Error opening file in: %s", frame->urlpath);
         return BLOSC2_ERROR_FILE_OPEN;
@@ -3743,10 +4255,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
     lazychunk_cbytes = (int32_t)lazychunk_cbytes_sz;
 
     // Read just the full header and bstarts section too (lazy partial length)
-    if (frame->sframe) {
-      io_pos = 0;
-    }
-    else {
+    if (!frame->sframe) {
       io_pos = frame->file_offset + header_len + offset;
     }
 
@@ -3785,7 +4294,8 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
 
     // Add the trailer (currently, nchunk + offset + block_csizes)
     if (frame->sframe) {
-      *(int32_t*)(*chunk + trailer_offset) = (int32_t)offset;   // offset is nchunk for sframes
+      // offset is the chunk file (or its segment and position in it, for packed sframes)
+      *(int32_t*)(*chunk + trailer_offset) = (int32_t)offset;
       *(int64_t*)(*chunk + trailer_offset + sizeof(int32_t)) = offset;
     }
     else {
@@ -3793,12 +4303,8 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
       *(int64_t*)(*chunk + trailer_offset + sizeof(int32_t)) = header_len + offset;
     }
 
-    block_csizes = malloc(nblocks * sizeof(int32_t));
-    if (block_csizes == NULL) {
-      rc = BLOSC2_ERROR_MEMORY_ALLOC;
-      goto end;
-    }
-
+    // The csizes go at the end of the trailer
+    int32_t* block_csizes = (int32_t*)(*chunk + lazychunk_cbytes - nblocks * sizeof(int32_t));
     if (memcpyed) {
       // When memcpyed the blocksizes are trivial to compute
       for (size_t i = 0; i + 1 < nblocks; i++) {
@@ -3811,15 +4317,18 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
     else {
       // In regular, compressed chunks, we need to sort the bstarts (they can be out
       // of order because of multi-threading), and get a reverse index too.
-      memcpy(block_csizes, *chunk + BLOSC_EXTENDED_HEADER_LENGTH, nblocks * sizeof(int32_t));
+      const uint8_t* bstarts = *chunk + BLOSC_EXTENDED_HEADER_LENGTH;
       // Helper structure to keep track of original indexes
-      csize_idx = malloc(nblocks * sizeof(struct csize_idx));
-      if (csize_idx == NULL) {
-        rc = BLOSC2_ERROR_MEMORY_ALLOC;
-        goto end;
+      csize_idx = csize_idx_stack;
+      if (nblocks > LAZYCHUNK_STACK_NBLOCKS) {
+        csize_idx = malloc(nblocks * sizeof(struct csize_idx));
+        if (csize_idx == NULL) {
+          rc = BLOSC2_ERROR_MEMORY_ALLOC;
+          goto end;
+        }
       }
       for (size_t n = 0; n < nblocks; n++) {
-        csize_idx[n].val = block_csizes[n];
+        memcpy(&csize_idx[n].val, bstarts + n * sizeof(int32_t), sizeof(int32_t));
         csize_idx[n].idx = (int)n;
       }
       qsort(csize_idx, nblocks, sizeof(struct csize_idx), &sort_offset);
@@ -3831,14 +4340,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
       }
       idx = csize_idx[nblocks - 1].idx;
       block_csizes[idx] = chunk_cbytes - csize_idx[nblocks - 1].val;
-      free(csize_idx);
-      csize_idx = NULL;
-    }
-    // Copy the csizes at the end of the trailer
-    void *trailer_csizes = *chunk + lazychunk_cbytes - nblocks * sizeof(int32_t);
-    memcpy(trailer_csizes, block_csizes, nblocks * sizeof(int32_t));
-    free(block_csizes);
-    block_csizes = NULL;
+    }
   } else {
     // The chunk is in memory and just one pointer away
     int64_t chunk_header_offset = header_len + offset;
@@ -3867,12 +4369,9 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int64_t nchunk, uint8_t **chunk,
   }
 
   end:
-  if (csize_idx != NULL) {
+  if (csize_idx != NULL && csize_idx != csize_idx_stack) {
     free(csize_idx);
   }
-  if (block_csizes != NULL) {
-    free(block_csizes);
-  }
   if (fp != NULL) {
     frame_reader_release(frame, io_cb, fp);
   }
@@ -3900,9 +4399,15 @@ int64_t frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_va
   int32_t typesize;
   int64_t nchunks;
 
-  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, NULL,
-                           &nchunks, &typesize, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                           schunk->storage->io);
+  // Work on the committed index: write out any deferred appends first
+  int rc = frame_flush_appends(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot commit the pending appends.");
+    return rc;
+  }
+  rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, NULL,
+                       &nchunks, &typesize, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                       schunk->storage->io);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
     return BLOSC2_ERROR_DATA;
@@ -4045,7 +4550,7 @@ int64_t frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_va
       }
       io_pos = frame->file_offset + header_len + cbytes;
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
+    wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
     io_cb->close(fp);
     if (wbytes != (size_t)new_off_cbytes) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
@@ -4054,11 +4559,7 @@ int64_t frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_va
   }
 
   // Invalidate the cache for chunk offsets
-  if (frame->coffsets != NULL) {
-    if (frame->coffsets_needs_free)
-      free(frame->coffsets);
-    frame->coffsets = NULL;
-  }
+  frame_drop_offsets_cache(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -4076,8 +4577,114 @@ int64_t frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_va
 }
 
 
-/* Append an existing chunk into a frame. */
-void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schunk) {
+/* Check that a chunk of @p chunk_nbytes can follow the @p nchunks ones in the
+   frame, given the frame (@p nbytes, @p chunksize) figures. */
+static int check_append_sizes(blosc2_frame_s* frame, int32_t chunk_nbytes, int64_t nbytes,
+                              int32_t chunksize, int64_t nchunks, blosc2_schunk* schunk) {
+  if ((nchunks > 0) && (chunksize > 0) && (schunk->chunksize != 0) && (chunk_nbytes > chunksize)) {
+    BLOSC_TRACE_ERROR("Appending chunks with a larger chunksize than frame is "
+                      "not allowed yet %d != %d.", chunk_nbytes, chunksize);
+    return BLOSC2_ERROR_CHUNK_APPEND;
+  }
+
+  // Check that we are not appending a small chunk after another small chunk
+  int32_t chunk_nbytes_last;
+  if ((chunksize > 0) && (nchunks > 0) && (chunk_nbytes < chunksize)) {
+    uint8_t* last_chunk;
+    bool needs_free;
+    int rc = frame_get_lazychunk(frame, nchunks - 1, &last_chunk, &needs_free);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot get the last chunk (in position %" PRId64 ").", nchunks - 1);
+    } else {
+      rc = blosc2_cbuffer_sizes(last_chunk, &chunk_nbytes_last, NULL, NULL);
+    }
+    if (needs_free) {
+      free(last_chunk);
+    }
+    if (rc < 0) {
+      return rc;
+    }
+    if ((chunk_nbytes_last < chunksize) && (nbytes < chunksize)) {
+      BLOSC_TRACE_ERROR("Appending two consecutive chunks with a chunksize smaller "
+                        "than the frame chunksize is not allowed yet: %d != %d.",
+                        chunk_nbytes, chunksize);
+      return BLOSC2_ERROR_CHUNK_APPEND;
+    }
+  }
+  return 0;
+}
+
+
+/* Make @p doffsets (malloc'ed, @p nalloc entries) the decoded offsets index. */
+static void set_doffsets(blosc2_frame_s* frame, int64_t* doffsets, int64_t nchunks, int64_t nalloc) {
+  frame->doffsets_max = -1;
+  for (int64_t i = 0; i < nchunks; i++) {
+    if (doffsets[i] > frame->doffsets_max) {
+      frame->doffsets_max = doffsets[i];
+    }
+  }
+  free(frame->doffsets);
+  frame->doffsets = doffsets;
+  frame->doffsets_nchunks = nchunks;
+  frame->doffsets_nalloc = nalloc;
+}
+
+
+/* Decode the committed offsets index into frame->doffsets.  It serves chunk
+   lookups (see get_coffset) and is what deferred appends extend in memory; it
+   survives their flushes and is only dropped when the offsets change in some
+   other way (see frame_drop_offsets_cache). */
+static int load_doffsets(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                         int64_t nchunks) {
+  int64_t nalloc = nchunks > 0 ? nchunks : 1;
+  int64_t* doffsets = malloc((size_t)nalloc * sizeof(int64_t));
+  if (doffsets == NULL) {
+    BLOSC_TRACE_ERROR("Cannot allocate memory for the offsets index.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  if (nchunks > 0) {
+    int32_t off_nbytes;
+    if (!blosc2_nchunks_to_offsets_nbytes(nchunks, &off_nbytes)) {
+      BLOSC_TRACE_ERROR("Too many chunks for offsets representation.");
+      free(doffsets);
+      return BLOSC2_ERROR_INVALID_HEADER;
+    }
+    int32_t coffsets_cbytes;
+    uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
+    if (coffsets == NULL) {
+      BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
+      free(doffsets);
+      return BLOSC2_ERROR_DATA;
+    }
+    blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
+    blosc2_context *dctx = blosc2_create_dctx(off_dparams);
+    if (dctx == NULL) {
+      BLOSC_TRACE_ERROR("Error while creating the decompression context");
+      free(doffsets);
+      return BLOSC2_ERROR_NULL_POINTER;
+    }
+    int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, doffsets,
+                                                off_nbytes);
+    blosc2_free_ctx(dctx);
+    if (prev_nbytes != off_nbytes) {
+      BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
+      free(doffsets);
+      return BLOSC2_ERROR_DATA;
+    }
+  }
+  set_doffsets(frame, doffsets, nchunks, nalloc);
+  return 0;
+}
+
+
+/* Append a chunk without touching the on-disk offsets, header or trailer;
+ * they are written once per batch by frame_flush_appends().
+ *
+ * For contiguous frames, the first append of a batch goes over the offsets
+ * and trailer of the committed frame, as frame_append_chunk() does, and the
+ * flush writes the new ones after the appended chunks.  Sparse frames store
+ * chunks in their own files, so only their index file update is deferred. */
+static void* frame_append_chunk_deferred(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schunk) {
   int8_t* chunk_ = chunk;
   int32_t header_len;
   int64_t frame_len;
@@ -4099,49 +4706,320 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
     return NULL;
   }
 
-  /* The uncompressed and compressed sizes start at byte 4 and 12 */
   int32_t chunk_nbytes;
   int32_t chunk_cbytes;
   rc = blosc2_cbuffer_sizes(chunk, &chunk_nbytes, &chunk_cbytes, NULL);
   if (rc < 0) {
     return NULL;
   }
+  if (check_append_sizes(frame, chunk_nbytes, nbytes, chunksize, nchunks, schunk) < 0) {
+    return NULL;
+  }
 
-  if ((nchunks > 0) && (chunksize > 0) && (schunk->chunksize != 0) && (chunk_nbytes > chunksize)) {
-    BLOSC_TRACE_ERROR("Appending chunks with a larger chunksize than frame is "
-                      "not allowed yet %d != %d.", chunk_nbytes, chunksize);
+  if (frame->doffsets == NULL) {
+    if (load_doffsets(frame, header_len, cbytes, nchunks) < 0) {
+      return NULL;
+    }
+  }
+  int32_t off_nbytes;
+  if (!blosc2_nchunks_to_offsets_nbytes(nchunks + 1, &off_nbytes)) {
+    BLOSC_TRACE_ERROR("Too many chunks for offsets representation.");
     return NULL;
   }
+  if (nchunks + 1 > frame->doffsets_nalloc) {
+    int64_t nalloc = frame->doffsets_nalloc < 512 ? 1024 : frame->doffsets_nalloc * 2;
+    int64_t* doffsets = realloc(frame->doffsets, (size_t)nalloc * sizeof(int64_t));
+    if (doffsets == NULL) {
+      BLOSC_TRACE_ERROR("Cannot grow the offsets index.");
+      return NULL;
+    }
+    frame->doffsets = doffsets;
+    frame->doffsets_nalloc = nalloc;
+  }
 
-  // Check that we are not appending a small chunk after another small chunk
-  int32_t chunk_nbytes_last;
-  if ((chunksize > 0) && (nchunks > 0) && (chunk_nbytes < chunksize)) {
-    uint8_t* last_chunk;
-    bool needs_free;
-    rc = frame_get_lazychunk(frame, nchunks - 1, &last_chunk, &needs_free);
-    if (rc < 0) {
-      BLOSC_TRACE_ERROR("Cannot get the last chunk (in position %" PRId64 ").", nchunks - 1);
-    } else {
-      rc = blosc2_cbuffer_sizes(last_chunk, &chunk_nbytes_last, NULL, NULL);
+  if (frame->npending == 0) {
+    frame->pending_cbytes = cbytes;
+  }
+
+  int64_t offset;
+  int special_value = (chunk_[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
+  uint64_t offset_value = ((uint64_t)1 << 63);
+  switch (special_value) {
+    case BLOSC2_SPECIAL_ZERO:
+    case BLOSC2_SPECIAL_UNINIT:
+    case BLOSC2_SPECIAL_NAN:
+      // Special chunks are coded in the offsets and not stored
+      offset_value += (uint64_t)special_value << (8 * 7);
+      to_little(&offset, &offset_value, sizeof(uint64_t));
+      chunk_cbytes = 0;
+      break;
+    default:
+      offset = frame->sframe ? frame->doffsets_max + 1 : frame->pending_cbytes;
+  }
+
+  if (chunk_cbytes != 0) {
+    if (frame->sframe) {
+      offset = sframe_create_chunk(frame, chunk, offset, chunk_cbytes);
+      if (offset < 0) {
+        BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+        return NULL;
+      }
     }
-    if (needs_free) {
-      free(last_chunk);
+    else {
+      blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+      if (io_cb == NULL) {
+        BLOSC_TRACE_ERROR("Error getting the input/output API");
+        return NULL;
+      }
+      void* fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
+      if (fp == NULL) {
+        BLOSC_TRACE_ERROR("Error opening file in: %s", frame->urlpath);
+        return NULL;
+      }
+      int64_t io_pos = frame->file_offset + header_len + offset;
+      int64_t wbytes = frame_io_write(frame, io_cb, chunk, 1, chunk_cbytes, io_pos, fp);
+      io_cb->close(fp);
+      if (wbytes != chunk_cbytes) {
+        BLOSC_TRACE_ERROR("Cannot write the full chunk to frame (wrote %" PRId64 " of %" PRId64
+                          " bytes at position %" PRId64 ", nchunk=%" PRId64 ").",
+                          wbytes, (int64_t)chunk_cbytes, io_pos, nchunks);
+        return NULL;
+      }
     }
-    if (rc < 0) {
+  }
+  frame->doffsets[nchunks] = offset;
+  frame->doffsets_nchunks = nchunks + 1;
+  if (offset > frame->doffsets_max) {
+    frame->doffsets_max = offset;
+  }
+  frame->pending_cbytes += chunk_cbytes;
+  frame->pending_nbytes = schunk->nbytes;
+  frame->pending_chunksize = schunk->chunksize;
+  if (!frame->sframe) {
+    frame->len = header_len + frame->pending_cbytes;
+  }
+  frame->npending++;
+
+  if (frame->append_batch > 0 && frame->npending >= frame->append_batch) {
+    if (frame_flush_appends(frame) < 0) {
       return NULL;
     }
-    if ((chunk_nbytes_last < chunksize) && (nbytes < chunksize)) {
-      BLOSC_TRACE_ERROR("Appending two consecutive chunks with a chunksize smaller "
-                        "than the frame chunksize is not allowed yet: %d != %d.",
-                        chunk_nbytes, chunksize);
-      return NULL;
+  }
+  // The caller keeps the chunk on failure
+  free(chunk);  // chunk has always to be a copy when reaching here...
+
+  return frame;
+}
+
+
+/* frame_flush_appends() but the commit of the journal */
+static int frame_flush_pending(blosc2_frame_s* frame) {
+  blosc2_schunk* schunk = frame->schunk;
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int64_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, &chunksize,
+                           &nchunks, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                           schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
+    return rc;
+  }
+
+  int32_t off_nbytes;
+  if (!blosc2_nchunks_to_offsets_nbytes(nchunks, &off_nbytes)) {
+    BLOSC_TRACE_ERROR("Too many chunks for offsets representation.");
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.splitmode = BLOSC_NEVER_SPLIT;
+  cparams.typesize = sizeof(int64_t);
+  cparams.blocksize = 16 * 1024;  // based on experiments with create_frame.c bench
+  cparams.nthreads = 4;  // 4 threads seems a decent default for nowadays CPUs
+  cparams.compcode = BLOSC_BLOSCLZ;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  if (cctx == NULL) {
+    BLOSC_TRACE_ERROR("Error while creating the compression context");
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  cctx->typesize = sizeof(int64_t);  // override a possible BLOSC_TYPESIZE env variable (or chaos may appear)
+  void* off_chunk = malloc((size_t)off_nbytes + BLOSC2_MAX_OVERHEAD);
+  int32_t new_off_cbytes = blosc2_compress_ctx(cctx, frame->doffsets, off_nbytes,
+                                               off_chunk, off_nbytes + BLOSC2_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  if (new_off_cbytes < 0) {
+    free(off_chunk);
+    return new_off_cbytes;
+  }
+
+  // Write the new index past the appended chunks (sframes keep it right after
+  // the header of their index file)
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(schunk->storage->io->id);
+  if (io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    free(off_chunk);
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  void* fp;
+  int64_t io_pos;
+  if (frame->sframe) {
+    fp = sframe_open_index(frame->urlpath, "rb+", schunk->storage->io);
+    io_pos = frame->file_offset + header_len;
+  }
+  else {
+    fp = io_cb->open(frame->urlpath, "rb+", schunk->storage->io->params);
+    io_pos = frame->file_offset + header_len + frame->pending_cbytes;
+  }
+  if (fp == NULL) {
+    BLOSC_TRACE_ERROR("Error opening file in: %s", frame->urlpath);
+    free(off_chunk);
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+  int64_t wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);
+  io_cb->close(fp);
+  free(off_chunk);
+  if (wbytes != new_off_cbytes) {
+    BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  if (frame->coffsets != NULL) {
+    if (frame->coffsets_needs_free) {
+      free(frame->coffsets);
     }
+    frame->coffsets = NULL;
+  }
+
+  int64_t pending_len = frame->len;
+  if (frame->sframe) {
+    frame->len = header_len + new_off_cbytes + frame->trailer_len;
+  }
+  else {
+    frame->len = header_len + frame->pending_cbytes + new_off_cbytes + frame->trailer_len;
+  }
+
+  // The trailer goes first: it also updates the length in the header, which
+  // is harmless while the header still points at the previous index (that is
+  // untouched, and the trailer is found from the end of the frame).  The
+  // header write below then commits the new index in one go.
+  rc = write_frame_trailer(frame, schunk);
+  if (rc < 0) {
+    // Still pending; the committed frame on disk is the previous one
+    frame->len = pending_len;
+    return rc;
+  }
+
+  // The header is built from the super-chunk counters, which callers may have
+  // already moved past the pending state (e.g. an update flushing on entry).
+  int64_t schunk_nbytes = schunk->nbytes;
+  int64_t schunk_cbytes = schunk->cbytes;
+  int32_t schunk_chunksize = schunk->chunksize;
+  schunk->nbytes = frame->pending_nbytes;
+  schunk->cbytes = frame->pending_cbytes;
+  schunk->chunksize = frame->pending_chunksize;
+  rc = write_frame_header(frame, schunk, false);
+  schunk->nbytes = schunk_nbytes;
+  schunk->cbytes = schunk_cbytes;
+  schunk->chunksize = schunk_chunksize;
+  frame->npending = 0;
+  if (rc < 0) {
+    return rc;
+  }
+
+  return 0;
+}
+
+/* See frame.h */
+int frame_flush_appends(blosc2_frame_s* frame) {
+  if (frame == NULL || frame->npending == 0) {
+    return 0;
+  }
+  blosc2_pthread_mutex_lock(&frame->write_mutex);
+  int rc = frame_flush_pending(frame);
+  if (rc >= 0 && frame->write_depth == 0) {
+    // Not within an operation, which would commit it
+    rc = journal_commit(frame);
+  }
+  blosc2_pthread_mutex_unlock(&frame->write_mutex);
+  return rc;
+}
+
+
+/* See frame.h */
+int frame_set_append_batch(blosc2_frame_s* frame, int64_t nappends) {
+  if (frame == NULL || frame->cframe != NULL || frame->urlpath == NULL) {
+    BLOSC_TRACE_ERROR("Deferred appends are only supported on disk-based frames.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (nappends != 0 && frame->locking) {
+    BLOSC_TRACE_ERROR("Deferred appends require a single writer; they cannot be "
+                      "combined with locking.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  frame->append_batch = nappends;
+  if (nappends == 0 || (nappends > 0 && frame->npending >= nappends)) {
+    return frame_flush_appends(frame);
+  }
+  return 0;
+}
+
+
+/* See frame.h */
+bool frame_can_defer_appends(blosc2_frame_s* frame) {
+  return frame != NULL && frame->cframe == NULL && frame->urlpath != NULL && !frame->locking &&
+         (frame->sframe || frame->journal);
+}
+
+
+/* Append an existing chunk into a frame. */
+void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schunk) {
+  if (frame->append_batch != 0) {
+    return frame_append_chunk_deferred(frame, chunk, schunk);
+  }
+  int8_t* chunk_ = chunk;
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int64_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, &chunksize,
+                           &nchunks, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                           frame->schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
+    return NULL;
+  }
+  rc = frame_refresh_if_stale(frame, frame_len);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to refresh the frame state from disk.");
+    return NULL;
+  }
+
+  /* The uncompressed and compressed sizes start at byte 4 and 12 */
+  int32_t chunk_nbytes;
+  int32_t chunk_cbytes;
+  rc = blosc2_cbuffer_sizes(chunk, &chunk_nbytes, &chunk_cbytes, NULL);
+  if (rc < 0) {
+    return NULL;
+  }
+
+  if (check_append_sizes(frame, chunk_nbytes, nbytes, chunksize, nchunks, schunk) < 0) {
+    return NULL;
   }
 
   // Get the current offsets and add one more
   int32_t off_nbytes = (int32_t) ((nchunks + 1) * sizeof(int64_t));
   int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
-  if (nchunks > 0) {
+  if (nchunks > 0 && frame->doffsets != NULL && frame->doffsets_nchunks == nchunks) {
+    // The decoded index is at hand; spare the decompression
+    memcpy(offsets, frame->doffsets, (size_t)nchunks * sizeof(int64_t));
+  }
+  else if (nchunks > 0) {
     int32_t coffsets_cbytes;
     uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
     if (coffsets == NULL) {
@@ -4197,7 +5075,14 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
             sframe_chunk_id = offsets[i];
           }
         }
-        offsets[nchunks] = ++sframe_chunk_id;
+        // Store the chunk right away, as its offset in packed sframes is only known then
+        sframe_chunk_id = sframe_create_chunk(frame, chunk, sframe_chunk_id + 1, chunk_cbytes);
+        if (sframe_chunk_id < 0) {
+          BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+          free(offsets);
+          return NULL;
+        }
+        offsets[nchunks] = sframe_chunk_id;
       }
       else {
         offsets[nchunks] = cbytes;
@@ -4221,8 +5106,8 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
   int32_t new_off_cbytes = blosc2_compress_ctx(cctx, offsets, off_nbytes,
                                                off_chunk, off_nbytes + BLOSC2_MAX_OVERHEAD);
   blosc2_free_ctx(cctx);
-  free(offsets);
   if (new_off_cbytes < 0) {
+    free(offsets);
     free(off_chunk);
     return NULL;
   }
@@ -4262,16 +5147,6 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
 
     if (frame->sframe) {
       // Update the offsets chunk in the chunks frame
-      if (chunk_cbytes != 0) {
-        if (sframe_chunk_id < 0) {
-          BLOSC_TRACE_ERROR("The chunk id (%" PRId64 ") is not correct", sframe_chunk_id);
-          return NULL;
-        }
-        if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
-          BLOSC_TRACE_ERROR("Cannot write the full chunk.");
-          return NULL;
-        }
-      }
       fp = sframe_open_index(frame->urlpath, "rb+",
                              frame->schunk->storage->io);
       if (fp == NULL) {
@@ -4288,7 +5163,7 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
         return NULL;
       }
       io_pos = frame->file_offset + header_len + cbytes;
-      wbytes = io_cb->write(chunk, 1, chunk_cbytes, io_pos, fp);  // the new chunk
+      wbytes = frame_io_write(frame, io_cb, chunk, 1, chunk_cbytes, io_pos, fp);  // the new chunk
       io_pos += chunk_cbytes;
       if (wbytes != chunk_cbytes) {
         BLOSC_TRACE_ERROR("Cannot write the full chunk to frame (wrote %" PRId64 " of %" PRId64
@@ -4298,20 +5173,16 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
         return NULL;
       }
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
+    wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
     io_cb->close(fp);
     if (wbytes != new_off_cbytes) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
   }
-  // Invalidate the cache for chunk offsets
-  if (frame->coffsets != NULL) {
-    if (frame->coffsets_needs_free)
-      free(frame->coffsets);
-    frame->coffsets = NULL;
-  }
-  free(chunk);  // chunk has always to be a copy when reaching here...
+  // Invalidate the cache for chunk offsets; the new ones are the decoded index
+  frame_drop_offsets_cache(frame);
+  set_doffsets(frame, offsets, nchunks + 1, nchunks + 1);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -4324,6 +5195,8 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
   if (rc < 0) {
     return NULL;
   }
+  // The caller keeps the chunk on failure
+  free(chunk);  // chunk has always to be a copy when reaching here...
 
   return frame;
 }
@@ -4338,10 +5211,16 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
   int32_t blocksize;
   int32_t chunksize;
   int64_t nchunks;
-  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
-                           &blocksize, &chunksize, &nchunks,
-                           NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                           frame->schunk->storage->io);
+  // Work on the committed index: write out any deferred appends first
+  int rc = frame_flush_appends(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot commit the pending appends.");
+    return NULL;
+  }
+  rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                       &blocksize, &chunksize, &nchunks,
+                       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                       frame->schunk->storage->io);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
     return NULL;
@@ -4420,7 +5299,14 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
             sframe_chunk_id = offsets[i];
           }
         }
-        offsets[nchunk] = ++sframe_chunk_id;
+        // Store the chunk right away, as its offset in packed sframes is only known then
+        sframe_chunk_id = sframe_create_chunk(frame, chunk, sframe_chunk_id + 1, chunk_cbytes);
+        if (sframe_chunk_id < 0) {
+          BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+          free(offsets);
+          return NULL;
+        }
+        offsets[nchunk] = sframe_chunk_id;
       }
       else {
         offsets[nchunk] = cbytes;
@@ -4485,16 +5371,6 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
     }
 
     if (frame->sframe) {
-      if (chunk_cbytes != 0) {
-        if (sframe_chunk_id < 0) {
-          BLOSC_TRACE_ERROR("The chunk id (%" PRId64 ") is not correct", sframe_chunk_id);
-          return NULL;
-        }
-        if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
-          BLOSC_TRACE_ERROR("Cannot write the full chunk.");
-          return NULL;
-        }
-      }
       // Update the offsets chunk in the chunks frame
       fp = sframe_open_index(frame->urlpath, "rb+",
                              frame->schunk->storage->io);
@@ -4512,7 +5388,7 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
         return NULL;
       }
       io_pos = frame->file_offset + header_len + cbytes;
-      wbytes = io_cb->write(chunk, 1, chunk_cbytes, io_pos, fp);  // the new chunk
+      wbytes = frame_io_write(frame, io_cb, chunk, 1, chunk_cbytes, io_pos, fp);  // the new chunk
       io_pos += chunk_cbytes;
       if (wbytes != chunk_cbytes) {
         BLOSC_TRACE_ERROR("Cannot write the full chunk to frame (wrote %" PRId64 " of %" PRId64
@@ -4522,19 +5398,15 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
         return NULL;
       }
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
+    wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
     io_cb->close(fp);
     if (wbytes != new_off_cbytes) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
-    // Invalidate the cache for chunk offsets
-    if (frame->coffsets != NULL) {
-      if (frame->coffsets_needs_free)
-        free(frame->coffsets);
-      frame->coffsets = NULL;
-    }
   }
+  // Invalidate the cache for chunk offsets
+  frame_drop_offsets_cache(frame);
   free(chunk);  // chunk has always to be a copy when reaching here...
   free(off_chunk);
 
@@ -4562,10 +5434,16 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
   int32_t blocksize;
   int32_t chunksize;
   int64_t nchunks;
-  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
-                           &blocksize, &chunksize, &nchunks,
-                           NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                           frame->schunk->storage->io);
+  // Work on the committed index: write out any deferred appends first
+  int rc = frame_flush_appends(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot commit the pending appends.");
+    return NULL;
+  }
+  rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                       &blocksize, &chunksize, &nchunks,
+                       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                       frame->schunk->storage->io);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
     return NULL;
@@ -4653,7 +5531,8 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
   bool new_chunk_is_regular = true;
   int64_t new_chunk_offset = cbytes;
   if (frame->sframe) {
-    if (offsets[nchunk] < 0) {
+    if (offsets[nchunk] < 0 || frame->packed) {
+      // Packed sframes never overwrite a chunk; the new one goes at the end of a segment
       sframe_chunk_id = -1;
     }
     else {
@@ -4691,8 +5570,16 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
               sframe_chunk_id = offsets[i];
             }
           }
-          offsets[nchunk] = ++sframe_chunk_id;
+          ++sframe_chunk_id;
+        }
+        // Store the chunk right away, as its offset in packed sframes is only known then
+        int64_t sframe_offset = sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes);
+        if (sframe_offset < 0) {
+          BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+          free(offsets);
+          return NULL;
         }
+        offsets[nchunk] = sframe_offset;
       }
       else {
         if (old_chunk_is_regular) {
@@ -4794,9 +5681,9 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
     }
 
     if (frame->sframe) {
-      // Create the chunks file, if it's a special value this will delete its old content
-      if (sframe_chunk_id >= 0) {
-        if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
+      // A special value replacing a chunk file: delete its old content
+      if (is_special_chunk && sframe_chunk_id >= 0) {
+        if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) < 0) {
           BLOSC_TRACE_ERROR("Cannot write the full chunk.");
           return NULL;
         }
@@ -4843,7 +5730,7 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
           if (!io_cb->is_allocation_necessary) {
             memcpy(tail, tail_src, (size_t)tail_nbytes);
           }
-          wbytes = io_cb->write(tail, 1, tail_nbytes,
+          wbytes = frame_io_write(frame, io_cb, tail, 1, tail_nbytes,
                                 frame->file_offset + header_len + tail_dst_offset, fp);
           free(tail);
           if (wbytes != tail_nbytes) {
@@ -4855,7 +5742,7 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
       }
       if (new_chunk_is_regular) {
         io_pos = frame->file_offset + header_len + new_chunk_offset;
-        wbytes = io_cb->write(chunk, 1, chunk_cbytes, io_pos, fp);  // the new chunk
+        wbytes = frame_io_write(frame, io_cb, chunk, 1, chunk_cbytes, io_pos, fp);  // the new chunk
         if (wbytes != chunk_cbytes) {
           BLOSC_TRACE_ERROR("Cannot write the full chunk to frame (wrote %" PRId64 " of %" PRId64
                             " bytes at position %" PRId64 ", nchunk=%" PRId64 ").",
@@ -4866,19 +5753,15 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
       }
       io_pos = frame->file_offset + header_len + new_cbytes;
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
+    wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
     io_cb->close(fp);
     if (wbytes != new_off_cbytes) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
-    // Invalidate the cache for chunk offsets
-    if (frame->coffsets != NULL) {
-      if (frame->coffsets_needs_free)
-        free(frame->coffsets);
-      frame->coffsets = NULL;
-    }
   }
+  // Invalidate the cache for chunk offsets
+  frame_drop_offsets_cache(frame);
   free(chunk);  // chunk has always to be a copy when reaching here...
   free(off_chunk);
 
@@ -4905,9 +5788,15 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int64_t nchunk, blosc2_schunk* s
   int32_t blocksize;
   int32_t chunksize;
   int64_t nchunks;
-  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
-                           &blocksize, &chunksize,  &nchunks,
-                           NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, frame->schunk->storage->io);
+  // Work on the committed index: write out any deferred appends first
+  int rc = frame_flush_appends(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot commit the pending appends.");
+    return NULL;
+  }
+  rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                       &blocksize, &chunksize,  &nchunks,
+                       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, frame->schunk->storage->io);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
     return NULL;
@@ -5021,7 +5910,7 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int64_t nchunk, blosc2_schunk* s
       }
       if (offset >= 0){
         // Remove the chunk file only if it is not a special value chunk
-        int err = sframe_delete_chunk(frame->urlpath, offset);
+        int err = sframe_delete_chunk(frame, offset);
         if (err != 0) {
           BLOSC_TRACE_ERROR("Unable to delete chunk!");
           return NULL;
@@ -5044,19 +5933,15 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int64_t nchunk, blosc2_schunk* s
       }
       io_pos = frame->file_offset + header_len + cbytes;
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
+    wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
     io_cb->close(fp);
     if (wbytes != (size_t)new_off_cbytes) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
-    // Invalidate the cache for chunk offsets
-    if (frame->coffsets != NULL) {
-      if (frame->coffsets_needs_free)
-        free(frame->coffsets);
-      frame->coffsets = NULL;
-    }
   }
+  // Invalidate the cache for chunk offsets
+  frame_drop_offsets_cache(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -5074,47 +5959,58 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int64_t nchunk, blosc2_schunk* s
 }
 
 
-int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, blosc2_schunk* schunk) {
+/* Get the decoded offsets index of a frame, for rewriting it with
+   frame_store_offsets().  Returns NULL on errors, with the code in *rc. */
+static int64_t* frame_load_offsets(blosc2_frame_s* frame, int32_t* header_len, int64_t* cbytes,
+                                   int64_t* nchunks, int32_t* off_nbytes, int* rc) {
   // Get header info
-  int32_t header_len;
   int64_t frame_len;
   int64_t nbytes;
-  int64_t cbytes;
   int32_t blocksize;
   int32_t chunksize;
-  int64_t nchunks;
-  int ret = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
-                            &blocksize, &chunksize, &nchunks,
-                            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                            frame->schunk->storage->io);
+  // Work on the committed index: write out any deferred appends first
+  int ret = frame_flush_appends(frame);
+  if (ret < 0) {
+    BLOSC_TRACE_ERROR("Cannot commit the pending appends.");
+    *rc = ret;
+    return NULL;
+  }
+  ret = get_header_info(frame, header_len, &frame_len, &nbytes, cbytes,
+                        &blocksize, &chunksize, nchunks,
+                        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                        frame->schunk->storage->io);
   if (ret < 0) {
       BLOSC_TRACE_ERROR("Cannot get the header info for the frame.");
-      return ret;
+      *rc = ret;
+      return NULL;
   }
   ret = frame_refresh_if_stale(frame, frame_len);
   if (ret < 0) {
     BLOSC_TRACE_ERROR("Unable to refresh the frame state from disk.");
-    return ret;
+    *rc = ret;
+    return NULL;
   }
 
-  // Get the current offsets and add one more
-  int32_t off_nbytes;
-  if (!blosc2_nchunks_to_offsets_nbytes(nchunks, &off_nbytes)) {
+  // Get the current offsets
+  if (!blosc2_nchunks_to_offsets_nbytes(*nchunks, off_nbytes)) {
     BLOSC_TRACE_ERROR("Too many chunks for offsets representation.");
-    return BLOSC2_ERROR_DATA;
+    *rc = BLOSC2_ERROR_DATA;
+    return NULL;
   }
-  int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
+  int64_t* offsets = (int64_t *) malloc((size_t)*off_nbytes);
   if (offsets == NULL) {
     BLOSC_TRACE_ERROR("Cannot allocate memory for offsets.");
-    return BLOSC2_ERROR_MEMORY_ALLOC;
+    *rc = BLOSC2_ERROR_MEMORY_ALLOC;
+    return NULL;
   }
 
   int32_t coffsets_cbytes = 0;
-  uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
+  uint8_t *coffsets = get_coffsets(frame, *header_len, *cbytes, *nchunks, &coffsets_cbytes);
   if (coffsets == NULL) {
     BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
     free(offsets);
-    return BLOSC2_ERROR_DATA;
+    *rc = BLOSC2_ERROR_DATA;
+    return NULL;
   }
 
   // Decompress offsets
@@ -5122,26 +6018,27 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, b
   blosc2_context *dctx = blosc2_create_dctx(off_dparams);
   if (dctx == NULL) {
     BLOSC_TRACE_ERROR("Error while creating the decompression context");
-    return BLOSC2_ERROR_NULL_POINTER;
+    free(offsets);
+    *rc = BLOSC2_ERROR_NULL_POINTER;
+    return NULL;
   }
   int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes,
-                                              offsets, off_nbytes);
+                                              offsets, *off_nbytes);
   blosc2_free_ctx(dctx);
   if (prev_nbytes < 0) {
     free(offsets);
     BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
-    return prev_nbytes;
+    *rc = prev_nbytes;
+    return NULL;
   }
 
-  // Make a copy of the chunk offsets and reorder it
-  int64_t *offsets_copy = malloc(prev_nbytes);
-  memcpy(offsets_copy, offsets, prev_nbytes);
+  return offsets;
+}
 
-  for (int64_t i = 0; i < nchunks; ++i) {
-    offsets[i] = offsets_copy[offsets_order[i]];
-  }
-  free(offsets_copy);
 
+/* Write the offsets index of a frame got with frame_load_offsets() back */
+static int frame_store_offsets(blosc2_frame_s* frame, blosc2_schunk* schunk, int64_t* offsets,
+                               int32_t off_nbytes, int32_t header_len, int64_t cbytes) {
   // Re-compress the offsets again
   blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
   cparams.splitmode = BLOSC_NEVER_SPLIT;
@@ -5160,11 +6057,9 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, b
   blosc2_free_ctx(cctx);
 
   if (new_off_cbytes < 0) {
-    free(offsets);
     free(off_chunk);
     return new_off_cbytes;
   }
-  free(offsets);
   int64_t new_frame_len;
   if (frame->sframe) {
     // The chunks are not in the frame
@@ -5214,7 +6109,7 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, b
       }
       io_pos = frame->file_offset + header_len + cbytes;
     }
-    int64_t wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
+    int64_t wbytes = frame_io_write(frame, io_cb, off_chunk, 1, new_off_cbytes, io_pos, fp);  // the new offsets
     io_cb->close(fp);
     if (wbytes != new_off_cbytes) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
@@ -5223,11 +6118,7 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, b
   }
 
   // Invalidate the cache for chunk offsets
-  if (frame->coffsets != NULL) {
-    if (frame->coffsets_needs_free)
-      free(frame->coffsets);
-    frame->coffsets = NULL;
-  }
+  frame_drop_offsets_cache(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -5244,6 +6135,75 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, b
   return 0;
 }
 
+
+int frame_reorder_offsets(blosc2_frame_s* frame, const int64_t* offsets_order, blosc2_schunk* schunk) {
+  int32_t header_len;
+  int64_t cbytes;
+  int64_t nchunks;
+  int32_t off_nbytes;
+  int rc;
+  int64_t* offsets = frame_load_offsets(frame, &header_len, &cbytes, &nchunks, &off_nbytes, &rc);
+  if (offsets == NULL) {
+    return rc;
+  }
+
+  // Make a copy of the chunk offsets and reorder it
+  int64_t *offsets_copy = malloc(off_nbytes);
+  memcpy(offsets_copy, offsets, off_nbytes);
+
+  for (int64_t i = 0; i < nchunks; ++i) {
+    offsets[i] = offsets_copy[offsets_order[i]];
+  }
+  free(offsets_copy);
+
+  rc = frame_store_offsets(frame, schunk, offsets, off_nbytes, header_len, cbytes);
+  free(offsets);
+  return rc;
+}
+
+
+/* See frame.h */
+int64_t frame_compact(blosc2_frame_s* frame, blosc2_schunk* schunk) {
+  if (!frame->sframe || !frame->packed) {
+    return 0;
+  }
+  int32_t header_len;
+  int64_t cbytes;
+  int64_t nchunks;
+  int32_t off_nbytes;
+  int rc;
+  int64_t* offsets = frame_load_offsets(frame, &header_len, &cbytes, &nchunks, &off_nbytes, &rc);
+  if (offsets == NULL) {
+    return rc;
+  }
+
+  // Copy the live chunks to new segments, then point the index there, and
+  // only then remove the old segments: a crash leaves a valid frame anyway
+  int64_t nsegments;
+  int64_t wbytes = sframe_compact_chunks(frame, offsets, nchunks, &nsegments);
+  if (wbytes < 0) {
+    free(offsets);
+    return wbytes;
+  }
+  rc = frame_store_offsets(frame, schunk, offsets, off_nbytes, header_len, cbytes);
+  free(offsets);
+  if (rc < 0) {
+    return rc;
+  }
+  // The new index has to be there for good before the segments go (the
+  // journal would bring back the old index, but not the removed segments)
+  rc = journal_commit(frame);
+  if (rc < 0) {
+    return rc;
+  }
+  int64_t rbytes = sframe_remove_segments(frame, nsegments);
+  if (rbytes < 0) {
+    return rbytes;
+  }
+
+  return rbytes > wbytes ? rbytes - wbytes : 0;
+}
+
 /* Decompress and return a chunk that is part of a frame. */
 int frame_decompress_chunk(blosc2_context *dctx, blosc2_frame_s* frame, int64_t nchunk, void *dest, int32_t nbytes) {
   uint8_t* src;
@@ -20,6 +20,7 @@
 // Different types of frames
 #define FRAME_CONTIGUOUS_TYPE 0
 #define FRAME_DIRECTORY_TYPE 1
+#define FRAME_PACKED_DIRECTORY_TYPE 2
 
 
 // Constants for metadata placement in header
@@ -70,6 +71,7 @@ typedef struct {
   int64_t maxlen;           //!< The maximum length of the frame; if 0, there is no maximum
   uint32_t trailer_len;     //!< The current length of the trailer in (compressed) bytes
   bool sframe;              //!< Whether the frame is sparse (true) or not
+  bool packed;              //!< Whether the chunks of a sparse frame are packed in segment files
   blosc2_schunk *schunk;    //!< The schunk associated
   int64_t file_offset;      //!< The offset where the frame starts inside the file
   bool locking;             //!< Whether accesses are serialized via a sidecar lock file
@@ -82,6 +84,34 @@ typedef struct {
   int32_t read_fp_refs;     //!< Outstanding frame_reader_acquire() calls on read_fp
   bool read_fp_nocache;     //!< The handle cache was full for this frame; do not ask again
   blosc2_pthread_mutex_t read_fp_mutex;  //!< Guards read_fp and its bookkeeping
+  void* sframe_handles;     //!< Cached handles of the chunk files of an sframe (see sframe.c); also under read_fp_mutex
+  int64_t append_batch;     //!< Appends deferred between index commits; 0: commit on every append
+  int64_t* doffsets;        //!< Decoded offsets index kept while deferring appends; NULL if not loaded
+  int64_t doffsets_nchunks; //!< Number of entries in doffsets
+  int64_t doffsets_nalloc;  //!< Capacity (in entries) of doffsets
+  int64_t doffsets_max;     //!< Largest non-negative entry in doffsets (-1 if none); next sframe chunk id - 1
+  int64_t npending;         //!< Appends not yet committed to the on-disk index
+  int64_t pending_nbytes;   //!< Uncompressed size including the pending appends
+  int64_t pending_cbytes;   //!< Size of the data section including the pending appends
+  int32_t pending_chunksize;  //!< Chunk size including the pending appends
+  blosc2_pthread_mutex_t write_mutex;  //!< Serializes the mutations through this handle (recursive)
+  int32_t write_depth;      //!< Nesting depth of frame_write_lock(); under write_mutex
+  uint8_t durability;       //!< One of BLOSC2_DURABILITY_* (see frame_set_durability())
+  int64_t durability_every; //!< Milliseconds (INTERVAL) or operations (EVERY_OPS) between syncs
+  bool durability_defers;   //!< EVERY_OPS turned the deferred appends on (and has to turn them off)
+  int64_t nunsynced;        //!< Mutating operations since the last sync; under write_mutex
+  int64_t* dirty_ids;       //!< Sframe chunk (or segment) files written since the last sync; under write_mutex
+  int64_t ndirty;           //!< Number of entries in dirty_ids
+  int64_t dirty_nalloc;     //!< Capacity (in entries) of dirty_ids
+  blosc2_pthread_mutex_t sync_mutex;  //!< Guards syncing and the syncer thread state
+  blosc2_pthread_cond_t sync_cv;      //!< Signalled when a sync completes
+  bool syncing;             //!< A sync is writing the files out (outside of write_mutex)
+  blosc2_pthread_cond_t syncer_cv;    //!< Wakes up the syncer thread to stop it
+  blosc2_pthread_t syncer;  //!< Background thread of the INTERVAL policy
+  bool syncer_running;      //!< Whether syncer has been started (and not joined yet)
+  bool syncer_stop;         //!< Asks syncer to exit
+  bool journal;             //!< Whether in-place updates are logged in a sidecar journal first
+  void* journal_state;      //!< The journal and its running transaction (see journal.c); under write_mutex
 } blosc2_frame_s;
 
 
@@ -175,6 +205,16 @@ void* frame_update_chunk(blosc2_frame_s* frame, int64_t nchunk, void* chunk, blo
 void* frame_delete_chunk(blosc2_frame_s* frame, int64_t nchunk, blosc2_schunk* schunk);
 int frame_reorder_offsets(blosc2_frame_s *frame, const int64_t *offsets_order, blosc2_schunk* schunk);
 
+/**
+ * @brief Copy the live chunks of a packed sparse frame into new segment files,
+ * point the offsets index to them and remove the old segments (see
+ * blosc2_schunk_compact()).
+ *
+ * @return The bytes reclaimed (0 if the frame is not a packed one), or a
+ * negative error code.
+ */
+int64_t frame_compact(blosc2_frame_s* frame, blosc2_schunk* schunk);
+
 /**
  * @brief Get an open "rb" handle for the frame file (regular frames only; sframe
  * chunk/index files keep their own opens).  With the default filesystem backend
@@ -183,7 +223,7 @@ int frame_reorder_offsets(blosc2_frame_s *frame, const int64_t *offsets_order, b
  * open/close each: reads there are positional (pread), hence safe to share.
  *
  * Caching is skipped, and a private per-call handle returned instead, when:
- * the backend is not #BLOSC2_IO_FILESYSTEM (other backends keep their per-call
+ * the backend is not #BLOSC2_IO_FILESYSTEM(_URING) (other backends keep their per-call
  * open/close contract); the platform is Windows (the CRT gives no
  * FILE_SHARE_DELETE, so a cached handle would block unlink/rename of the frame
  * file); or the process-wide cache is full, which bounds descriptor use at
@@ -222,14 +262,124 @@ void frame_reader_invalidate(blosc2_frame_s* frame);
  */
 void frame_reader_revalidate(blosc2_frame_s* frame);
 
+/**
+ * @brief Claim a slot of the process-wide budget of cached handles (see
+ * frame_reader_acquire()) for one more cached handle, or report that it is
+ * exhausted (always, on Windows).  Give it back with
+ * frame_reader_cache_return() when the handle is closed.
+ */
+bool frame_reader_cache_claim(void);
+void frame_reader_cache_return(void);
+
 int frame_get_chunk(blosc2_frame_s* frame, int64_t nchunk, uint8_t **chunk, bool *needs_free);
 int frame_get_lazychunk(blosc2_frame_s* frame, int64_t nchunk, uint8_t **chunk, bool *needs_free);
+
+/**
+ * @brief Hint the I/O backend that @p nchunk is going to be read soon, so that
+ * reading it overlaps with the work done until then.  A no-op for in-memory
+ * frames, special chunks and backends without a prefetch callback.
+ *
+ * @return The number of ranges hinted (0 or 1), or a negative value on errors.
+ */
+int frame_prefetch_chunk(blosc2_frame_s* frame, int64_t nchunk);
 int frame_decompress_chunk(blosc2_context* dctx, blosc2_frame_s* frame, int64_t nchunk,
                            void *dest, int32_t nbytes);
 
 int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new);
 int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk);
 
+/**
+ * @brief Set how many appends are accumulated before the offsets index, header
+ * and trailer of a disk-based frame are written out (see
+ * blosc2_schunk_set_append_batch() for the semantics of @p nappends).
+ * Switching back to 0 commits the pending appends first.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_set_append_batch(blosc2_frame_s* frame, int64_t nappends);
+
+/**
+ * @brief Whether the appends to a disk-based frame can be deferred without the
+ * caller asking for it (see blosc2_schunk_append_buffers()): a crash amid them
+ * only loses the pending appends of a sparse frame, and the journal rolls a
+ * contiguous one back, but a plain contiguous frame would be left invalid.
+ */
+bool frame_can_defer_appends(blosc2_frame_s* frame);
+
+/**
+ * @brief Commit the appends deferred by frame_set_append_batch(): write the
+ * offsets index past the last appended chunk, then the trailer and finally the
+ * header, so the on-disk frame is valid (and complete) again.  A no-op when
+ * nothing is pending.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_flush_appends(blosc2_frame_s* frame);
+
+/**
+ * @brief Serialize a mutation (or a sequence of them) through this handle
+ * with the others, from any thread, and take the exclusive sidecar lock
+ * (see frame_lock()).  Re-entrant.  A no-op when @p frame is NULL.
+ *
+ * @return 0 if succeeds; BLOSC2_ERROR_LOCK otherwise.
+ */
+int frame_write_lock(blosc2_frame_s* frame);
+
+/**
+ * @brief Release frame_write_lock().  Leaving the outermost level counts as
+ * one mutating operation for the durability policy, and may sync the frame
+ * (outside of the lock) with #BLOSC2_DURABILITY_EVERY_OPS.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_write_unlock(blosc2_frame_s* frame);
+
+/**
+ * @brief Set the durability policy of a disk-based frame (see
+ * blosc2_schunk_set_durability()).  Leaving a policy other than
+ * #BLOSC2_DURABILITY_NONE syncs the frame one last time, so
+ * frame_set_durability(frame, BLOSC2_DURABILITY_NONE, 0) is also what
+ * closing the frame does.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_set_durability(blosc2_frame_s* frame, uint8_t policy, int64_t every);
+
+/**
+ * @brief Commit the pending appends and make everything written to the frame
+ * so far durable, through the `sync` callback of the I/O backend.  The files
+ * are synced outside of frame_write_lock(), so writers in other threads go on
+ * meanwhile; a sync that is already in flight is waited for first.  A no-op
+ * with #BLOSC2_DURABILITY_NONE.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_sync(blosc2_frame_s* frame);
+
+/**
+ * @brief Record that sframe file @p id (a chunk, or a segment for packed
+ * frames) has been written to, so that the next sync covers it.  Must be
+ * called under frame_write_lock().
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_mark_dirty(blosc2_frame_s* frame, int64_t id);
+
+/**
+ * @brief Sync the files of the frame right away: the frame file, or the index
+ * and the @p nids files in @p ids of an sframe, plus their directory.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int frame_sync_files(blosc2_frame_s* frame, const int64_t* ids, int64_t nids);
+
+/**
+ * @brief Sync the directory entries of the frame in @p urlpath (the files of
+ * an sframe, or the frame file itself), so that created and removed files are
+ * durable too.  A no-op on Windows.
+ */
+void frame_sync_dir(const char* urlpath, bool sframe);
+
 int frame_get_metalayers(blosc2_frame_s* frame, blosc2_schunk* schunk);
 int frame_get_vlmetalayers(blosc2_frame_s* frame, blosc2_schunk* schunk);
 
@@ -248,6 +398,10 @@ int frame_check_stale(blosc2_frame_s* frame);
 void schunk_free_metalayers(blosc2_schunk* schunk);
 void schunk_free_vlmetalayers(blosc2_schunk* schunk);
 
+/* Drop the cached decompressed chunks of a schunk (defined in schunk.c); used
+ * when a refresh finds that another handle changed the frame. */
+void schunk_clear_cache(blosc2_schunk* schunk);
+
 /**
  * @brief Acquire the frame's cross-process advisory lock (shared for reads,
  * exclusive for mutations), blocking until available.  A no-op unless locking
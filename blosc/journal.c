@@ -0,0 +1,841 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#if !defined(_WIN32)
+// Make flock() and O_CLOEXEC visible (see frame.c)
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#define _DARWIN_C_SOURCE
+#if defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || \
+    defined(__DragonFly__)
+#undef _XOPEN_SOURCE
+#endif
+#endif
+
+#include "journal.h"
+#include "frame.h"
+#include "sframe.h"
+#include "blosc-private.h"
+#include "blosc2.h"
+
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <windows.h>
+#define stat _stat64
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#if !defined(O_CLOEXEC)
+#define O_CLOEXEC 0
+#endif
+#endif  /* _WIN32 */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* The journal is a magic string followed by records, all little endian:
+ *
+ *   uint32 type, uint32 checksum, int64 file, int64 pos, int64 len, payload
+ *
+ * A JOURNAL_FILE record comes first for every file touched by the
+ * transaction, with its original size in pos (-1 if it did not exist) and no
+ * payload.  A JOURNAL_RANGE record has the len bytes found at pos in the
+ * file before they were overwritten.  The checksum (FNV-1a) covers the whole
+ * record with the checksum field zeroed, so a record torn by a crash is
+ * detected and ends the journal. */
+#define JOURNAL_MAGIC "b2jrnl01"
+#define JOURNAL_MAGIC_LEN 8
+#define JOURNAL_RECORD_LEN 32
+#define JOURNAL_FILE 1
+#define JOURNAL_RANGE 2
+
+
+typedef struct {
+  int64_t start;
+  int64_t stop;
+} journal_range;
+
+typedef struct {
+  int64_t id;               //!< JOURNAL_MAIN_FILE or a chunk id
+  int64_t size;             //!< The size before the transaction; -1 if it did not exist
+  int64_t limit;            //!< Bytes past this one are not part of the frame
+  journal_range* saved;     //!< The ranges already in the journal
+  int64_t nsaved;
+  int64_t nalloc;
+} journal_file;
+
+typedef struct {
+  intptr_t fd;              //!< The fd (POSIX) or HANDLE (Windows) of the journal; -1 if not open
+  bool active;              //!< A transaction is running (and the journal is locked)
+  int64_t len;              //!< The length of the journal
+  journal_file* files;      //!< The files touched by the transaction
+  int64_t nfiles;
+  int64_t nalloc;
+} journal_state;
+
+
+bool journal_requested(const blosc2_io* io) {
+  if (io == NULL || (io->id != BLOSC2_IO_FILESYSTEM && io->id != BLOSC2_IO_FILESYSTEM_URING)) {
+    return false;
+  }
+  // "0" or an empty value leave it off
+  char* envvar = getenv("BLOSC_JOURNAL");
+  return envvar != NULL && envvar[0] != '\0' && strcmp(envvar, "0") != 0;
+}
+
+
+void journal_enable(blosc2_frame_s* frame, const blosc2_io* io) {
+  if (frame->urlpath != NULL && frame->cframe == NULL && journal_requested(io)) {
+    frame->journal = true;
+  }
+}
+
+
+int journal_set(blosc2_frame_s* frame, bool journal) {
+  const blosc2_io* io = frame->schunk->storage->io;
+  if (frame->urlpath == NULL || frame->cframe != NULL ||
+      (io->id != BLOSC2_IO_FILESYSTEM && io->id != BLOSC2_IO_FILESYSTEM_URING)) {
+    BLOSC_TRACE_ERROR("The journal is only supported on frames on disk with the default filesystem I/O.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  int rc = BLOSC2_ERROR_SUCCESS;
+  blosc2_pthread_mutex_lock(&frame->write_mutex);
+  if (!journal && !frame->sframe && frame->durability_defers) {
+    // Without the journal, a crash amid deferred appends would leave a contiguous frame invalid
+    rc = frame_set_append_batch(frame, 0);
+    frame->durability_defers = false;
+  }
+  if (!journal && rc >= 0) {
+    rc = journal_commit(frame);
+  }
+  if (rc >= 0) {
+    frame->journal = journal;
+  }
+  blosc2_pthread_mutex_unlock(&frame->write_mutex);
+  return rc;
+}
+
+
+/* Path of the journal: inside the directory for sframes, alongside the file
+   for cframes (like the .b2lock sidecar) */
+static char* journal_path(const char* urlpath, bool sframe) {
+  const char* suffix = sframe ? "/.b2journal" : ".b2journal";
+  char* path = malloc(strlen(urlpath) + strlen(suffix) + 1);
+  if (path == NULL) {
+    return NULL;
+  }
+  strcpy(path, urlpath);
+  strcat(path, suffix);
+  return path;
+}
+
+
+static char* journal_file_path(const char* urlpath, bool sframe, int64_t id) {
+  if (id != JOURNAL_MAIN_FILE) {
+    return sframe_make_file_path(urlpath, id, "chunk");
+  }
+  if (sframe) {
+    return sframe_make_index_path(urlpath);
+  }
+  char* path = malloc(strlen(urlpath) + 1);
+  return path == NULL ? NULL : strcpy(path, urlpath);
+}
+
+
+static int64_t journal_file_size(const char* path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return -1;
+  }
+  return (int64_t)st.st_size;
+}
+
+
+static uint32_t journal_checksum(uint32_t hash, const uint8_t* data, int64_t len) {
+  for (int64_t i = 0; i < len; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+
+/* Thin wrappers over the OS file API, as the journal has to be locked (like
+   the .b2lock sidecar) and synced independently of the I/O backend */
+
+static intptr_t journal_os_open(const char* path) {
+#if defined(_WIN32)
+  HANDLE h = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  return h == INVALID_HANDLE_VALUE ? -1 : (intptr_t)h;
+#else
+  return open(path, O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+#endif
+}
+
+
+static void journal_os_close(intptr_t fd) {
+#if defined(_WIN32)
+  CloseHandle((HANDLE)fd);
+#else
+  close((int)fd);
+#endif
+}
+
+
+/* Returns false when the lock is busy (!wait) or cannot be taken */
+static bool journal_os_lock(intptr_t fd, bool wait) {
+#if defined(_WIN32)
+  OVERLAPPED ov;
+  memset(&ov, 0, sizeof(ov));
+  DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+  return LockFileEx((HANDLE)fd, flags, 0, 1, 0, &ov) != 0;
+#else
+  int rc;
+  do {
+    rc = flock((int)fd, LOCK_EX | (wait ? 0 : LOCK_NB));
+  } while (rc != 0 && errno == EINTR);
+  return rc == 0;
+#endif
+}
+
+
+static void journal_os_unlock(intptr_t fd) {
+#if defined(_WIN32)
+  OVERLAPPED ov;
+  memset(&ov, 0, sizeof(ov));
+  UnlockFileEx((HANDLE)fd, 0, 1, 0, &ov);
+#else
+  flock((int)fd, LOCK_UN);
+#endif
+}
+
+
+static int journal_os_pwrite(intptr_t fd, const uint8_t* buf, int64_t len, int64_t pos) {
+  while (len > 0) {
+#if defined(_WIN32)
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)(pos & 0xFFFFFFFF);
+    ov.OffsetHigh = (DWORD)(pos >> 32);
+    DWORD n = 0;
+    DWORD nbytes = len > (1 << 30) ? (1 << 30) : (DWORD)len;
+    if (!WriteFile((HANDLE)fd, buf, nbytes, &n, &ov) || n == 0) {
+      return -1;
+    }
+#else
+    ssize_t n = pwrite((int)fd, buf, (size_t)(len > (1 << 30) ? (1 << 30) : len), (off_t)pos);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+#endif
+    buf += n;
+    pos += n;
+    len -= n;
+  }
+  return 0;
+}
+
+
+static int journal_os_pread(intptr_t fd, uint8_t* buf, int64_t len, int64_t pos) {
+  while (len > 0) {
+#if defined(_WIN32)
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)(pos & 0xFFFFFFFF);
+    ov.OffsetHigh = (DWORD)(pos >> 32);
+    DWORD n = 0;
+    DWORD nbytes = len > (1 << 30) ? (1 << 30) : (DWORD)len;
+    if (!ReadFile((HANDLE)fd, buf, nbytes, &n, &ov) || n == 0) {
+      return -1;
+    }
+#else
+    ssize_t n = pread((int)fd, buf, (size_t)(len > (1 << 30) ? (1 << 30) : len), (off_t)pos);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+#endif
+    buf += n;
+    pos += n;
+    len -= n;
+  }
+  return 0;
+}
+
+
+static int64_t journal_os_size(intptr_t fd) {
+#if defined(_WIN32)
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx((HANDLE)fd, &size)) {
+    return -1;
+  }
+  return (int64_t)size.QuadPart;
+#else
+  struct stat st;
+  if (fstat((int)fd, &st) != 0) {
+    return -1;
+  }
+  return (int64_t)st.st_size;
+#endif
+}
+
+
+/* Empty the journal, durably: this is what commits a transaction */
+static int journal_os_clear(intptr_t fd) {
+#if defined(_WIN32)
+  LARGE_INTEGER zero;
+  zero.QuadPart = 0;
+  if (!SetFilePointerEx((HANDLE)fd, zero, NULL, FILE_BEGIN) || !SetEndOfFile((HANDLE)fd) ||
+      !FlushFileBuffers((HANDLE)fd)) {
+    return -1;
+  }
+#else
+  if (ftruncate((int)fd, 0) != 0) {
+    return -1;
+  }
+#if defined(__linux__)
+  if (fdatasync((int)fd) != 0) {
+#else
+  if (fsync((int)fd) != 0) {
+#endif
+    return -1;
+  }
+#endif
+  return 0;
+}
+
+
+static int journal_os_sync(intptr_t fd) {
+#if defined(_WIN32)
+  return FlushFileBuffers((HANDLE)fd) ? 0 : -1;
+#elif defined(__linux__)
+  return fdatasync((int)fd);
+#else
+  return fsync((int)fd);
+#endif
+}
+
+
+/* Undo the transaction recorded in the (locked) journal fd */
+static int journal_rollback(intptr_t fd, const char* urlpath, bool sframe) {
+  int64_t len = journal_os_size(fd);
+  if (len <= 0) {
+    return len < 0 ? BLOSC2_ERROR_FILE_READ : BLOSC2_ERROR_SUCCESS;
+  }
+  uint8_t* journal = malloc((size_t)len);
+  if (journal == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  if (journal_os_pread(fd, journal, len, 0) < 0) {
+    free(journal);
+    return BLOSC2_ERROR_FILE_READ;
+  }
+  if (len < JOURNAL_MAGIC_LEN || memcmp(journal, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN) != 0) {
+    // Torn before the first record: nothing was overwritten yet
+    free(journal);
+    return journal_os_clear(fd) < 0 ? BLOSC2_ERROR_FILE_WRITE : BLOSC2_ERROR_SUCCESS;
+  }
+
+  // Collect the valid records
+  int64_t nrecords = 0;
+  int64_t* records = malloc((size_t)(len / JOURNAL_RECORD_LEN + 1) * sizeof(int64_t));
+  if (records == NULL) {
+    free(journal);
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int64_t offset = JOURNAL_MAGIC_LEN;
+  while (offset + JOURNAL_RECORD_LEN <= len) {
+    uint8_t* record = journal + offset;
+    uint32_t type;
+    uint32_t checksum;
+    int64_t rlen;
+    from_little(&type, record, sizeof(type));
+    from_little(&checksum, record + 4, sizeof(checksum));
+    from_little(&rlen, record + 24, sizeof(rlen));
+    int64_t payload_len = type == JOURNAL_RANGE ? rlen : 0;
+    if ((type != JOURNAL_FILE && type != JOURNAL_RANGE) || payload_len < 0 ||
+        payload_len > len - offset - JOURNAL_RECORD_LEN) {
+      break;
+    }
+    memset(record + 4, 0, sizeof(checksum));
+    uint32_t hash = journal_checksum(2166136261u, record, JOURNAL_RECORD_LEN + payload_len);
+    if (hash != checksum) {
+      break;
+    }
+    records[nrecords++] = offset;
+    offset += JOURNAL_RECORD_LEN + payload_len;
+  }
+
+  // The newest pre-images go back first, so that the oldest ones win
+  int rc = BLOSC2_ERROR_SUCCESS;
+  for (int64_t i = nrecords - 1; i >= 0 && rc == BLOSC2_ERROR_SUCCESS; i--) {
+    uint8_t* record = journal + records[i];
+    uint32_t type;
+    int64_t file;
+    int64_t pos;
+    int64_t rlen;
+    from_little(&type, record, sizeof(type));
+    from_little(&file, record + 8, sizeof(file));
+    from_little(&pos, record + 16, sizeof(pos));
+    from_little(&rlen, record + 24, sizeof(rlen));
+    if (type != JOURNAL_RANGE) {
+      continue;
+    }
+    char* path = journal_file_path(urlpath, sframe, file);
+    if (path == NULL) {
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      break;
+    }
+    // Removed files are recreated
+    void* fp = blosc2_stdio_open(path, journal_file_size(path) < 0 ? "wb" : "rb+", NULL);
+    if (fp == NULL) {
+      rc = BLOSC2_ERROR_FILE_OPEN;
+    }
+    else {
+      if (blosc2_stdio_write(record + JOURNAL_RECORD_LEN, 1, rlen, pos, fp) != rlen) {
+        rc = BLOSC2_ERROR_FILE_WRITE;
+      }
+      blosc2_stdio_close(fp);
+    }
+    free(path);
+  }
+
+  // Then the files get their original sizes back, and are synced
+  for (int64_t i = 0; i < nrecords && rc == BLOSC2_ERROR_SUCCESS; i++) {
+    uint8_t* record = journal + records[i];
+    uint32_t type;
+    int64_t file;
+    int64_t size;
+    from_little(&type, record, sizeof(type));
+    from_little(&file, record + 8, sizeof(file));
+    from_little(&size, record + 16, sizeof(size));
+    if (type != JOURNAL_FILE) {
+      continue;
+    }
+    char* path = journal_file_path(urlpath, sframe, file);
+    if (path == NULL) {
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      break;
+    }
+    if (size < 0) {
+      // Created by the transaction
+      if (journal_file_size(path) >= 0 && remove(path) != 0) {
+        rc = BLOSC2_ERROR_FILE_REMOVE;
+      }
+    }
+    else {
+      void* fp = blosc2_stdio_open(path, journal_file_size(path) < 0 ? "wb" : "rb+", NULL);
+      if (fp == NULL) {
+        rc = BLOSC2_ERROR_FILE_OPEN;
+      }
+      else {
+        if (blosc2_stdio_truncate(fp, size) != 0) {
+          rc = BLOSC2_ERROR_FILE_TRUNCATE;
+        }
+        else if (blosc2_stdio_sync(fp) < 0) {
+          rc = BLOSC2_ERROR_FILE_WRITE;
+        }
+        blosc2_stdio_close(fp);
+      }
+    }
+    free(path);
+  }
+  free(records);
+  free(journal);
+
+  if (rc == BLOSC2_ERROR_SUCCESS) {
+    frame_sync_dir(urlpath, sframe);
+    if (journal_os_clear(fd) < 0) {
+      rc = BLOSC2_ERROR_FILE_WRITE;
+    }
+  }
+  return rc;
+}
+
+
+int journal_recover(const char* urlpath, const blosc2_io* io) {
+  if (io == NULL || (io->id != BLOSC2_IO_FILESYSTEM && io->id != BLOSC2_IO_FILESYSTEM_URING &&
+                     io->id != BLOSC2_IO_FILESYSTEM_MMAP)) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  struct stat st;
+  if (stat(urlpath, &st) != 0) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  bool sframe = (st.st_mode & S_IFDIR) != 0;
+  char* path = journal_path(urlpath, sframe);
+  if (path == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  // Frames that never had journaling enabled have no journal
+  if (journal_file_size(path) <= 0) {
+    free(path);
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  intptr_t fd = journal_os_open(path);
+  free(path);
+  if (fd == -1) {
+    BLOSC_TRACE_ERROR("Cannot open the journal of: %s", urlpath);
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+  if (!journal_os_lock(fd, false)) {
+    // The writer is alive and will commit
+    journal_os_close(fd);
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  int rc = BLOSC2_ERROR_SUCCESS;
+  if (journal_os_size(fd) > 0) {
+    BLOSC_TRACE_WARNING("Rolling back an interrupted update of: %s", urlpath);
+    rc = journal_rollback(fd, urlpath, sframe);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot roll back the interrupted update of: %s", urlpath);
+    }
+  }
+  journal_os_unlock(fd);
+  journal_os_close(fd);
+  return rc;
+}
+
+
+static journal_state* journal_get_state(blosc2_frame_s* frame) {
+  if (frame->journal_state == NULL) {
+    journal_state* state = calloc(1, sizeof(journal_state));
+    if (state == NULL) {
+      return NULL;
+    }
+    state->fd = -1;
+    frame->journal_state = state;
+  }
+  return frame->journal_state;
+}
+
+
+static int journal_append(journal_state* state, uint32_t type, int64_t file, int64_t pos,
+                          int64_t len, uint8_t* record) {
+  to_little(record, &type, sizeof(type));
+  memset(record + 4, 0, 4);
+  to_little(record + 8, &file, sizeof(file));
+  to_little(record + 16, &pos, sizeof(pos));
+  to_little(record + 24, &len, sizeof(len));
+  int64_t payload_len = type == JOURNAL_RANGE ? len : 0;
+  uint32_t checksum = journal_checksum(2166136261u, record, JOURNAL_RECORD_LEN + payload_len);
+  to_little(record + 4, &checksum, sizeof(checksum));
+  if (journal_os_pwrite(state->fd, record, JOURNAL_RECORD_LEN + payload_len, state->len) < 0) {
+    BLOSC_TRACE_ERROR("Cannot write to the journal.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  state->len += JOURNAL_RECORD_LEN + payload_len;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Copy [start, stop) of jf to the journal, unless it is there already */
+static int journal_save_range(blosc2_frame_s* frame, journal_state* state, journal_file* jf,
+                              int64_t start, int64_t stop, bool* appended) {
+  if (stop > jf->limit) {
+    stop = jf->limit;
+  }
+  if (start >= stop) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  for (int64_t i = 0; i < jf->nsaved; i++) {
+    if (jf->saved[i].start <= start && stop <= jf->saved[i].stop) {
+      return BLOSC2_ERROR_SUCCESS;
+    }
+  }
+  if (jf->nsaved == jf->nalloc) {
+    int64_t nalloc = jf->nalloc == 0 ? 8 : 2 * jf->nalloc;
+    journal_range* saved = realloc(jf->saved, (size_t)nalloc * sizeof(journal_range));
+    if (saved == NULL) {
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    jf->saved = saved;
+    jf->nalloc = nalloc;
+  }
+
+  char* path = journal_file_path(frame->urlpath, frame->sframe, jf->id);
+  void* fp = path == NULL ? NULL : blosc2_stdio_open(path, "rb", NULL);
+  free(path);
+  if (fp == NULL) {
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+  // Whatever is past the end now was truncated by the transaction, which
+  // saved it then
+  int64_t size = blosc2_stdio_size(fp);
+  if (stop > size) {
+    stop = size;
+  }
+  if (start >= stop) {
+    blosc2_stdio_close(fp);
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  int64_t len = stop - start;
+  uint8_t* record = malloc((size_t)(JOURNAL_RECORD_LEN + len));
+  if (record == NULL) {
+    blosc2_stdio_close(fp);
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  void* payload = record + JOURNAL_RECORD_LEN;
+  int64_t rbytes = blosc2_stdio_read(&payload, 1, len, start, fp);
+  blosc2_stdio_close(fp);
+  int rc = BLOSC2_ERROR_SUCCESS;
+  if (rbytes != len) {
+    BLOSC_TRACE_ERROR("Cannot read the bytes to journal.");
+    rc = BLOSC2_ERROR_FILE_READ;
+  }
+  else {
+    rc = journal_append(state, JOURNAL_RANGE, jf->id, start, len, record);
+  }
+  free(record);
+  if (rc < 0) {
+    return rc;
+  }
+  jf->saved[jf->nsaved].start = start;
+  jf->saved[jf->nsaved].stop = stop;
+  jf->nsaved++;
+  *appended = true;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Open and lock the journal, and roll back whatever a crashed writer left
+   behind in it (the transaction would mix with ours otherwise) */
+static int journal_begin(blosc2_frame_s* frame, journal_state* state) {
+  if (state->fd == -1) {
+    char* path = journal_path(frame->urlpath, frame->sframe);
+    if (path == NULL) {
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    state->fd = journal_os_open(path);
+    if (state->fd == -1) {
+      BLOSC_TRACE_ERROR("Cannot open the journal in: %s", path);
+      free(path);
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    free(path);
+  }
+  if (!journal_os_lock(state->fd, true)) {
+    BLOSC_TRACE_ERROR("Cannot lock the journal.");
+    return BLOSC2_ERROR_LOCK;
+  }
+  int rc = BLOSC2_ERROR_SUCCESS;
+  if (journal_os_size(state->fd) != 0) {
+    BLOSC_TRACE_WARNING("Rolling back an interrupted update of: %s", frame->urlpath);
+    rc = journal_rollback(state->fd, frame->urlpath, frame->sframe);
+  }
+  if (rc == BLOSC2_ERROR_SUCCESS &&
+      journal_os_pwrite(state->fd, (const uint8_t*)JOURNAL_MAGIC, JOURNAL_MAGIC_LEN, 0) < 0) {
+    rc = BLOSC2_ERROR_FILE_WRITE;
+  }
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot start a transaction in the journal.");
+    journal_os_unlock(state->fd);
+    return rc;
+  }
+  state->len = JOURNAL_MAGIC_LEN;
+  state->active = true;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* The limit of the frame file is its committed length, as the appends
+   deferred since live past it; the header fields are read from the file for
+   that, and give the header and the offsets/trailer ranges too. */
+static void journal_frame_ranges(blosc2_frame_s* frame, const char* path, int64_t* limit,
+                                 int64_t* header_len, int64_t* tail_start) {
+  *header_len = 0;
+  *tail_start = *limit;
+  void* fp = blosc2_stdio_open(path, "rb", NULL);
+  if (fp == NULL) {
+    return;
+  }
+  uint8_t header[FRAME_CBYTES + sizeof(int64_t)];
+  void* header_ptr = header;
+  int64_t rbytes = blosc2_stdio_read(&header_ptr, 1, sizeof(header), frame->file_offset, fp);
+  blosc2_stdio_close(fp);
+  if (rbytes != (int64_t)sizeof(header)) {
+    return;
+  }
+  int32_t hlen;
+  int64_t frame_len;
+  int64_t cbytes;
+  from_big(&hlen, header + FRAME_HEADER_LEN, sizeof(hlen));
+  from_big(&frame_len, header + FRAME_LEN, sizeof(frame_len));
+  from_big(&cbytes, header + FRAME_CBYTES, sizeof(cbytes));
+  if (hlen <= 0 || cbytes < 0 || frame_len < hlen + cbytes ||
+      frame_len > *limit - frame->file_offset) {
+    // Not a frame we can make sense of: keep it all
+    return;
+  }
+  *limit = frame->file_offset + frame_len;
+  *header_len = hlen;
+  *tail_start = frame->file_offset + hlen + cbytes;
+}
+
+
+int journal_save(blosc2_frame_s* frame, int64_t file, int64_t pos, int64_t len) {
+  if (!frame->journal || len <= 0) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  journal_state* state = journal_get_state(frame);
+  if (state == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int64_t stop = len > INT64_MAX - pos ? INT64_MAX : pos + len;
+
+  journal_file* jf = NULL;
+  for (int64_t i = 0; i < state->nfiles; i++) {
+    if (state->files[i].id == file) {
+      jf = &state->files[i];
+      break;
+    }
+  }
+  bool appended = false;
+  int rc;
+  if (jf == NULL) {
+    // First time the transaction touches the file
+    char* path = journal_file_path(frame->urlpath, frame->sframe, file);
+    if (path == NULL) {
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    int64_t size = journal_file_size(path);
+    int64_t limit = size;
+    int64_t header_len = 0;
+    int64_t tail_start = size;
+    if (file == JOURNAL_MAIN_FILE && !frame->sframe && size > 0) {
+      journal_frame_ranges(frame, path, &limit, &header_len, &tail_start);
+    }
+    free(path);
+    if (!state->active && pos >= limit) {
+      // Nothing committed is touched (e.g. deferred appends)
+      return BLOSC2_ERROR_SUCCESS;
+    }
+    if (!state->active) {
+      rc = journal_begin(frame, state);
+      if (rc < 0) {
+        return rc;
+      }
+    }
+    if (state->nfiles == state->nalloc) {
+      int64_t nalloc = state->nalloc == 0 ? 4 : 2 * state->nalloc;
+      journal_file* files = realloc(state->files, (size_t)nalloc * sizeof(journal_file));
+      if (files == NULL) {
+        return BLOSC2_ERROR_MEMORY_ALLOC;
+      }
+      state->files = files;
+      state->nalloc = nalloc;
+    }
+    jf = &state->files[state->nfiles++];
+    memset(jf, 0, sizeof(journal_file));
+    jf->id = file;
+    jf->size = size;
+    jf->limit = limit;
+    uint8_t record[JOURNAL_RECORD_LEN];
+    rc = journal_append(state, JOURNAL_FILE, file, size, 0, record);
+    if (rc < 0) {
+      return rc;
+    }
+    // A new file has nothing to lose; this record alone need not be synced
+    if (file == JOURNAL_MAIN_FILE) {
+      // The header, offsets and trailer are rewritten by most mutations:
+      // saving them upfront makes for a single sync of the journal per operation
+      if (header_len > 0) {
+        rc = journal_save_range(frame, state, jf, frame->file_offset, frame->file_offset + header_len,
+                                &appended);
+        if (rc == BLOSC2_ERROR_SUCCESS) {
+          rc = journal_save_range(frame, state, jf, tail_start, limit, &appended);
+        }
+      }
+      else {
+        rc = journal_save_range(frame, state, jf, 0, limit, &appended);
+      }
+      if (rc < 0) {
+        return rc;
+      }
+    }
+  }
+
+  rc = journal_save_range(frame, state, jf, pos, stop, &appended);
+  if (rc < 0) {
+    return rc;
+  }
+  // The pre-images have to be durable before the bytes are overwritten
+  if (appended && journal_os_sync(state->fd) < 0) {
+    BLOSC_TRACE_ERROR("Cannot sync the journal.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+int journal_commit(blosc2_frame_s* frame) {
+  journal_state* state = frame->journal_state;
+  if (state == NULL || !state->active) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  // Everything the transaction wrote has to be durable before the journal goes
+  int rc = frame_sync_files(frame, frame->dirty_ids, frame->ndirty);
+  if (rc < 0) {
+    // Left running: the next commit tries again
+    BLOSC_TRACE_ERROR("Cannot sync the frame to commit the journal.");
+    return rc;
+  }
+  frame->ndirty = 0;
+  if (journal_os_clear(state->fd) < 0) {
+    BLOSC_TRACE_ERROR("Cannot clear the journal.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  journal_os_unlock(state->fd);
+  for (int64_t i = 0; i < state->nfiles; i++) {
+    free(state->files[i].saved);
+  }
+  state->nfiles = 0;
+  state->len = 0;
+  state->active = false;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+void journal_free(blosc2_frame_s* frame) {
+  journal_state* state = frame->journal_state;
+  if (state == NULL) {
+    return;
+  }
+  if (state->active) {
+    // A transaction left open by an error path; better commit what is there
+    // than to roll back behind the back of the next user of the frame
+    journal_commit(frame);
+  }
+  if (state->active) {
+    journal_os_unlock(state->fd);
+    for (int64_t i = 0; i < state->nfiles; i++) {
+      free(state->files[i].saved);
+    }
+  }
+  if (state->fd != -1) {
+    journal_os_close(state->fd);
+  }
+  free(state->files);
+  free(state);
+  frame->journal_state = NULL;
+}
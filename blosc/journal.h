@@ -0,0 +1,70 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  An undo journal for the in-place updates of on-disk frames.
+
+  Before a mutation overwrites, truncates or removes bytes of a frame
+  (its header, offsets index and trailer, or the chunk files of a
+  sparse frame), the bytes are copied to a sidecar file (.b2journal,
+  next to the .b2lock one) and the copy is made durable.  Once the
+  outermost mutation is done, the frame files are synced and the
+  journal is emptied, which is the commit point.
+
+  A journal that is not empty when the frame is opened again is the
+  trace of an interrupted mutation, and journal_recover() rolls it
+  back, so the frame is found as it was before the mutation started.
+
+  Journaling is opt-in (see blosc2_schunk_set_journal()), and only for
+  the default filesystem backends.
+**********************************************************************/
+
+#ifndef BLOSC_JOURNAL_H
+#define BLOSC_JOURNAL_H
+
+#include "frame.h"
+#include "blosc2.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The id of the frame file (or the index file of a sparse frame) in the
+ * journal; the chunk files of a sparse frame go by their own ids. */
+#define JOURNAL_MAIN_FILE (-1)
+
+/* Whether journaling is requested for frames using io, via the BLOSC_JOURNAL
+ * environment variable. */
+bool journal_requested(const blosc2_io* io);
+
+/* Enable journaling on a disk-based frame if io requests it. */
+void journal_enable(blosc2_frame_s* frame, const blosc2_io* io);
+
+/* Enable or disable journaling on a disk-based frame (disabling it commits
+ * the running transaction). */
+int journal_set(blosc2_frame_s* frame, bool journal);
+
+/* Log the bytes [pos, pos + len) of file (JOURNAL_MAIN_FILE or a chunk id)
+ * before they are overwritten; a len of INT64_MAX stands for the rest of
+ * the file (truncations and removals).  Starts a transaction when there is
+ * none.  A no-op when journaling is off. */
+int journal_save(blosc2_frame_s* frame, int64_t file, int64_t pos, int64_t len);
+
+/* Sync the frame files and empty the journal, ending the transaction.
+ * A no-op when there is none. */
+int journal_commit(blosc2_frame_s* frame);
+
+/* Release the journal state of frame (the transaction must be committed). */
+void journal_free(blosc2_frame_s* frame);
+
+/* Roll back the interrupted transaction of the frame in urlpath, if any.
+ * A transaction still running (in another process) is left alone. */
+int journal_recover(const char* urlpath, const blosc2_io* io);
+
+#endif /* BLOSC_JOURNAL_H */
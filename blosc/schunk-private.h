@@ -37,4 +37,30 @@
  * detected, a negative code is returned instead.
  */
 int64_t schunk_get_slice_nchunks(blosc2_schunk *schunk, int64_t start, int64_t stop, int64_t **chunks_idx);
+
+/**
+ * @brief Get a decompressed chunk from the cache of the super-chunk,
+ * decompressing it there first if needed.
+ *
+ * @param schunk The super-chunk.
+ * @param nchunk The chunk to get.
+ * @param data The pointer where the address of the decompressed chunk will be
+ * stored.  It belongs to the cache and is only valid until the next operation
+ * on the super-chunk.
+ *
+ * @return The size of the decompressed chunk, or 0 if the super-chunk has no
+ * cache or the chunk does not fit in it.  If some problem is detected, a
+ * negative code is returned instead.
+ */
+int32_t schunk_get_cached_chunk(blosc2_schunk *schunk, int64_t nchunk, uint8_t **data);
+
+/**
+ * @brief The variable-length metalayer API, reserved variable-length metalayers
+ * (like the dictionary of the super-chunk) included.  See blosc2_vlmeta_exists(),
+ * blosc2_vlmeta_add() and blosc2_vlmeta_get().
+ */
+int schunk_vlmeta_exists(blosc2_schunk *schunk, const char *name);
+int schunk_vlmeta_add(blosc2_schunk *schunk, const char *name, uint8_t *content, int32_t content_len,
+                      blosc2_cparams *cparams);
+int schunk_vlmeta_get(blosc2_schunk *schunk, const char *name, uint8_t **content, int32_t *content_len);
 #endif /* BLOSC_SCHUNK_PRIVATE_H */
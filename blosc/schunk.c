@@ -9,6 +9,8 @@
 **********************************************************************/
 
 #include "frame.h"
+#include "journal.h"
+#include "schunk-private.h"
 #include "stune.h"
 #include "blosc-private.h"
 #include "context.h"
@@ -38,6 +40,28 @@
   #include <stdalign.h>
 #endif
 
+/* The cache of decompressed chunks: a handful of entries (the memory budget
+   divided by the chunksize), so a linear scan on the chunk number and a use
+   clock for the LRU eviction are enough. */
+typedef struct {
+  int64_t nchunk;
+  int32_t nbytes;
+  uint64_t last_use;
+  uint8_t *data;
+} chunk_cache_entry;
+
+struct blosc2_chunk_cache_s {
+  int64_t maxbytes;
+  int64_t nbytes;
+  chunk_cache_entry *entries;
+  int nentries;
+  int maxentries;
+  uint64_t clock;
+  int64_t nhits;
+  int64_t nmisses;
+};
+
+
 static int schunk_get_chunk_flags2(blosc2_schunk *schunk, int64_t nchunk, uint8_t *chunk_flags2);
 
 
@@ -86,6 +110,7 @@ int blosc2_schunk_get_cparams(blosc2_schunk *schunk, blosc2_cparams **cparams) {
   }
   else {
     (*cparams)->nthreads = (int16_t)schunk->cctx->nthreads;
+    (*cparams)->dict_nchunks = schunk->cctx->dict_nchunks;
   }
   return 0;
 }
@@ -101,6 +126,9 @@ int blosc2_schunk_get_dparams(blosc2_schunk *schunk, blosc2_dparams **dparams) {
   else {
     (*dparams)->nthreads = schunk->dctx->nthreads;
   }
+  if (schunk->cache != NULL) {
+    (*dparams)->cache_nbytes = schunk->cache->maxbytes;
+  }
   return 0;
 }
 
@@ -149,7 +177,7 @@ int update_schunk_properties(struct blosc2_schunk* schunk) {
     return BLOSC2_ERROR_NULL_POINTER;
   }
 
-  return BLOSC2_ERROR_SUCCESS;
+  return blosc2_schunk_set_cache(schunk, dparams->cache_nbytes);
 }
 
 
@@ -203,6 +231,7 @@ blosc2_schunk* blosc2_schunk_new(blosc2_storage *storage) {
       return NULL;
     }
     frame->sframe = true;
+    frame->packed = storage->packed;
     frame_set_locking(frame, schunk->storage->io);
     // Initialize frame (basically, encode the header)
     frame->schunk = schunk;
@@ -211,7 +240,13 @@ blosc2_schunk* blosc2_schunk_new(blosc2_storage *storage) {
       BLOSC_TRACE_ERROR("Error during the conversion of schunk to frame.");
       return NULL;
     }
+    // A new frame has nothing to roll back to, so it is journaled from here on
+    journal_enable(frame, schunk->storage->io);
     schunk->frame = (blosc2_frame*)frame;
+    if (frame_set_durability(frame, storage->durability, storage->durability_every) < 0) {
+      BLOSC_TRACE_ERROR("Error setting the durability policy of the frame.");
+      return NULL;
+    }
   }
   if (storage->contiguous){
     // We want a contiguous frame as storage
@@ -235,7 +270,14 @@ blosc2_schunk* blosc2_schunk_new(blosc2_storage *storage) {
       BLOSC_TRACE_ERROR("Error during the conversion of schunk to frame.");
       return NULL;
     }
+    // A new frame has nothing to roll back to, so it is journaled from here on
+    journal_enable(frame, schunk->storage->io);
     schunk->frame = (blosc2_frame*)frame;
+    if (storage->urlpath != NULL &&
+        frame_set_durability(frame, storage->durability, storage->durability_every) < 0) {
+      BLOSC_TRACE_ERROR("Error setting the durability policy of the frame.");
+      return NULL;
+    }
   }
 
   return schunk;
@@ -260,6 +302,7 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
     cparams.compcode_meta = schunk->cctx->compcode_meta;
     cparams.splitmode = schunk->cctx->splitmode;
     cparams.use_dict = schunk->cctx->use_dict;
+    cparams.dict_nchunks = schunk->cctx->dict_nchunks;
     cparams.blocksize = schunk->cctx->blocksize;
     memcpy(cparams.filters, schunk->cctx->filters, BLOSC2_MAX_FILTERS);
     memcpy(cparams.filters_meta, schunk->cctx->filters_meta, BLOSC2_MAX_FILTERS);
@@ -315,6 +358,21 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
   bool uses_vlblocks = (schunk->flags2 & BLOSC2_VL_BLOCKS) != 0;
 
   if (cparams_equal || uses_vlblocks) {
+    // The chunks may use the dict of schunk, so the new one needs it first
+    if (schunk_vlmeta_exists(schunk, BLOSC2_DICT_VLMETA) >= 0) {
+      uint8_t *dict;
+      int32_t dict_size;
+      if (schunk_vlmeta_get(schunk, BLOSC2_DICT_VLMETA, &dict, &dict_size) < 0) {
+        BLOSC_TRACE_ERROR("Can not get the dictionary of the super-chunk.");
+        return NULL;
+      }
+      int rc = schunk_vlmeta_add(new_schunk, BLOSC2_DICT_VLMETA, dict, dict_size, NULL);
+      free(dict);
+      if (rc < 0) {
+        BLOSC_TRACE_ERROR("Can not add the dictionary of the super-chunk.");
+        return NULL;
+      }
+    }
     for (int nchunk = 0; nchunk < schunk->nchunks; ++nchunk) {
       uint8_t *chunk;
       bool needs_free;
@@ -350,13 +408,17 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
     uint8_t *content = NULL;
     int32_t content_len;
     char* name = schunk->vlmetalayers[nmeta]->name;
-    if (blosc2_vlmeta_get(schunk, name, &content, &content_len) < 0) {
+    if (strcmp(name, BLOSC2_DICT_VLMETA) == 0 && schunk_vlmeta_exists(new_schunk, name) >= 0) {
+      // Already copied along with the chunks, or the recompressed chunks have a dictionary of their own
+      continue;
+    }
+    if (schunk_vlmeta_get(schunk, name, &content, &content_len) < 0) {
       // Passing the (previously uninitialized) content pointer forward ended
       // in a bogus free that aborted the process; bail out instead.
       BLOSC_TRACE_ERROR("Can not get %s `vlmetalayer`.", name);
       return NULL;
     }
-    if (blosc2_vlmeta_add(new_schunk, name, content, content_len, NULL) < 0) {
+    if (schunk_vlmeta_add(new_schunk, name, content, content_len, NULL) < 0) {
       BLOSC_TRACE_ERROR("Can not add %s `vlmetalayer`.", name);
       free(content);
       return NULL;
@@ -408,6 +470,11 @@ blosc2_schunk* blosc2_schunk_open_offset_udio(const char* urlpath, int64_t offse
     return NULL;
   }
 
+  // Roll back an update interrupted by a crash before reading anything
+  if (journal_recover(urlpath, udio) < 0) {
+    return NULL;
+  }
+
   bool retry_on_race = frame_locking_requested(udio);
   const int max_attempts = retry_on_race ? 50 : 1;
   blosc2_frame_s* frame = frame_from_file_offset_retrying(urlpath, udio, offset, max_attempts);
@@ -466,6 +533,7 @@ blosc2_schunk* blosc2_schunk_open_offset_udio(const char* urlpath, int64_t offse
   schunk->storage->urlpath = malloc(pathlen + 1);
   strcpy(schunk->storage->urlpath, urlpath);
   schunk->storage->contiguous = !frame->sframe;
+  schunk->storage->packed = frame->packed;
 
   return schunk;
 }
@@ -679,6 +747,19 @@ void schunk_free_vlmetalayers(blosc2_schunk *schunk) {
 int blosc2_schunk_free(blosc2_schunk *schunk) {
   int err = 0;
 
+  // Commit the appends deferred by blosc2_schunk_set_append_batch(), if any,
+  // and make the frame durable as its policy asks
+  if (schunk->frame != NULL && !schunk->view) {
+    if (frame_set_durability((blosc2_frame_s *) schunk->frame, BLOSC2_DURABILITY_NONE, 0) < 0) {
+      BLOSC_TRACE_ERROR("Could not sync the frame.");
+      err = 1;
+    }
+    if (frame_flush_appends((blosc2_frame_s *) schunk->frame) < 0) {
+      BLOSC_TRACE_ERROR("Could not commit the pending appends to the frame.");
+      err = 1;
+    }
+  }
+
   // If it is a view, the data belongs to original array and should not be freed
   if (schunk->data != NULL && !schunk->view) {
     for (int i = 0; i < schunk->nchunks; i++) {
@@ -692,6 +773,7 @@ int blosc2_schunk_free(blosc2_schunk *schunk) {
     blosc2_free_ctx(schunk->dctx);
   if (schunk->blockshape != NULL)
     free(schunk->blockshape);
+  blosc2_schunk_set_cache(schunk, 0);
 
   schunk_free_metalayers(schunk);
 
@@ -763,14 +845,14 @@ void blosc2_schunk_avoid_cframe_free(blosc2_schunk *schunk, bool avoid_cframe_fr
    between blosc2_schunk_lock() and blosc2_schunk_unlock() nest on the
    already-held lock (via the frame's lock depth counter) instead of
    re-acquiring it, so the whole bracket is atomic against other handles.
-   No-ops (success) when locking is not enabled on the handle. */
+   Without locking, it still keeps out the mutations from other threads. */
 int blosc2_schunk_lock(blosc2_schunk *schunk) {
-  return frame_lock((blosc2_frame_s*)schunk->frame, true);
+  return frame_write_lock((blosc2_frame_s*)schunk->frame);
 }
 
 
 int blosc2_schunk_unlock(blosc2_schunk *schunk) {
-  return frame_unlock((blosc2_frame_s*)schunk->frame);
+  return frame_write_unlock((blosc2_frame_s*)schunk->frame);
 }
 
 
@@ -788,6 +870,238 @@ int blosc2_schunk_refresh(blosc2_schunk *schunk) {
 }
 
 
+static void cache_drop_entry(blosc2_chunk_cache *cache, int i) {
+  cache->nbytes -= cache->entries[i].nbytes;
+  free(cache->entries[i].data);
+  cache->entries[i] = cache->entries[--cache->nentries];
+}
+
+
+void schunk_clear_cache(blosc2_schunk *schunk) {
+  blosc2_chunk_cache *cache = schunk->cache;
+  if (cache == NULL) {
+    return;
+  }
+  while (cache->nentries > 0) {
+    cache_drop_entry(cache, cache->nentries - 1);
+  }
+}
+
+
+static void schunk_drop_cached_chunk(blosc2_schunk *schunk, int64_t nchunk) {
+  blosc2_chunk_cache *cache = schunk->cache;
+  if (cache == NULL) {
+    return;
+  }
+  for (int i = 0; i < cache->nentries; i++) {
+    if (cache->entries[i].nchunk == nchunk) {
+      cache_drop_entry(cache, i);
+      return;
+    }
+  }
+}
+
+
+/* Get a decompressed chunk from the cache, decompressing it there if needed.
+   The returned buffer belongs to the cache and is valid until the next
+   operation on the super-chunk.  Returns its size, or 0 when there is no
+   cache or the chunk cannot go in it (the caller falls back to decompressing
+   on its own), or a negative error code. */
+int32_t schunk_get_cached_chunk(blosc2_schunk *schunk, int64_t nchunk, uint8_t **data) {
+  blosc2_chunk_cache *cache = schunk->cache;
+  // A pending maskout would leave holes in the cached chunk
+  if (cache == NULL || schunk->dctx->block_maskout != NULL) {
+    return 0;
+  }
+  // Drop the cache if another handle changed the frame
+  int rc = frame_check_stale((blosc2_frame_s *) schunk->frame);
+  if (rc < 0) {
+    return rc;
+  }
+
+  for (int i = 0; i < cache->nentries; i++) {
+    if (cache->entries[i].nchunk == nchunk) {
+      cache->nhits++;
+      cache->entries[i].last_use = ++cache->clock;
+      *data = cache->entries[i].data;
+      return cache->entries[i].nbytes;
+    }
+  }
+
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_lazychunk(schunk, nchunk, &chunk, &needs_free);
+  if (cbytes < 0) {
+    return cbytes;
+  }
+  int32_t nbytes = 0;
+  if (cbytes > 0) {
+    rc = blosc2_cbuffer_sizes(chunk, &nbytes, NULL, NULL);
+    if (rc < 0) {
+      if (needs_free) {
+        free(chunk);
+      }
+      return rc;
+    }
+  }
+  if (nbytes <= 0 || nbytes > cache->maxbytes) {
+    if (needs_free) {
+      free(chunk);
+    }
+    return 0;
+  }
+  cache->nmisses++;
+
+  while (cache->nentries > 0 && cache->nbytes + nbytes > cache->maxbytes) {
+    int lru = 0;
+    for (int i = 1; i < cache->nentries; i++) {
+      if (cache->entries[i].last_use < cache->entries[lru].last_use) {
+        lru = i;
+      }
+    }
+    cache_drop_entry(cache, lru);
+  }
+  if (cache->nentries == cache->maxentries) {
+    int maxentries = cache->maxentries == 0 ? 8 : 2 * cache->maxentries;
+    chunk_cache_entry *entries = realloc(cache->entries, maxentries * sizeof(chunk_cache_entry));
+    if (entries == NULL) {
+      if (needs_free) {
+        free(chunk);
+      }
+      BLOSC_TRACE_ERROR("Error allocating memory for the chunk cache.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    cache->entries = entries;
+    cache->maxentries = maxentries;
+  }
+  uint8_t *buffer = malloc(nbytes);
+  if (buffer == NULL) {
+    if (needs_free) {
+      free(chunk);
+    }
+    BLOSC_TRACE_ERROR("Error allocating memory for the chunk cache.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int dsize = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, buffer, nbytes);
+  if (needs_free) {
+    free(chunk);
+  }
+  if (dsize != nbytes) {
+    free(buffer);
+    BLOSC_TRACE_ERROR("Error decompressing chunk %" PRId64 " into the cache.", nchunk);
+    return dsize < 0 ? dsize : BLOSC2_ERROR_FAILURE;
+  }
+
+  chunk_cache_entry *entry = &cache->entries[cache->nentries++];
+  entry->nchunk = nchunk;
+  entry->nbytes = nbytes;
+  entry->last_use = ++cache->clock;
+  entry->data = buffer;
+  cache->nbytes += nbytes;
+  *data = buffer;
+  return nbytes;
+}
+
+
+int blosc2_schunk_set_cache(blosc2_schunk *schunk, int64_t nbytes) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  if (nbytes < 0) {
+    BLOSC_TRACE_ERROR("The size of the chunk cache cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (schunk->cache != NULL) {
+    schunk_clear_cache(schunk);
+    free(schunk->cache->entries);
+    free(schunk->cache);
+    schunk->cache = NULL;
+  }
+  if (nbytes > 0) {
+    schunk->cache = calloc(1, sizeof(blosc2_chunk_cache));
+    BLOSC_ERROR_NULL(schunk->cache, BLOSC2_ERROR_MEMORY_ALLOC);
+    schunk->cache->maxbytes = nbytes;
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+int blosc2_schunk_get_cache_stats(blosc2_schunk *schunk, int64_t *nhits, int64_t *nmisses) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  if (schunk->cache == NULL) {
+    BLOSC_TRACE_ERROR("The super-chunk has no chunk cache.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (nhits != NULL) {
+    *nhits = schunk->cache->nhits;
+  }
+  if (nmisses != NULL) {
+    *nmisses = schunk->cache->nmisses;
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Defer the offsets index, header and trailer updates of appends to a
+   disk-based frame; see blosc2.h for the crash-safety guarantees. */
+int blosc2_schunk_set_append_batch(blosc2_schunk *schunk, int64_t nappends) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  if (schunk->frame == NULL) {
+    BLOSC_TRACE_ERROR("Deferred appends are only supported on disk-based frames.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return frame_set_append_batch((blosc2_frame_s *) schunk->frame, nappends);
+}
+
+
+/* Commit the appends deferred by blosc2_schunk_set_append_batch(). */
+int blosc2_schunk_flush(blosc2_schunk *schunk) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  blosc2_frame_s *frame = (blosc2_frame_s *) schunk->frame;
+  if (frame == NULL) {
+    return 0;
+  }
+  if (frame->durability != BLOSC2_DURABILITY_NONE) {
+    // Commits the appends too
+    return frame_sync(frame);
+  }
+  return frame_flush_appends(frame);
+}
+
+
+/* Set when the writes to a disk-based frame are made durable. */
+int blosc2_schunk_set_durability(blosc2_schunk *schunk, uint8_t policy, int64_t every) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  int rc = frame_set_durability((blosc2_frame_s *) schunk->frame, policy, every);
+  if (rc < 0) {
+    return rc;
+  }
+  schunk->storage->durability = policy;
+  schunk->storage->durability_every = every;
+  return 0;
+}
+
+
+int blosc2_schunk_set_journal(blosc2_schunk *schunk, bool journal) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  if (schunk->frame == NULL) {
+    BLOSC_TRACE_ERROR("The journal is only supported on disk-based frames.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return journal_set((blosc2_frame_s *) schunk->frame, journal);
+}
+
+
 /* Fill an empty frame with special values (fast path). */
 int64_t blosc2_schunk_fill_special(blosc2_schunk* schunk, int64_t nitems, int special_value,
                                int32_t chunksize) {
@@ -892,7 +1206,7 @@ int64_t blosc2_schunk_fill_special(blosc2_schunk* schunk, int64_t nitems, int sp
     schunk->chunksize = chunksize;
     schunk->nchunks = nchunks;
     schunk->nbytes = nitems * typesize;
-    int rc = frame_lock(frame, true);
+    int rc = frame_write_lock(frame);
     if (rc < 0) {
       schunk->chunksize = old_chunksize;
       schunk->nchunks = old_nchunks;
@@ -900,7 +1214,7 @@ int64_t blosc2_schunk_fill_special(blosc2_schunk* schunk, int64_t nitems, int sp
       return rc;
     }
     int64_t frame_len = frame_fill_special(frame, nitems, special_value, chunksize, schunk);
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     if (frame_len < 0) {
       schunk->chunksize = old_chunksize;
       schunk->nchunks = old_nchunks;
@@ -984,6 +1298,13 @@ static int64_t schunk_append_chunk_unlocked(blosc2_schunk *schunk, uint8_t *chun
   }
   uint8_t flags2 = get_chunk_flags2(chunk, chunk_cbytes);
   bool chunk_vlblocks = (flags2 & BLOSC2_VL_BLOCKS) != 0;
+  if (flags2 & BLOSC2_SCHUNK_DICT) {
+    // A chunk using the dict of another super-chunk could not be decompressed here
+    rc = check_schunk_dict_chunk(schunk->dctx, chunk, chunk_cbytes);
+    if (rc < 0) {
+      return rc;
+    }
+  }
   if (nchunks > 0) {
     uint8_t first_flags2;
     rc = schunk_get_chunk_flags2(schunk, 0, &first_flags2);
@@ -1078,7 +1399,7 @@ static int64_t schunk_append_chunk_unlocked(blosc2_schunk *schunk, uint8_t *chun
 /* Append an existing @p chunk to a super-chunk. */
 int64_t blosc2_schunk_append_chunk(blosc2_schunk *schunk, uint8_t *chunk, bool copy) {
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
-  int rc = frame_lock(frame, true);
+  int rc = frame_write_lock(frame);
   if (rc < 0) {
     return rc;
   }
@@ -1087,11 +1408,11 @@ int64_t blosc2_schunk_append_chunk(blosc2_schunk *schunk, uint8_t *chunk, bool c
   // wrong nbytes/cbytes/nchunks (see plans/todo-locking-swmr.md item 1).
   rc = frame_check_stale(frame);
   if (rc < 0) {
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
   int64_t nchunks = schunk_append_chunk_unlocked(schunk, chunk, copy);
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   return nchunks;
 }
 
@@ -1102,6 +1423,8 @@ static int64_t schunk_insert_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
   if (rc < 0) {
     return rc;
   }
+  // Chunks after the insertion point are renumbered
+  schunk_clear_cache(schunk);
 
   int32_t chunk_nbytes;
   int32_t chunk_cbytes;
@@ -1113,6 +1436,13 @@ static int64_t schunk_insert_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
   }
   uint8_t flags2 = get_chunk_flags2(chunk, chunk_cbytes);
   bool chunk_vlblocks = (flags2 & BLOSC2_VL_BLOCKS) != 0;
+  if (flags2 & BLOSC2_SCHUNK_DICT) {
+    // A chunk using the dict of another super-chunk could not be decompressed here
+    rc = check_schunk_dict_chunk(schunk->dctx, chunk, chunk_cbytes);
+    if (rc < 0) {
+      return rc;
+    }
+  }
   if (nchunks > 0) {
     uint8_t first_flags2;
     rc = schunk_get_chunk_flags2(schunk, 0, &first_flags2);
@@ -1215,7 +1545,7 @@ static int64_t schunk_insert_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
 /* Insert an existing @p chunk in a specified position on a super-chunk. */
 int64_t blosc2_schunk_insert_chunk(blosc2_schunk *schunk, int64_t nchunk, uint8_t *chunk, bool copy) {
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
-  int rc = frame_lock(frame, true);
+  int rc = frame_write_lock(frame);
   if (rc < 0) {
     return rc;
   }
@@ -1223,11 +1553,11 @@ int64_t blosc2_schunk_insert_chunk(blosc2_schunk *schunk, int64_t nchunk, uint8_
   // counter deltas below are applied.
   rc = frame_check_stale(frame);
   if (rc < 0) {
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
   int64_t nchunks = schunk_insert_chunk_unlocked(schunk, nchunk, chunk, copy);
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   return nchunks;
 }
 
@@ -1237,6 +1567,7 @@ static int64_t schunk_update_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
   if (rc < 0) {
     return rc;
   }
+  schunk_drop_cached_chunk(schunk, nchunk);
 
   int32_t chunk_nbytes;
   int32_t chunk_cbytes;
@@ -1247,6 +1578,13 @@ static int64_t schunk_update_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
   }
   uint8_t flags2 = get_chunk_flags2(chunk, chunk_cbytes);
   bool chunk_vlblocks = (flags2 & BLOSC2_VL_BLOCKS) != 0;
+  if (flags2 & BLOSC2_SCHUNK_DICT) {
+    // A chunk using the dict of another super-chunk could not be decompressed here
+    rc = check_schunk_dict_chunk(schunk->dctx, chunk, chunk_cbytes);
+    if (rc < 0) {
+      return rc;
+    }
+  }
   if (schunk->nchunks > 1 || (schunk->nchunks == 1 && nchunk != 0)) {
     int64_t ref_nchunk = (nchunk == 0) ? 1 : 0;
     uint8_t ref_flags2;
@@ -1362,12 +1700,12 @@ static int64_t schunk_update_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
 /* Update the chunk at a specified position of a super-chunk. */
 int64_t blosc2_schunk_update_chunk(blosc2_schunk *schunk, int64_t nchunk, uint8_t *chunk, bool copy) {
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
-  int rc = frame_lock(frame, true);
+  int rc = frame_write_lock(frame);
   if (rc < 0) {
     return rc;
   }
   int64_t nchunks = schunk_update_chunk_unlocked(schunk, nchunk, chunk, copy);
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   return nchunks;
 }
 
@@ -1377,6 +1715,8 @@ static int64_t schunk_delete_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
   if (rc < 0) {
     return rc;
   }
+  // Chunks after the deleted one are renumbered
+  schunk_clear_cache(schunk);
 
   bool needs_free;
   uint8_t *chunk_old;
@@ -1445,12 +1785,12 @@ static int64_t schunk_delete_chunk_unlocked(blosc2_schunk *schunk, int64_t nchun
 /* Delete the chunk at a specified position of a super-chunk. */
 int64_t blosc2_schunk_delete_chunk(blosc2_schunk *schunk, int64_t nchunk) {
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
-  int rc = frame_lock(frame, true);
+  int rc = frame_write_lock(frame);
   if (rc < 0) {
     return rc;
   }
   int64_t nchunks = schunk_delete_chunk_unlocked(schunk, nchunk);
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   return nchunks;
 }
 
@@ -1470,6 +1810,7 @@ int64_t blosc2_schunk_append_buffer(blosc2_schunk *schunk, const void *src, int3
   int64_t nchunks = blosc2_schunk_append_chunk(schunk, chunk, false);
   if (nchunks < 0) {
     BLOSC_TRACE_ERROR("Error appending a buffer in super-chunk");
+    free(chunk);
     return nchunks;
   }
 
@@ -1477,6 +1818,183 @@ int64_t blosc2_schunk_append_buffer(blosc2_schunk *schunk, const void *src, int3
 }
 
 
+/* Shared state of the workers of blosc2_schunk_append_buffers() */
+typedef struct {
+  const void **srcs;
+  const int32_t *nbytes;
+  uint8_t **chunks;
+  int64_t nbuffers;
+  int64_t next_buffer;
+  int error;
+  blosc2_pthread_mutex_t mutex;
+} append_work;
+
+typedef struct {
+  append_work *work;
+  blosc2_context *cctx;
+} append_worker;
+
+static void append_worker_func(void *arg) {
+  append_worker *worker = (append_worker *)arg;
+  append_work *work = worker->work;
+
+  while (true) {
+    blosc2_pthread_mutex_lock(&work->mutex);
+    int64_t i = work->error < 0 ? work->nbuffers : work->next_buffer++;
+    blosc2_pthread_mutex_unlock(&work->mutex);
+    if (i >= work->nbuffers) {
+      return;
+    }
+    int32_t nbytes = work->nbytes[i];
+    uint8_t *chunk = malloc((size_t)nbytes + BLOSC2_MAX_OVERHEAD);
+    int cbytes = BLOSC2_ERROR_MEMORY_ALLOC;
+    if (chunk != NULL) {
+      cbytes = blosc2_compress_ctx(worker->cctx, work->srcs[i], nbytes, chunk,
+                                   nbytes + BLOSC2_MAX_OVERHEAD);
+    }
+    if (cbytes < 0) {
+      free(chunk);
+      blosc2_pthread_mutex_lock(&work->mutex);
+      if (work->error == 0) {
+        work->error = cbytes;
+      }
+      blosc2_pthread_mutex_unlock(&work->mutex);
+      return;
+    }
+    work->chunks[i] = chunk;
+  }
+}
+
+
+/* Append several data buffers to a super-chunk, compressing one chunk per thread. */
+int64_t blosc2_schunk_append_buffers(blosc2_schunk *schunk, int64_t nbuffers,
+                                     const void **srcs, const int32_t *nbytes) {
+  if (schunk == NULL || (nbuffers > 0 && (srcs == NULL || nbytes == NULL))) {
+    BLOSC_TRACE_ERROR("schunk, srcs and nbytes must not be NULL.");
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  if (nbuffers < 0) {
+    BLOSC_TRACE_ERROR("nbuffers must be non-negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  for (int64_t i = 0; i < nbuffers; i++) {
+    if (nbytes[i] < 0 || nbytes[i] > BLOSC2_MAX_BUFFERSIZE) {
+      BLOSC_TRACE_ERROR("Invalid size for buffer %" PRId64 ".", i);
+      return BLOSC2_ERROR_INVALID_PARAM;
+    }
+  }
+
+  int16_t pool_nthreads = schunk->cctx->nthreads;
+  int16_t nthreads = pool_nthreads;
+  if ((int64_t)nthreads > nbuffers) {
+    nthreads = (int16_t)nbuffers;
+  }
+  // Prefilters, tuners and the training of a dict for the super-chunk see the chunks in order,
+  // so they cannot run concurrently
+  bool dict_training = schunk->cctx->use_dict && schunk->cctx->dict_nchunks > 0 &&
+                       schunk_vlmeta_exists(schunk, BLOSC2_DICT_VLMETA) < 0;
+  if (nthreads <= 1 || schunk->cctx->prefilter != NULL || schunk->cctx->tuner_params != NULL ||
+      schunk->cctx->tuner_id != BLOSC_STUNE || dict_training) {
+    int64_t nchunks = schunk->nchunks;
+    for (int64_t i = 0; i < nbuffers; i++) {
+      nchunks = blosc2_schunk_append_buffer(schunk, srcs[i], nbytes[i]);
+      if (nchunks < 0) {
+        return nchunks;
+      }
+    }
+    return nchunks;
+  }
+
+  append_work work = {.srcs = srcs, .nbytes = nbytes, .nbuffers = nbuffers};
+  append_worker *workers = calloc((size_t)nthreads, sizeof(append_worker));
+  work.chunks = calloc((size_t)nbuffers, sizeof(uint8_t *));
+  if (workers == NULL || work.chunks == NULL) {
+    free(workers);
+    free(work.chunks);
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  blosc2_pthread_mutex_init(&work.mutex, NULL);
+
+  int64_t rc = 0;
+  blosc2_cparams cparams = *schunk->storage->cparams;
+  cparams.schunk = schunk;
+  cparams.nthreads = 1;
+  for (int16_t i = 0; i < nthreads; i++) {
+    workers[i].work = &work;
+    workers[i].cctx = blosc2_create_cctx(cparams);
+    if (workers[i].cctx == NULL) {
+      rc = BLOSC2_ERROR_NULL_POINTER;
+      goto cleanup;
+    }
+    // The threads are for the chunks here, so override a possible BLOSC_NTHREADS
+    workers[i].cctx->nthreads = 1;
+    workers[i].cctx->new_nthreads = 1;
+    // Look up the dict of the super-chunk here, not concurrently from the workers
+    if (workers[i].cctx->use_dict) {
+      rc = load_schunk_dict(workers[i].cctx);
+      if (rc < 0) {
+        goto cleanup;
+      }
+      rc = 0;
+    }
+  }
+  rc = blosc2_run_parallel(pool_nthreads, nthreads, append_worker_func, sizeof(append_worker), workers);
+  if (rc == 0) {
+    rc = work.error;
+  }
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Error compressing the buffers.");
+    goto cleanup;
+  }
+
+  // Append the chunks in order, committing the index of a disk-based frame only once when a
+  // crash cannot leave it invalid in between
+  blosc2_frame_s *frame = (blosc2_frame_s *)schunk->frame;
+  bool defer = frame_can_defer_appends(frame) && frame->append_batch == 0;
+  if (defer) {
+    rc = frame_set_append_batch(frame, -1);
+    if (rc < 0) {
+      goto cleanup;
+    }
+  }
+  rc = frame_write_lock(frame);
+  if (rc == 0) {
+    rc = schunk->nchunks;
+    for (int64_t i = 0; i < nbuffers && rc >= 0; i++) {
+      rc = blosc2_schunk_append_chunk(schunk, work.chunks[i], false);
+      if (rc >= 0) {
+        // The super-chunk owns the chunk now (as in blosc2_schunk_append_buffer)
+        work.chunks[i] = NULL;
+      }
+    }
+    frame_write_unlock(frame);
+  }
+  if (defer) {
+    int rc2 = frame_set_append_batch(frame, 0);
+    if (rc >= 0 && rc2 < 0) {
+      rc = rc2;
+    }
+  }
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Error appending the chunks to the super-chunk.");
+  }
+
+  cleanup:
+  for (int16_t i = 0; i < nthreads; i++) {
+    if (workers[i].cctx != NULL) {
+      blosc2_free_ctx(workers[i].cctx);
+    }
+  }
+  for (int64_t i = 0; i < nbuffers; i++) {
+    free(work.chunks[i]);
+  }
+  blosc2_pthread_mutex_destroy(&work.mutex);
+  free(work.chunks);
+  free(workers);
+  return rc;
+}
+
+
 /* Decompress and return a chunk that is part of a super-chunk. */
 int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int64_t nchunk,
                                    void *dest, int32_t nbytes) {
@@ -1491,6 +2009,20 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int64_t nchunk,
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
 
   schunk->current_nchunk = nchunk;
+  uint8_t *cached;
+  chunksize = schunk_get_cached_chunk(schunk, nchunk, &cached);
+  if (chunksize != 0) {
+    if (chunksize < 0) {
+      return chunksize;
+    }
+    if (nbytes < chunksize) {
+      BLOSC_TRACE_ERROR("Buffer size is too small for the decompressed buffer "
+                        "('%d' bytes, but '%d' are needed).", nbytes, chunksize);
+      return BLOSC2_ERROR_INVALID_PARAM;
+    }
+    memcpy(dest, cached, chunksize);
+    return chunksize;
+  }
   if (frame == NULL) {
     uint8_t* src = schunk->data[nchunk];
     if (src == 0) {
@@ -1530,6 +2062,224 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int64_t nchunk,
 }
 
 
+/* A decompressed chunk in the ring of a chunk iterator */
+typedef struct {
+  blosc2_schunk_iter *iter;
+  blosc2_context *dctx;   // one per slot, as slots are filled concurrently
+  blosc_pool_task *task;  // the decompression of the chunk ahead, if queued
+  uint8_t *data;
+  int32_t nalloc;
+  int32_t nbytes;
+  int64_t nchunk;
+  int rc;
+} schunk_iter_slot;
+
+struct blosc2_schunk_iter_s {
+  blosc2_schunk *schunk;
+  int64_t start;
+  int64_t stop;
+  int16_t nthreads;
+  int32_t nslots;
+  schunk_iter_slot *slots;
+  int64_t consumed;   // chunks handed out by blosc2_schunk_iter_next()
+  blosc2_pthread_mutex_t mutex;  // serializes the reads of the super-chunk
+};
+
+/* Decompress a chunk into a slot, growing its buffer if needed */
+static int schunk_iter_fill(blosc2_schunk_iter *iter, schunk_iter_slot *slot) {
+  blosc2_schunk *schunk = iter->schunk;
+  int64_t nchunk = slot->nchunk;
+  slot->nbytes = 0;
+
+  uint8_t *chunk;
+  bool needs_free;
+  blosc2_pthread_mutex_lock(&iter->mutex);
+  if (nchunk + 1 < iter->stop && schunk->frame != NULL) {
+    // Let the I/O of the next chunk overlap with the decompression of this one
+    frame_prefetch_chunk((blosc2_frame_s*)schunk->frame, nchunk + 1);
+  }
+  int rc = blosc2_schunk_get_chunk(schunk, nchunk, &chunk, &needs_free);
+  blosc2_pthread_mutex_unlock(&iter->mutex);
+  if (rc <= 0) {
+    return rc;
+  }
+  int32_t chunk_nbytes;
+  int32_t chunk_cbytes;
+  rc = blosc2_cbuffer_sizes(chunk, &chunk_nbytes, &chunk_cbytes, NULL);
+  if (rc < 0) {
+    goto end;
+  }
+  if (chunk_nbytes > slot->nalloc) {
+    uint8_t *data = realloc(slot->data, (size_t)chunk_nbytes);
+    if (data == NULL) {
+      BLOSC_TRACE_ERROR("Cannot allocate a buffer for chunk %" PRId64 ".", nchunk);
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto end;
+    }
+    slot->data = data;
+    slot->nalloc = chunk_nbytes;
+  }
+  rc = blosc2_decompress_ctx(slot->dctx, chunk, chunk_cbytes, slot->data, slot->nalloc);
+  if (rc >= 0 && rc != chunk_nbytes) {
+    rc = BLOSC2_ERROR_FAILURE;
+  }
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Error in decompressing chunk %" PRId64 ".", nchunk);
+    goto end;
+  }
+  slot->nbytes = rc;
+
+  end:
+  if (needs_free) {
+    free(chunk);
+  }
+  return rc;
+}
+
+static void schunk_iter_fill_task(void *arg) {
+  schunk_iter_slot *slot = (schunk_iter_slot *)arg;
+  slot->rc = schunk_iter_fill(slot->iter, slot);
+}
+
+/* Queue the decompression of the i-th chunk of an iterator on the shared pool.
+   If it cannot be queued, blosc2_schunk_iter_next() decompresses it on demand. */
+static void schunk_iter_read_ahead(blosc2_schunk_iter *iter, int64_t i) {
+  schunk_iter_slot *slot = &iter->slots[i % iter->nslots];
+  slot->nchunk = iter->start + i;
+  slot->task = pool_task_submit(iter->nthreads, schunk_iter_fill_task, slot);
+}
+
+
+/* Create an iterator over the chunks of a super-chunk that decompresses ahead */
+blosc2_schunk_iter* blosc2_schunk_iter_new(blosc2_schunk *schunk, int64_t start, int64_t stop, int32_t depth) {
+  if (schunk == NULL) {
+    BLOSC_TRACE_ERROR("schunk must not be NULL.");
+    return NULL;
+  }
+  if (start < 0 || stop > schunk->nchunks || start > stop) {
+    BLOSC_TRACE_ERROR("[%" PRId64 ", %" PRId64 ") is not a valid range of chunks "
+                      "(the super-chunk has %" PRId64 ").", start, stop, schunk->nchunks);
+    return NULL;
+  }
+  if (depth < 0) {
+    BLOSC_TRACE_ERROR("depth must be non-negative.");
+    return NULL;
+  }
+  // No point in having more slots than chunks
+  if ((int64_t)depth > stop - start) {
+    depth = (int32_t)(stop - start);
+  }
+
+  blosc2_schunk_iter *iter = calloc(1, sizeof(blosc2_schunk_iter));
+  if (iter == NULL) {
+    BLOSC_TRACE_ERROR("Cannot allocate the iterator.");
+    return NULL;
+  }
+  iter->schunk = schunk;
+  iter->start = start;
+  iter->stop = stop;
+  iter->nthreads = schunk->dctx != NULL ? schunk->dctx->nthreads : blosc2_get_nthreads();
+  iter->nslots = depth + 1;
+  iter->slots = calloc((size_t)iter->nslots, sizeof(schunk_iter_slot));
+  if (iter->slots == NULL) {
+    BLOSC_TRACE_ERROR("Cannot set up the iterator.");
+    free(iter);
+    return NULL;
+  }
+  blosc2_pthread_mutex_init(&iter->mutex, NULL);
+
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = iter->nthreads;
+  dparams.schunk = schunk;
+  if (schunk->dctx != NULL) {
+    dparams.postfilter = schunk->dctx->postfilter;
+    dparams.postparams = schunk->dctx->postparams;
+  }
+  for (int32_t i = 0; i < iter->nslots; i++) {
+    iter->slots[i].iter = iter;
+    iter->slots[i].dctx = blosc2_create_dctx(dparams);
+    if (iter->slots[i].dctx == NULL) {
+      BLOSC_TRACE_ERROR("Cannot set up the iterator.");
+      blosc2_schunk_iter_free(iter);
+      return NULL;
+    }
+  }
+
+  // The workers of the shared pool decompress up to depth chunks ahead
+  for (int32_t i = 0; i < depth; i++) {
+    schunk_iter_read_ahead(iter, i);
+  }
+
+  return iter;
+}
+
+
+/* Get the next decompressed chunk out of an iterator */
+int blosc2_schunk_iter_next(blosc2_schunk_iter *iter, int64_t *nchunk, void **dest, int32_t *nbytes) {
+  if (iter == NULL || nchunk == NULL || dest == NULL || nbytes == NULL) {
+    BLOSC_TRACE_ERROR("iter, nchunk, dest and nbytes must not be NULL.");
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+
+  int64_t i = iter->consumed;
+  if (i > 0 && iter->slots[(i - 1) % iter->nslots].rc < 0) {
+    // Errors are sticky
+    return iter->slots[(i - 1) % iter->nslots].rc;
+  }
+  if (i >= iter->stop - iter->start) {
+    *nchunk = iter->stop;
+    *dest = NULL;
+    *nbytes = 0;
+    return 0;
+  }
+  // Handing out this chunk releases the slot of the previous one, for the chunk depth ahead
+  if (iter->nslots > 1 && i + iter->nslots - 1 < iter->stop - iter->start) {
+    schunk_iter_read_ahead(iter, i + iter->nslots - 1);
+  }
+  schunk_iter_slot *slot = &iter->slots[i % iter->nslots];
+  if (slot->task != NULL) {
+    pool_task_wait(slot->task, false);
+    slot->task = NULL;
+  }
+  else {
+    slot->nchunk = iter->start + i;
+    slot->rc = schunk_iter_fill(iter, slot);
+  }
+  iter->consumed = i + 1;
+
+  if (slot->rc < 0) {
+    return slot->rc;
+  }
+  *nchunk = slot->nchunk;
+  *dest = slot->data;
+  *nbytes = slot->nbytes;
+  return 1;
+}
+
+
+/* Free an iterator, dropping the decompression of the chunks ahead */
+int blosc2_schunk_iter_free(blosc2_schunk_iter *iter) {
+  if (iter == NULL) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  for (int32_t i = 0; i < iter->nslots; i++) {
+    if (iter->slots[i].task != NULL) {
+      pool_task_wait(iter->slots[i].task, true);
+    }
+  }
+  for (int32_t i = 0; i < iter->nslots; i++) {
+    free(iter->slots[i].data);
+    if (iter->slots[i].dctx != NULL) {
+      blosc2_free_ctx(iter->slots[i].dctx);
+    }
+  }
+  blosc2_pthread_mutex_destroy(&iter->mutex);
+  free(iter->slots);
+  free(iter);
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
 /* Return a compressed chunk that is part of a super-chunk in the `chunk` parameter.
  * If the super-chunk is backed by a frame that is disk-based, a buffer is allocated for the
  * (compressed) chunk, and hence a free is needed.  You can check if the chunk requires a free
@@ -1682,83 +2432,125 @@ int blosc2_schunk_get_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t
   int32_t chunksize = schunk->chunksize;
 
   while (nbytes_read < ((stop - start) * schunk->typesize)) {
-    cbytes = blosc2_schunk_get_lazychunk(schunk, nchunk, &chunk, &needs_free);
-    if (cbytes < 0) {
-      BLOSC_TRACE_ERROR("Cannot get lazychunk ('%" PRId64 "').", nchunk);
+    uint8_t *cached;
+    int32_t cached_nbytes = schunk_get_cached_chunk(schunk, nchunk, &cached);
+    if (cached_nbytes < 0) {
+      BLOSC_TRACE_ERROR("Cannot get chunk ('%" PRId64 "') from the cache.", nchunk);
       return BLOSC2_ERROR_FAILURE;
     }
-    int32_t blocksize = sw32_(chunk + BLOSC2_CHUNK_BLOCKSIZE);
-
-    int32_t nblock_start = (int32_t) (chunk_start / blocksize);
-    int32_t nblock_stop = (int32_t) ((chunk_stop - 1) / blocksize);
-    if (nchunk == (schunk->nchunks - 1) && schunk->nbytes % schunk->chunksize != 0) {
-      chunksize = schunk->nbytes % schunk->chunksize;
-    }
-    int32_t nblocks = chunksize / blocksize;
-    if (chunksize % blocksize != 0) {
-      nblocks++;
-    }
-
-    if (chunk_start == 0 && chunk_stop == chunksize) {
-      // Avoid memcpy
-      nbytes = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, dst_ptr, chunksize);
-      if (nbytes < 0) {
-        BLOSC_TRACE_ERROR("Cannot decompress chunk ('%" PRId64 "').", nchunk);
-        if (needs_free) {
-          free(chunk);
-        }
+    if (cached_nbytes > 0) {
+      if (chunk_stop > cached_nbytes) {
+        BLOSC_TRACE_ERROR("Short read (%d out of %d bytes) in ('%" PRId64 "') chunk.",
+                          cached_nbytes, chunk_stop, nchunk);
         return BLOSC2_ERROR_FAILURE;
       }
+      nbytes = chunk_stop - chunk_start;
+      memcpy(dst_ptr, cached + chunk_start, nbytes);
+      needs_free = false;
     }
     else {
-      // After extensive timing I have not been able to see lots of situations where
-      // a maskout read is better than a getitem one.  Disabling for now.
-      // if (nblock_start != nblock_stop) {
-      if (false) {
-        uint8_t *data = malloc(chunksize);
-        /* We have more than 1 block to read, so use a masked read */
-        bool *block_maskout = calloc(nblocks, 1);
-        for (int32_t nblock = 0; nblock < nblocks; nblock++) {
-          if ((nblock < nblock_start) || (nblock > nblock_stop)) {
-            block_maskout[nblock] = true;
-          }
-        }
-        if (blosc2_set_maskout(schunk->dctx, block_maskout, nblocks) < 0) {
-          BLOSC_TRACE_ERROR("Cannot set maskout");
-          return BLOSC2_ERROR_FAILURE;
-        }
+      // Let the next chunk of the slice come from disk while this one is decompressed
+      if (schunk->frame != NULL && byte_stop > (nchunk + 1) * schunk->chunksize) {
+        frame_prefetch_chunk((blosc2_frame_s *)schunk->frame, nchunk + 1);
+      }
+      cbytes = blosc2_schunk_get_lazychunk(schunk, nchunk, &chunk, &needs_free);
+      if (cbytes < 0) {
+        BLOSC_TRACE_ERROR("Cannot get lazychunk ('%" PRId64 "').", nchunk);
+        return BLOSC2_ERROR_FAILURE;
+      }
+      int32_t blocksize = sw32_(chunk + BLOSC2_CHUNK_BLOCKSIZE);
+
+      int32_t nblock_start = (int32_t) (chunk_start / blocksize);
+      int32_t nblock_stop = (int32_t) ((chunk_stop - 1) / blocksize);
+      if (nchunk == (schunk->nchunks - 1) && schunk->nbytes % schunk->chunksize != 0) {
+        chunksize = schunk->nbytes % schunk->chunksize;
+      }
+      int32_t nblocks = chunksize / blocksize;
+      if (chunksize % blocksize != 0) {
+        nblocks++;
+      }
 
-        nbytes = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, data, chunksize);
+      if (chunk_start == 0 && chunk_stop == chunksize) {
+        // Avoid memcpy
+        nbytes = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, dst_ptr, chunksize);
         if (nbytes < 0) {
           BLOSC_TRACE_ERROR("Cannot decompress chunk ('%" PRId64 "').", nchunk);
+          if (needs_free) {
+            free(chunk);
+          }
           return BLOSC2_ERROR_FAILURE;
         }
-        nbytes = chunk_stop - chunk_start;
-        memcpy(dst_ptr, &data[chunk_start], nbytes);
-        free(block_maskout);
-        free(data);
       }
       else {
-        /* Less than 1 block to read; use a getitem call.  Counting in bytes
-           keeps this right for typesizes above BLOSC_MAX_TYPESIZE, which chunks
-           record as 1. */
-        int32_t nbytes_wanted = chunk_stop - chunk_start;
-        nbytes = blosc2_getitem_bytes_ctx(schunk->dctx, chunk, cbytes, chunk_start,
-                                          nbytes_wanted, dst_ptr, nbytes_wanted);
-        if (nbytes < 0) {
-          BLOSC_TRACE_ERROR("Cannot get item from ('%" PRId64 "') chunk.", nchunk);
-          if (needs_free) {
-            free(chunk);
+        // After extensive timing I have not been able to see lots of situations where
+        // a maskout read is better than a getitem one for in-memory chunks.  For lazy
+        // chunks, though, a masked read fetches all the blocks with a single (vectored)
+        // read, whereas a getitem one goes to disk once per block.
+        bool is_lazy = (chunk[BLOSC2_CHUNK_BLOSC2_FLAGS] & 0x08u) != 0;
+        if (is_lazy && nblock_start != nblock_stop) {
+          uint8_t *data = malloc(chunksize);
+          /* We have more than 1 block to read, so use a masked read */
+          bool *block_maskout = calloc(nblocks, 1);
+          if (data == NULL || block_maskout == NULL) {
+            free(data);
+            free(block_maskout);
+            if (needs_free) {
+              free(chunk);
+            }
+            BLOSC_TRACE_ERROR("Error allocating memory!");
+            return BLOSC2_ERROR_MEMORY_ALLOC;
           }
-          return BLOSC2_ERROR_FAILURE;
+          for (int32_t nblock = 0; nblock < nblocks; nblock++) {
+            if ((nblock < nblock_start) || (nblock > nblock_stop)) {
+              block_maskout[nblock] = true;
+            }
+          }
+          if (blosc2_set_maskout(schunk->dctx, block_maskout, nblocks) < 0) {
+            BLOSC_TRACE_ERROR("Cannot set maskout");
+            free(block_maskout);
+            free(data);
+            if (needs_free) {
+              free(chunk);
+            }
+            return BLOSC2_ERROR_FAILURE;
+          }
+          free(block_maskout);
+
+          nbytes = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, data, chunksize);
+          if (nbytes < 0) {
+            BLOSC_TRACE_ERROR("Cannot decompress chunk ('%" PRId64 "').", nchunk);
+            free(data);
+            if (needs_free) {
+              free(chunk);
+            }
+            return BLOSC2_ERROR_FAILURE;
+          }
+          nbytes = chunk_stop - chunk_start;
+          memcpy(dst_ptr, &data[chunk_start], nbytes);
+          free(data);
         }
-        if (nbytes != nbytes_wanted) {
-          BLOSC_TRACE_ERROR("Short read (%d out of %d bytes) in ('%" PRId64 "') chunk.",
-                            nbytes, nbytes_wanted, nchunk);
-          if (needs_free) {
-            free(chunk);
+        else {
+          /* Less than 1 block to read; use a getitem call.  Counting in bytes
+             keeps this right for typesizes above BLOSC_MAX_TYPESIZE, which chunks
+             record as 1. */
+          int32_t nbytes_wanted = chunk_stop - chunk_start;
+          nbytes = blosc2_getitem_bytes_ctx(schunk->dctx, chunk, cbytes, chunk_start,
+                                            nbytes_wanted, dst_ptr, nbytes_wanted);
+          if (nbytes < 0) {
+            BLOSC_TRACE_ERROR("Cannot get item from ('%" PRId64 "') chunk.", nchunk);
+            if (needs_free) {
+              free(chunk);
+            }
+            return BLOSC2_ERROR_FAILURE;
+          }
+          if (nbytes != nbytes_wanted) {
+            BLOSC_TRACE_ERROR("Short read (%d out of %d bytes) in ('%" PRId64 "') chunk.",
+                              nbytes, nbytes_wanted, nchunk);
+            if (needs_free) {
+              free(chunk);
+            }
+            return BLOSC2_ERROR_FAILURE;
           }
-          return BLOSC2_ERROR_FAILURE;
         }
       }
     }
@@ -1972,6 +2764,7 @@ int blosc2_schunk_get_sparse_buffer(blosc2_schunk *schunk, int64_t ncoords, cons
   sparse_chunk_entry *chunks = NULL;
   sparse_worker *workers = NULL;
   int16_t nthreads = 1;
+  int16_t pool_nthreads = 1;
   int64_t ntasks = 0;
   int64_t nchunks = 0;
   sparse_work work;
@@ -2062,10 +2855,11 @@ int blosc2_schunk_get_sparse_buffer(blosc2_schunk *schunk, int64_t ncoords, cons
     ++chunk_index;
   }
 
-  nthreads = schunk->dctx != NULL ? schunk->dctx->nthreads : blosc2_get_nthreads();
-  if (nthreads < 1) {
-    nthreads = 1;
+  pool_nthreads = schunk->dctx != NULL ? schunk->dctx->nthreads : blosc2_get_nthreads();
+  if (pool_nthreads < 1) {
+    pool_nthreads = 1;
   }
+  nthreads = pool_nthreads;
   if ((int64_t)nthreads > ntasks) {
     nthreads = (int16_t)ntasks;
   }
@@ -2105,7 +2899,7 @@ int blosc2_schunk_get_sparse_buffer(blosc2_schunk *schunk, int64_t ncoords, cons
     sparse_worker_func(&workers[0]);
   }
   else {
-    int err = blosc2_run_parallel(nthreads, sparse_worker_func, sizeof(sparse_worker), workers);
+    int err = blosc2_run_parallel(pool_nthreads, nthreads, sparse_worker_func, sizeof(sparse_worker), workers);
     if (err < 0) {
       sparse_work_set_error(&work, err);
     }
@@ -2260,15 +3054,16 @@ int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int64_t *offsets_order)
     }
   }
   free(index_check);
+  schunk_clear_cache(schunk);
 
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
   if (frame != NULL) {
-    int rc = frame_lock(frame, true);
+    int rc = frame_write_lock(frame);
     if (rc < 0) {
       return rc;
     }
     rc = frame_reorder_offsets(frame, offsets_order, schunk);
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
   uint8_t **offsets = schunk->data;
@@ -2286,6 +3081,25 @@ int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int64_t *offsets_order)
 }
 
 
+/* Reclaim the space of stale chunks in a packed sparse frame */
+int64_t blosc2_schunk_compact(blosc2_schunk *schunk) {
+  if (schunk == NULL) {
+    return BLOSC2_ERROR_NULL_POINTER;
+  }
+  blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
+  if (frame == NULL) {
+    return 0;
+  }
+  int rc = frame_write_lock(frame);
+  if (rc < 0) {
+    return rc;
+  }
+  int64_t nbytes = frame_compact(frame, schunk);
+  frame_write_unlock(frame);
+  return nbytes;
+}
+
+
 // Get the length (in bytes) of the internal frame of the super-chunk
 int64_t blosc2_schunk_frame_len(blosc2_schunk* schunk) {
   int64_t len;
@@ -2320,23 +3134,23 @@ int metalayer_flush(blosc2_schunk* schunk) {
   if (frame == NULL) {
     return rc;
   }
-  rc = frame_lock(frame, true);
+  rc = frame_write_lock(frame);
   if (rc < 0) {
     return rc;
   }
   rc = frame_update_header(frame, schunk, true);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to update metalayers into frame.");
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
   rc = frame_update_trailer(frame, schunk);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to update trailer into frame.");
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   return rc;
 }
 
@@ -2439,11 +3253,19 @@ int blosc2_meta_update(blosc2_schunk *schunk, const char *name, uint8_t *content
   // Update the metalayers in frame (as size has not changed, we don't need to update the trailer)
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
   if (frame != NULL) {
-    int rc = frame_update_header(frame, schunk, false);
+    int rc = frame_write_lock(frame);
+    if (rc < 0) {
+      return rc;
+    }
+    rc = frame_update_header(frame, schunk, false);
+    int rc2 = frame_write_unlock(frame);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Unable to update meta info from frame.");
       return rc;
     }
+    if (rc2 < 0) {
+      return rc2;
+    }
   }
   schunk->change_tick++;
 
@@ -2451,11 +3273,25 @@ int blosc2_meta_update(blosc2_schunk *schunk, const char *name, uint8_t *content
 }
 
 
+/* Whether name is one of the variable-length metalayers that Blosc keeps for itself, which are hidden
+ * from the vlmeta API */
+static bool vlmeta_reserved(const char *name) {
+  return name != NULL && strcmp(name, BLOSC2_DICT_VLMETA) == 0;
+}
+
+
 /* Find whether the schunk has a variable-length metalayer or not.
  *
  * If successful, return the index of the variable-length metalayer.  Else, return a negative value.
  */
 int blosc2_vlmeta_exists(blosc2_schunk *schunk, const char *name) {
+  if (vlmeta_reserved(name)) {
+    return BLOSC2_ERROR_NOT_FOUND;
+  }
+  return schunk_vlmeta_exists(schunk, name);
+}
+
+int schunk_vlmeta_exists(blosc2_schunk *schunk, const char *name) {
   if (strlen(name) > BLOSC2_METALAYER_NAME_MAXLEN) {
     BLOSC_TRACE_ERROR("Variable-length metalayer names cannot be larger than %d chars.", BLOSC2_METALAYER_NAME_MAXLEN);
     return BLOSC2_ERROR_INVALID_PARAM;
@@ -2485,23 +3321,23 @@ int vlmetalayer_flush(blosc2_schunk* schunk) {
   if (frame == NULL) {
     return rc;
   }
-  rc = frame_lock(frame, true);
+  rc = frame_write_lock(frame);
   if (rc < 0) {
     return rc;
   }
   rc = frame_update_header(frame, schunk, false);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to update metalayers into frame.");
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
   rc = frame_update_trailer(frame, schunk);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Unable to update trailer into frame.");
-    frame_unlock(frame);
+    frame_write_unlock(frame);
     return rc;
   }
-  frame_unlock(frame);
+  frame_write_unlock(frame);
   return rc;
 }
 
@@ -2511,11 +3347,20 @@ int vlmetalayer_flush(blosc2_schunk* schunk) {
  */
 int blosc2_vlmeta_add(blosc2_schunk *schunk, const char *name, uint8_t *content, int32_t content_len,
                       blosc2_cparams *cparams) {
+  if (vlmeta_reserved(name)) {
+    BLOSC_TRACE_ERROR("Variable-length metalayer name \"%s\" is reserved.", name);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return schunk_vlmeta_add(schunk, name, content, content_len, cparams);
+}
+
+int schunk_vlmeta_add(blosc2_schunk *schunk, const char *name, uint8_t *content, int32_t content_len,
+                      blosc2_cparams *cparams) {
   if (schunk == NULL || name == NULL) {
     BLOSC_TRACE_ERROR("Invalid parameters.");
     return BLOSC2_ERROR_INVALID_PARAM;
   }
-  int nvlmetalayer = blosc2_vlmeta_exists(schunk, name);
+  int nvlmetalayer = schunk_vlmeta_exists(schunk, name);
   if (nvlmetalayer >= 0) {
     BLOSC_TRACE_ERROR("Variable-length metalayer \"%s\" already exists.", name);
     return BLOSC2_ERROR_INVALID_PARAM;
@@ -2608,13 +3453,22 @@ int blosc2_vlmeta_add(blosc2_schunk *schunk, const char *name, uint8_t *content,
 
 int blosc2_vlmeta_get(blosc2_schunk *schunk, const char *name, uint8_t **content,
                       int32_t *content_len) {
+  if (vlmeta_reserved(name)) {
+    BLOSC_TRACE_ERROR("User metalayer \"%s\" not found.", name);
+    return BLOSC2_ERROR_NOT_FOUND;
+  }
+  return schunk_vlmeta_get(schunk, name, content, content_len);
+}
+
+int schunk_vlmeta_get(blosc2_schunk *schunk, const char *name, uint8_t **content,
+                      int32_t *content_len) {
   if (schunk == NULL || name == NULL || content == NULL || content_len == NULL) {
     BLOSC_TRACE_ERROR("Invalid parameters.");
     return BLOSC2_ERROR_INVALID_PARAM;
   }
-  // blosc2_vlmeta_exists() re-syncs the cached vlmetalayers if another handle
+  // schunk_vlmeta_exists() re-syncs the cached vlmetalayers if another handle
   // rewrote the frame
-  int nvlmetalayer = blosc2_vlmeta_exists(schunk, name);
+  int nvlmetalayer = schunk_vlmeta_exists(schunk, name);
   if (nvlmetalayer < 0) {
     BLOSC_TRACE_ERROR("User metalayer \"%s\" not found.", name);
     return nvlmetalayer;
@@ -2764,15 +3618,21 @@ int blosc2_vlmeta_delete(blosc2_schunk *schunk, const char *name) {
   }
   schunk->change_tick++;
 
-  return schunk->nvlmetalayers;
+  return blosc2_vlmeta_get_names(schunk, NULL);
 }
 
 
 int blosc2_vlmeta_get_names(blosc2_schunk *schunk, char **names) {
-  int16_t nvlmetalayers = schunk->nvlmetalayers;
+  int nvlmetalayers = 0;
 
-  for (int i = 0; i < nvlmetalayers; ++i) {
-    names[i] = schunk->vlmetalayers[i]->name;
+  for (int i = 0; i < schunk->nvlmetalayers; ++i) {
+    if (vlmeta_reserved(schunk->vlmetalayers[i]->name)) {
+      continue;
+    }
+    if (names != NULL) {
+      names[nvlmetalayers] = schunk->vlmetalayers[i]->name;
+    }
+    nvlmetalayers++;
   }
 
   return nvlmetalayers;
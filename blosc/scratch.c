@@ -0,0 +1,110 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "scratch.h"
+
+#include <stdlib.h>
+
+/* What precedes every buffer handed out (keeps the buffer aligned for any scalar) */
+typedef union scratch_header {
+  struct {
+    void* next;  /* The next released buffer of the same size class */
+    int32_t sclass;  /* The size class, or SCRATCH_NCLASSES for big buffers */
+  } h;
+  long double align;
+  int64_t pad[2];
+} scratch_header;
+
+
+static int32_t size_class(size_t size) {
+  int32_t sclass = 0;
+  size_t class_size = (size_t)1 << SCRATCH_MIN_SHIFT;
+  while (class_size < size && sclass < SCRATCH_NCLASSES) {
+    class_size <<= 1;
+    sclass++;
+  }
+  return sclass;
+}
+
+
+static size_t class_size(int32_t sclass) {
+  return (size_t)1 << (SCRATCH_MIN_SHIFT + sclass);
+}
+
+
+void* scratch_alloc(scratch_arena* arena, size_t size) {
+  if (size == 0 || size > SIZE_MAX - sizeof(scratch_header)) {
+    return NULL;
+  }
+  int32_t sclass = size_class(size);
+  scratch_header* header;
+  if (sclass < SCRATCH_NCLASSES && arena->free_lists[sclass] != NULL) {
+    header = (scratch_header*)arena->free_lists[sclass];
+    arena->free_lists[sclass] = header->h.next;
+    arena->cached_nbytes -= (int64_t)class_size(sclass);
+    return header + 1;
+  }
+  size_t nbytes = sclass < SCRATCH_NCLASSES ? class_size(sclass) : size;
+  header = malloc(sizeof(scratch_header) + nbytes);
+  if (header == NULL) {
+    return NULL;
+  }
+  arena->nallocs++;
+  header->h.next = NULL;
+  header->h.sclass = sclass;
+  return header + 1;
+}
+
+
+void scratch_release(scratch_arena* arena, void* ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+  scratch_header* header = (scratch_header*)ptr - 1;
+  int32_t sclass = header->h.sclass;
+  if (sclass >= SCRATCH_NCLASSES) {
+    free(header);
+    return;
+  }
+  header->h.next = arena->free_lists[sclass];
+  arena->free_lists[sclass] = header;
+  arena->cached_nbytes += (int64_t)class_size(sclass);
+}
+
+
+void* scratch_realloc(scratch_arena* arena, void* ptr, size_t size) {
+  if (ptr != NULL) {
+    int32_t sclass = ((scratch_header*)ptr - 1)->h.sclass;
+    if (sclass < SCRATCH_NCLASSES && size > 0 && size <= class_size(sclass)) {
+      return ptr;
+    }
+  }
+  scratch_release(arena, ptr);
+  return scratch_alloc(arena, size);
+}
+
+
+int64_t scratch_trim(scratch_arena* arena) {
+  int64_t nbytes = arena->cached_nbytes;
+  for (int32_t sclass = 0; sclass < SCRATCH_NCLASSES; sclass++) {
+    while (arena->free_lists[sclass] != NULL) {
+      scratch_header* header = (scratch_header*)arena->free_lists[sclass];
+      arena->free_lists[sclass] = header->h.next;
+      free(header);
+    }
+  }
+  arena->cached_nbytes = 0;
+  return nbytes;
+}
+
+
+void scratch_destroy(scratch_arena* arena) {
+  scratch_trim(arena);
+}
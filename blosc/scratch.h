@@ -0,0 +1,58 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  A scratch arena for the temporaries of (de)compression calls.
+
+  Buffers are handed out from power-of-two size classes, and released
+  buffers are kept in a free list per class instead of going back to
+  the system, so a context that is used over and over again stops
+  allocating once it has seen its biggest temporaries.  The memory is
+  only given back on scratch_trim() (and on scratch_destroy()).
+
+  An arena is not thread-safe: it belongs to a context (or thread
+  context), which is never used by two threads at the same time.
+**********************************************************************/
+
+#ifndef BLOSC_SCRATCH_H
+#define BLOSC_SCRATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Buffers of up to 2^(SCRATCH_MIN_SHIFT + SCRATCH_NCLASSES - 1) bytes are
+ * recycled; bigger ones are allocated and freed every time. */
+#define SCRATCH_MIN_SHIFT 6
+#define SCRATCH_NCLASSES 25
+
+typedef struct scratch_arena {
+  void* free_lists[SCRATCH_NCLASSES];  /* The released buffers of every size class */
+  int64_t cached_nbytes;  /* The bytes in the free lists */
+  int64_t nallocs;  /* The buffers allocated from the system so far */
+} scratch_arena;
+
+/* Get a buffer of (at least) size bytes, aligned for any scalar type.
+ * Returns NULL if size is zero or the allocation fails. */
+void* scratch_alloc(scratch_arena* arena, size_t size);
+
+/* Give a buffer from scratch_alloc() back to the arena (NULL is fine). */
+void scratch_release(scratch_arena* arena, void* ptr);
+
+/* Release a buffer and get another one of (at least) size bytes; the contents
+ * are not preserved.  Buffers that are already big enough are returned as is. */
+void* scratch_realloc(scratch_arena* arena, void* ptr, size_t size);
+
+/* Free the buffers cached by the arena.  Returns the number of bytes freed. */
+int64_t scratch_trim(scratch_arena* arena);
+
+/* Free the buffers cached by the arena; all of them must have been released. */
+void scratch_destroy(scratch_arena* arena);
+
+#endif /* BLOSC_SCRATCH_H */
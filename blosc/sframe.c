@@ -8,9 +8,13 @@
   See LICENSE.txt for details about copyright and rights to use.
 **********************************************************************/
 
+#include "sframe.h"
 #include "frame.h"
+#include "journal.h"
 #include "blosc2.h"
 
+#include <sys/stat.h>
+
 #include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
@@ -25,7 +29,7 @@
 #endif
 
 
-static char* sframe_make_index_path(const char* urlpath) {
+char* sframe_make_index_path(const char* urlpath) {
   size_t path_len = strlen(urlpath);
   size_t suffix_len = strlen("/chunks.b2frame");
   if (path_len > SIZE_MAX - suffix_len - 1) {
@@ -49,14 +53,14 @@ static char* sframe_make_index_path(const char* urlpath) {
 }
 
 
-static char* sframe_make_chunk_path(const char* urlpath, int64_t nchunk) {
-  if (nchunk < 0 || (uint64_t)nchunk > UINT32_MAX) {
-    BLOSC_TRACE_ERROR("Chunk index (%" PRId64 ") is out of range for sframe filenames", nchunk);
+char* sframe_make_file_path(const char* urlpath, int64_t nfile, const char* ext) {
+  if (nfile < 0 || (uint64_t)nfile > UINT32_MAX) {
+    BLOSC_TRACE_ERROR("File index (%" PRId64 ") is out of range for sframe filenames", nfile);
     return NULL;
   }
 
   size_t path_len = strlen(urlpath);
-  size_t suffix_len = strlen("/.chunk");
+  size_t suffix_len = strlen("/.") + strlen(ext);
   size_t chunk_hex_len = 8;
   if (path_len > SIZE_MAX - suffix_len - chunk_hex_len - 1) {
     BLOSC_TRACE_ERROR("Chunk path length overflows size limits");
@@ -69,9 +73,9 @@ static char* sframe_make_chunk_path(const char* urlpath, int64_t nchunk) {
     return NULL;
   }
 
-  int written = snprintf(chunk_path, total_len, "%s/%08" PRIX32 ".chunk", urlpath, (uint32_t)nchunk);
+  int written = snprintf(chunk_path, total_len, "%s/%08" PRIX32 ".%s", urlpath, (uint32_t)nfile, ext);
   if (written < 0 || (size_t)written >= total_len) {
-    BLOSC_TRACE_ERROR("Error building chunk path for chunk index (%" PRId64 ")", nchunk);
+    BLOSC_TRACE_ERROR("Error building the path for file index (%" PRId64 ")", nfile);
     free(chunk_path);
     return NULL;
   }
@@ -99,53 +103,417 @@ void* sframe_open_index(const char* urlpath, const char* mode, const blosc2_io *
   return fp;
 }
 
-/* Open directory/nchunk.chunk with 8 zeros of padding */
-void* sframe_open_chunk(const char* urlpath, int64_t nchunk, const char* mode, const blosc2_io *io) {
+/* Open directory/<nfile>.<ext>, with 8 zeros of padding */
+static void* sframe_open_file(const char* urlpath, int64_t nfile, const char* ext, const char* mode,
+                              const blosc2_io *io) {
   void* fp = NULL;
-  char* chunk_path = sframe_make_chunk_path(urlpath, nchunk);
-  if (chunk_path) {
+  char* file_path = sframe_make_file_path(urlpath, nfile, ext);
+  if (file_path) {
     blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
     if (io_cb == NULL) {
       BLOSC_TRACE_ERROR("Error getting the input/output API");
-      free(chunk_path);
+      free(file_path);
       return NULL;
     }
-    fp = io_cb->open(chunk_path, mode, io->params);
+    fp = io_cb->open(file_path, mode, io->params);
     if (fp == NULL)
-      BLOSC_TRACE_ERROR("Error opening chunk path in: %s", chunk_path);
-    free(chunk_path);
+      BLOSC_TRACE_ERROR("Error opening chunk path in: %s", file_path);
+    free(file_path);
+  }
+  return fp;
+}
+
+/* Open directory/nchunk.chunk with 8 zeros of padding */
+void* sframe_open_chunk(const char* urlpath, int64_t nchunk, const char* mode, const blosc2_io *io) {
+  return sframe_open_file(urlpath, nchunk, "chunk", mode, io);
+}
+
+
+/* The files of a sparse frame are either one per chunk, named after the
+   chunk id in the offsets index, or (packed layout) append-only segments
+   holding many chunks each, and then the index has the segment and the
+   position of the chunk in it. */
+static int64_t sframe_file_id(const blosc2_frame_s* frame, int64_t offset, int64_t* chunk_pos) {
+  if (frame->packed) {
+    *chunk_pos = SFRAME_SEGMENT_POS(offset);
+    return SFRAME_SEGMENT(offset);
+  }
+  *chunk_pos = 0;
+  return offset;
+}
+
+static void* sframe_open_id(const blosc2_frame_s* frame, int64_t id, const char* mode, const blosc2_io *io) {
+  return sframe_open_file(frame->urlpath, id, frame->packed ? "segment" : "chunk", mode, io);
+}
+
+
+/* Open handles of the chunk (or segment) files, kept per frame in
+   frame->sframe_handles and guarded by frame->read_fp_mutex.  Reading an
+   sframe otherwise costs an open() and a close() per chunk and per lazy
+   block, which dominates the reads of small chunks.  Like the handle of a
+   contiguous frame (see frame_reader_acquire), handles are only cached for
+   the default filesystem backend on POSIX, where reads are positional and
+   can be shared between threads, and every cached handle takes a slot of the
+   process-wide budget of frame_reader_cache_claim().  This one does evict:
+   a handle is only closed once nobody has it checked out, so the least
+   recently used idle one goes when the cache is full (and when all of them
+   are busy, the caller gets a private handle instead). */
+#define SFRAME_HANDLES_MAX 16
+
+typedef struct {
+  int64_t id;         //!< The chunk or segment number of the file; -1 if the slot is free
+  void* fp;           //!< The "rb" handle
+  int32_t refs;       //!< Outstanding sframe_acquire_chunk() calls on fp
+  bool stale;         //!< Invalidated while checked out: closed on the last release
+  uint64_t last_use;  //!< Tick of the last acquire, for the LRU
+} sframe_handle;
+
+typedef struct {
+  sframe_handle slots[SFRAME_HANDLES_MAX];
+  uint64_t clock;     //!< Acquire ticks
+  int64_t wsegment;   //!< The segment appended to (packed layout); -1 if not known yet
+  void* wfp;          //!< Cached "rb+" handle of wsegment; NULL if none
+} sframe_handles;
+
+
+static bool sframe_handles_cacheable(const blosc2_io* io) {
+#if defined(_WIN32)
+  /* No FILE_SHARE_DELETE in the CRT; see frame_reader_acquire() */
+  BLOSC_UNUSED_PARAM(io);
+  return false;
+#else
+  return io->id == BLOSC2_IO_FILESYSTEM || io->id == BLOSC2_IO_FILESYSTEM_URING;
+#endif
+}
+
+/* Get the handles of the frame, creating them if needed; caller must hold read_fp_mutex */
+static sframe_handles* sframe_get_handles(blosc2_frame_s* frame) {
+  sframe_handles* handles = frame->sframe_handles;
+  if (handles == NULL) {
+    handles = calloc(1, sizeof(sframe_handles));
+    if (handles == NULL) {
+      return NULL;
+    }
+    for (int i = 0; i < SFRAME_HANDLES_MAX; i++) {
+      handles->slots[i].id = -1;
+    }
+    handles->wsegment = -1;
+    frame->sframe_handles = handles;
+  }
+  return handles;
+}
+
+/* Only handles from the filesystem backend are ever cached, so close them
+   directly (as frame_reader_close_locked() does) */
+static void sframe_close_slot(sframe_handle* slot) {
+  blosc2_stdio_close(slot->fp);
+  frame_reader_cache_return();
+  slot->id = -1;
+  slot->fp = NULL;
+  slot->refs = 0;
+  slot->stale = false;
+}
+
+
+/* See sframe.h */
+void* sframe_acquire_chunk(blosc2_frame_s* frame, int64_t offset, const blosc2_io* io, int64_t* chunk_pos) {
+  int64_t id = sframe_file_id(frame, offset, chunk_pos);
+  if (!sframe_handles_cacheable(io)) {
+    return sframe_open_id(frame, id, "rb", io);
+  }
+
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  sframe_handles* handles = sframe_get_handles(frame);
+  if (handles != NULL) {
+    for (int i = 0; i < SFRAME_HANDLES_MAX; i++) {
+      sframe_handle* slot = &handles->slots[i];
+      if (slot->id == id && !slot->stale) {
+        slot->refs++;
+        slot->last_use = ++handles->clock;
+        blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+        return slot->fp;
+      }
+    }
+  }
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+
+  // Open outside the lock, so that a slow open() does not stall the readers of other files
+  void* fp = sframe_open_id(frame, id, "rb", io);
+  if (fp == NULL || handles == NULL) {
+    return fp;
   }
+
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  sframe_handle* victim = NULL;
+  for (int i = 0; i < SFRAME_HANDLES_MAX; i++) {
+    sframe_handle* slot = &handles->slots[i];
+    if (slot->id == id && !slot->stale) {
+      // Another thread opened the same file in the meantime: share its handle
+      slot->refs++;
+      slot->last_use = ++handles->clock;
+      blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+      blosc2_stdio_close(fp);
+      return slot->fp;
+    }
+    if (slot->refs > 0) {
+      continue;
+    }
+    if (victim == NULL || slot->fp == NULL ||
+        (victim->fp != NULL && slot->last_use < victim->last_use)) {
+      victim = slot;
+    }
+  }
+  if (victim != NULL) {
+    if (victim->fp != NULL) {
+      // Recycle the budget slot of the evicted handle
+      blosc2_stdio_close(victim->fp);
+      victim->fp = NULL;
+    }
+    else if (!frame_reader_cache_claim()) {
+      victim = NULL;
+    }
+  }
+  if (victim != NULL) {
+    victim->id = id;
+    victim->fp = fp;
+    victim->refs = 1;
+    victim->stale = false;
+    victim->last_use = ++handles->clock;
+  }
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+  // Otherwise the handle is a private one, which sframe_release_chunk() closes
   return fp;
 }
 
-/* Append an existing chunk into a sparse frame. */
-void* sframe_create_chunk(blosc2_frame_s* frame, uint8_t* chunk, int64_t nchunk, int64_t cbytes) {
+
+/* See sframe.h */
+void sframe_release_chunk(blosc2_frame_s* frame, const blosc2_io_cb* io_cb, void* fp) {
+  if (fp == NULL) {
+    return;
+  }
+  bool is_cached = false;
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  sframe_handles* handles = frame->sframe_handles;
+  if (handles != NULL) {
+    for (int i = 0; i < SFRAME_HANDLES_MAX; i++) {
+      sframe_handle* slot = &handles->slots[i];
+      if (slot->fp == fp) {
+        is_cached = true;
+        slot->refs--;
+        if (slot->stale && slot->refs == 0) {
+          sframe_close_slot(slot);
+        }
+        break;
+      }
+    }
+  }
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+  if (!is_cached) {
+    io_cb->close(fp);
+  }
+}
+
+
+/* See sframe.h */
+void sframe_invalidate_chunks(blosc2_frame_s* frame, int64_t id) {
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  sframe_handles* handles = frame->sframe_handles;
+  if (handles != NULL) {
+    for (int i = 0; i < SFRAME_HANDLES_MAX; i++) {
+      sframe_handle* slot = &handles->slots[i];
+      if (slot->fp == NULL || (id >= 0 && slot->id != id)) {
+        continue;
+      }
+      if (slot->refs > 0) {
+        // A read is in flight on it; it finishes on the file it started on
+        slot->stale = true;
+      }
+      else {
+        sframe_close_slot(slot);
+      }
+    }
+    if (id < 0) {
+      // The segment appended to is found out again from the offsets index
+      if (handles->wfp != NULL) {
+        blosc2_stdio_close(handles->wfp);
+        frame_reader_cache_return();
+        handles->wfp = NULL;
+      }
+      handles->wsegment = -1;
+    }
+  }
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+}
+
+
+/* See sframe.h */
+void sframe_free_handles(blosc2_frame_s* frame) {
+  if (frame->sframe_handles == NULL) {
+    return;
+  }
+  sframe_invalidate_chunks(frame, -1);
+  free(frame->sframe_handles);
+  frame->sframe_handles = NULL;
+}
+
+
+/* Append a chunk at the end of the current segment of a packed sparse frame
+   (or of a new one if @p new_segment), going on with a new segment when it
+   would grow past SFRAME_SEGMENT_MAXLEN.  @p next_offset is one past the
+   largest offset in the index, where the segment is found out from when not
+   known yet.  Returns the offset for the index, or a negative error code. */
+static int64_t sframe_append_segment(blosc2_frame_s* frame, const uint8_t* chunk, int64_t next_offset,
+                                     int64_t cbytes, bool new_segment) {
+  const blosc2_io* io = frame->schunk->storage->io;
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
+  if (io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  // Mutations are serialized by the caller, so the writer state only needs
+  // guarding against sframe_invalidate_chunks() from the readers
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  sframe_handles* handles = sframe_get_handles(frame);
+  if (handles == NULL) {
+    blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int64_t segment = handles->wsegment;
+  void* fp = handles->wfp;
+  handles->wfp = NULL;
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+  // Whether fp holds a slot of the handle budget
+  bool fp_cached = fp != NULL;
+
+  // Segments are only ever appended to.  The ones past the segment of the
+  // last chunk in the index hold nothing referenced, so they are (re)created.
+  const char* mode = "rb+";
+  if (segment < 0) {
+    if (next_offset > 0) {
+      segment = SFRAME_SEGMENT(next_offset - 1);
+    }
+    else {
+      segment = 0;
+      mode = "wb";
+    }
+  }
+  if (new_segment) {
+    segment++;
+    mode = "wb";
+  }
+  int64_t pos;
+  while (true) {
+    if (fp != NULL && new_segment) {
+      io_cb->close(fp);
+      if (fp_cached) {
+        frame_reader_cache_return();
+      }
+      fp = NULL;
+      fp_cached = false;
+    }
+    if (fp == NULL) {
+      fp = sframe_open_file(frame->urlpath, segment, "segment", mode, io);
+      if (fp == NULL) {
+        BLOSC_TRACE_ERROR("Cannot open the segment file.");
+        return BLOSC2_ERROR_FILE_OPEN;
+      }
+    }
+    // The end of the file, rather than a length kept here, as another handle
+    // may have appended to it
+    pos = io_cb->size(fp);
+    if (pos < 0 || pos == 0 || pos + cbytes <= SFRAME_SEGMENT_MAXLEN) {
+      break;
+    }
+    // Full: go on with the next one
+    segment++;
+    mode = "wb";
+    new_segment = true;
+  }
+  if (pos < 0 || segment > SFRAME_SEGMENT_MAX || pos > SFRAME_SEGMENT_POS_MAX - cbytes) {
+    BLOSC_TRACE_ERROR("Cannot append to segment %" PRId64 " (at position %" PRId64 ").", segment, pos);
+    io_cb->close(fp);
+    if (fp_cached) {
+      frame_reader_cache_return();
+    }
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  int64_t wbytes = io_cb->write(chunk, 1, cbytes, pos, fp);
+
+  // Keep the handle for the next append if there is room for it
+  if (!fp_cached && sframe_handles_cacheable(io)) {
+    fp_cached = frame_reader_cache_claim();
+  }
+  if (!fp_cached) {
+    io_cb->close(fp);
+    fp = NULL;
+  }
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  handles->wsegment = segment;
+  handles->wfp = fp;
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+  if (wbytes != cbytes) {
+    BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  int rc = frame_mark_dirty(frame, segment);
+  if (rc < 0) {
+    return rc;
+  }
+
+  return SFRAME_PACKED_OFFSET(segment, pos);
+}
+
+
+/* Store a chunk into a sparse frame. */
+int64_t sframe_create_chunk(blosc2_frame_s* frame, uint8_t* chunk, int64_t nchunk, int64_t cbytes) {
+  if (frame->packed) {
+    return sframe_append_segment(frame, chunk, nchunk, cbytes, false);
+  }
+  // The chunk file may be an existing one being replaced
+  int rc = journal_save(frame, nchunk, 0, INT64_MAX);
+  if (rc < 0) {
+    return rc;
+  }
   void* fpc = sframe_open_chunk(frame->urlpath, nchunk, "wb", frame->schunk->storage->io);
   if (fpc == NULL) {
     BLOSC_TRACE_ERROR("Cannot open the chunkfile.");
-    return NULL;
+    return BLOSC2_ERROR_FILE_OPEN;
   }
   blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
   if (io_cb == NULL) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
-    return NULL;
+    return BLOSC2_ERROR_PLUGIN_IO;
   }
   int64_t io_pos = 0;
   int64_t wbytes = io_cb->write(chunk, 1, cbytes, io_pos, fpc);
   io_cb->close(fpc);
   if (wbytes != cbytes) {
     BLOSC_TRACE_ERROR("Cannot write the full chunk.");
-    return NULL;
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  rc = frame_mark_dirty(frame, nchunk);
+  if (rc < 0) {
+    return rc;
   }
 
-  return frame;
+  return nchunk;
 }
 
-/* Append an existing chunk into a sparse frame. */
-int sframe_delete_chunk(const char *urlpath, int64_t nchunk) {
-  char* chunk_path = sframe_make_chunk_path(urlpath, nchunk);
+/* Delete a chunk from a sparse frame. */
+int sframe_delete_chunk(blosc2_frame_s* frame, int64_t offset) {
+  if (frame->packed) {
+    // Its bytes stay in the segment until blosc2_schunk_compact()
+    return 0;
+  }
+  // A new chunk file could reuse the name, and the cached handle would still read the old one
+  sframe_invalidate_chunks(frame, offset);
+  int rc = journal_save(frame, offset, 0, INT64_MAX);
+  if (rc < 0) {
+    return rc;
+  }
+  char* chunk_path = sframe_make_file_path(frame->urlpath, offset, "chunk");
   if (chunk_path) {
-    int rc = remove(chunk_path);
+    rc = remove(chunk_path);
     free(chunk_path);
     return rc;
   }
@@ -153,26 +521,45 @@ int sframe_delete_chunk(const char *urlpath, int64_t nchunk) {
 }
 
 /* Get chunk from sparse frame. */
-int32_t sframe_get_chunk(blosc2_frame_s* frame, int64_t nchunk, uint8_t** chunk, bool* needs_free){
-  void *fpc = sframe_open_chunk(frame->urlpath, nchunk, "rb", frame->schunk->storage->io);
-  if(fpc == NULL){
-    BLOSC_TRACE_ERROR("Cannot open the chunkfile.");
-    return BLOSC2_ERROR_FILE_OPEN;
-  }
-
+int32_t sframe_get_chunk(blosc2_frame_s* frame, int64_t offset, uint8_t** chunk, bool* needs_free){
   blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
   if (io_cb == NULL) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
     return BLOSC2_ERROR_PLUGIN_IO;
   }
 
-  int64_t chunk_cbytes = io_cb->size(fpc);
+  int64_t io_pos;
+  void *fpc = sframe_acquire_chunk(frame, offset, frame->schunk->storage->io, &io_pos);
+  if(fpc == NULL){
+    BLOSC_TRACE_ERROR("Cannot open the chunkfile.");
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+
+  int64_t chunk_cbytes;
+  if (frame->packed) {
+    // The size is in the header of the chunk
+    uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
+    uint8_t* header_ptr = header;
+    int64_t rbytes = io_cb->read((void**)&header_ptr, 1, BLOSC_EXTENDED_HEADER_LENGTH, io_pos, fpc);
+    int32_t cbytes_ = 0;
+    if (rbytes != BLOSC_EXTENDED_HEADER_LENGTH ||
+        blosc2_cbuffer_sizes(header_ptr, NULL, &cbytes_, NULL) < 0) {
+      cbytes_ = 0;
+    }
+    if (io_cb->is_allocation_necessary && header_ptr != header) {
+      free(header_ptr);
+    }
+    chunk_cbytes = cbytes_;
+  }
+  else {
+    chunk_cbytes = io_cb->size(fpc);
+  }
   if (chunk_cbytes < BLOSC_MIN_HEADER_LENGTH) {
     // A valid chunk file always starts with a Blosc header; a smaller (e.g. empty)
     // file means the on-disk state changed under us (another handle replaced this
     // chunk) or the file is corrupted.  Fail the same way as frame_get_lazychunk().
     BLOSC_TRACE_ERROR("Chunkfile is too small to contain a valid chunk.");
-    io_cb->close(fpc);
+    sframe_release_chunk(frame, io_cb, fpc);
     return BLOSC2_ERROR_FILE_READ;
   }
 
@@ -184,9 +571,8 @@ int32_t sframe_get_chunk(blosc2_frame_s* frame, int64_t nchunk, uint8_t** chunk,
     *needs_free = false;
   }
 
-  int64_t io_pos = 0;
   int64_t rbytes = io_cb->read((void**)chunk, 1, chunk_cbytes, io_pos, fpc);
-  io_cb->close(fpc);
+  sframe_release_chunk(frame, io_cb, fpc);
   if (rbytes != chunk_cbytes) {
     BLOSC_TRACE_ERROR("Cannot read the chunk out of the chunkfile.");
     return BLOSC2_ERROR_FILE_READ;
@@ -194,3 +580,138 @@ int32_t sframe_get_chunk(blosc2_frame_s* frame, int64_t nchunk, uint8_t** chunk,
 
   return (int32_t)chunk_cbytes;
 }
+
+/* The size of segment file @p segment, or -1 if there is none */
+static int64_t sframe_segment_size(const char* urlpath, int64_t segment) {
+  char* segment_path = sframe_make_file_path(urlpath, segment, "segment");
+  if (segment_path == NULL) {
+    return -1;
+  }
+  struct stat st;
+  int64_t size = stat(segment_path, &st) == 0 ? (int64_t)st.st_size : -1;
+  free(segment_path);
+  return size;
+}
+
+/* See sframe.h */
+int64_t sframe_compact_chunks(blosc2_frame_s* frame, int64_t* offsets, int64_t nchunks, int64_t* nsegments) {
+  // The copies go to segments past every existing one, including those that
+  // only hold unreferenced chunks
+  int64_t top = -1;
+  for (int64_t i = 0; i < nchunks; i++) {
+    if (offsets[i] >= 0 && SFRAME_SEGMENT(offsets[i]) > top) {
+      top = SFRAME_SEGMENT(offsets[i]);
+    }
+  }
+  blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+  sframe_handles* handles = sframe_get_handles(frame);
+  if (handles != NULL && handles->wsegment > top) {
+    top = handles->wsegment;
+  }
+  blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+  if (handles == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  while (top < SFRAME_SEGMENT_MAX && sframe_segment_size(frame->urlpath, top + 1) >= 0) {
+    top++;
+  }
+  *nsegments = top + 1;
+
+  int64_t wbytes = 0;
+  bool first = true;
+  for (int64_t i = 0; i < nchunks; i++) {
+    if (offsets[i] < 0) {
+      continue;
+    }
+    uint8_t* chunk;
+    bool needs_free;
+    int32_t cbytes = sframe_get_chunk(frame, offsets[i], &chunk, &needs_free);
+    if (cbytes < 0) {
+      return cbytes;
+    }
+    if (first) {
+      blosc2_pthread_mutex_lock(&frame->read_fp_mutex);
+      handles->wsegment = top;
+      blosc2_pthread_mutex_unlock(&frame->read_fp_mutex);
+    }
+    int64_t offset = sframe_append_segment(frame, chunk, 0, cbytes, first);
+    if (needs_free) {
+      free(chunk);
+    }
+    if (offset < 0) {
+      return offset;
+    }
+    offsets[i] = offset;
+    wbytes += cbytes;
+    first = false;
+  }
+
+  return wbytes;
+}
+
+/* See sframe.h */
+int64_t sframe_remove_segments(blosc2_frame_s* frame, int64_t nsegments) {
+  sframe_invalidate_chunks(frame, -1);
+  int64_t nbytes = 0;
+  for (int64_t segment = 0; segment < nsegments; segment++) {
+    int64_t size = sframe_segment_size(frame->urlpath, segment);
+    if (size < 0) {
+      // Removed by an earlier compaction
+      continue;
+    }
+    char* segment_path = sframe_make_file_path(frame->urlpath, segment, "segment");
+    if (segment_path == NULL || remove(segment_path) != 0) {
+      BLOSC_TRACE_ERROR("Cannot remove segment %" PRId64 ".", segment);
+      free(segment_path);
+      return BLOSC2_ERROR_FILE_REMOVE;
+    }
+    free(segment_path);
+    nbytes += size;
+  }
+
+  return nbytes;
+}
+
+/* See sframe.h */
+int sframe_sync_files(blosc2_frame_s* frame, const int64_t* ids, int64_t nids) {
+  const blosc2_io* io = frame->schunk->storage->io;
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
+  blosc2_io_cb_ext *io_ext = blosc2_get_io_cb_ext(io->id);
+  if (io_cb == NULL || io_ext == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  if (io_ext->sync == NULL) {
+    return 0;
+  }
+  for (int64_t i = 0; i < nids; i++) {
+    char* file_path = sframe_make_file_path(frame->urlpath, ids[i], frame->packed ? "segment" : "chunk");
+    if (file_path == NULL) {
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    // Not sframe_open_id(): a file removed by a writer since is no error
+    void* fp = io_cb->open(file_path, "rb+", io->params);
+    free(file_path);
+    if (fp == NULL) {
+      continue;
+    }
+    int rc = io_ext->sync(fp);
+    io_cb->close(fp);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot sync file %" PRId64 " of the sparse frame.", ids[i]);
+      return BLOSC2_ERROR_FILE_WRITE;
+    }
+  }
+  // Writable handles, as Windows cannot flush the others
+  void* fp = sframe_open_index(frame->urlpath, "rb+", io);
+  if (fp == NULL) {
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+  int rc = io_ext->sync(fp);
+  io_cb->close(fp);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot sync the index of the sparse frame.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  return 0;
+}
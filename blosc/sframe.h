@@ -16,10 +16,76 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Packed sparse frames keep their chunks in append-only segment files, and
+ * the offsets index holds the segment in the upper bits of an entry and the
+ * position of the chunk in it in the lower SFRAME_SEGMENT_SHIFT ones. */
+#define SFRAME_SEGMENT_SHIFT 40
+#define SFRAME_SEGMENT_POS_MAX (((int64_t)1 << SFRAME_SEGMENT_SHIFT) - 1)
+#define SFRAME_SEGMENT_MAX (((int64_t)1 << (63 - SFRAME_SEGMENT_SHIFT)) - 1)
+#define SFRAME_SEGMENT(offset) ((offset) >> SFRAME_SEGMENT_SHIFT)
+#define SFRAME_SEGMENT_POS(offset) ((offset) & SFRAME_SEGMENT_POS_MAX)
+#define SFRAME_PACKED_OFFSET(segment, pos) (((segment) << SFRAME_SEGMENT_SHIFT) | (pos))
+/* Size from where appends go on with a new segment */
+#define SFRAME_SEGMENT_MAXLEN ((int64_t)1 << 30)
+
+/* The paths of the index file, and of file nfile (with the "chunk" or
+ * "segment" extension), of the sparse frame in urlpath; to be freed. */
+char* sframe_make_index_path(const char* urlpath);
+char* sframe_make_file_path(const char* urlpath, int64_t nfile, const char* ext);
 void* sframe_open_index(const char* urlpath, const char* mode, const blosc2_io *io);
 void* sframe_open_chunk(const char* urlpath, int64_t nchunk, const char* mode, const blosc2_io *io);
-int sframe_delete_chunk(const char* urlpath, int64_t nchunk);
-void* sframe_create_chunk(blosc2_frame_s* frame, uint8_t* chunk, int64_t nchunk, int64_t cbytes);
-int32_t sframe_get_chunk(blosc2_frame_s* frame, int64_t nchunk, uint8_t** chunk, bool* needs_free);
+int sframe_delete_chunk(blosc2_frame_s* frame, int64_t offset);
+
+/**
+ * @brief Store a chunk in a sparse frame.
+ *
+ * @param nchunk The id for a chunk file of its own, i.e. one past the largest
+ * offset in the index (for packed frames, the segment appended to is found
+ * out from it when not known yet).
+ *
+ * @return The offset of the chunk for the offsets index, or a negative error code.
+ */
+int64_t sframe_create_chunk(blosc2_frame_s* frame, uint8_t* chunk, int64_t nchunk, int64_t cbytes);
+int32_t sframe_get_chunk(blosc2_frame_s* frame, int64_t offset, uint8_t** chunk, bool* needs_free);
+
+/**
+ * @brief Get an open "rb" handle for the file of the chunk at @p offset of the
+ * offsets index, and the position of the chunk in it in @p chunk_pos.  The
+ * handles are kept in a small per-frame LRU (see sframe.c), under the same
+ * conditions as frame_reader_acquire(); give them back with
+ * sframe_release_chunk() (or frame_reader_release(), which forwards there).
+ *
+ * @return The handle, or NULL if it could not be opened.
+ */
+void* sframe_acquire_chunk(blosc2_frame_s* frame, int64_t offset, const blosc2_io* io, int64_t* chunk_pos);
+void sframe_release_chunk(blosc2_frame_s* frame, const blosc2_io_cb* io_cb, void* fp);
+
+/**
+ * @brief Drop the cached handles of chunk (or segment) file @p id, or all of
+ * them, together with the append state of packed frames, if @p id is negative.
+ * Handles checked out are closed on their last release.
+ */
+void sframe_invalidate_chunks(blosc2_frame_s* frame, int64_t id);
+void sframe_free_handles(blosc2_frame_s* frame);
+
+/**
+ * @brief Copy the chunks referenced by @p offsets of a packed frame into new
+ * segments, updating @p offsets to point there.  Then the segments below
+ * @p nsegments only hold stale copies, and can go with
+ * sframe_remove_segments() once the new index is written.
+ *
+ * @return The bytes copied, or a negative error code.
+ */
+int64_t sframe_compact_chunks(blosc2_frame_s* frame, int64_t* offsets, int64_t nchunks, int64_t* nsegments);
+int64_t sframe_remove_segments(blosc2_frame_s* frame, int64_t nsegments);
+
+/**
+ * @brief Sync the chunk (or segment) files @p ids and the index of a sparse
+ * frame with the `sync` callback of its I/O backend.  Files that are gone
+ * (deleted or compacted away since) are skipped.
+ *
+ * @return 0 if succeeds; a negative error code otherwise.
+ */
+int sframe_sync_files(blosc2_frame_s* frame, const int64_t* ids, int64_t nids);
 
 #endif /* BLOSC_SFRAME_H */
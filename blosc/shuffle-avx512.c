@@ -0,0 +1,264 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "shuffle-avx512.h"
+#include "shuffle-avx2.h"
+#include "shuffle-generic.h"
+#include <stdlib.h>
+
+/* Make sure AVX512F and AVX512BW are available for the compilation target and compiler. */
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+
+#include <immintrin.h>
+
+#include <stdint.h>
+
+/* Every routine below handles 64 elements (one ZMM register per byte of the
+   type) per iteration.  Bytes are first regrouped inside the 128-bit lanes
+   with shuffle_epi8, then moved across lanes and registers. */
+
+/* Byte masks for _mm512_shuffle_epi8, the same for each 128-bit lane.
+   Gathers byte k of 8 (2-byte), 4 (4-byte) or 2 (8-byte) elements together. */
+static const uint8_t shmask2[16] = {0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15};
+static const uint8_t shmask4[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+static const uint8_t shmask8[16] = {0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15};
+
+/* Cross-lane permutation for 4-byte types: dword k of lane l goes to lane k */
+static const uint32_t permute4[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+
+/* Cross-lane permutation for 8-byte types: word k of lane l goes to quad word k */
+static const uint16_t permute8[32] = {
+    0, 8, 16, 24, 1, 9, 17, 25, 2, 10, 18, 26, 3, 11, 19, 27,
+    4, 12, 20, 28, 5, 13, 21, 29, 6, 14, 22, 30, 7, 15, 23, 31};
+
+/* Quad word selections merging two registers for 2-byte types */
+static const uint64_t even_qwords[8] = {0, 2, 4, 6, 8, 10, 12, 14};
+static const uint64_t odd_qwords[8] = {1, 3, 5, 7, 9, 11, 13, 15};
+
+
+static inline __m512i load_lane_mask(const uint8_t* mask) {
+  return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)mask));
+}
+
+/* Transpose the 128-bit lanes of four registers: lane k of register i goes
+   to lane i of register k. */
+static inline void transpose_lanes(__m512i* a, __m512i* b, __m512i* c, __m512i* d) {
+  const __m512i t0 = _mm512_shuffle_i64x2(*a, *b, 0x44);
+  const __m512i t1 = _mm512_shuffle_i64x2(*a, *b, 0xee);
+  const __m512i t2 = _mm512_shuffle_i64x2(*c, *d, 0x44);
+  const __m512i t3 = _mm512_shuffle_i64x2(*c, *d, 0xee);
+  *a = _mm512_shuffle_i64x2(t0, t2, 0x88);
+  *b = _mm512_shuffle_i64x2(t0, t2, 0xdd);
+  *c = _mm512_shuffle_i64x2(t1, t3, 0x88);
+  *d = _mm512_shuffle_i64x2(t1, t3, 0xdd);
+}
+
+/* Transpose an 8x8 matrix of quad words held in 8 registers. */
+static inline void transpose8x8_epi64(__m512i* zmm) {
+  __m512i t[8];
+  int k;
+  for (k = 0; k < 4; k++) {
+    t[k * 2] = _mm512_unpacklo_epi64(zmm[k * 2], zmm[k * 2 + 1]);
+    t[k * 2 + 1] = _mm512_unpackhi_epi64(zmm[k * 2], zmm[k * 2 + 1]);
+  }
+  transpose_lanes(&t[0], &t[2], &t[4], &t[6]);
+  transpose_lanes(&t[1], &t[3], &t[5], &t[7]);
+  for (k = 0; k < 8; k++) {
+    zmm[k] = t[k];
+  }
+}
+
+/* Transpose, inside every 128-bit lane, the 16x16 byte matrix made of the
+   same lane of 16 registers (four rounds of a perfect shuffle). */
+static inline void transpose16x16_epi8(__m512i* zmm) {
+  __m512i t[16];
+  int k, round;
+  for (round = 0; round < 4; round++) {
+    for (k = 0; k < 8; k++) {
+      t[k * 2] = _mm512_unpacklo_epi8(zmm[k], zmm[k + 8]);
+      t[k * 2 + 1] = _mm512_unpackhi_epi8(zmm[k], zmm[k + 8]);
+    }
+    for (k = 0; k < 16; k++) {
+      zmm[k] = t[k];
+    }
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 2 bytes. */
+static void
+shuffle2_avx512(uint8_t* const dest, const uint8_t* const src,
+                const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 2;
+  int32_t j;
+  int k;
+  __m512i zmm[2];
+  const __m512i shmask = load_lane_mask(shmask2);
+  const __m512i even = _mm512_loadu_si512(even_qwords);
+  const __m512i odd = _mm512_loadu_si512(odd_qwords);
+
+  for (j = 0; j < vectorizable_elements; j += sizeof(__m512i)) {
+    /* Fetch 64 elements (128 bytes) and group their bytes in quad words */
+    for (k = 0; k < 2; k++) {
+      zmm[k] = _mm512_loadu_si512(src + (j * bytesoftype) + (k * sizeof(__m512i)));
+      zmm[k] = _mm512_shuffle_epi8(zmm[k], shmask);
+    }
+    /* Store the result vectors */
+    uint8_t* const dest_for_jth_element = dest + j;
+    _mm512_storeu_si512(dest_for_jth_element, _mm512_permutex2var_epi64(zmm[0], even, zmm[1]));
+    _mm512_storeu_si512(dest_for_jth_element + total_elements,
+                        _mm512_permutex2var_epi64(zmm[0], odd, zmm[1]));
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 4 bytes. */
+static void
+shuffle4_avx512(uint8_t* const dest, const uint8_t* const src,
+                const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 4;
+  int32_t j;
+  int k;
+  __m512i zmm[4];
+  const __m512i shmask = load_lane_mask(shmask4);
+  const __m512i permute = _mm512_loadu_si512(permute4);
+
+  for (j = 0; j < vectorizable_elements; j += sizeof(__m512i)) {
+    /* Fetch 64 elements (256 bytes) and gather byte k of each register in lane k */
+    for (k = 0; k < 4; k++) {
+      zmm[k] = _mm512_loadu_si512(src + (j * bytesoftype) + (k * sizeof(__m512i)));
+      zmm[k] = _mm512_shuffle_epi8(zmm[k], shmask);
+      zmm[k] = _mm512_permutexvar_epi32(permute, zmm[k]);
+    }
+    transpose_lanes(&zmm[0], &zmm[1], &zmm[2], &zmm[3]);
+    /* Store the result vectors */
+    uint8_t* const dest_for_jth_element = dest + j;
+    for (k = 0; k < 4; k++) {
+      _mm512_storeu_si512(dest_for_jth_element + (k * total_elements), zmm[k]);
+    }
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 8 bytes. */
+static void
+shuffle8_avx512(uint8_t* const dest, const uint8_t* const src,
+                const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 8;
+  int32_t j;
+  int k;
+  __m512i zmm[8];
+  const __m512i shmask = load_lane_mask(shmask8);
+  const __m512i permute = _mm512_loadu_si512(permute8);
+
+  for (j = 0; j < vectorizable_elements; j += sizeof(__m512i)) {
+    /* Fetch 64 elements (512 bytes) and gather byte k of each register in quad word k */
+    for (k = 0; k < 8; k++) {
+      zmm[k] = _mm512_loadu_si512(src + (j * bytesoftype) + (k * sizeof(__m512i)));
+      zmm[k] = _mm512_shuffle_epi8(zmm[k], shmask);
+      zmm[k] = _mm512_permutexvar_epi16(permute, zmm[k]);
+    }
+    transpose8x8_epi64(zmm);
+    /* Store the result vectors */
+    uint8_t* const dest_for_jth_element = dest + j;
+    for (k = 0; k < 8; k++) {
+      _mm512_storeu_si512(dest_for_jth_element + (k * total_elements), zmm[k]);
+    }
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 16 bytes. */
+static void
+shuffle16_avx512(uint8_t* const dest, const uint8_t* const src,
+                 const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 16;
+  int32_t j;
+  int k;
+  __m512i zmm0[16], zmm1[16];
+
+  for (j = 0; j < vectorizable_elements; j += sizeof(__m512i)) {
+    /* Fetch 64 elements (1024 bytes) into 16 ZMM registers... */
+    for (k = 0; k < 16; k++) {
+      zmm0[k] = _mm512_loadu_si512(src + (j * bytesoftype) + (k * sizeof(__m512i)));
+    }
+    /* ...so that lane l of register k holds element 16 * l + k */
+    for (k = 0; k < 4; k++) {
+      transpose_lanes(&zmm0[k], &zmm0[k + 4], &zmm0[k + 8], &zmm0[k + 12]);
+    }
+    for (k = 0; k < 16; k++) {
+      zmm1[k] = zmm0[(k % 4) * 4 + k / 4];
+    }
+    transpose16x16_epi8(zmm1);
+    /* Store the result vectors */
+    uint8_t* const dest_for_jth_element = dest + j;
+    for (k = 0; k < 16; k++) {
+      _mm512_storeu_si512(dest_for_jth_element + (k * total_elements), zmm1[k]);
+    }
+  }
+}
+
+/* Shuffle a block.  This can never fail. */
+void
+shuffle_avx512(const int32_t bytesoftype, const int32_t blocksize,
+               const uint8_t *_src, uint8_t *_dest) {
+  const int32_t vectorized_chunk_size = bytesoftype * (int32_t)sizeof(__m512i);
+
+  /* Type sizes without a 512-bit kernel, and blocks too small to be
+     vectorized with them, go to the AVX2 implementation (which falls
+     back to the generic one when needed). */
+  if ((bytesoftype != 2 && bytesoftype != 4 && bytesoftype != 8 && bytesoftype != 16) ||
+      blocksize < vectorized_chunk_size) {
+    shuffle_avx2(bytesoftype, blocksize, _src, _dest);
+    return;
+  }
+
+  /* If the blocksize is not a multiple of both the typesize and
+     the vector size, round the blocksize down to the next value
+     which is a multiple of both. The vectorized shuffle can be
+     used for that portion of the data, and the naive implementation
+     can be used for the remaining portion. */
+  const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+
+  const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+  const int32_t total_elements = blocksize / bytesoftype;
+
+  /* Optimized shuffle implementations */
+  switch (bytesoftype) {
+    case 2:
+      shuffle2_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    case 4:
+      shuffle4_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    case 8:
+      shuffle8_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    default:
+      shuffle16_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+  }
+
+  /* If the buffer had any bytes at the end which couldn't be handled
+     by the vectorized implementations, use the non-optimized version
+     to finish them up. */
+  if (vectorizable_bytes < blocksize) {
+    shuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+  }
+}
+
+const bool is_shuffle_avx512 = true;
+
+#else /* defined(__AVX512F__) && defined(__AVX512BW__) */
+
+const bool is_shuffle_avx512 = false;
+
+void shuffle_avx512(const int32_t bytesoftype, const int32_t blocksize,
+                    const uint8_t *_src, uint8_t *_dest) {
+  abort();
+}
+
+#endif /* defined(__AVX512F__) && defined(__AVX512BW__) */
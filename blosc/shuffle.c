@@ -15,6 +15,7 @@
     the target architecture. Note that a target architecture may support
     more than one type of acceleration!*/
 #if defined(SHUFFLE_AVX512_ENABLED)
+  #include "shuffle-avx512.h"
   #include "bitshuffle-avx512.h"
 #endif  /* defined(SHUFFLE_AVX512_ENABLED) */
 
@@ -82,22 +83,13 @@ typedef struct shuffle_implementation {
   bitunshuffle_func bitunshuffle;
 } shuffle_implementation_t;
 
-typedef enum {
-  BLOSC_HAVE_NOTHING = 0,
-  BLOSC_HAVE_SSE2 = 1,
-  BLOSC_HAVE_AVX2 = 2,
-  BLOSC_HAVE_NEON = 4,
-  BLOSC_HAVE_ALTIVEC = 8,
-  BLOSC_HAVE_AVX512 = 16,
-} blosc_cpu_features;
-
 /* Detect hardware and set function pointers to the best shuffle/unshuffle
    implementations supported by the host processor. */
 #if (defined(SHUFFLE_AVX2_ENABLED) || defined(SHUFFLE_SSE2_ENABLED)) && \
     (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))  /* Intel/i686 */
 
 #if defined(HAVE_CPU_FEAT_INTRIN)
-static blosc_cpu_features blosc_get_cpu_features(void) {
+blosc_cpu_features blosc_get_cpu_features(void) {
   blosc_cpu_features cpu_features = BLOSC_HAVE_NOTHING;
   if (__builtin_cpu_supports("sse2")) {
     cpu_features |= BLOSC_HAVE_SSE2;
@@ -174,7 +166,7 @@ _xgetbv(uint32_t xcr) {
 #define _XCR_XFEATURE_ENABLED_MASK 0x0
 #endif
 
-static blosc_cpu_features blosc_get_cpu_features(void) {
+blosc_cpu_features blosc_get_cpu_features(void) {
   blosc_cpu_features result = BLOSC_HAVE_NOTHING;
   /* Holds the values of eax, ebx, ecx, edx set by the `cpuid` instruction */
   int32_t cpu_info[4];
@@ -265,7 +257,7 @@ static blosc_cpu_features blosc_get_cpu_features(void) {
 #endif /* HAVE_CPU_FEAT_INTRIN */
 
 #elif defined(SHUFFLE_NEON_ENABLED) /* ARM-NEON */
-static blosc_cpu_features blosc_get_cpu_features(void) {
+blosc_cpu_features blosc_get_cpu_features(void) {
   blosc_cpu_features cpu_features = BLOSC_HAVE_NOTHING;
 #if defined(__aarch64__)
   /* aarch64 always has NEON */
@@ -278,13 +270,15 @@ static blosc_cpu_features blosc_get_cpu_features(void) {
   return cpu_features;
 }
 #elif defined(SHUFFLE_ALTIVEC_ENABLED) /* POWER9-ALTIVEC preliminary test*/
-static blosc_cpu_features blosc_get_cpu_features(void) {
+blosc_cpu_features blosc_get_cpu_features(void) {
   blosc_cpu_features cpu_features = BLOSC_HAVE_NOTHING;
   cpu_features |= BLOSC_HAVE_ALTIVEC;
   return cpu_features;
 }
 #else   /* No hardware acceleration supported for the target architecture. */
-
+blosc_cpu_features blosc_get_cpu_features(void) {
+  return BLOSC_HAVE_NOTHING;
+}
 #endif /* defined(SHUFFLE_AVX2_ENABLED) || defined(SHUFFLE_SSE2_ENABLED) */
 
 static shuffle_implementation_t get_shuffle_implementation(void) {
@@ -292,10 +286,11 @@ static shuffle_implementation_t get_shuffle_implementation(void) {
   blosc_cpu_features cpu_features = blosc_get_cpu_features();
 #endif
 #if defined(SHUFFLE_AVX512_ENABLED)
-  if (cpu_features & BLOSC_HAVE_AVX512 && is_shuffle_avx2 && is_bshuf_AVX512) {
+  if (cpu_features & BLOSC_HAVE_AVX512 && is_shuffle_avx512 && is_shuffle_avx2 && is_bshuf_AVX512) {
     shuffle_implementation_t impl_avx512;
     impl_avx512.name = "avx512";
-    impl_avx512.shuffle = (shuffle_func)shuffle_avx2;
+    impl_avx512.shuffle = (shuffle_func)shuffle_avx512;
+    /* The AVX2 unshuffle is as fast as a 512-bit one */
     impl_avx512.unshuffle = (unshuffle_func)unshuffle_avx2;
     impl_avx512.bitshuffle = (bitshuffle_func) bshuf_trans_bit_elem_AVX512;
     impl_avx512.bitunshuffle = (bitunshuffle_func)bshuf_untrans_bit_elem_AVX512;
@@ -23,6 +23,21 @@
 
 #include <stdint.h>
 
+typedef enum {
+  BLOSC_HAVE_NOTHING = 0,
+  BLOSC_HAVE_SSE2 = 1,
+  BLOSC_HAVE_AVX2 = 2,
+  BLOSC_HAVE_NEON = 4,
+  BLOSC_HAVE_ALTIVEC = 8,
+  BLOSC_HAVE_AVX512 = 16,
+} blosc_cpu_features;
+
+/**
+  Detect the hardware features of the host processor.  Other filters use
+  this to choose their accelerated routines the same way shuffle does.
+ */
+BLOSC_NO_EXPORT blosc_cpu_features blosc_get_cpu_features(void);
+
 /**
   Internal bitunshuffle routine that accepts a format version.
   We don't have to expose this parameter to users, since the public API is new to blosc2, and its
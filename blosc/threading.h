@@ -39,6 +39,7 @@
 #endif
 
 #include "windows.h"
+#include <stdint.h>
 
 /*
  * Defines that adapt Windows API threads to pthreads API
@@ -49,6 +50,8 @@
 #define blosc2_pthread_mutex_destroy(a) DeleteCriticalSection((a))
 #define blosc2_pthread_mutex_lock EnterCriticalSection
 #define blosc2_pthread_mutex_unlock LeaveCriticalSection
+/* Critical sections are always recursive */
+#define blosc2_pthread_mutex_init_recursive(a) (InitializeCriticalSection((a)), 0)
 
 /*
  * Use native Windows condition variables to match pthread condvar semantics
@@ -61,6 +64,8 @@ int blosc2_pthread_cond_destroy(blosc2_pthread_cond_t *cond);
 int blosc2_pthread_cond_wait(blosc2_pthread_cond_t *cond, CRITICAL_SECTION *mutex);
 int blosc2_pthread_cond_signal(blosc2_pthread_cond_t *cond);
 int blosc2_pthread_cond_broadcast(blosc2_pthread_cond_t *cond);
+/* Like cond_wait, but gives up after `ms` milliseconds (returning non-zero) */
+int blosc2_pthread_cond_timedwait_ms(blosc2_pthread_cond_t *cond, CRITICAL_SECTION *mutex, int64_t ms);
 
 /*
  * Simple thread creation implementation using pthread API
@@ -85,6 +90,8 @@ int blosc2_pthread_join_impl(blosc2_pthread_t *thread, void **value_ptr);
 #else /* not _WIN32 */
 
 #include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 
 #define blosc2_pthread_mutex_t pthread_mutex_t
 #define blosc2_pthread_mutex_init(a, b) pthread_mutex_init((a), (b))
@@ -99,6 +106,29 @@ int blosc2_pthread_join_impl(blosc2_pthread_t *thread, void **value_ptr);
 #define blosc2_pthread_cond_signal(a) pthread_cond_signal((a))
 #define blosc2_pthread_cond_broadcast(a) pthread_cond_broadcast((a))
 
+static inline int blosc2_pthread_mutex_init_recursive(pthread_mutex_t *mutex) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  int rc = pthread_mutex_init(mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+  return rc;
+}
+
+/* Like cond_wait, but gives up after `ms` milliseconds (returning ETIMEDOUT) */
+static inline int blosc2_pthread_cond_timedwait_ms(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                                                   int64_t ms) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += (time_t)(ms / 1000);
+  ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+  if (ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+  }
+  return pthread_cond_timedwait(cond, mutex, &ts);
+}
+
 #define blosc2_pthread_t pthread_t
 #define blosc2_pthread_create(a, b, c, d) pthread_create((a), (b), (c), (d))
 #define blosc2_pthread_join(a, b) pthread_join((a), (b))
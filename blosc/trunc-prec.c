@@ -66,7 +66,11 @@ int truncate_precision64(int8_t prec_bits, int32_t nelems,
   return 0;
 }
 
-/* Apply the truncate precision to src.  This can never fail. */
+/* Apply the truncate precision to src.  This can never fail.
+
+   The masking loops above are plain enough for compilers to vectorize them,
+   and they run at memory speed already (see bench/trunc_prec_schunk.c), so
+   there are no hand-written SIMD versions of them. */
 int truncate_precision(int8_t prec_bits, int32_t typesize, int32_t nbytes,
                        const uint8_t* src, uint8_t* dest) {
   // Positive values of prec_bits will set absolute precision bits, whereas negative
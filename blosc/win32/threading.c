@@ -101,6 +101,12 @@ int blosc2_pthread_cond_wait(pthread_cond_t *cond, CRITICAL_SECTION *mutex)
 	return SleepConditionVariableCS(cond, mutex, INFINITE) ? 0 : (int)GetLastError();
 }
 
+int blosc2_pthread_cond_timedwait_ms(pthread_cond_t *cond, CRITICAL_SECTION *mutex, int64_t ms)
+{
+	DWORD timeout = ms >= (int64_t)INFINITE ? INFINITE - 1 : (DWORD)ms;
+	return SleepConditionVariableCS(cond, mutex, timeout) ? 0 : (int)GetLastError();
+}
+
 int blosc2_pthread_cond_signal(pthread_cond_t *cond)
 {
 	WakeConditionVariable(cond);
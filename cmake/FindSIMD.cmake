@@ -20,6 +20,14 @@ if(CMAKE_SYSTEM_NAME MATCHES "Linux")
       set(AVX2_FOUND false CACHE BOOL "AVX2 available on host")
    endif()
 
+   string(REGEX REPLACE "^.*(avx512bw).*$" "\\1" SSE_THERE "${CPUINFO}")
+   string(COMPARE EQUAL "avx512bw" "${SSE_THERE}" AVX512_TRUE)
+   if(AVX512_TRUE)
+      set(AVX512_FOUND true CACHE BOOL "AVX512 available on host")
+   else()
+      set(AVX512_FOUND false CACHE BOOL "AVX512 available on host")
+   endif()
+
 elseif(CMAKE_SYSTEM_NAME MATCHES "Darwin")
    execute_process(COMMAND /usr/sbin/sysctl -a OUTPUT_VARIABLE CPUINFO_ALL)
    string(REGEX MATCH ".*machdep.cpu.features.*" CPUINFO "${CPUINFO_ALL}")
@@ -40,14 +48,24 @@ elseif(CMAKE_SYSTEM_NAME MATCHES "Darwin")
       set(AVX2_FOUND false CACHE BOOL "AVX2 available on host")
    endif()
 
+   string(REGEX REPLACE "^.*(AVX512BW).*$" "\\1" SSE_THERE "${CPUINFO}")
+   string(COMPARE EQUAL "AVX512BW" "${SSE_THERE}" AVX512_TRUE)
+   if(AVX512_TRUE)
+      set(AVX512_FOUND true CACHE BOOL "AVX512 available on host")
+   else()
+      set(AVX512_FOUND false CACHE BOOL "AVX512 available on host")
+   endif()
+
    unset(CPUINFO_ALL)
 elseif(CMAKE_SYSTEM_NAME MATCHES "Windows")
    # TODO.  For now supposing SSE2 is safe enough
    set(SSE2_FOUND true  CACHE BOOL "SSE2 available on host")
    set(AVX2_FOUND false CACHE BOOL "AVX2 available on host")
+   set(AVX512_FOUND false CACHE BOOL "AVX512 available on host")
 else()
    set(SSE2_FOUND true  CACHE BOOL "SSE2 available on host")
    set(AVX2_FOUND false CACHE BOOL "AVX2 available on host")
+   set(AVX512_FOUND false CACHE BOOL "AVX512 available on host")
 endif()
 
 if(NOT SSE2_FOUND)
@@ -56,5 +74,8 @@ endif()
 if(NOT AVX2_FOUND)
    message(STATUS "Could not find hardware support for AVX2 on this machine.")
 endif()
+if(NOT AVX512_FOUND)
+   message(STATUS "Could not find hardware support for AVX512 on this machine.")
+endif()
 
-mark_as_advanced(SSE2_FOUND AVX2_FOUND)
+mark_as_advanced(SSE2_FOUND AVX2_FOUND AVX512_FOUND)
@@ -57,6 +57,9 @@ extern "C" {
  */
 #define DTYPE_NUMPY_FORMAT 0
 
+/* The default memory budget (in bytes) of b2nd_rechunk() and b2nd_copy() */
+#define B2ND_DEFAULT_RECHUNK_MEMORY (128 * 1024 * 1024)
+
 /* The default data type */
 #define B2ND_DEFAULT_DTYPE "|u1"
 /* The default data format */
@@ -472,6 +475,32 @@ BLOSC_EXPORT int b2nd_set_slice_cbuffer(const void *buffer, const int64_t *buffe
  */
 BLOSC_EXPORT int b2nd_copy(b2nd_context_t *ctx, const b2nd_array_t *src, b2nd_array_t **array);
 
+/**
+ * @brief Make a copy of the array data with a new chunkshape and/or blockshape.
+ *
+ * The output chunks are produced in order, and appended to the new array (streaming them to
+ * disk for persistent arrays) in batches that fit in @p memory_budget together with the data
+ * they are made of.  The source is read in slabs matching those batches, so each source chunk
+ * is decompressed about once (just once when the budget can hold whole source chunks).
+ * The threads of the source and destination arrays are used for reading and compressing the
+ * chunks of every batch in parallel.
+ *
+ * @param ctx The b2nd context for the new array, with the new chunkshape and blockshape.
+ * @param src The array from which data is copied.
+ * @param memory_budget The approximate memory (in bytes) to use for staging data.  A
+ *   non-positive value means #B2ND_DEFAULT_RECHUNK_MEMORY.  At least one output chunk is always
+ *   staged, regardless of the budget.
+ * @param array The memory pointer where the array will be created.
+ *
+ * @return An error code
+ *
+ * @note This is what b2nd_copy() does, with #B2ND_DEFAULT_RECHUNK_MEMORY, when the chunkshape
+ * or blockshape change.  The ndim and shape in ctx will be overwritten by the src ctx.
+ *
+ */
+BLOSC_EXPORT int b2nd_rechunk(b2nd_context_t *ctx, const b2nd_array_t *src, int64_t memory_budget,
+                              b2nd_array_t **array);
+
 /**
  * @brief Concatenate arrays. The result is stored in a new b2nd array, or an enlarged one.
  *
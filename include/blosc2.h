@@ -133,6 +133,8 @@ enum {
      3 -> Blosc 2-alpha.x series
      4 -> Blosc 2.x beta.1 series
      5 -> Blosc 2.x stable series
+     6 -> Blosc 2.x chunks with variable-length blocks
+     7 -> Blosc 2.x chunks using the dictionary of their super-chunk
      */
   BLOSC1_VERSION_FORMAT_PRE1 = 1,
   BLOSC1_VERSION_FORMAT = 2,
@@ -140,8 +142,9 @@ enum {
   BLOSC2_VERSION_FORMAT_BETA1 = 4,
   BLOSC2_VERSION_FORMAT_STABLE = 5,
   BLOSC2_VERSION_FORMAT_VL_BLOCKS = 6,
+  BLOSC2_VERSION_FORMAT_SCHUNK_DICT = 7,
   /* Highest chunk format version supported by this library. */
-  BLOSC2_VERSION_FORMAT = BLOSC2_VERSION_FORMAT_VL_BLOCKS,
+  BLOSC2_VERSION_FORMAT = BLOSC2_VERSION_FORMAT_SCHUNK_DICT,
 };
 
 
@@ -291,6 +294,7 @@ enum {
  */
 enum {
   BLOSC2_VL_BLOCKS = 0x1,        //!< chunk uses variable-length blocks
+  BLOSC2_SCHUNK_DICT = 0x2,      //!< chunk uses the dictionary of its super-chunk
 };
 
 /**
@@ -994,7 +998,8 @@ BLOSC_EXPORT const char* blosc2_cbuffer_complib(const void* cbuffer);
 enum {
   BLOSC2_IO_FILESYSTEM = 0,
   BLOSC2_IO_FILESYSTEM_MMAP = 1,
-  BLOSC_IO_LAST_BLOSC_DEFINED = 2,  // sentinel
+  BLOSC2_IO_FILESYSTEM_URING = 2,
+  BLOSC_IO_LAST_BLOSC_DEFINED = 3,  // sentinel
   BLOSC_IO_LAST_REGISTERED = 32,  // sentinel
 };
 
@@ -1012,6 +1017,22 @@ typedef int64_t (*blosc2_read_cb)(void **ptr, int64_t size, int64_t nitems, int6
 typedef int     (*blosc2_truncate_cb)(void *stream, int64_t size);
 typedef int     (*blosc2_destroy_cb)(void *params);
 
+/**
+ * @brief A range of bytes to read by a #blosc2_readv_cb callback.
+ */
+typedef struct blosc2_io_range_s {
+  void *ptr;
+  //!< Where to read the range into (allocated by the caller).
+  int64_t size;
+  //!< The number of bytes in the range.
+  int64_t position;
+  //!< The position of the range in the stream.
+} blosc2_io_range;
+
+typedef int64_t (*blosc2_readv_cb)(const blosc2_io_range *ranges, int64_t nranges, void *stream);
+typedef int     (*blosc2_prefetch_cb)(const blosc2_io_range *ranges, int64_t nranges, void *stream);
+typedef int     (*blosc2_sync_cb)(void *stream);
+
 
 /*
  * Input/Output callbacks.
@@ -1041,6 +1062,29 @@ typedef struct {
 } blosc2_io_cb;
 
 
+/*
+ * Optional input/output callbacks.  They are registered apart from the #blosc2_io_cb ones (with
+ * blosc2_register_io_cb_ext()), so that backends written against older versions of this library
+ * keep working unchanged.  Zero-initialize the struct: the members left NULL are not used.
+ */
+typedef struct {
+  blosc2_readv_cb readv;
+  //!< The IO vectored read callback.  It reads a batch of ranges in one go, and returns the number of
+  //!< bytes read (the sum of the range sizes on success).  Blosc uses it for reading the blocks of lazy
+  //!< chunks with as few requests as possible.  Only used when the backend allocates the buffers
+  //!< (`is_allocation_necessary`); when NULL, the ranges are read one by one with the read callback.
+  blosc2_prefetch_cb prefetch;
+  //!< The IO prefetch callback.  A hint that the ranges are going to be read soon (their ptr members are
+  //!< not used).  It must not wait for the data, so that reading it overlaps with whatever the caller does
+  //!< next (e.g. decompressing the previous chunk).  Returns the number of ranges that have been hinted
+  //!< (or a negative value on errors, which are not fatal).
+  blosc2_sync_cb sync;
+  //!< The IO sync callback.  It makes the writes done so far to the file of the stream durable (e.g. with
+  //!< fdatasync), through any stream of the same file.  Returns 0 on success.  Without it, the durability
+  //!< policies of #blosc2_storage cannot do anything.
+} blosc2_io_cb_ext;
+
+
 /*
  * Input/Output parameters.
  */
@@ -1077,6 +1121,26 @@ BLOSC_EXPORT int blosc2_register_io_cb(const blosc2_io_cb *io);
  */
 BLOSC_EXPORT blosc2_io_cb *blosc2_get_io_cb(uint8_t id);
 
+/**
+ * @brief Register the optional callbacks of a user-defined input/output backend.
+ *
+ * @param id The id of the backend, which must have been registered with blosc2_register_io_cb().
+ * @param ext The optional callbacks (they replace the ones registered before, if any).
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_register_io_cb_ext(uint8_t id, const blosc2_io_cb_ext *ext);
+
+/**
+ * @brief Get the optional callbacks of an input/output backend.
+ *
+ * @param id The id of the backend.
+ *
+ * @return A pointer to the optional callbacks of the backend (all NULL if none have been registered).
+ * NULL if the backend is not registered.
+ */
+BLOSC_EXPORT blosc2_io_cb_ext *blosc2_get_io_cb_ext(uint8_t id);
+
 /*********************************************************************
   Structures and functions related with contexts.
 *********************************************************************/
@@ -1110,6 +1174,20 @@ typedef struct {
  */
 BLOSC_EXPORT int blosc2_register_tuner(blosc2_tuner *tuner);
 
+/**
+ * @brief The configuration of the built-in BTUNE tuner, to be passed as the
+ * @p tuner_params of #blosc2_cparams along with a @p tuner_id of BLOSC_BTUNE
+ * (see blosc2/tuners-registry.h).
+ *
+ * @note When the external blosc2_btune plugin is installed, it takes precedence
+ * over the built-in tuner and expects its own configuration instead.
+ */
+typedef struct {
+  float tradeoff;
+  //!< 0 optimizes for compression speed and 1 for compression ratio.  A negative
+  //!< value means the BTUNE_TRADEOFF environment variable (or 0.5 if not set).
+} blosc2_btune_config;
+
 
 /**
  * @brief The parameters for a prefilter function.
@@ -1208,6 +1286,12 @@ typedef struct {
   //!< User defined parameters for the codec
   void *filter_params[BLOSC2_MAX_FILTERS];
   //!< User defined parameters for the filters
+  int32_t dict_nchunks;
+  //!< When `use_dict` is set for a super-chunk, train a single dict out of its first
+  //!< `dict_nchunks` chunks and share it among all the next ones, instead of a dict per
+  //!< chunk (0).  The dict is stored in a reserved vlmetalayer of the super-chunk (not listed
+  //!< by the vlmeta API).  The chunks using it can only be decompressed through a super-chunk
+  //!< with that same dict, and adding them to a super-chunk with another one fails.
 } blosc2_cparams;
 
 /**
@@ -1219,7 +1303,7 @@ static const blosc2_cparams BLOSC2_CPARAMS_DEFAULTS = {
         {0, 0, 0, 0, 0, BLOSC_SHUFFLE},
         {0, 0, 0, 0, 0, 0},
         NULL, NULL, NULL, 0, 0,
-        NULL, {NULL, NULL, NULL, NULL, NULL, NULL}
+        NULL, {NULL, NULL, NULL, NULL, NULL, NULL}, 0
         };
 
 
@@ -1240,12 +1324,15 @@ typedef struct {
   //!< The postfilter parameters.
   int32_t typesize;
   //!< The type size (8).
+  int64_t cache_nbytes;
+  //!< The memory budget of the cache of decompressed chunks of the super-chunk
+  //!< (0, meaning no cache).  See blosc2_schunk_set_cache().
 } blosc2_dparams;
 
 /**
  * @brief Default struct for decompression params meant for user initialization.
  */
-static const blosc2_dparams BLOSC2_DPARAMS_DEFAULTS = {1, NULL, NULL, NULL, 8};
+static const blosc2_dparams BLOSC2_DPARAMS_DEFAULTS = {1, NULL, NULL, NULL, 8, 0};
 
 
 /**
@@ -1327,6 +1414,24 @@ BLOSC_EXPORT int blosc2_ctx_get_dparams(blosc2_context *ctx, blosc2_dparams *dpa
  */
 BLOSC_EXPORT int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblocks);
 
+/**
+ * @brief Give the scratch memory cached by a context back to the system.
+ *
+ * A context keeps the temporaries of its (de)compression calls (block
+ * buffers, block sizes of VL-block chunks, blocks of lazy chunks, masks...)
+ * around so that calls after the first one do not allocate memory.  Use this
+ * when a long-lived context has seen an unusually big chunk, or is going to
+ * stay idle for a while; the next call will allocate what it needs again.
+ *
+ * @param ctx The context to trim.  It must not be in use by another thread.
+ *
+ * @return The number of bytes freed.
+ *
+ * @note The temporaries of the threads of a shared pool belong to the pool
+ * and are not freed here.
+ */
+BLOSC_EXPORT int64_t blosc2_ctx_trim_scratch(blosc2_context *ctx);
+
 /**
  * @brief Compress a block of data in the @p src buffer and returns the size of
  * compressed block.
@@ -1750,10 +1855,30 @@ BLOSC_EXPORT int blosc2_getitem_bytes_ctx(blosc2_context* context, const void* s
 #define BLOSC2_MAX_VLMETALAYERS (8 * 1024)
 #define BLOSC2_VLMETALAYERS_NAME_MAXLEN BLOSC2_METALAYER_NAME_MAXLEN
 
+/**
+ * @brief Durability policies for disk-based frames (see
+ * #blosc2_storage.durability).
+ */
+enum {
+  BLOSC2_DURABILITY_NONE = 0,
+  //!< Leave flushing the writes to disk to the operating system (default).
+  BLOSC2_DURABILITY_ON_CLOSE = 1,
+  //!< Sync the files of the frame on blosc2_schunk_flush() and blosc2_schunk_free().
+  BLOSC2_DURABILITY_INTERVAL = 2,
+  //!< Also sync them in the background every `durability_every` milliseconds.
+  BLOSC2_DURABILITY_EVERY_OPS = 3,
+  //!< Commit the appends and sync the files once every `durability_every`
+  //!< mutating operations (group commit).
+};
+
 /**
  * @brief This struct is meant for holding storage parameters for a
  * for a blosc2 container, allowing to specify, for example, how to interpret
  * the contents included in the schunk.
+ *
+ * @note New members may be added at the end in future versions, so start from
+ * #BLOSC2_STORAGE_DEFAULTS (or blosc2_get_blosc2_storage_defaults()), or use a
+ * designated initializer, so that the members you do not set are zeroed.
  */
 typedef struct {
     bool contiguous;
@@ -1768,12 +1893,22 @@ typedef struct {
     //!< If NULL, sensible defaults are used depending on the context.
     blosc2_io *io;
     //!< Input/output backend.
+    bool packed;
+    //!< For sparse frames, whether many chunks share each file (append-only
+    //!< segments, see blosc2_schunk_compact()) instead of a file per chunk.
+    uint8_t durability;
+    //!< For disk-based frames, when their writes are made durable (one of the
+    //!< BLOSC2_DURABILITY_* values; see blosc2_schunk_set_durability()).
+    int64_t durability_every;
+    //!< The milliseconds or mutating operations between syncs, for the
+    //!< #BLOSC2_DURABILITY_INTERVAL and #BLOSC2_DURABILITY_EVERY_OPS policies.
 } blosc2_storage;
 
 /**
  * @brief Default struct for #blosc2_storage meant for user initialization.
  */
-static const blosc2_storage BLOSC2_STORAGE_DEFAULTS = {false, NULL, NULL, NULL, NULL};
+static const blosc2_storage BLOSC2_STORAGE_DEFAULTS = {false, NULL, NULL, NULL, NULL, false,
+                                                       BLOSC2_DURABILITY_NONE, 0};
 
 /**
  * @brief Get default struct for compression params meant for user initialization.
@@ -1802,6 +1937,8 @@ BLOSC_EXPORT blosc2_stdio_mmap blosc2_get_blosc2_stdio_mmap_defaults(void);
 
 typedef struct blosc2_frame_s blosc2_frame;   /* opaque type */
 
+typedef struct blosc2_chunk_cache_s blosc2_chunk_cache;   /* opaque type */
+
 /**
  * @brief This struct is meant to store metadata information inside
  * a #blosc2_schunk, allowing to specify, for example, how to interpret
@@ -1889,6 +2026,8 @@ typedef struct blosc2_schunk {
   //!< refresh that follows a mutation made through another handle on the same
   //!< on-disk frame.  Upper layers compare it against a cached value to know
   //!< whether their deserialized view of the metalayers is still current.
+  blosc2_chunk_cache* cache;
+  //!< Cache of decompressed chunks. NULL if disabled (see blosc2_schunk_set_cache()).
 } blosc2_schunk;
 
 
@@ -1958,8 +2097,13 @@ BLOSC_EXPORT void blosc2_schunk_avoid_cframe_free(blosc2_schunk *schunk, bool av
  * Everything inside the bracket is serialized exclusively — including plain
  * reads through other locked handles — so keep brackets short.  The bracket
  * is re-entrant on the same handle.  When locking is not enabled on the
- * handle (or the super-chunk is not disk-based), this is a no-op returning
- * success, so callers do not need to check whether locking is active.
+ * handle (or the super-chunk is not disk-based), the bracket only keeps the
+ * mutations from other threads on the same handle out, and returns success,
+ * so callers do not need to check whether locking is active.
+ *
+ * When the journal is enabled on the handle (see blosc2_schunk_set_journal()),
+ * the bracket is also a single transaction: a crash before
+ * blosc2_schunk_unlock() rolls back all of its operations.
  *
  * @param schunk The super-chunk.
  *
@@ -1998,6 +2142,154 @@ BLOSC_EXPORT int blosc2_schunk_unlock(blosc2_schunk *schunk);
  */
 BLOSC_EXPORT int blosc2_schunk_refresh(blosc2_schunk *schunk);
 
+/**
+ * @brief Attach a cache of decompressed chunks to a super-chunk.
+ *
+ * Reads of whole chunks (blosc2_schunk_decompress_chunk()) and of slices
+ * (blosc2_schunk_get_slice_buffer(), b2nd_get_slice_cbuffer() and friends)
+ * are then served from the cache, which keeps the least recently used chunks
+ * within a memory budget.  Chunks are dropped from it when they are updated,
+ * inserted or deleted, and the whole cache is dropped when a refresh finds
+ * that another handle changed the on-disk frame.
+ *
+ * The cache can also be set up at creation or opening time with the
+ * @p cache_nbytes field of the #blosc2_dparams in the #blosc2_storage.
+ *
+ * @param schunk The super-chunk.
+ * @param nbytes The memory budget of the cache.  Chunks larger than it are
+ * never cached.  0 disables (and frees) the cache.
+ *
+ * @return 0 on success; a negative error code otherwise.  Changing the budget
+ * empties the cache and resets its counters.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_cache(blosc2_schunk *schunk, int64_t nbytes);
+
+/**
+ * @brief Get the number of reads served from the cache of decompressed chunks
+ * (hits) and of reads that had to decompress a chunk into it (misses).
+ *
+ * @param schunk The super-chunk.
+ * @param nhits The pointer where the number of hits will be stored (can be NULL).
+ * @param nmisses The pointer where the number of misses will be stored (can be NULL).
+ *
+ * @return 0 on success; a negative error code otherwise (e.g. when the
+ * super-chunk has no cache).
+ */
+BLOSC_EXPORT int blosc2_schunk_get_cache_stats(blosc2_schunk *schunk, int64_t *nhits, int64_t *nmisses);
+
+/**
+ * @brief Defer the offsets index, header and trailer updates that every
+ * append to a disk-based frame performs.
+ *
+ * By default each append decompresses, extends and recompresses the whole
+ * offsets index of the frame and rewrites its header and trailer, so ingesting
+ * N chunks does O(N²) index work.  With a non-zero @p nappends, appended
+ * chunks are written to disk right away but the index is extended in memory
+ * only, and written out (together with the header and trailer) at commit
+ * points: every @p nappends appends when it is positive, on
+ * blosc2_schunk_flush(), before any other kind of mutation (insert, update,
+ * delete, reorder, metalayer changes) and on blosc2_schunk_free().  Reads keep
+ * working on the pending chunks in between.
+ *
+ * Crash safety: for contiguous frames, the first append of a batch is written
+ * over the index and trailer of the frame, as a regular append does, and the
+ * commit writes the new index and trailer after the appended chunks and
+ * updates the header last.  Until the commit, the file does not hold a valid
+ * frame (nor can other handles read it), so a crash in between can lose it;
+ * enable the journal (see blosc2_schunk_set_journal()) to have the whole batch
+ * rolled back to the last commit instead.  Sparse frames store chunks in files
+ * of their own and only defer the update of their index file; a crash leaves
+ * that at the last commit, plus orphan chunk files that later appends
+ * overwrite.
+ *
+ * Deferred appends assume a single writer and are not available when file
+ * locking is enabled on the handle.
+ *
+ * @param schunk The super-chunk.  Must be backed by an on-disk frame.
+ * @param nappends The number of appends between automatic commits; a negative
+ * value only commits at the points listed above.  0 restores the default
+ * behaviour (committing any pending appends first).
+ *
+ * @return 0 on success; a negative error code otherwise.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_append_batch(blosc2_schunk *schunk, int64_t nappends);
+
+/**
+ * @brief Commit the appends deferred by blosc2_schunk_set_append_batch(), so
+ * that the on-disk frame reflects all of them.  With a durability policy
+ * (see blosc2_schunk_set_durability()), the files of the frame are synced too.
+ *
+ * @param schunk The super-chunk.
+ *
+ * @return 0 on success (also when nothing was pending, or when @p schunk is
+ * not frame-backed); a negative error code otherwise.
+ */
+BLOSC_EXPORT int blosc2_schunk_flush(blosc2_schunk *schunk);
+
+/**
+ * @brief Set when the writes to a disk-based frame are made durable.  This is
+ * what the `durability` and `durability_every` fields of #blosc2_storage do
+ * for new super-chunks, for super-chunks that have been opened.
+ *
+ * With #BLOSC2_DURABILITY_NONE (the default) flushing is left to the
+ * operating system.  The other policies sync the files of the frame (with the
+ * `sync` callback of the I/O backend, e.g. fdatasync) on blosc2_schunk_flush()
+ * and blosc2_schunk_free(), and besides:
+ *
+ * - #BLOSC2_DURABILITY_INTERVAL: a background thread syncs them every
+ *   @p every milliseconds whenever there were mutations in between.  Each
+ *   mutation still commits to the frame right away, so at most the last
+ *   @p every ms of them can be lost in a crash.
+ * - #BLOSC2_DURABILITY_EVERY_OPS: every @p every mutating operations the
+ *   files are synced, once for all of them.  Writers in other threads go on
+ *   while the sync is in flight, and the operations they complete in the
+ *   meantime are committed together by the next sync (group commit).  At most
+ *   the last @p every operations, plus those during a sync, can be lost in a
+ *   crash.  On sparse frames, and on contiguous ones with the journal enabled
+ *   beforehand (see blosc2_schunk_set_journal()), appends are also deferred as
+ *   with blosc2_schunk_set_append_batch(), so that their index, the header and
+ *   the trailer are only committed at each sync.  Plain contiguous frames
+ *   commit every append, since a crash amid deferred appends would leave them
+ *   without a valid index.
+ *
+ * The mutations of a super-chunk (appends, inserts, updates, deletes,
+ * metalayer changes...) are serialized on the handle, so several threads can
+ * append to it at the same time.  Compress their chunks with contexts of
+ * their own and add them with blosc2_schunk_append_chunk(), as
+ * blosc2_schunk_append_buffer() uses the context of the super-chunk.
+ *
+ * @param schunk The super-chunk.  Must be backed by an on-disk frame.
+ * @param policy One of the BLOSC2_DURABILITY_* values.
+ * @param every The milliseconds or operations between syncs, for the policies
+ * that need it (must be positive then).
+ *
+ * @return 0 on success; a negative error code otherwise.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_durability(blosc2_schunk *schunk, uint8_t policy, int64_t every);
+
+/**
+ * @brief Enable or disable the journal of a disk-based frame.
+ *
+ * With the journal, what the mutations of the frame overwrite (its header,
+ * offsets and trailer, or the chunk files of a sparse frame) is logged first
+ * in a sidecar journal next to the frame, and the frame is synced after every
+ * operation (or blosc2_schunk_lock() bracket), so that a crash midway is rolled
+ * back the next time the frame is opened.  Interrupted updates are rolled back
+ * on open whatever the setting of the handle opening the frame.  Disabling the
+ * journal commits the transaction running, if any.
+ *
+ * The **BLOSC_JOURNAL** environment variable enables it for every frame
+ * subsequently opened or created, like **BLOSC_LOCKING** does for locking; set
+ * it to "0" or the empty string to leave it off.
+ *
+ * @param schunk The super-chunk.  Must be backed by an on-disk frame using the
+ * default filesystem I/O (#BLOSC2_IO_FILESYSTEM or #BLOSC2_IO_FILESYSTEM_URING).
+ * @param journal Whether to enable the journal.
+ *
+ * @return 0 on success; a negative error code otherwise.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_journal(blosc2_schunk *schunk, bool journal);
+
 /**
  * @brief Open an existing super-chunk that is on-disk (frame). No in-memory copy is made.
  *
@@ -2094,6 +2386,7 @@ BLOSC_EXPORT int blosc2_schunk_free(blosc2_schunk *schunk);
  * @param chunk The @p chunk to append.  An internal copy is made, so @p chunk can be reused or
  * freed if desired.
  * @param copy Whether the chunk should be copied internally or can be used as-is.
+ * When used as-is, the super-chunk only takes @p chunk over if the append succeeds.
  *
  * @return The number of chunks in super-chunk. If some problem is
  * detected, this number will be negative.
@@ -2151,6 +2444,34 @@ BLOSC_EXPORT int64_t blosc2_schunk_delete_chunk(blosc2_schunk *schunk, int64_t n
  */
 BLOSC_EXPORT int64_t blosc2_schunk_append_buffer(blosc2_schunk *schunk, const void *src, int32_t nbytes);
 
+/**
+ * @brief Append several data buffers to a super-chunk, one chunk per buffer.
+ *
+ * The buffers are compressed concurrently, one chunk per thread of the
+ * compression context of the super-chunk (instead of one chunk at a time with
+ * the threads working on its blocks), which pays off for small chunks.  The
+ * chunks are then appended in order.  For sparse frames, and for contiguous
+ * ones with the journal enabled, the offsets index, header and trailer are
+ * only updated once for the whole batch; a crash in between loses the batch
+ * (the journal rolls it back).  Other contiguous frames commit every append,
+ * so that a crash never leaves them invalid.
+ *
+ * Super-chunks with a prefilter or a tuner other than the default one
+ * compress the buffers one after the other, exactly as
+ * blosc2_schunk_append_buffer() would.
+ *
+ * @param schunk The super-chunk where data will be appended.
+ * @param nbuffers The number of buffers.
+ * @param srcs The buffers of data to compress.
+ * @param nbytes The sizes of the buffers.
+ *
+ * @return The number of chunks in super-chunk. If some problem is
+ * detected, this number will be negative, and only the buffers before the
+ * failing one may have been appended.
+ */
+BLOSC_EXPORT int64_t blosc2_schunk_append_buffers(blosc2_schunk *schunk, int64_t nbuffers,
+                                                  const void **srcs, const int32_t *nbytes);
+
 /**
  * @brief Decompress and return the @p nchunk chunk of a super-chunk.
  *
@@ -2170,6 +2491,62 @@ BLOSC_EXPORT int64_t blosc2_schunk_append_buffer(blosc2_schunk *schunk, const vo
  */
 BLOSC_EXPORT int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int64_t nchunk, void *dest, int32_t nbytes);
 
+/**
+ * @brief An iterator over the decompressed chunks of a super-chunk.
+ */
+typedef struct blosc2_schunk_iter_s blosc2_schunk_iter;
+
+/**
+ * @brief Create an iterator over the chunks [@p start, @p stop) of a super-chunk.
+ *
+ * Up to @p depth chunks ahead of the one being consumed are decompressed by
+ * the workers of the shared thread pool of Blosc (the one with as many threads
+ * as the decompression context of the super-chunk), so that the I/O and
+ * decompression of the next chunks overlap with the processing of the current
+ * one.  No thread is started for the iterator itself.  Memory is bounded by
+ * @p depth + 1 decompressed chunks.  A @p depth of 0, or a build without the
+ * shared pool (Windows, or blosc2_set_threads_callback()), decompresses every
+ * chunk on demand.
+ *
+ * The super-chunk must not be modified, nor used by other threads, while the
+ * iterator is alive.
+ *
+ * @param schunk The super-chunk to iterate over (in-memory or on-disk).
+ * @param start The first chunk to return.
+ * @param stop The chunk at which the iteration stops (not included).
+ * @param depth The number of chunks to decompress ahead.
+ *
+ * @return The new iterator, or NULL in case of error.  Free it with
+ * blosc2_schunk_iter_free().
+ */
+BLOSC_EXPORT blosc2_schunk_iter* blosc2_schunk_iter_new(blosc2_schunk *schunk, int64_t start,
+                                                        int64_t stop, int32_t depth);
+
+/**
+ * @brief Get the next decompressed chunk out of an iterator.
+ *
+ * @param iter The iterator.
+ * @param nchunk The index of the chunk in the super-chunk.
+ * @param dest A pointer to the decompressed data.  It is owned by the iterator
+ * and stays valid until the next call to this function or to
+ * blosc2_schunk_iter_free().
+ * @param nbytes The size of the decompressed data.
+ *
+ * @return 1 if a chunk has been returned, 0 once all the chunks have been
+ * returned, or a negative value if some problem is detected; errors are sticky.
+ */
+BLOSC_EXPORT int blosc2_schunk_iter_next(blosc2_schunk_iter *iter, int64_t *nchunk, void **dest,
+                                         int32_t *nbytes);
+
+/**
+ * @brief Free an iterator, stopping the decompression of the chunks ahead.
+ *
+ * @param iter The iterator (may be NULL).
+ *
+ * @return 0 on success.
+ */
+BLOSC_EXPORT int blosc2_schunk_iter_free(blosc2_schunk_iter *iter);
+
 /**
  * @brief Return a compressed chunk that is part of a super-chunk in the @p chunk parameter.
  *
@@ -2337,6 +2714,20 @@ BLOSC_EXPORT int blosc2_schunk_get_dparams(blosc2_schunk *schunk, blosc2_dparams
  */
 BLOSC_EXPORT int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int64_t *offsets_order);
 
+/**
+ * @brief Reclaim the space left behind by updated and deleted chunks of a
+ * sparse frame with the packed layout (see #blosc2_storage.packed).  The
+ * chunks still in use are copied into new segment files, the offsets index
+ * is pointed there, and then the old segments are removed.  A crash in
+ * between leaves a valid frame, with either the old or the new segments.
+ *
+ * @param schunk The super-chunk to compact.
+ *
+ * @return The number of bytes reclaimed (0 for super-chunks that are not
+ * backed by a packed sparse frame). Else a negative code is returned.
+ */
+BLOSC_EXPORT int64_t blosc2_schunk_compact(blosc2_schunk *schunk);
+
 /**
  * @brief Get the length (in bytes) of the internal frame of the super-chunk.
  *
@@ -2570,7 +2961,8 @@ BLOSC_EXPORT int blosc2_vlmeta_delete(blosc2_schunk *schunk, const char *name);
  * @param names The pointer to a char** to store the name pointers. This should
  * be of size *schunk->nvlmetalayers * sizeof(char*).
  *
- * @return The number of the variable-length metalayers in the super-chunk.
+ * @return The number of the variable-length metalayers in the super-chunk (the ones
+ * reserved for Blosc itself, like its shared dictionary, are not listed).
  * This cannot fail unless the user does not pass a @p names which is large enough to
  * keep pointers to all names, in which case funny things (seg faults and such) will happen.
  */
@@ -36,6 +36,8 @@ typedef struct {
   FILE *file;
 } blosc2_stdio_file;
 
+struct blosc2_io_range_s;
+
 /**
  * @brief Parameters for the default filesystem I/O (#BLOSC2_IO_FILESYSTEM).
  * Pass a pointer to this struct in the params member of the #blosc2_io struct;
@@ -65,7 +67,9 @@ BLOSC_EXPORT int blosc2_stdio_close(void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_size(void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_write(const void *ptr, int64_t size, int64_t nitems, int64_t position, void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_read(void **ptr, int64_t size, int64_t nitems, int64_t position, void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_readv(const struct blosc2_io_range_s *ranges, int64_t nranges, void *stream);
 BLOSC_EXPORT int blosc2_stdio_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int blosc2_stdio_sync(void *stream);
 BLOSC_EXPORT int blosc2_stdio_destroy(void* params);
 
 
@@ -113,6 +117,10 @@ typedef struct {
   HANDLE mmap_handle;
   //!< The Windows handle to the memory mapping.
 #endif
+  int64_t prefetch_start;
+  //!< The start of the last range hinted by blosc2_stdio_mmap_prefetch().
+  int64_t prefetch_end;
+  //!< The end of the last range hinted by blosc2_stdio_mmap_prefetch().
 } blosc2_stdio_mmap;
 
 /**
@@ -123,6 +131,7 @@ static const blosc2_stdio_mmap BLOSC2_STDIO_MMAP_DEFAULTS = {
 #if defined(_WIN32)
   , INVALID_HANDLE_VALUE
 #endif
+  , 0, 0
 };
 
 BLOSC_EXPORT void *blosc2_stdio_mmap_open(const char *urlpath, const char *mode, void* params);
@@ -131,9 +140,37 @@ BLOSC_EXPORT int64_t blosc2_stdio_mmap_size(void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_mmap_write(
   const void *ptr, int64_t size, int64_t nitems, int64_t position, void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_mmap_read(void **ptr, int64_t size, int64_t nitems, int64_t position, void *stream);
+/**
+ * @brief Hint the kernel to page in the @p ranges of the mapping (madvise(MADV_WILLNEED)) without waiting for them.
+ * Ranges that follow the previous one, as in forward scans, are also marked as sequentially accessed.
+ * Returns the number of ranges hinted.
+ */
+BLOSC_EXPORT int blosc2_stdio_mmap_prefetch(const struct blosc2_io_range_s *ranges, int64_t nranges, void *stream);
 BLOSC_EXPORT int blosc2_stdio_mmap_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int blosc2_stdio_mmap_sync(void *stream);
 BLOSC_EXPORT int blosc2_stdio_mmap_destroy(void* params);
 
+
+/**
+ * @brief Filesystem I/O on top of io_uring (#BLOSC2_IO_FILESYSTEM_URING). It takes the same parameters
+ * (#blosc2_stdio_params) as the default filesystem I/O, and behaves like it, except that reads go through an
+ * io_uring of the calling thread: the ranges of vectored reads are all in flight at the same time, and prefetch
+ * hints are queued without waiting for them.  Where io_uring is not available (other platforms than Linux, builds
+ * with DEACTIVATE_IO_URING or kernels that do not allow it) this is just the default filesystem I/O.
+ * Set the **BLOSC_IO_URING** environment variable (to anything but "0" or the empty string) for making the
+ * default filesystem I/O use io_uring too.
+ */
+BLOSC_EXPORT void *blosc2_uring_open(const char *urlpath, const char *mode, void* params);
+BLOSC_EXPORT int blosc2_uring_close(void *stream);
+BLOSC_EXPORT int64_t blosc2_uring_size(void *stream);
+BLOSC_EXPORT int64_t blosc2_uring_write(const void *ptr, int64_t size, int64_t nitems, int64_t position, void *stream);
+BLOSC_EXPORT int64_t blosc2_uring_read(void **ptr, int64_t size, int64_t nitems, int64_t position, void *stream);
+BLOSC_EXPORT int64_t blosc2_uring_readv(const struct blosc2_io_range_s *ranges, int64_t nranges, void *stream);
+BLOSC_EXPORT int blosc2_uring_prefetch(const struct blosc2_io_range_s *ranges, int64_t nranges, void *stream);
+BLOSC_EXPORT int blosc2_uring_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int blosc2_uring_sync(void *stream);
+BLOSC_EXPORT int blosc2_uring_destroy(void* params);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,94 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "bytedelta-avx2.h"
+#include <stdlib.h>
+
+/* Make sure AVX2 is available for the compilation target and compiler. */
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include <stdint.h>
+
+
+/* The 32 bytes before v: the last byte of prev followed by v[0..30] */
+static inline __m256i previous_bytes(__m256i v, __m256i prev) {
+  /* The high lane of prev and the low lane of v */
+  __m256i mid = _mm256_permute2x128_si256(prev, v, 0x21);
+  return _mm256_alignr_epi8(v, mid, 15);
+}
+
+/* Inclusive prefix sum of the 32 bytes of x */
+static inline __m256i prefix_sum(__m256i x) {
+  x = _mm256_add_epi8(x, _mm256_slli_si256(x, 1));
+  x = _mm256_add_epi8(x, _mm256_slli_si256(x, 2));
+  x = _mm256_add_epi8(x, _mm256_slli_si256(x, 4));
+  x = _mm256_add_epi8(x, _mm256_slli_si256(x, 8));
+  /* Carry the total of the low lane over the high one */
+  __m256i lo = _mm256_shuffle_epi8(x, _mm256_set1_epi8(15));
+  return _mm256_add_epi8(x, _mm256_permute2x128_si256(lo, lo, 0x08));
+}
+
+/* The last byte of x in every byte */
+static inline __m256i broadcast_last(__m256i x) {
+  __m256i last = _mm256_shuffle_epi8(x, _mm256_set1_epi8(15));
+  return _mm256_permute2x128_si256(last, last, 0x11);
+}
+
+
+void bytedelta_encode_avx2(const uint8_t *input, uint8_t *output, int32_t len) {
+  __m256i prev = _mm256_setzero_si256();
+  int32_t i;
+  for (i = 0; i + (int32_t)sizeof(__m256i) <= len; i += (int32_t)sizeof(__m256i)) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(input + i));
+    _mm256_storeu_si256((__m256i *)(output + i), _mm256_sub_epi8(v, previous_bytes(v, prev)));
+    prev = v;
+  }
+  uint8_t last = i > 0 ? input[i - 1] : 0;
+  for (; i < len; i++) {
+    uint8_t v = input[i];
+    output[i] = v - last;
+    last = v;
+  }
+}
+
+
+void bytedelta_decode_avx2(const uint8_t *input, uint8_t *output, int32_t len) {
+  __m256i carry = _mm256_setzero_si256();
+  int32_t i;
+  for (i = 0; i + (int32_t)sizeof(__m256i) <= len; i += (int32_t)sizeof(__m256i)) {
+    __m256i sum = prefix_sum(_mm256_loadu_si256((const __m256i *)(input + i)));
+    _mm256_storeu_si256((__m256i *)(output + i), _mm256_add_epi8(sum, carry));
+    /* The only dependency on the previous vectors */
+    carry = _mm256_add_epi8(carry, broadcast_last(sum));
+  }
+  uint8_t last = i > 0 ? output[i - 1] : 0;
+  for (; i < len; i++) {
+    last += input[i];
+    output[i] = last;
+  }
+}
+
+const bool is_bytedelta_avx2 = true;
+
+#else /* defined(__AVX2__) */
+
+const bool is_bytedelta_avx2 = false;
+
+void bytedelta_encode_avx2(const uint8_t *input, uint8_t *output, int32_t len) {
+  abort();
+}
+
+void bytedelta_decode_avx2(const uint8_t *input, uint8_t *output, int32_t len) {
+  abort();
+}
+
+#endif /* defined(__AVX2__) */
@@ -0,0 +1,97 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "bytedelta-avx512.h"
+#include <stdlib.h>
+
+/* Make sure AVX512 is available for the compilation target and compiler. */
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+
+#include <immintrin.h>
+
+#include <stdint.h>
+
+
+/* The 64 bytes before v: the last byte of prev followed by v[0..62] */
+static inline __m512i previous_bytes(__m512i v, __m512i prev) {
+  /* The last lane of prev followed by the first three of v */
+  __m512i lanes = _mm512_alignr_epi32(v, prev, 12);
+  return _mm512_alignr_epi8(v, lanes, 15);
+}
+
+/* Inclusive prefix sum of the 64 bytes of x.  Sets *total to the sum of
+   them all in every byte. */
+static inline __m512i prefix_sum(__m512i x, __m512i *total) {
+  const __m512i zero = _mm512_setzero_si512();
+  /* Within each 64-bit word, with shifts that do not take the shuffle port
+     (byte shifts within 128-bit lanes do, and are slower here) */
+  x = _mm512_add_epi8(x, _mm512_slli_epi64(x, 8));
+  x = _mm512_add_epi8(x, _mm512_slli_epi64(x, 16));
+  x = _mm512_add_epi8(x, _mm512_slli_epi64(x, 32));
+  /* Then across the words: scan of their totals */
+  __m512i words = _mm512_shuffle_epi8(x, _mm512_set4_epi64(0x0F0F0F0F0F0F0F0FLL, 0x0707070707070707LL,
+                                                          0x0F0F0F0F0F0F0F0FLL, 0x0707070707070707LL));
+  __m512i scan = _mm512_add_epi8(words, _mm512_alignr_epi64(words, zero, 7));
+  scan = _mm512_add_epi8(scan, _mm512_alignr_epi64(scan, zero, 6));
+  scan = _mm512_add_epi8(scan, _mm512_alignr_epi64(scan, zero, 4));
+  *total = _mm512_permutexvar_epi64(_mm512_set1_epi64(7), scan);
+  return _mm512_add_epi8(x, _mm512_sub_epi8(scan, words));
+}
+
+
+void bytedelta_encode_avx512(const uint8_t *input, uint8_t *output, int32_t len) {
+  __m512i prev = _mm512_setzero_si512();
+  int32_t i;
+  for (i = 0; i + (int32_t)sizeof(__m512i) <= len; i += (int32_t)sizeof(__m512i)) {
+    __m512i v = _mm512_loadu_si512((const void *)(input + i));
+    _mm512_storeu_si512((void *)(output + i), _mm512_sub_epi8(v, previous_bytes(v, prev)));
+    prev = v;
+  }
+  uint8_t last = i > 0 ? input[i - 1] : 0;
+  for (; i < len; i++) {
+    uint8_t v = input[i];
+    output[i] = v - last;
+    last = v;
+  }
+}
+
+
+void bytedelta_decode_avx512(const uint8_t *input, uint8_t *output, int32_t len) {
+  __m512i carry = _mm512_setzero_si512();
+  int32_t i;
+  for (i = 0; i + (int32_t)sizeof(__m512i) <= len; i += (int32_t)sizeof(__m512i)) {
+    __m512i total;
+    __m512i sum = prefix_sum(_mm512_loadu_si512((const void *)(input + i)), &total);
+    _mm512_storeu_si512((void *)(output + i), _mm512_add_epi8(sum, carry));
+    /* The only dependency on the previous vectors */
+    carry = _mm512_add_epi8(carry, total);
+  }
+  uint8_t last = i > 0 ? output[i - 1] : 0;
+  for (; i < len; i++) {
+    last += input[i];
+    output[i] = last;
+  }
+}
+
+const bool is_bytedelta_avx512 = true;
+
+#else /* defined(__AVX512F__) && defined(__AVX512BW__) */
+
+const bool is_bytedelta_avx512 = false;
+
+void bytedelta_encode_avx512(const uint8_t *input, uint8_t *output, int32_t len) {
+  abort();
+}
+
+void bytedelta_decode_avx512(const uint8_t *input, uint8_t *output, int32_t len) {
+  abort();
+}
+
+#endif /* defined(__AVX512F__) && defined(__AVX512BW__) */
@@ -0,0 +1,37 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/* AVX512-accelerated kernels for the bytedelta filter. */
+
+#ifndef BLOSC_PLUGINS_FILTERS_BYTEDELTA_BYTEDELTA_AVX512_H
+#define BLOSC_PLUGINS_FILTERS_BYTEDELTA_BYTEDELTA_AVX512_H
+
+#include "blosc2/blosc2-common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * AVX512-accelerated bytedelta kernels availability.
+*/
+extern const bool is_bytedelta_avx512;
+
+/**
+  Set output[i] = input[i] - input[i - 1] for the len bytes of a stream,
+  with input[-1] = 0.
+*/
+BLOSC_NO_EXPORT void bytedelta_encode_avx512(const uint8_t *input, uint8_t *output, int32_t len);
+
+/**
+  Undo bytedelta_encode_avx512(): set output[i] to the sum of input[0..i].
+*/
+BLOSC_NO_EXPORT void bytedelta_decode_avx512(const uint8_t *input, uint8_t *output, int32_t len);
+
+#endif /* BLOSC_PLUGINS_FILTERS_BYTEDELTA_BYTEDELTA_AVX512_H */
@@ -11,10 +11,19 @@
 // ByteDelta filter.  This is based on work by Aras Pranckevičius:
 // https://aras-p.info/blog/2023/03/01/Float-Compression-7-More-Filtering-Optimization/
 // This requires Intel SSE4.1 and ARM64 NEON, which should be widely available by now.
+// AVX2 and AVX512 kernels are chosen at run-time, like the shuffle ones.
 
 #include "bytedelta.h"
+#include "shuffle.h"
 #include "blosc2.h"
 
+#if defined(SHUFFLE_AVX512_ENABLED)
+#include "bytedelta-avx512.h"
+#endif
+#if defined(SHUFFLE_AVX2_ENABLED)
+#include "bytedelta-avx2.h"
+#endif
+
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -82,7 +91,122 @@ uint8_t simd_get_last(bytes16 x) { return vgetq_lane_u8(x, 15); }
 #endif
 
 
-// Fetch 16b from N streams, compute SIMD delta
+// Delta of one stream with the 16-byte SIMD (if any) of this build
+static void bytedelta_encode_generic(const uint8_t *input, uint8_t *output, int32_t stream_len) {
+  int ip = 0;
+  uint8_t _v2 = 0;
+  // SIMD delta within the channel, store
+#if defined(CPU_HAS_SIMD)
+  bytes16 v2 = {0};
+  for (; ip < stream_len - 15; ip += 16) {
+    bytes16 v = simd_load(input);
+    input += 16;
+    bytes16 delta = simd_sub(v, simd_concat(v, v2));
+    simd_store(output, delta);
+    output += 16;
+    v2 = v;
+  }
+  if (stream_len > 15) {
+    _v2 = simd_get_last(v2);
+  }
+#endif // #if defined(CPU_HAS_SIMD)
+  // scalar leftover
+  for (; ip < stream_len ; ip++) {
+    uint8_t v = *input;
+    input++;
+    *output = v - _v2;
+    output++;
+    _v2 = v;
+  }
+}
+
+// Undelta of one stream with the 16-byte SIMD (if any) of this build
+static void bytedelta_decode_generic(const uint8_t *input, uint8_t *output, int32_t stream_len) {
+  int ip = 0;
+  uint8_t _v2 = 0;
+  // SIMD fetch 16 bytes from the channel, prefix-sum un-delta
+#if defined(CPU_HAS_SIMD)
+  bytes16 v2 = {0};
+  for (; ip < stream_len - 15; ip += 16) {
+    bytes16 v = simd_load(input);
+    input += 16;
+    // un-delta via prefix sum
+    v2 = simd_add(simd_prefix_sum(v), simd_duplane15(v2));
+    simd_store(output, v2);
+    output += 16;
+  }
+  if (stream_len > 15) {
+    _v2 = simd_get_last(v2);
+  }
+#endif // #if defined(CPU_HAS_SIMD)
+  // scalar leftover
+  for (; ip < stream_len; ip++) {
+    uint8_t v = *input + _v2;
+    input++;
+    *output = v;
+    output++;
+    _v2 = v;
+  }
+}
+
+
+/*  Define function pointer types for the stream kernels. */
+typedef void(* bytedelta_stream_func)(const uint8_t*, uint8_t*, int32_t);
+
+/* An implementation of the bytedelta kernels. */
+typedef struct bytedelta_implementation {
+  /* Name of this implementation. */
+  const char* name;
+  /* Function pointer to the delta of one stream. */
+  bytedelta_stream_func encode;
+  /* Function pointer to the undelta of one stream. */
+  bytedelta_stream_func decode;
+} bytedelta_implementation_t;
+
+static bytedelta_implementation_t get_bytedelta_implementation(void) {
+  bytedelta_implementation_t impl = {"generic", bytedelta_encode_generic, bytedelta_decode_generic};
+#if defined(SHUFFLE_AVX512_ENABLED) || defined(SHUFFLE_AVX2_ENABLED)
+  blosc_cpu_features cpu_features = blosc_get_cpu_features();
+#endif
+#if defined(SHUFFLE_AVX512_ENABLED)
+  if (cpu_features & BLOSC_HAVE_AVX512 && is_bytedelta_avx512) {
+    impl.name = "avx512";
+    impl.encode = bytedelta_encode_avx512;
+    impl.decode = bytedelta_decode_avx512;
+    return impl;
+  }
+#endif  /* defined(SHUFFLE_AVX512_ENABLED) */
+
+#if defined(SHUFFLE_AVX2_ENABLED)
+  if (cpu_features & BLOSC_HAVE_AVX2 && is_bytedelta_avx2) {
+    impl.name = "avx2";
+    impl.encode = bytedelta_encode_avx2;
+    impl.decode = bytedelta_decode_avx2;
+    return impl;
+  }
+#endif  /* defined(SHUFFLE_AVX2_ENABLED) */
+
+  return impl;
+}
+
+
+/* Flag indicating whether the implementation has been initialized.
+   A concurrent initialization is harmless because every thread would
+   choose the same implementation. */
+static int32_t implementation_initialized;
+
+/* The dynamically-chosen bytedelta implementation. */
+static bytedelta_implementation_t host_implementation;
+
+static inline void init_bytedelta_implementation(void) {
+  if (!implementation_initialized) {
+    host_implementation = get_bytedelta_implementation();
+    implementation_initialized = 1;
+  }
+}
+
+
+// Delta of N streams, with the best kernels for the host
 int bytedelta_forward(const uint8_t *input, uint8_t *output, int32_t length, uint8_t meta,
                       blosc2_cparams *cparams, uint8_t id) {
   BLOSC_UNUSED_PARAM(id);
@@ -97,33 +221,12 @@ int bytedelta_forward(const uint8_t *input, uint8_t *output, int32_t length, uin
     typesize = schunk->typesize;
   }
 
+  init_bytedelta_implementation();
   const int stream_len = length / typesize;
   for (int ich = 0; ich < typesize; ++ich) {
-    int ip = 0;
-    uint8_t _v2 = 0;
-    // SIMD delta within each channel, store
-#if defined(CPU_HAS_SIMD)
-    bytes16 v2 = {0};
-    for (; ip < stream_len - 15; ip += 16) {
-      bytes16 v = simd_load(input);
-      input += 16;
-      bytes16 delta = simd_sub(v, simd_concat(v, v2));
-      simd_store(output, delta);
-      output += 16;
-      v2 = v;
-    }
-    if (stream_len > 15) {
-      _v2 = simd_get_last(v2);
-    }
-#endif // #if defined(CPU_HAS_SIMD)
-    // scalar leftover
-    for (; ip < stream_len ; ip++) {
-      uint8_t v = *input;
-      input++;
-      *output = v - _v2;
-      output++;
-      _v2 = v;
-    }
+    host_implementation.encode(input, output, stream_len);
+    input += stream_len;
+    output += stream_len;
   }
 
   // When length is not a multiple of typesize, the trailing length % typesize
@@ -134,7 +237,7 @@ int bytedelta_forward(const uint8_t *input, uint8_t *output, int32_t length, uin
   return BLOSC2_ERROR_SUCCESS;
 }
 
-// Fetch 16b from N streams, sum SIMD undelta
+// Undelta of N streams, with the best kernels for the host
 int bytedelta_backward(const uint8_t *input, uint8_t *output, int32_t length, uint8_t meta,
                        blosc2_dparams *dparams, uint8_t id) {
   BLOSC_UNUSED_PARAM(id);
@@ -149,33 +252,12 @@ int bytedelta_backward(const uint8_t *input, uint8_t *output, int32_t length, ui
     typesize = schunk->typesize;
   }
 
+  init_bytedelta_implementation();
   const int stream_len = length / typesize;
   for (int ich = 0; ich < typesize; ++ich) {
-    int ip = 0;
-    uint8_t _v2 = 0;
-    // SIMD fetch 16 bytes from each channel, prefix-sum un-delta
-#if defined(CPU_HAS_SIMD)
-    bytes16 v2 = {0};
-    for (; ip < stream_len - 15; ip += 16) {
-      bytes16 v = simd_load(input);
-      input += 16;
-      // un-delta via prefix sum
-      v2 = simd_add(simd_prefix_sum(v), simd_duplane15(v2));
-      simd_store(output, v2);
-      output += 16;
-    }
-    if (stream_len > 15) {
-      _v2 = simd_get_last(v2);
-    }
-#endif // #if defined(CPU_HAS_SIMD)
-    // scalar leftover
-    for (; ip < stream_len; ip++) {
-      uint8_t v = *input + _v2;
-      input++;
-      *output = v;
-      output++;
-      _v2 = v;
-    }
+    host_implementation.decode(input, output, stream_len);
+    input += stream_len;
+    output += stream_len;
   }
 
   // Mirror of the forward pass: restore the trailing bytes verbatim.
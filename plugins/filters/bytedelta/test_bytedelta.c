@@ -41,6 +41,7 @@
 
 **********************************************************************/
 
+#include "bytedelta.h"
 #include "blosc2/filters-registry.h"
 #include "b2nd.h"
 
@@ -398,10 +399,56 @@ int partial_element_tail(void) {
   return failures == 0 ? BLOSC2_ERROR_SUCCESS : BLOSC2_ERROR_FAILURE;
 }
 
+/* The SIMD kernels (chosen at run-time) must give the same bytes as the
+ * scalar reference for every stream length, around the 16, 32 and 64-byte
+ * vector boundaries included. */
+int stream_kernels(void) {
+  const int32_t maxbytes = 16 * 300;
+  uint8_t *src = malloc(maxbytes);
+  uint8_t *delta = malloc(maxbytes);
+  uint8_t *delta_ref = malloc(maxbytes);
+  uint8_t *back = malloc(maxbytes);
+  int failures = 0;
+
+  for (int32_t i = 0; i < maxbytes; i++) {
+    src[i] = (uint8_t) (rand() % 256);
+  }
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  for (int32_t typesize = 1; typesize <= 16; typesize *= 2) {
+    for (int32_t nbytes = typesize; nbytes <= 300 * typesize; nbytes += typesize) {
+      bytedelta_forward(src, delta, nbytes, (uint8_t) typesize, &cparams, BLOSC_FILTER_BYTEDELTA);
+      correct_bytedelta_forward(src, delta_ref, nbytes, (uint8_t) typesize, &cparams, 250);
+      if (memcmp(delta, delta_ref, nbytes) != 0) {
+        printf("forward mismatch for nbytes=%d typesize=%d\n", nbytes, typesize);
+        failures++;
+      }
+      bytedelta_backward(delta, back, nbytes, (uint8_t) typesize, &dparams, BLOSC_FILTER_BYTEDELTA);
+      if (memcmp(src, back, nbytes) != 0) {
+        printf("backward mismatch for nbytes=%d typesize=%d\n", nbytes, typesize);
+        failures++;
+      }
+    }
+  }
+
+  free(src);
+  free(delta);
+  free(delta_ref);
+  free(back);
+  return failures == 0 ? BLOSC2_ERROR_SUCCESS : BLOSC2_ERROR_FAILURE;
+}
+
+
 int main(void) {
   int result;
   blosc2_init();
 
+  result = stream_kernels();
+  printf("stream_kernels: %s \n \n", result == 0 ? "OK" : "FAILED");
+  if (result < 0)
+    return result;
+
   result = partial_element_tail();
   printf("partial_element_tail: %s \n \n", result == 0 ? "OK" : "FAILED");
   if (result < 0)
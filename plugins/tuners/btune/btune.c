@@ -0,0 +1,355 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "btune.h"
+#include "context.h"
+#include "stune.h"
+#include "blosc-private.h"
+#include "blosc2.h"
+
+#if defined(USING_CMAKE)
+  #include "config.h"
+#endif /*  USING_CMAKE */
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* Blocks are not halved below this size when tuning the blocksize */
+#define BTUNE_MIN_BLOCKSIZE (8 * 1024)
+/* The blocksize goes from the automatic one / 2^N to the automatic one * 2^N */
+#define BTUNE_MAX_BSHIFT 2
+/* New chunks drift when their cratio changes by this factor, or their speed
+   drops by it, with respect to the first chunk after settling... */
+#define BTUNE_DRIFT_FACTOR 1.5
+/* ...and tuning starts over after this many drifting chunks in a row */
+#define BTUNE_MAX_DRIFTS 3
+
+static const uint8_t btune_filters[] = {BLOSC_SHUFFLE, BLOSC_BITSHUFFLE, BLOSC_NOSHUFFLE};
+
+static const uint8_t btune_codecs[] = {
+  BLOSC_BLOSCLZ,
+  BLOSC_LZ4,
+  BLOSC_LZ4HC,
+#if defined(HAVE_ZSTD)
+  BLOSC_ZSTD,
+#endif /* HAVE_ZSTD */
+};
+
+typedef enum {
+  BTUNE_BASELINE,    // measure the best candidate so far on the current data
+  BTUNE_FILTERS,
+  BTUNE_CODECS,
+  BTUNE_CLEVELS,
+  BTUNE_BLOCKSIZES,
+  BTUNE_STEADY,
+} btune_phase;
+
+typedef struct {
+  uint8_t compcode;
+  uint8_t filter;
+  uint8_t clevel;
+  int8_t bshift;     // the blocksize is the automatic one times 2^bshift
+} btune_candidate;
+
+typedef struct {
+  double tradeoff;
+  int filter_slot;        // where the shuffle filter goes (-1 for leaving filters alone)
+  bool tune_blocksize;    // false when the user fixed the blocksize
+  btune_phase phase;
+  int step;               // next candidate of the filter and codec phases
+  int direction;          // direction of the clevel and blocksize climbs
+  bool turned;            // whether the climb cannot turn around anymore
+  btune_candidate best;
+  btune_candidate current;
+  double best_score;
+  int nchunks;            // chunks seen since tuning (re)started
+  double steady_cratio;   // figures of the first chunk after settling
+  double steady_cspeed;
+  int ndrifts;
+} btune_state;
+
+
+static double get_tradeoff(const blosc2_btune_config *config) {
+  if (config != NULL && config->tradeoff >= 0) {
+    return config->tradeoff > 1 ? 1. : config->tradeoff;
+  }
+  char *envvar = getenv("BTUNE_TRADEOFF");
+  if (envvar != NULL) {
+    char *end;
+    double tradeoff = strtod(envvar, &end);
+    if (end != envvar && tradeoff >= 0 && tradeoff <= 1) {
+      return tradeoff;
+    }
+    BLOSC_TRACE_WARNING("BTUNE_TRADEOFF environment variable '%s' not recognized\n", envvar);
+  }
+  return 0.5;
+}
+
+
+int btune_init(void *config, blosc2_context *cctx, blosc2_context *dctx) {
+  BLOSC_UNUSED_PARAM(dctx);
+
+  btune_state *state = calloc(1, sizeof(btune_state));
+  BLOSC_ERROR_NULL(state, BLOSC2_ERROR_MEMORY_ALLOC);
+  state->tradeoff = get_tradeoff((blosc2_btune_config *)config);
+
+  /* Only the shuffle flavour of the pipeline is tuned: use the slot of an
+     existing (bit)shuffle, or else the last one if it is free */
+  state->filter_slot = -1;
+  for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
+    if (cctx->filters[i] == BLOSC_SHUFFLE || cctx->filters[i] == BLOSC_BITSHUFFLE) {
+      state->filter_slot = i;
+    }
+  }
+  if (state->filter_slot < 0 && cctx->filters[BLOSC2_MAX_FILTERS - 1] == BLOSC_NOFILTER) {
+    state->filter_slot = BLOSC2_MAX_FILTERS - 1;
+  }
+  state->tune_blocksize = cctx->blocksize == 0;
+
+  /* Start from the user parameters, but with a clevel that suits the tradeoff */
+  state->best.compcode = cctx->compcode;
+  state->best.filter = state->filter_slot >= 0 ? cctx->filters[state->filter_slot] : BLOSC_NOFILTER;
+  state->best.clevel = (uint8_t)(1 + lround(state->tradeoff * 8));
+  state->best.bshift = 0;
+  state->current = state->best;
+  state->phase = BTUNE_BASELINE;
+  /* Codecs that are not in the list are never tuned */
+  bool known_codec = false;
+  for (size_t i = 0; i < sizeof(btune_codecs); i++) {
+    known_codec |= (btune_codecs[i] == cctx->compcode);
+  }
+  if (!known_codec) {
+    state->best.clevel = cctx->clevel;
+    state->current = state->best;
+    state->phase = BTUNE_STEADY;
+  }
+
+  cctx->tuner_params = state;
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+int btune_next_blocksize(blosc2_context *context) {
+  return blosc_stune_next_blocksize(context);
+}
+
+
+int btune_next_cparams(blosc2_context *context) {
+  btune_state *state = (btune_state *)context->tuner_params;
+  btune_candidate *candidate = &state->current;
+
+  context->compcode = candidate->compcode;
+  context->clevel = candidate->clevel;
+  if (state->filter_slot >= 0) {
+    context->filters[state->filter_slot] = candidate->filter;
+    context->filters_meta[state->filter_slot] = 0;
+    context->filter_flags &= (uint8_t)~(BLOSC_DOSHUFFLE | BLOSC_DOBITSHUFFLE);
+    if (candidate->filter == BLOSC_SHUFFLE) {
+      context->filter_flags |= BLOSC_DOSHUFFLE;
+    }
+    else if (candidate->filter == BLOSC_BITSHUFFLE) {
+      context->filter_flags |= BLOSC_DOBITSHUFFLE;
+    }
+  }
+
+  if (state->tune_blocksize) {
+    /* Scale the automatic blocksize for the current codec and clevel */
+    context->blocksize = 0;
+    int rc = blosc_stune_next_blocksize(context);
+    if (rc < 0) {
+      return rc;
+    }
+    int32_t blocksize = context->blocksize;
+    for (int i = 0; i < candidate->bshift && blocksize <= context->sourcesize / 2; i++) {
+      blocksize *= 2;
+    }
+    for (int i = 0; i > candidate->bshift && blocksize >= 2 * BTUNE_MIN_BLOCKSIZE; i--) {
+      blocksize /= 2;
+    }
+    if (blocksize > context->typesize) {
+      blocksize = blocksize / context->typesize * context->typesize;
+    }
+    context->blocksize = blocksize;
+    context->header_blocksize = blocksize;
+  }
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Hill climbing of one parameter from its `best` value in [min, max].  The
+   climb goes on in a direction while it pays off, and turns around (once)
+   when the very first step does not.  Returns the next value to try, or
+   INT_MIN when the climb is over. */
+static int climb(btune_state *state, bool entering, bool improved, int best, int min, int max) {
+  if (entering) {
+    state->turned = false;
+  }
+  else if (improved) {
+    state->turned = true;
+  }
+  else if (!state->turned) {
+    state->turned = true;
+    state->direction = -state->direction;
+  }
+  else {
+    return INT_MIN;
+  }
+  int value = best + state->direction;
+  if (value < min || value > max) {
+    if (state->turned) {
+      return INT_MIN;
+    }
+    state->turned = true;
+    state->direction = -state->direction;
+    value = best + state->direction;
+    if (value < min || value > max) {
+      return INT_MIN;
+    }
+  }
+  return value;
+}
+
+
+/* Set the next candidate of the current phase, if any */
+static bool next_in_phase(btune_state *state, bool entering, bool improved) {
+  btune_candidate next = state->best;
+  int value;
+
+  if (entering) {
+    state->step = 0;
+  }
+  switch (state->phase) {
+    case BTUNE_FILTERS:
+      while (state->filter_slot >= 0 && state->step < (int)sizeof(btune_filters)) {
+        next.filter = btune_filters[state->step++];
+        if (next.filter != state->best.filter) {
+          state->current = next;
+          return true;
+        }
+      }
+      return false;
+    case BTUNE_CODECS:
+      while (state->step < (int)sizeof(btune_codecs)) {
+        next.compcode = btune_codecs[state->step++];
+        if (next.compcode != state->best.compcode) {
+          state->current = next;
+          return true;
+        }
+      }
+      return false;
+    case BTUNE_CLEVELS:
+      if (entering) {
+        // Speed favours lower clevels, and cratio higher ones
+        state->direction = state->tradeoff < 0.5 ? -1 : 1;
+      }
+      value = climb(state, entering, improved, state->best.clevel, 1, 9);
+      if (value == INT_MIN) {
+        return false;
+      }
+      next.clevel = (uint8_t)value;
+      state->current = next;
+      return true;
+    case BTUNE_BLOCKSIZES:
+      if (!state->tune_blocksize) {
+        return false;
+      }
+      if (entering) {
+        state->direction = 1;
+      }
+      value = climb(state, entering, improved, state->best.bshift, -BTUNE_MAX_BSHIFT, BTUNE_MAX_BSHIFT);
+      if (value == INT_MIN) {
+        return false;
+      }
+      next.bshift = (int8_t)value;
+      state->current = next;
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+/* Choose the candidate for the next chunk */
+static void next_candidate(btune_state *state, bool improved) {
+  bool entering = false;
+
+  if (state->phase == BTUNE_BASELINE) {
+    state->phase = BTUNE_FILTERS;
+    entering = true;
+  }
+  while (state->phase != BTUNE_STEADY) {
+    if (next_in_phase(state, entering, improved)) {
+      return;
+    }
+    state->phase++;
+    entering = true;
+  }
+
+  state->current = state->best;
+  state->steady_cratio = 0;
+  state->ndrifts = 0;
+  BLOSC_INFO("btune: settled on compcode %d, filter %d, clevel %d and blocksize shift %d after %d chunks",
+             state->best.compcode, state->best.filter, state->best.clevel, state->best.bshift,
+             state->nchunks);
+}
+
+
+int btune_update(blosc2_context *context, double ctime) {
+  btune_state *state = (btune_state *)context->tuner_params;
+
+  if (context->destsize <= 0 || context->sourcesize <= 0) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  double cratio = (double)context->sourcesize / (double)context->destsize;
+  double cspeed = (double)context->sourcesize / (ctime > 1e-9 ? ctime : 1e-9);
+  state->nchunks++;
+
+  if (state->phase == BTUNE_STEADY) {
+    if (state->steady_cratio == 0) {
+      state->steady_cratio = cratio;
+      state->steady_cspeed = cspeed;
+      return BLOSC2_ERROR_SUCCESS;
+    }
+    bool drift = cratio > state->steady_cratio * BTUNE_DRIFT_FACTOR ||
+                 cratio * BTUNE_DRIFT_FACTOR < state->steady_cratio;
+    // Speed is of no concern when only optimizing for cratio
+    if (state->tradeoff < 1) {
+      drift |= cspeed * BTUNE_DRIFT_FACTOR < state->steady_cspeed;
+    }
+    state->ndrifts = drift ? state->ndrifts + 1 : 0;
+    if (state->ndrifts >= BTUNE_MAX_DRIFTS) {
+      // Data has changed, so start over from the current candidate
+      state->phase = BTUNE_BASELINE;
+      state->nchunks = 0;
+    }
+    return BLOSC2_ERROR_SUCCESS;
+  }
+
+  double score = (1 - state->tradeoff) * log(cspeed) + state->tradeoff * log(cratio);
+  bool improved = false;
+  if (state->phase == BTUNE_BASELINE || score > state->best_score) {
+    improved = state->phase != BTUNE_BASELINE;
+    state->best = state->current;
+    state->best_score = score;
+  }
+  next_candidate(state, improved);
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+int btune_free(blosc2_context *context) {
+  free(context->tuner_params);
+  context->tuner_params = NULL;
+  return BLOSC2_ERROR_SUCCESS;
+}
@@ -0,0 +1,42 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  The built-in BTUNE tuner.  It measures the compression ratio and speed
+  of each chunk and uses them to walk the codec, filter, clevel and
+  blocksize space in turn (one candidate per chunk), keeping whatever
+  maximizes
+
+      (1 - tradeoff) * log(cspeed) + tradeoff * log(cratio)
+
+  After a few chunks it settles on the best candidate, and it starts over
+  when the ratio or speed of new chunks drifts away from what was seen
+  when it settled.
+
+  It is used when the external blosc2_btune plugin cannot be loaded, and
+  its configuration is a blosc2_btune_config.
+**********************************************************************/
+
+#ifndef BLOSC_TUNER_BTUNE_H
+#define BLOSC_TUNER_BTUNE_H
+
+#include "blosc2.h"
+
+int btune_init(void *config, blosc2_context *cctx, blosc2_context *dctx);
+
+int btune_next_blocksize(blosc2_context *context);
+
+int btune_next_cparams(blosc2_context *context);
+
+int btune_update(blosc2_context *context, double ctime);
+
+int btune_free(blosc2_context *context);
+
+#endif /* BLOSC_TUNER_BTUNE_H */
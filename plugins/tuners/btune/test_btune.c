@@ -0,0 +1,196 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Tests for the built-in BTUNE tuner.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "blosc2.h"
+#include "blosc2/tuners-registry.h"
+
+#define NCHUNKS 40
+#define NSETTLED 10
+#define CHUNKSIZE (32 * 1024)
+
+
+/* A noisy ramp of floats: the best parameters are far from the defaults */
+static void fill_ramp(float *buffer, int nchunk) {
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    buffer[i] = (float)(nchunk * CHUNKSIZE + i) * 0.25f + (float)(rand() % 4);
+  }
+}
+
+static void fill_random(float *buffer) {
+  uint8_t *bytes = (uint8_t *)buffer;
+  for (size_t i = 0; i < CHUNKSIZE * sizeof(float); i++) {
+    bytes[i] = (uint8_t)rand();
+  }
+}
+
+/* What a chunk header tells about the parameters used for it */
+typedef struct {
+  const char *complib;
+  int flags;
+  int32_t blocksize;
+} chunk_params;
+
+static int get_chunk_params(blosc2_schunk *schunk, int64_t nchunk, chunk_params *params) {
+  uint8_t *chunk;
+  bool needs_free;
+  size_t typesize;
+  if (blosc2_schunk_get_chunk(schunk, nchunk, &chunk, &needs_free) < 0) {
+    return -1;
+  }
+  params->complib = blosc2_cbuffer_complib(chunk);
+  blosc1_cbuffer_metainfo(chunk, &typesize, &params->flags);
+  blosc2_cbuffer_sizes(chunk, NULL, NULL, &params->blocksize);
+  if (needs_free) {
+    free(chunk);
+  }
+  return 0;
+}
+
+static bool same_params(chunk_params *a, chunk_params *b) {
+  return strcmp(a->complib, b->complib) == 0 && a->flags == b->flags && a->blocksize == b->blocksize;
+}
+
+static blosc2_schunk *new_schunk(blosc2_btune_config *config) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(float);
+  cparams.tuner_id = BLOSC_BTUNE;
+  cparams.tuner_params = config;
+  blosc2_storage storage = {.cparams = &cparams, .contiguous = false};
+  return blosc2_schunk_new(&storage);
+}
+
+
+/* Tuning for cratio only is deterministic: it must settle, never be worse
+   than the defaults and keep the data intact */
+static int test_settle(void) {
+  float *data = malloc(CHUNKSIZE * sizeof(float));
+  float *data_dest = malloc(CHUNKSIZE * sizeof(float));
+  blosc2_btune_config config = {.tradeoff = 1};
+  blosc2_schunk *schunk = new_schunk(&config);
+  int rc = -1;
+
+  srand(1);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_ramp(data, nchunk);
+    if (blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE * sizeof(float)) != nchunk + 1) {
+      printf("Error appending chunk %d\n", nchunk);
+      goto out;
+    }
+  }
+
+  srand(1);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_ramp(data, nchunk);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, CHUNKSIZE * sizeof(float));
+    if (dsize != CHUNKSIZE * sizeof(float) || memcmp(data, data_dest, dsize) != 0) {
+      printf("Chunk %d does not round trip\n", nchunk);
+      goto out;
+    }
+  }
+
+  chunk_params first, last, params;
+  get_chunk_params(schunk, 0, &first);
+  get_chunk_params(schunk, NCHUNKS - 1, &last);
+  for (int nchunk = NCHUNKS - NSETTLED; nchunk < NCHUNKS; nchunk++) {
+    get_chunk_params(schunk, nchunk, &params);
+    if (!same_params(&params, &last)) {
+      printf("Tuner did not settle (chunk %d)\n", nchunk);
+      goto out;
+    }
+  }
+  if (same_params(&first, &last)) {
+    printf("Tuner did not move from the defaults\n");
+    goto out;
+  }
+
+  /* The defaults on the same data */
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(float);
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  uint8_t *chunk = malloc(CHUNKSIZE * sizeof(float) + BLOSC2_MAX_OVERHEAD);
+  int cbytes_default = blosc2_compress_ctx(cctx, data, CHUNKSIZE * sizeof(float), chunk,
+                                           CHUNKSIZE * sizeof(float) + BLOSC2_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  free(chunk);
+  int32_t cbytes_tuned;
+  uint8_t *tuned;
+  bool needs_free;
+  blosc2_schunk_get_chunk(schunk, NCHUNKS - 1, &tuned, &needs_free);
+  blosc2_cbuffer_sizes(tuned, NULL, &cbytes_tuned, NULL);
+  if (needs_free) {
+    free(tuned);
+  }
+  printf("Settled on %s (flags 0x%x, blocksize %d): %d bytes vs %d with the defaults\n",
+         last.complib, last.flags, last.blocksize, cbytes_tuned, cbytes_default);
+  if (cbytes_tuned > cbytes_default) {
+    printf("Tuned chunk is larger than the default one\n");
+    goto out;
+  }
+  rc = 0;
+
+  out:
+  blosc2_schunk_free(schunk);
+  free(data);
+  free(data_dest);
+  return rc;
+}
+
+
+/* After settling, a change in the data makes the tuner start over */
+static int test_drift(void) {
+  float *data = malloc(CHUNKSIZE * sizeof(float));
+  blosc2_btune_config config = {.tradeoff = 1};
+  blosc2_schunk *schunk = new_schunk(&config);
+  int rc = -1;
+
+  srand(2);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_ramp(data, nchunk);
+    blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE * sizeof(float));
+  }
+  for (int nchunk = 0; nchunk < NSETTLED; nchunk++) {
+    fill_random(data);
+    blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE * sizeof(float));
+  }
+
+  chunk_params settled, params;
+  get_chunk_params(schunk, NCHUNKS - 1, &settled);
+  for (int nchunk = NCHUNKS; nchunk < NCHUNKS + NSETTLED; nchunk++) {
+    get_chunk_params(schunk, nchunk, &params);
+    if (!same_params(&params, &settled)) {
+      rc = 0;
+      break;
+    }
+  }
+  if (rc < 0) {
+    printf("Tuner did not start over after the data changed\n");
+  }
+
+  blosc2_schunk_free(schunk);
+  free(data);
+  return rc;
+}
+
+
+int main(void) {
+  blosc2_init();
+
+  int result = test_settle();
+  if (result == 0) {
+    result = test_drift();
+  }
+
+  blosc2_destroy();
+  if (result == 0) {
+    printf("btune tests succeeded\n");
+  }
+  return result;
+}
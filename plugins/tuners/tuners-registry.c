@@ -5,6 +5,7 @@
 */
 
 #include "blosc2/tuners-registry.h"
+#include "btune/btune.h"
 #include "blosc-private.h"
 #include "blosc2.h"
 
@@ -23,3 +24,16 @@ void register_tuners(void) {
 
   register_tuner_private(&btune);
 }
+
+int fill_builtin_tuner(blosc2_tuner *tuner) {
+  if (tuner->id != BLOSC_BTUNE) {
+    return BLOSC2_ERROR_FAILURE;
+  }
+  tuner->init = btune_init;
+  tuner->next_cparams = btune_next_cparams;
+  tuner->next_blocksize = btune_next_blocksize;
+  tuner->update = btune_update;
+  tuner->free = btune_free;
+
+  return BLOSC2_ERROR_SUCCESS;
+}
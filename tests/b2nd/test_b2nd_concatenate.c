@@ -150,6 +150,10 @@ CUTEST_TEST_SETUP(concatenate) {
       {2, 1, {10, 8}, {2, 2}, {1, 1}, {10, 8}, {2, 2}, {1, 1}},
       {2, 0, {4, 4}, {4, 4}, {2, 2}, {4, 4}, {4, 4}, {2, 2}},
       {2, 1, {25, 50}, {25, 25}, {5, 5}, {25, 5}, {25, 25}, {5, 5}},
+      // Aligned chunk grids: chunks of src2 are appended or updated as they are
+      {2, 0, {10, 10}, {5, 5}, {5, 5}, {13, 10}, {5, 5}, {5, 5}},
+      {2, 1, {5, 10}, {5, 5}, {5, 5}, {5, 7}, {5, 5}, {5, 5}},
+      {2, 1, {10, 10}, {5, 5}, {5, 5}, {10, 15}, {5, 5}, {5, 5}},
       // 3-dim
       {3, 0, {50, 5, 50}, {25, 13, 10}, {5, 8, 5}, {50, 5, 50}, {25, 13, 10}, {5, 8, 5}},
       {3, 1, {50, 5, 50}, {25, 13, 10}, {5, 8, 5}, {50, 5, 50}, {25, 13, 10}, {5, 8, 5}},
@@ -11,11 +11,20 @@
 #include "test_common.h"
 
 
-static int check_get_and_set_orthogonal_selection(void) {
+typedef struct {
+  int32_t chunkshape[3];
+  int32_t blockshape[3];
+} test_orthogonal_shapes_t;
+
+
+static int check_get_and_set_orthogonal_selection(int16_t nthreads, _test_backend backend,
+                                                  test_orthogonal_shapes_t shapes) {
   const int8_t ndim = 3;
   const int64_t shape[] = {10, 10, 10};
-  const int32_t chunkshape[] = {10, 10, 10};
-  const int32_t blockshape[] = {10, 10, 10};
+  const int32_t *chunkshape = shapes.chunkshape;
+  const int32_t *blockshape = shapes.blockshape;
+  char *urlpath = "test_b2nd_orthogonal_selection.b2nd";
+  blosc2_remove_urlpath(urlpath);
   const int64_t nitems = 1000;
 
   int32_t src[1000];
@@ -29,12 +38,16 @@ static int check_get_and_set_orthogonal_selection(void) {
 
   blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
   cparams.typesize = sizeof(int32_t);
-  cparams.nthreads = 1;
+  cparams.nthreads = nthreads;
   blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
-  dparams.nthreads = 1;
+  dparams.nthreads = nthreads;
   blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
   storage.cparams = &cparams;
   storage.dparams = &dparams;
+  storage.contiguous = backend.contiguous;
+  if (backend.persistent) {
+    storage.urlpath = urlpath;
+  }
 
   b2nd_context_t *ctx = b2nd_create_ctx(&storage, ndim, shape, chunkshape, blockshape,
                                         NULL, 0, NULL, 0);
@@ -87,19 +100,44 @@ static int check_get_and_set_orthogonal_selection(void) {
     CUTEST_ASSERT("Orthogonal set selection mismatch", roundtrip[i] == replacement[i]);
   }
 
+  // Items outside of the selection are left untouched
+  int32_t all[1000];
+  B2ND_TEST_ASSERT(b2nd_to_cbuffer(array, all, nitems * (int64_t)sizeof(int32_t)));
+  int nchanged = 0;
+  for (int64_t i = 0; i < nitems; ++i) {
+    nchanged += all[i] != src[i];
+  }
+  CUTEST_ASSERT("Orthogonal set changed items outside of the selection", nchanged == set_out_nitems);
+
   b2nd_free(array);
   b2nd_free_ctx(ctx);
+  blosc2_remove_urlpath(urlpath);
   return 0;
 }
 
 
 CUTEST_TEST_SETUP(orthogonal_selection) {
   blosc2_init();
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(1, 4));
+  CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+      {false, false},
+      {true, true},
+      {false, true},
+  ));
+  // A single chunk, and many chunks (processed one per thread)
+  CUTEST_PARAMETRIZE(shapes, test_orthogonal_shapes_t, CUTEST_DATA(
+      {{10, 10, 10}, {10, 10, 10}},
+      {{3, 4, 5}, {2, 2, 5}},
+  ));
 }
 
 CUTEST_TEST_TEST(orthogonal_selection) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(backend, _test_backend);
+  CUTEST_GET_PARAMETER(shapes, test_orthogonal_shapes_t);
   CUTEST_ASSERT("Orthogonal selection regression check failed",
-                check_get_and_set_orthogonal_selection() == 0);
+                check_get_and_set_orthogonal_selection(nthreads, backend, shapes) == 0);
   return 0;
 }
 
@@ -0,0 +1,134 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+// Arrays are rechunked with memory budgets from less than a chunk to the whole array
+
+#include "test_common.h"
+
+typedef struct {
+  int8_t ndim;
+  int64_t shape[B2ND_MAX_DIM];
+  int32_t chunkshape[B2ND_MAX_DIM];
+  int32_t blockshape[B2ND_MAX_DIM];
+  int32_t chunkshape2[B2ND_MAX_DIM];
+  int32_t blockshape2[B2ND_MAX_DIM];
+} test_shapes_t;
+
+
+CUTEST_TEST_SETUP(rechunk) {
+  blosc2_init();
+
+  CUTEST_PARAMETRIZE(shapes, test_shapes_t, CUTEST_DATA(
+      {1, {1000}, {300}, {70}, {128}, {32}},
+      {2, {50, 60}, {10, 60}, {5, 20}, {50, 7}, {25, 7}},  // space-major to time-major
+      {3, {40, 15, 23}, {31, 5, 22}, {4, 4, 4}, {30, 5, 20}, {10, 4, 4}},
+      {3, {21, 22, 23}, {7, 11, 23}, {7, 11, 5}, {3, 4, 5}, {3, 2, 5}},
+  ));
+  CUTEST_PARAMETRIZE(memory_budget, int64_t, CUTEST_DATA(
+      1,  // one chunk at a time
+      4 * 1024,
+      0,  // the default (the whole array)
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(1, 4));
+  CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+      {false, false},
+      {true, true},
+  ));
+}
+
+CUTEST_TEST_TEST(rechunk) {
+  CUTEST_GET_PARAMETER(shapes, test_shapes_t);
+  CUTEST_GET_PARAMETER(memory_budget, int64_t);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(backend, _test_backend);
+
+  char *urlpath = "test_b2nd_rechunk.b2frame";
+  blosc2_remove_urlpath(urlpath);
+  uint8_t typesize = sizeof(int32_t);
+  double datatoserialize = 8.34;
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.nthreads = nthreads;
+  cparams.typesize = typesize;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage b2_storage = {.cparams=&cparams, .dparams=&dparams};
+
+  blosc2_metalayer metalayers[B2ND_MAX_METALAYERS];
+  metalayers[0].name = "random";
+  metalayers[0].content = (uint8_t *) &datatoserialize;
+  metalayers[0].content_len = 8;
+  b2nd_context_t *ctx = b2nd_create_ctx(&b2_storage, shapes.ndim, shapes.shape, shapes.chunkshape,
+                                        shapes.blockshape, NULL, 0, metalayers, 1);
+
+  size_t buffersize = typesize;
+  for (int i = 0; i < ctx->ndim; ++i) {
+    buffersize *= (size_t) ctx->shape[i];
+  }
+  uint8_t *buffer = malloc(buffersize);
+  CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, typesize, buffersize / typesize));
+  b2nd_array_t *src;
+  B2ND_TEST_ASSERT(b2nd_from_cbuffer(ctx, &src, buffer, buffersize));
+  B2ND_TEST_ASSERT(blosc2_vlmeta_add(src->sc, "random", (uint8_t *) &datatoserialize, 8, NULL));
+
+  if (backend.persistent) {
+    b2_storage.urlpath = urlpath;
+  }
+  b2_storage.contiguous = backend.contiguous;
+  b2nd_context_t *ctx2 = b2nd_create_ctx(&b2_storage, shapes.ndim, shapes.shape, shapes.chunkshape2,
+                                         shapes.blockshape2, NULL, 0, NULL, 0);
+  b2nd_array_t *dest;
+  B2ND_TEST_ASSERT(b2nd_rechunk(ctx2, src, memory_budget, &dest));
+  if (backend.persistent) {
+    // The rechunked array has to be complete on disk
+    B2ND_TEST_ASSERT(b2nd_free(dest));
+    B2ND_TEST_ASSERT(b2nd_open(urlpath, &dest));
+  }
+
+  int64_t nchunks = 1;
+  for (int i = 0; i < shapes.ndim; ++i) {
+    CUTEST_ASSERT("Wrong shape", dest->shape[i] == shapes.shape[i]);
+    CUTEST_ASSERT("Wrong chunkshape", dest->chunkshape[i] == shapes.chunkshape2[i]);
+    CUTEST_ASSERT("Wrong blockshape", dest->blockshape[i] == shapes.blockshape2[i]);
+    nchunks *= (shapes.shape[i] + shapes.chunkshape2[i] - 1) / shapes.chunkshape2[i];
+  }
+  CUTEST_ASSERT("Wrong number of chunks", dest->sc->nchunks == nchunks);
+
+  uint8_t *content;
+  int32_t content_len;
+  B2ND_TEST_ASSERT(blosc2_meta_get(dest->sc, "random", &content, &content_len));
+  CUTEST_ASSERT("Metalayer not copied", *((double *) content) == datatoserialize);
+  free(content);
+  B2ND_TEST_ASSERT(blosc2_vlmeta_get(dest->sc, "random", &content, &content_len));
+  CUTEST_ASSERT("Variable-length metalayer not copied", *((double *) content) == datatoserialize);
+  free(content);
+
+  uint8_t *buffer_dest = malloc(buffersize);
+  B2ND_TEST_ASSERT(b2nd_to_cbuffer(dest, buffer_dest, buffersize));
+  B2ND_TEST_ASSERT_BUFFER(buffer, buffer_dest, (int) buffersize);
+
+  free(buffer);
+  free(buffer_dest);
+  B2ND_TEST_ASSERT(b2nd_free(src));
+  B2ND_TEST_ASSERT(b2nd_free(dest));
+  B2ND_TEST_ASSERT(b2nd_free_ctx(ctx));
+  B2ND_TEST_ASSERT(b2nd_free_ctx(ctx2));
+  blosc2_remove_urlpath(urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(rechunk) {
+  blosc2_destroy();
+}
+
+int main() {
+  CUTEST_TEST_RUN(rechunk);
+}
@@ -0,0 +1,135 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+// Slices spanning many chunks are got and set with one chunk per thread
+
+#include "test_common.h"
+
+#define NDIM 3
+
+typedef struct {
+  int64_t start[NDIM];
+  int64_t stop[NDIM];
+} test_slice_t;
+
+static const int64_t shape[NDIM] = {40, 33, 27};
+static const int32_t chunkshape[NDIM] = {10, 8, 9};
+static const int32_t blockshape[NDIM] = {5, 4, 3};
+
+
+CUTEST_TEST_SETUP(slice_parallel) {
+  blosc2_init();
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(1, 2, 4));
+  CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+      {false, false},
+      {true, false},
+      {true, true},
+      {false, true},
+  ));
+  CUTEST_PARAMETRIZE(slice, test_slice_t, CUTEST_DATA(
+      {{0, 0, 0}, {40, 33, 27}},  // the whole array
+      {{3, 5, 2}, {37, 30, 25}},  // most of every chunk
+      {{9, 7, 8}, {21, 17, 19}},  // a few blocks of each chunk
+      {{10, 8, 0}, {30, 24, 27}},  // whole chunks only
+  ));
+}
+
+CUTEST_TEST_TEST(slice_parallel) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(backend, _test_backend);
+  CUTEST_GET_PARAMETER(slice, test_slice_t);
+
+  char *urlpath = "test_b2nd_slice_parallel.b2frame";
+  blosc2_remove_urlpath(urlpath);
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.nthreads = nthreads;
+  cparams.typesize = sizeof(int64_t);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage b2_storage = {.cparams=&cparams, .dparams=&dparams};
+  if (backend.persistent) {
+    b2_storage.urlpath = urlpath;
+  }
+  b2_storage.contiguous = backend.contiguous;
+
+  b2nd_context_t *ctx = b2nd_create_ctx(&b2_storage, NDIM, shape, chunkshape, blockshape, NULL, 0, NULL, 0);
+  CUTEST_ASSERT("Could not create the context", ctx != NULL);
+
+  int64_t nitems = shape[0] * shape[1] * shape[2];
+  int64_t *array_buffer = malloc(nitems * sizeof(int64_t));
+  for (int64_t i = 0; i < nitems; ++i) {
+    array_buffer[i] = i;
+  }
+  b2nd_array_t *array;
+  B2ND_TEST_ASSERT(b2nd_from_cbuffer(ctx, &array, array_buffer, nitems * sizeof(int64_t)));
+
+  int64_t slice_shape[NDIM];
+  int64_t slice_nitems = 1;
+  for (int i = 0; i < NDIM; ++i) {
+    slice_shape[i] = slice.stop[i] - slice.start[i];
+    slice_nitems *= slice_shape[i];
+  }
+  int64_t slice_nbytes = slice_nitems * (int64_t) sizeof(int64_t);
+  int64_t *slice_buffer = malloc(slice_nbytes);
+
+  // Get the slice
+  B2ND_TEST_ASSERT(b2nd_get_slice_cbuffer(array, slice.start, slice.stop, slice_buffer, slice_shape,
+                                          slice_nbytes));
+  int64_t n = 0;
+  for (int64_t i = slice.start[0]; i < slice.stop[0]; ++i) {
+    for (int64_t j = slice.start[1]; j < slice.stop[1]; ++j) {
+      for (int64_t k = slice.start[2]; k < slice.stop[2]; ++k) {
+        CUTEST_ASSERT("Wrong item in the slice",
+                      slice_buffer[n++] == (i * shape[1] + j) * shape[2] + k);
+      }
+    }
+  }
+
+  // Set it to new values, leaving the rest of the array untouched
+  for (int64_t i = 0; i < slice_nitems; ++i) {
+    slice_buffer[i] = -i - 1;
+  }
+  B2ND_TEST_ASSERT(b2nd_set_slice_cbuffer(slice_buffer, slice_shape, slice_nbytes, slice.start, slice.stop,
+                                          array));
+  B2ND_TEST_ASSERT(b2nd_to_cbuffer(array, array_buffer, nitems * sizeof(int64_t)));
+  n = 0;
+  for (int64_t i = 0; i < shape[0]; ++i) {
+    for (int64_t j = 0; j < shape[1]; ++j) {
+      for (int64_t k = 0; k < shape[2]; ++k) {
+        int64_t item = array_buffer[(i * shape[1] + j) * shape[2] + k];
+        bool inside = i >= slice.start[0] && i < slice.stop[0] && j >= slice.start[1] &&
+                      j < slice.stop[1] && k >= slice.start[2] && k < slice.stop[2];
+        if (inside) {
+          CUTEST_ASSERT("Wrong item set in the slice", item == -(++n));
+        } else {
+          CUTEST_ASSERT("Item outside of the slice changed", item == (i * shape[1] + j) * shape[2] + k);
+        }
+      }
+    }
+  }
+
+  free(slice_buffer);
+  free(array_buffer);
+  B2ND_TEST_ASSERT(b2nd_free(array));
+  B2ND_TEST_ASSERT(b2nd_free_ctx(ctx));
+  blosc2_remove_urlpath(urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(slice_parallel) {
+  blosc2_destroy();
+}
+
+int main() {
+  CUTEST_TEST_RUN(slice_parallel);
+}
@@ -0,0 +1,198 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test for the deferred offsets index of on-disk frames
+  (blosc2_schunk_set_append_batch / blosc2_schunk_flush).
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+
+#define NCHUNKS (40)
+#define CHUNKSHAPE (5 * 1000)
+#define NTHREADS 2
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  char *ref_urlpath;
+} test_append_batch_backend;
+
+CUTEST_TEST_DATA(append_batch) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(append_batch) {
+  blosc2_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.clevel = 5;
+  data->cparams.nthreads = NTHREADS;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = NTHREADS;
+
+  CUTEST_PARAMETRIZE(batch, int, CUTEST_DATA(
+      1,
+      7,
+      -1,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_append_batch_backend, CUTEST_DATA(
+      {true, "test_append_batch.b2frame", "test_append_batch_ref.b2frame"}, // disk - cframe
+      {false, "test_append_batch_s.b2frame", "test_append_batch_ref_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+static int check_chunks(blosc2_schunk *schunk, int64_t nchunks, int32_t *buffer) {
+  if (schunk->nchunks != nchunks) {
+    return -1;
+  }
+  int32_t isize = CHUNKSHAPE * (int32_t)sizeof(int32_t);
+  for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, buffer, isize);
+    if (dsize != isize) {
+      return -1;
+    }
+    for (int j = 0; j < CHUNKSHAPE; j++) {
+      // Every 5th chunk is made of zeros (a special chunk)
+      int32_t expected = (nchunk % 5 == 4) ? 0 : (int32_t)(j + nchunk * CHUNKSHAPE);
+      if (buffer[j] != expected) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+
+static int append_chunks(blosc2_schunk *schunk, int64_t start, int64_t stop, int32_t *buffer) {
+  int32_t isize = CHUNKSHAPE * (int32_t)sizeof(int32_t);
+  for (int64_t nchunk = start; nchunk < stop; nchunk++) {
+    int64_t rc;
+    if (nchunk % 5 == 4) {
+      uint8_t chunk[BLOSC_EXTENDED_HEADER_LENGTH];
+      blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+      cparams.typesize = sizeof(int32_t);
+      if (blosc2_chunk_zeros(cparams, isize, chunk, sizeof(chunk)) < 0) {
+        return -1;
+      }
+      rc = blosc2_schunk_append_chunk(schunk, chunk, true);
+    }
+    else {
+      for (int j = 0; j < CHUNKSHAPE; j++) {
+        buffer[j] = (int32_t)(j + nchunk * CHUNKSHAPE);
+      }
+      rc = blosc2_schunk_append_buffer(schunk, buffer, isize);
+    }
+    if (rc != nchunk + 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+CUTEST_TEST_TEST(append_batch) {
+  CUTEST_GET_PARAMETER(batch, int);
+  CUTEST_GET_PARAMETER(backend, test_append_batch_backend);
+
+  int32_t *buffer = malloc(CHUNKSHAPE * sizeof(int32_t));
+
+  // In-memory super-chunks have nothing to defer
+  blosc2_storage mem_storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                                .contiguous=true};
+  blosc2_schunk *mem_schunk = blosc2_schunk_new(&mem_storage);
+  CUTEST_ASSERT("Deferred appends should not be accepted in memory",
+                blosc2_schunk_set_append_batch(mem_schunk, batch) < 0);
+  blosc2_schunk_free(mem_schunk);
+
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+  CUTEST_ASSERT("Cannot set the append batch",
+                blosc2_schunk_set_append_batch(schunk, batch) == 0);
+
+  // Half of the chunks, committed explicitly
+  CUTEST_ASSERT("Cannot append chunks", append_chunks(schunk, 0, NCHUNKS / 2, buffer) == 0);
+  CUTEST_ASSERT("Wrong pending chunks", check_chunks(schunk, NCHUNKS / 2, buffer) == 0);
+  CUTEST_ASSERT("Cannot flush", blosc2_schunk_flush(schunk) == 0);
+
+  // The batches leave no unreferenced bytes behind
+  blosc2_storage ref_storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                                .urlpath=backend.ref_urlpath, .contiguous=backend.contiguous};
+  blosc2_remove_urlpath(backend.ref_urlpath);
+  blosc2_schunk *ref = blosc2_schunk_new(&ref_storage);
+  CUTEST_ASSERT("Cannot append chunks", append_chunks(ref, 0, NCHUNKS / 2, buffer) == 0);
+  CUTEST_ASSERT("Wrong cbytes", schunk->cbytes == ref->cbytes);
+  blosc2_schunk_free(ref);
+  blosc2_remove_urlpath(backend.ref_urlpath);
+
+  // The rest is left pending (unless the batch commits it)
+  CUTEST_ASSERT("Cannot append chunks",
+                append_chunks(schunk, NCHUNKS / 2, NCHUNKS, buffer) == 0);
+  CUTEST_ASSERT("Wrong pending chunks", check_chunks(schunk, NCHUNKS, buffer) == 0);
+  if (!backend.contiguous) {
+    // The index file of a sparse frame stays at the last commit, so another
+    // handle sees at least the committed half
+    blosc2_schunk *reader = blosc2_schunk_open(backend.urlpath);
+    CUTEST_ASSERT("Cannot open the frame while appends are pending", reader != NULL);
+    int64_t committed = NCHUNKS / 2;
+    if (batch > 0) {
+      committed += (NCHUNKS - NCHUNKS / 2) / batch * batch;
+    }
+    CUTEST_ASSERT("Wrong committed chunks", check_chunks(reader, committed, buffer) == 0);
+    blosc2_schunk_free(reader);
+  }
+
+  // Any other mutation commits the pending appends first
+  int32_t isize = CHUNKSHAPE * (int32_t)sizeof(int32_t);
+  for (int j = 0; j < CHUNKSHAPE; j++) {
+    buffer[j] = j + 1 * CHUNKSHAPE;
+  }
+  uint8_t *chunk = malloc(isize + BLOSC2_MAX_OVERHEAD);
+  int csize = blosc2_compress_ctx(schunk->cctx, buffer, isize, chunk, isize + BLOSC2_MAX_OVERHEAD);
+  CUTEST_ASSERT("Cannot compress chunk", csize > 0);
+  CUTEST_ASSERT("Cannot update chunk", blosc2_schunk_update_chunk(schunk, 1, chunk, true) == NCHUNKS);
+  free(chunk);
+  CUTEST_ASSERT("Wrong chunks after update", check_chunks(schunk, NCHUNKS, buffer) == 0);
+
+  // Some more pending appends, committed on free
+  CUTEST_ASSERT("Cannot append chunks",
+                append_chunks(schunk, NCHUNKS, NCHUNKS + 3, buffer) == 0);
+  int64_t nbytes = schunk->nbytes;
+  CUTEST_ASSERT("Error freeing schunk", blosc2_schunk_free(schunk) == 0);
+
+  schunk = blosc2_schunk_open(backend.urlpath);
+  CUTEST_ASSERT("Cannot reopen the frame", schunk != NULL);
+  CUTEST_ASSERT("Wrong nbytes after reopening", schunk->nbytes == nbytes);
+  CUTEST_ASSERT("Wrong chunks after reopening", check_chunks(schunk, NCHUNKS + 3, buffer) == 0);
+  // A regular append still works on a frame written in batches
+  CUTEST_ASSERT("Cannot append chunks",
+                append_chunks(schunk, NCHUNKS + 3, NCHUNKS + 4, buffer) == 0);
+  CUTEST_ASSERT("Wrong chunks after append", check_chunks(schunk, NCHUNKS + 4, buffer) == 0);
+  blosc2_schunk_free(schunk);
+
+  blosc2_remove_urlpath(backend.urlpath);
+  free(buffer);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(append_batch) {
+  BLOSC_UNUSED_PARAM(data);
+  blosc2_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(append_batch);
+}
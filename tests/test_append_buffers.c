@@ -0,0 +1,134 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Tests for appending several buffers at once to super-chunks.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+
+#define CHUNKSHAPE (16 * 1000)
+#define CHUNKSIZE (CHUNKSHAPE * sizeof(int32_t))
+#define NBUFFERS 25
+
+/* Global vars */
+int tests_run = 0;
+char *urlpath;
+bool contiguous;
+int16_t nthreads;
+
+static int32_t *data[NBUFFERS];
+static const void *srcs[NBUFFERS];
+static int32_t nbytes[NBUFFERS];
+static int32_t data_dest[CHUNKSHAPE];
+
+
+static blosc2_schunk* create_schunk(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams};
+  blosc2_remove_urlpath(urlpath);
+  return blosc2_schunk_new(&storage);
+}
+
+static bool check_schunk(blosc2_schunk *schunk, int64_t nchunks) {
+  if (schunk->nchunks != nchunks) {
+    return false;
+  }
+  for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+    int i = (int)(nchunk % NBUFFERS);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, CHUNKSIZE);
+    if (dsize != nbytes[i] || memcmp(data[i], data_dest, (size_t)dsize) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+static char* test_append_buffers(void) {
+  blosc2_schunk *schunk = create_schunk();
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  mu_assert("ERROR: appending no buffers should do nothing",
+            blosc2_schunk_append_buffers(schunk, 0, NULL, NULL) == 0);
+  // The last buffer is shorter, so the batch can only go once
+  mu_assert("ERROR: cannot append the buffers",
+            blosc2_schunk_append_buffers(schunk, NBUFFERS - 1, srcs, nbytes) == NBUFFERS - 1);
+  mu_assert("ERROR: cannot append the last buffer",
+            blosc2_schunk_append_buffers(schunk, 1, srcs + NBUFFERS - 1, nbytes + NBUFFERS - 1) == NBUFFERS);
+  mu_assert("ERROR: wrong data", check_schunk(schunk, NBUFFERS));
+  mu_assert("ERROR: wrong nbytes",
+            schunk->nbytes == (NBUFFERS - 1) * (int64_t)CHUNKSIZE + nbytes[NBUFFERS - 1]);
+
+  // Reopening gives the same
+  if (urlpath != NULL) {
+    blosc2_schunk_free(schunk);
+    schunk = blosc2_schunk_open(urlpath);
+    mu_assert("ERROR: cannot reopen the super-chunk", schunk != NULL);
+    mu_assert("ERROR: wrong data after reopening", check_schunk(schunk, NBUFFERS));
+  }
+
+  mu_assert("ERROR: a negative number of buffers should fail",
+            blosc2_schunk_append_buffers(schunk, -1, srcs, nbytes) < 0);
+  mu_assert("ERROR: a failed call should not append anything", schunk->nchunks == NBUFFERS);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  char *urlpaths[] = {NULL, "test_append_buffers.b2frame", "test_append_buffers_s.b2frame"};
+  bool contiguous_[] = {true, true, false};
+  int16_t nthreads_[] = {1, 4};
+  for (int i = 0; i < (int)ARRAY_SIZE(urlpaths); i++) {
+    for (int j = 0; j < (int)ARRAY_SIZE(nthreads_); j++) {
+      urlpath = urlpaths[i];
+      contiguous = contiguous_[i];
+      nthreads = nthreads_[j];
+      mu_run_test(test_append_buffers);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  for (int i = 0; i < NBUFFERS; i++) {
+    data[i] = malloc(CHUNKSIZE);
+    for (int j = 0; j < CHUNKSHAPE; j++) {
+      data[i][j] = i * CHUNKSHAPE + j;
+    }
+    srcs[i] = data[i];
+    nbytes[i] = i == NBUFFERS - 1 ? CHUNKSIZE / 2 : CHUNKSIZE;
+  }
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  for (int i = 0; i < NBUFFERS; i++) {
+    free(data[i]);
+  }
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Roundtrip tests for the AVX512-accelerated BloscLZ codec.
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "test_common.h"
+#include "../blosc/blosclz-generic.h"
+
+/* Include accelerated codecs if supported by this compiler and CPU. */
+
+#if defined(SHUFFLE_AVX512_ENABLED)
+  #include "../blosc/blosclz-avx512.h"
+#else
+  #if defined(_MSC_VER)
+    #pragma message("AVX512 BloscLZ tests not enabled.")
+  #else
+    #warning AVX512 BloscLZ tests not enabled.
+  #endif
+#endif  /* defined(SHUFFLE_AVX512_ENABLED) */
+
+
+/** Roundtrip tests for the AVX512-accelerated BloscLZ codec. */
+static int test_blosclz_roundtrip_avx512(int clevel, int32_t buffer_size, int data_type, int test_type) {
+#if defined(SHUFFLE_AVX512_ENABLED)
+  if (!is_blosclz_avx512) {
+    /* The codec was not compiled for AVX512 */
+    return EXIT_SUCCESS;
+  }
+  int32_t maxout = buffer_size + buffer_size / 16 + 66;
+
+  /* Allocate memory for the test. */
+  void* original = blosc_test_malloc(32, (size_t)buffer_size);
+  void* compressed = blosc_test_malloc(32, (size_t)maxout);
+  void* decompressed = blosc_test_malloc(32, (size_t)buffer_size);
+
+  /* Fill the input data buffer, with long or short matches, or none. */
+  switch (data_type) {
+    case 0:
+      blosc_test_fill_seq(original, (size_t)buffer_size);
+      break;
+    case 1:
+      blosc_test_fill_words(original, (size_t)buffer_size);
+      break;
+    default:
+      blosc_test_fill_random(original, (size_t)buffer_size);
+  }
+
+  /* Compress/decompress, selecting the implementations based on the test type. */
+  int csize, dsize = 0;
+  switch(test_type)
+  {
+    case 0:
+      /* avx512/avx512 */
+      csize = blosclz_compress_avx512(clevel, original, buffer_size, compressed, maxout, NULL);
+      if (csize > 0) {
+        dsize = blosclz_decompress_avx512(compressed, csize, decompressed, buffer_size);
+      }
+      break;
+    case 1:
+      /* generic/avx512 */
+      csize = blosclz_compress_generic(clevel, original, buffer_size, compressed, maxout, NULL);
+      if (csize > 0) {
+        dsize = blosclz_decompress_avx512(compressed, csize, decompressed, buffer_size);
+      }
+      break;
+    case 2:
+      /* avx512/generic */
+      csize = blosclz_compress_avx512(clevel, original, buffer_size, compressed, maxout, NULL);
+      if (csize > 0) {
+        dsize = blosclz_decompress_generic(compressed, csize, decompressed, buffer_size);
+      }
+      break;
+    default:
+      fprintf(stderr, "Invalid test type specified (%d).", test_type);
+      return EXIT_FAILURE;
+  }
+
+  /* Only random data may be left uncompressed; otherwise the round-tripped
+     data must match the original data. */
+  int exit_code;
+  if (csize == 0) {
+    exit_code = data_type == 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  else {
+    exit_code = (dsize != buffer_size || memcmp(original, decompressed, (size_t)buffer_size)) ?
+                EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  /* Free allocated memory. */
+  blosc_test_free(original);
+  blosc_test_free(compressed);
+  blosc_test_free(decompressed);
+
+  return exit_code;
+#else
+  BLOSC_UNUSED_PARAM(clevel);
+  BLOSC_UNUSED_PARAM(buffer_size);
+  BLOSC_UNUSED_PARAM(data_type);
+  BLOSC_UNUSED_PARAM(test_type);
+  return EXIT_SUCCESS;
+#endif /* defined(SHUFFLE_AVX512_ENABLED) */
+}
+
+
+/** Required number of arguments to this test, including the executable name. */
+#define TEST_ARG_COUNT  5
+
+int main(int argc, char** argv) {
+  /*  argv[1]: compression level
+      argv[2]: buffer size
+      argv[3]: data type (0: sequence, 1: words, 2: random)
+      argv[4]: test type
+  */
+
+  /*  Verify the correct number of command-line args have been specified. */
+  if (TEST_ARG_COUNT != argc) {
+    blosc_test_print_bad_argcount_msg(TEST_ARG_COUNT, argc);
+    return EXIT_FAILURE;
+  }
+
+  /* Parse arguments */
+  uint32_t clevel;
+  if (!blosc_test_parse_uint32_t(argv[1], &clevel) || (clevel < 1) || (clevel > 9)) {
+    blosc_test_print_bad_arg_msg(1);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t buffer_size;
+  if (!blosc_test_parse_uint32_t(argv[2], &buffer_size) || (buffer_size < 16)) {
+    blosc_test_print_bad_arg_msg(2);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t data_type;
+  if (!blosc_test_parse_uint32_t(argv[3], &data_type) || (data_type > 2)) {
+    blosc_test_print_bad_arg_msg(3);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t test_type;
+  if (!blosc_test_parse_uint32_t(argv[4], &test_type) || (test_type > 2)) {
+    blosc_test_print_bad_arg_msg(4);
+    return EXIT_FAILURE;
+  }
+
+  /* Run the test. */
+  return test_blosclz_roundtrip_avx512((int)clevel, (int32_t)buffer_size, (int)data_type, (int)test_type);
+}
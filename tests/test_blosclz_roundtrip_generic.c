@@ -0,0 +1,100 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Roundtrip tests for the generic BloscLZ codec.
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "test_common.h"
+#include "../blosc/blosclz-generic.h"
+
+
+/** Roundtrip tests for the generic BloscLZ codec. */
+static int test_blosclz_roundtrip_generic(int clevel, int32_t buffer_size, int data_type) {
+  int32_t maxout = buffer_size + buffer_size / 16 + 66;
+
+  /* Allocate memory for the test. */
+  void* original = blosc_test_malloc(32, (size_t)buffer_size);
+  void* compressed = blosc_test_malloc(32, (size_t)maxout);
+  void* decompressed = blosc_test_malloc(32, (size_t)buffer_size);
+
+  /* Fill the input data buffer, with long or short matches, or none. */
+  switch (data_type) {
+    case 0:
+      blosc_test_fill_seq(original, (size_t)buffer_size);
+      break;
+    case 1:
+      blosc_test_fill_words(original, (size_t)buffer_size);
+      break;
+    default:
+      blosc_test_fill_random(original, (size_t)buffer_size);
+  }
+
+  /* Generic compression, then generic decompression. */
+  int dsize = 0;
+  int csize = blosclz_compress_generic(clevel, original, buffer_size, compressed, maxout, NULL);
+  if (csize > 0) {
+    dsize = blosclz_decompress_generic(compressed, csize, decompressed, buffer_size);
+  }
+
+  /* Only random data may be left uncompressed; otherwise the round-tripped
+     data must match the original data. */
+  int exit_code;
+  if (csize == 0) {
+    exit_code = data_type == 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  else {
+    exit_code = (dsize != buffer_size || memcmp(original, decompressed, (size_t)buffer_size)) ?
+                EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  /* Free allocated memory. */
+  blosc_test_free(original);
+  blosc_test_free(compressed);
+  blosc_test_free(decompressed);
+
+  return exit_code;
+}
+
+/** Required number of arguments to this test, including the executable name. */
+#define TEST_ARG_COUNT  4
+
+int main(int argc, char** argv) {
+  /*  argv[1]: compression level
+      argv[2]: buffer size
+      argv[3]: data type (0: sequence, 1: words, 2: random)
+  */
+
+  /*  Verify the correct number of command-line args have been specified. */
+  if (TEST_ARG_COUNT != argc) {
+    blosc_test_print_bad_argcount_msg(TEST_ARG_COUNT, argc);
+    return EXIT_FAILURE;
+  }
+
+  /* Parse arguments */
+  uint32_t clevel;
+  if (!blosc_test_parse_uint32_t(argv[1], &clevel) || (clevel < 1) || (clevel > 9)) {
+    blosc_test_print_bad_arg_msg(1);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t buffer_size;
+  if (!blosc_test_parse_uint32_t(argv[2], &buffer_size) || (buffer_size < 16)) {
+    blosc_test_print_bad_arg_msg(2);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t data_type;
+  if (!blosc_test_parse_uint32_t(argv[3], &data_type) || (data_type > 2)) {
+    blosc_test_print_bad_arg_msg(3);
+    return EXIT_FAILURE;
+  }
+
+  /* Run the test. */
+  return test_blosclz_roundtrip_generic((int)clevel, (int32_t)buffer_size, (int)data_type);
+}
@@ -121,6 +121,24 @@ static inline void blosc_test_fill_random(void* const ptr, const size_t size) {
   }
 }
 
+/** Fills a buffer with words of a small random vocabulary, so that it has
+    matches of many lengths and offsets. */
+static inline void blosc_test_fill_words(void* const ptr, const size_t size) {
+  uint8_t words[8][128];
+  size_t k, i;
+  for (k = 0; k < sizeof(words); k++) {
+    ((uint8_t*)words)[k] = (uint8_t)rand();
+  }
+  uint8_t* const byte_ptr = (uint8_t*)ptr;
+  for (k = 0; k < size;) {
+    const uint8_t* word = words[rand() % 8];
+    size_t len = 16 + (size_t)rand() % (sizeof(words[0]) - 16);
+    for (i = 0; i < len && k < size; i++, k++) {
+      byte_ptr[k] = word[i];
+    }
+  }
+}
+
 /*
   Argument parsing.
 */
@@ -126,7 +126,7 @@ int main(void) {
   memcpy(future_chunk_unknown, data_out, (size_t)csize);
   future_chunk[BLOSC2_CHUNK_VERSION] = BLOSC2_VERSION_FORMAT + 1;
   future_chunk_unknown[BLOSC2_CHUNK_VERSION] = BLOSC2_VERSION_FORMAT + 1;
-  future_chunk_unknown[BLOSC2_CHUNK_BLOSC2_FLAGS2] = 0x2;
+  future_chunk_unknown[BLOSC2_CHUNK_BLOSC2_FLAGS2] = 0x4;  // a reserved bit
 
   ret = blosc2_getitem_ctx(dctx, future_chunk, csize, 5, 5, data_subset, sizeof(data_subset));
   if (ret < 0) {
@@ -0,0 +1,218 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Unit tests for the scratch memory of contexts.  Contexts keep their
+  temporaries between calls; check that results do not depend on that,
+  and that blosc2_ctx_trim_scratch() gives them back.
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "test_common.h"
+
+int tests_run = 0;
+
+#define NITEMS (100 * 1000)
+#define BLOCKSIZE (16 * 1024)
+#define NBYTES (NITEMS * (int)sizeof(int32_t))
+#define NBLOCKS ((NBYTES + BLOCKSIZE - 1) / BLOCKSIZE)
+#define URLPATH "test_ctx_trim_scratch.b2frame"
+
+int16_t nthreads = 1;
+int32_t *data;
+int32_t *dest;
+
+
+static char *check_masked(const bool *maskout) {
+  for (int i = 0; i < NITEMS; i++) {
+    int nblock = i * (int)sizeof(int32_t) / BLOCKSIZE;
+    if (!maskout[nblock]) {
+      mu_assert("ERROR: wrong values in dest", dest[i] == data[i]);
+    }
+  }
+  return 0;
+}
+
+
+// Decompress lazy chunks with masks, trimming the scratch memory in between
+static char *test_lazy_maskout_trim(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = BLOCKSIZE;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous = true, .urlpath = URLPATH, .cparams = &cparams,
+                            .dparams = &dparams};
+  blosc2_remove_urlpath(URLPATH);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create schunk", schunk != NULL);
+  for (int nchunk = 0; nchunk < 3; nchunk++) {
+    mu_assert("ERROR: cannot append chunk", blosc2_schunk_append_buffer(schunk, data, NBYTES) == nchunk + 1);
+  }
+
+  bool maskout[NBLOCKS];
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < NBLOCKS; i++) {
+      maskout[i] = (i + round) % 3 == 0;
+    }
+    for (int64_t nchunk = 0; nchunk < schunk->nchunks; nchunk++) {
+      uint8_t *lazychunk;
+      bool needs_free;
+      int cbytes = blosc2_schunk_get_lazychunk(schunk, nchunk, &lazychunk, &needs_free);
+      mu_assert("ERROR: cannot get lazy chunk", cbytes > 0);
+      memset(dest, 0, NBYTES);
+      mu_assert("ERROR: setting maskout", blosc2_set_maskout(schunk->dctx, maskout, NBLOCKS) == 0);
+      int nbytes = blosc2_decompress_ctx(schunk->dctx, lazychunk, cbytes, dest, NBYTES);
+      mu_assert("ERROR: nbytes is not correct w/ mask", nbytes == NBYTES);
+      char *msg = check_masked(maskout);
+      if (msg != NULL) {
+        return msg;
+      }
+      // Without a mask afterwards
+      nbytes = blosc2_decompress_ctx(schunk->dctx, lazychunk, cbytes, dest, NBYTES);
+      mu_assert("ERROR: nbytes is not correct w/out mask", nbytes == NBYTES);
+      mu_assert("ERROR: wrong values in dest", memcmp(dest, data, NBYTES) == 0);
+      if (needs_free) {
+        free(lazychunk);
+      }
+    }
+    if (round % 2) {
+      mu_assert("ERROR: nothing trimmed", blosc2_ctx_trim_scratch(schunk->dctx) > 0);
+      mu_assert("ERROR: trimmed twice", blosc2_ctx_trim_scratch(schunk->dctx) == 0);
+    }
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(URLPATH);
+  return 0;
+}
+
+
+// Chunks with variable-length blocks of different counts through the same contexts
+static char *test_vlblocks_trim(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = 1;
+  cparams.nthreads = nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  size_t chunk_nbytes = NBYTES + BLOSC2_MAX_OVERHEAD + 1024 * sizeof(int32_t) * 2;
+  uint8_t *chunk = malloc(chunk_nbytes);
+
+  const void *srcs[1024];
+  int32_t srcsizes[1024];
+  void *dests[1024];
+  int32_t destsizes[1024];
+  int32_t nblocks_list[] = {3, 1024, 7, 1};
+  for (int i = 0; i < (int)(sizeof(nblocks_list) / sizeof(nblocks_list[0])); i++) {
+    int32_t nblocks = nblocks_list[i];
+    int32_t offset = 0;
+    for (int32_t nblock = 0; nblock < nblocks; nblock++) {
+      srcs[nblock] = (uint8_t *)data + offset;
+      srcsizes[nblock] = 1 + (nblock * 37) % 91;
+      offset += srcsizes[nblock];
+    }
+    int cbytes = blosc2_vlcompress_ctx(cctx, srcs, srcsizes, nblocks, chunk, (int32_t)chunk_nbytes);
+    mu_assert("ERROR: cannot compress VL-block chunk", cbytes > 0);
+    int nblocks_ = blosc2_vldecompress_ctx(dctx, chunk, cbytes, dests, destsizes, 1024);
+    mu_assert("ERROR: wrong number of blocks", nblocks_ == nblocks);
+    for (int32_t nblock = 0; nblock < nblocks; nblock++) {
+      mu_assert("ERROR: wrong block size", destsizes[nblock] == srcsizes[nblock]);
+      mu_assert("ERROR: wrong block values", memcmp(dests[nblock], srcs[nblock], srcsizes[nblock]) == 0);
+      free(dests[nblock]);
+    }
+    if (i % 2) {
+      blosc2_ctx_trim_scratch(cctx);
+      blosc2_ctx_trim_scratch(dctx);
+    }
+  }
+
+  free(chunk);
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  return 0;
+}
+
+
+// Regular (de)compression after a trim
+static char *test_roundtrip_trim(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = BLOSC_MIN_BUFFERSIZE * 32;
+  cparams.nthreads = nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  uint8_t *chunk = malloc(NBYTES + BLOSC2_MAX_OVERHEAD);
+
+  for (int i = 0; i < 3; i++) {
+    int cbytes = blosc2_compress_ctx(cctx, data, NBYTES, chunk, NBYTES + BLOSC2_MAX_OVERHEAD);
+    mu_assert("ERROR: cannot compress", cbytes > 0);
+    int nbytes = blosc2_decompress_ctx(dctx, chunk, cbytes, dest, NBYTES);
+    mu_assert("ERROR: nbytes is not correct", nbytes == NBYTES);
+    mu_assert("ERROR: wrong values in dest", memcmp(dest, data, NBYTES) == 0);
+    int32_t item;
+    mu_assert("ERROR: getitem", blosc2_getitem_ctx(dctx, chunk, cbytes, 12345, 1, &item, sizeof(item)) > 0);
+    mu_assert("ERROR: wrong item", item == data[12345]);
+    if (nthreads == 1) {
+      // The serial temporaries are released too
+      mu_assert("ERROR: nothing trimmed", blosc2_ctx_trim_scratch(dctx) > 0);
+    }
+    else {
+      blosc2_ctx_trim_scratch(dctx);
+    }
+    blosc2_ctx_trim_scratch(cctx);
+  }
+
+  free(chunk);
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  return 0;
+}
+
+
+static char *all_tests(void) {
+  nthreads = 1;
+  mu_run_test(test_lazy_maskout_trim);
+  mu_run_test(test_vlblocks_trim);
+  mu_run_test(test_roundtrip_trim);
+  nthreads = 4;
+  mu_run_test(test_lazy_maskout_trim);
+  mu_run_test(test_vlblocks_trim);
+  mu_run_test(test_roundtrip_trim);
+
+  return 0;
+}
+
+
+int main(void) {
+  blosc2_init();
+
+  data = malloc(NBYTES);
+  dest = malloc(NBYTES);
+  for (int i = 0; i < NITEMS; i++) {
+    data[i] = i * 3;
+  }
+
+  char *result = all_tests();
+  if (result != 0) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  free(data);
+  free(dest);
+  blosc2_destroy();
+
+  return result != 0;
+}
@@ -0,0 +1,127 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Unit tests for the (possibly accelerated) delta encoder and decoder.
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "test_common.h"
+#include "delta.h"
+
+#define MAXBYTES (4 * 1024 + 77)
+#define FILLER 0xa5
+
+int tests_run = 0;
+
+/* One byte past the largest block is a FILLER guard, checked to be left untouched */
+static uint8_t src[2 * MAXBYTES + 1];
+static uint8_t encoded[2 * MAXBYTES + 1];
+static uint8_t expected[2 * MAXBYTES + 1];
+
+static const int32_t typesizes[] = {1, 2, 3, 4, 8, 12, 16, 24};
+static const int32_t sizes[] = {8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 1000, 4096, MAXBYTES};
+
+
+/* The filter as specified: elements of 1, 2, 4 or 8 bytes */
+static int32_t element_size(int32_t typesize) {
+  if (typesize == 1 || typesize == 2 || typesize == 4 || typesize == 8) {
+    return typesize;
+  }
+  return (typesize % 8) == 0 ? 8 : 1;
+}
+
+static void reference_encoder(const uint8_t *dref, int32_t offset, int32_t nbytes,
+                              int32_t elsize, const uint8_t *src_, uint8_t *dest) {
+  int32_t used = nbytes - nbytes % elsize;
+  for (int32_t i = 0; i < used; i++) {
+    if (offset != 0) {
+      dest[i] = src_[i] ^ dref[i];
+    } else {
+      dest[i] = (i < elsize) ? dref[i] : src_[i] ^ dref[i - elsize];
+    }
+  }
+}
+
+
+static char *test_reference_block(void) {
+  for (size_t t = 0; t < sizeof(typesizes) / sizeof(typesizes[0]); t++) {
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      int32_t typesize = typesizes[t];
+      int32_t nbytes = sizes[s];
+      int32_t elsize = element_size(typesize);
+      blosc_test_fill_random(src, (size_t)nbytes);
+      memset(encoded, FILLER, sizeof(encoded));
+      memset(expected, FILLER, sizeof(expected));
+      delta_encoder(src, 0, nbytes, typesize, src, encoded);
+      reference_encoder(src, 0, nbytes, elsize, src, expected);
+      mu_assert("ERROR: reference block not encoded as expected",
+                memcmp(encoded, expected, (size_t)nbytes + 1) == 0);
+      // The reference block decodes in place
+      delta_decoder(encoded, 0, nbytes, typesize, encoded);
+      memcpy(expected, src, (size_t)(nbytes - nbytes % elsize));
+      mu_assert("ERROR: reference block not decoded as expected",
+                memcmp(encoded, expected, (size_t)nbytes + 1) == 0);
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+
+static char *test_other_blocks(void) {
+  for (size_t t = 0; t < sizeof(typesizes) / sizeof(typesizes[0]); t++) {
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      int32_t typesize = typesizes[t];
+      int32_t nbytes = sizes[s];
+      int32_t elsize = element_size(typesize);
+      int32_t offset = MAXBYTES;
+      blosc_test_fill_random(src, (size_t)(offset + nbytes));
+      memset(encoded, FILLER, sizeof(encoded));
+      memset(expected, FILLER, sizeof(expected));
+      delta_encoder(src, offset, nbytes, typesize, src + offset, encoded + offset);
+      reference_encoder(src, offset, nbytes, elsize, src + offset, expected + offset);
+      mu_assert("ERROR: block not encoded as expected",
+                memcmp(encoded + offset, expected + offset, (size_t)nbytes + 1) == 0);
+      // Blocks decode against the (already decoded) reference block
+      memcpy(encoded, src, (size_t)offset);
+      delta_decoder(encoded, offset, nbytes, typesize, encoded + offset);
+      memcpy(expected + offset, src + offset, (size_t)(nbytes - nbytes % elsize));
+      mu_assert("ERROR: block not decoded as expected",
+                memcmp(encoded + offset, expected + offset, (size_t)nbytes + 1) == 0);
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  mu_run_test(test_reference_block);
+  mu_run_test(test_other_blocks);
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
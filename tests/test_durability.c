@@ -0,0 +1,244 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Test the durability policies of on-disk frames (blosc2_storage.durability
+  and blosc2_schunk_set_durability()), with several threads appending to the
+  same super-chunk.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+#include "threading.h"
+
+#define CHUNKSIZE (10 * 1000)
+#define NWRITERS (4)
+#define NPERWRITER (25)
+#define NCHUNKS (NWRITERS * NPERWRITER)
+
+/* Global vars */
+int tests_run = 0;
+char* urlpath;
+bool contiguous;
+bool packed;
+
+
+typedef struct {
+  blosc2_schunk* schunk;
+  int writer;
+  int rc;
+} writer_arg;
+
+
+/* Every chunk is filled with its own value, so they can be told apart */
+static void* writer_func(void* arg) {
+  writer_arg* warg = (writer_arg*)arg;
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+  int32_t* data = malloc(isize);
+  uint8_t* chunk = malloc(isize + BLOSC2_MAX_OVERHEAD);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  warg->rc = 0;
+  for (int i = 0; i < NPERWRITER && warg->rc == 0; i++) {
+    for (int j = 0; j < CHUNKSIZE; j++) {
+      data[j] = warg->writer * NPERWRITER + i;
+    }
+    int csize = blosc2_compress_ctx(cctx, data, isize, chunk, isize + BLOSC2_MAX_OVERHEAD);
+    if (csize < 0 || blosc2_schunk_append_chunk(warg->schunk, chunk, true) < 0) {
+      warg->rc = -1;
+    }
+  }
+  blosc2_free_ctx(cctx);
+  free(chunk);
+  free(data);
+  return NULL;
+}
+
+
+static char* append_concurrently(blosc2_schunk* schunk) {
+  blosc2_pthread_t threads[NWRITERS];
+  writer_arg args[NWRITERS];
+  for (int i = 0; i < NWRITERS; i++) {
+    args[i].schunk = schunk;
+    args[i].writer = i;
+    mu_assert("ERROR: cannot start writer", blosc2_pthread_create(&threads[i], NULL, writer_func, &args[i]) == 0);
+  }
+  for (int i = 0; i < NWRITERS; i++) {
+    blosc2_pthread_join(threads[i], NULL);
+    mu_assert("ERROR: a writer failed", args[i].rc == 0);
+  }
+  mu_assert("ERROR: bad number of chunks", schunk->nchunks == NCHUNKS);
+  return EXIT_SUCCESS;
+}
+
+
+/* Reopen the frame and check that every chunk is there exactly once */
+static char* check_frame(void) {
+  blosc2_schunk* schunk = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the frame", schunk != NULL);
+  mu_assert("ERROR: bad number of chunks on disk", schunk->nchunks == NCHUNKS);
+  bool seen[NCHUNKS] = {false};
+  int32_t* data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int64_t nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data, CHUNKSIZE * sizeof(int32_t));
+    mu_assert("ERROR: cannot decompress chunk", dsize == CHUNKSIZE * sizeof(int32_t));
+    int32_t value = data[0];
+    mu_assert("ERROR: bad chunk contents", value >= 0 && value < NCHUNKS && data[CHUNKSIZE - 1] == value);
+    mu_assert("ERROR: chunk appended twice", !seen[value]);
+    seen[value] = true;
+  }
+  free(data);
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_policy(uint8_t policy, int64_t every) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams,
+                            .packed=packed, .durability=policy, .durability_every=every};
+  blosc2_remove_urlpath(urlpath);
+
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the frame", schunk != NULL);
+  char* msg = append_concurrently(schunk);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+  // Everything up to here is committed (and synced) after a flush
+  mu_assert("ERROR: cannot flush", blosc2_schunk_flush(schunk) == 0);
+  msg = check_frame();
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+  blosc2_schunk_free(schunk);
+  msg = check_frame();
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_every_ops(void) {
+  return test_policy(BLOSC2_DURABILITY_EVERY_OPS, 8);
+}
+
+static char* test_interval(void) {
+  return test_policy(BLOSC2_DURABILITY_INTERVAL, 5);
+}
+
+static char* test_on_close(void) {
+  return test_policy(BLOSC2_DURABILITY_ON_CLOSE, 0);
+}
+
+static char* test_none(void) {
+  return test_policy(BLOSC2_DURABILITY_NONE, 0);
+}
+
+
+/* The policy can be changed on opened frames, and the appends deferred by
+   EVERY_OPS (on sparse frames) are committed when leaving it */
+static char* test_set_durability(void) {
+  static int32_t data[CHUNKSIZE];
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams, .packed=packed};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the frame", schunk != NULL);
+  blosc2_schunk_free(schunk);
+
+  schunk = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the frame", schunk != NULL);
+  mu_assert("ERROR: invalid interval accepted",
+            blosc2_schunk_set_durability(schunk, BLOSC2_DURABILITY_INTERVAL, 0) < 0);
+  mu_assert("ERROR: invalid policy accepted", blosc2_schunk_set_durability(schunk, 42, 1) < 0);
+  mu_assert("ERROR: cannot set the policy",
+            blosc2_schunk_set_durability(schunk, BLOSC2_DURABILITY_EVERY_OPS, 1000) == 0);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < CHUNKSIZE; j++) {
+      data[j] = i;
+    }
+    mu_assert("ERROR: cannot append", blosc2_schunk_append_buffer(schunk, data, sizeof(data)) == i + 1);
+  }
+  // Still deferred on sparse frames; a contiguous one without the journal commits every append,
+  // so that a crash cannot leave it without a valid index
+  blosc2_schunk* schunk2 = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the frame again", schunk2 != NULL);
+  mu_assert("ERROR: appends should be deferred on sparse frames only",
+            schunk2->nchunks == (contiguous ? 3 : 0));
+  blosc2_schunk_free(schunk2);
+
+  mu_assert("ERROR: cannot leave the policy",
+            blosc2_schunk_set_durability(schunk, BLOSC2_DURABILITY_NONE, 0) == 0);
+  schunk2 = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the frame again", schunk2 != NULL);
+  mu_assert("ERROR: appends not committed", schunk2->nchunks == 3);
+  blosc2_schunk_free(schunk2);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+/* In-memory super-chunks have nothing to sync */
+static char* test_in_memory(void) {
+  blosc2_storage storage = {.contiguous=true};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  mu_assert("ERROR: policy accepted in memory",
+            blosc2_schunk_set_durability(schunk, BLOSC2_DURABILITY_ON_CLOSE, 0) < 0);
+  mu_assert("ERROR: NONE refused in memory",
+            blosc2_schunk_set_durability(schunk, BLOSC2_DURABILITY_NONE, 0) == 0);
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  const char* urlpaths[] = {"test_durability.b2frame", "test_durability_s.b2frame",
+                            "test_durability_p.b2frame"};
+  for (int backend = 0; backend < 3; backend++) {
+    urlpath = (char*)urlpaths[backend];
+    contiguous = backend == 0;
+    packed = backend == 2;
+    mu_run_test(test_every_ops);
+    mu_run_test(test_interval);
+    mu_run_test(test_on_close);
+    mu_run_test(test_none);
+    mu_run_test(test_set_durability);
+  }
+  mu_run_test(test_in_memory);
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char* result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  /* Run all the suite */
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
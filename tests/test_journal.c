@@ -0,0 +1,314 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Test the sidecar journal of disk-based frames (blosc2_schunk_set_journal()):
+  the journal is empty after every operation, and an update interrupted by a
+  crash (a child process that dies midway, on POSIX systems) is rolled back
+  when the frame is opened again.
+*/
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include "test_common.h"
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define CHUNKSIZE (5 * 1000)
+#define NCHUNKS (10)
+
+/* Global vars */
+int tests_run = 0;
+char* urlpath;
+bool contiguous;
+bool packed;
+
+
+static blosc2_schunk* open_journaled(void) {
+  blosc2_schunk* schunk = blosc2_schunk_open(urlpath);
+  if (schunk != NULL && blosc2_schunk_set_journal(schunk, true) < 0) {
+    blosc2_schunk_free(schunk);
+    return NULL;
+  }
+  return schunk;
+}
+
+
+static int64_t journal_size(void) {
+  char path[1024];
+  snprintf(path, sizeof(path), contiguous ? "%s.b2journal" : "%s/.b2journal", urlpath);
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return -1;
+  }
+  return (int64_t)st.st_size;
+}
+
+
+static void fill_data(int32_t* data, int32_t value) {
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data[i] = value;
+  }
+}
+
+
+/* Check that the frame holds the chunks with the given values */
+static char* check_frame(const int32_t* values, int64_t nchunks) {
+  static int32_t data[CHUNKSIZE];
+  blosc2_schunk* schunk = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the frame", schunk != NULL);
+  mu_assert("ERROR: bad number of chunks", schunk->nchunks == nchunks);
+  for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data, sizeof(data));
+    mu_assert("ERROR: cannot decompress chunk", dsize == sizeof(data));
+    mu_assert("ERROR: bad chunk contents", data[0] == values[nchunk] && data[CHUNKSIZE - 1] == values[nchunk]);
+  }
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+static blosc2_schunk* create_frame(int32_t* values) {
+  static int32_t data[CHUNKSIZE];
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams,
+                            .packed=packed};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  if (schunk == NULL || blosc2_schunk_set_journal(schunk, true) < 0) {
+    return NULL;
+  }
+  int32_t meta = 0;
+  if (blosc2_meta_add(schunk, "meta", (uint8_t*)&meta, sizeof(meta)) < 0) {
+    return NULL;
+  }
+  for (int i = 0; i < NCHUNKS; i++) {
+    values[i] = i;
+    fill_data(data, i);
+    if (blosc2_schunk_append_buffer(schunk, data, sizeof(data)) != i + 1) {
+      return NULL;
+    }
+  }
+  return schunk;
+}
+
+
+/* Every kind of mutation goes through the journal and commits it */
+static char* test_ops(void) {
+  static int32_t data[CHUNKSIZE];
+  int32_t values[NCHUNKS + 1];
+  blosc2_schunk* schunk = create_frame(values);
+  mu_assert("ERROR: cannot create the frame", schunk != NULL);
+  mu_assert("ERROR: the journal is not empty after the appends", journal_size() == 0);
+
+  uint8_t* chunk = malloc(sizeof(data) + BLOSC2_MAX_OVERHEAD);
+  fill_data(data, 100);
+  int csize = blosc2_compress_ctx(schunk->cctx, data, sizeof(data), chunk, sizeof(data) + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot compress", csize > 0);
+  mu_assert("ERROR: cannot update", blosc2_schunk_update_chunk(schunk, 2, chunk, true) == NCHUNKS);
+  mu_assert("ERROR: the journal is not empty after an update", journal_size() == 0);
+  values[2] = 100;
+  fill_data(data, 200);
+  csize = blosc2_compress_ctx(schunk->cctx, data, sizeof(data), chunk, sizeof(data) + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot compress", csize > 0);
+  mu_assert("ERROR: cannot insert", blosc2_schunk_insert_chunk(schunk, 4, chunk, true) == NCHUNKS + 1);
+  free(chunk);
+  memmove(values + 5, values + 4, (NCHUNKS - 4) * sizeof(int32_t));
+  values[4] = 200;
+  mu_assert("ERROR: cannot delete", blosc2_schunk_delete_chunk(schunk, 7) == NCHUNKS);
+  memmove(values + 7, values + 8, (NCHUNKS - 7) * sizeof(int32_t));
+  mu_assert("ERROR: the journal is not empty after a delete", journal_size() == 0);
+  int32_t meta = 42;
+  mu_assert("ERROR: cannot update the metalayer",
+            blosc2_meta_update(schunk, "meta", (uint8_t*)&meta, sizeof(meta)) >= 0);
+  mu_assert("ERROR: the journal is not empty after a metalayer update", journal_size() == 0);
+  blosc2_schunk_free(schunk);
+
+  char* msg = check_frame(values, NCHUNKS);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+  schunk = blosc2_schunk_open(urlpath);
+  uint8_t* content;
+  int32_t content_len;
+  mu_assert("ERROR: cannot get the metalayer",
+            blosc2_meta_get(schunk, "meta", &content, &content_len) >= 0);
+  mu_assert("ERROR: bad metalayer", content_len == sizeof(meta) && memcmp(content, &meta, sizeof(meta)) == 0);
+  free(content);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+/* Only frames on disk can have a journal */
+static char* test_in_memory(void) {
+  blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  mu_assert("ERROR: in-memory super-chunks cannot have a journal", blosc2_schunk_set_journal(schunk, true) < 0);
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+#if !defined(_WIN32)
+/* A child updates the frame inside a blosc2_schunk_lock() bracket (a single
+   transaction), tears the frame header as a crash midway through a write
+   would, and dies.  Opening the frame again rolls everything back. */
+static char* test_crash(void) {
+  int32_t values[NCHUNKS];
+  blosc2_schunk* schunk = create_frame(values);
+  mu_assert("ERROR: cannot create the frame", schunk != NULL);
+  blosc2_schunk_free(schunk);
+
+  pid_t pid = fork();
+  mu_assert("ERROR: cannot fork", pid >= 0);
+  if (pid == 0) {
+    static int32_t data[CHUNKSIZE];
+    blosc2_schunk* sc = open_journaled();
+    if (sc == NULL || blosc2_schunk_lock(sc) < 0) {
+      _exit(1);
+    }
+    fill_data(data, 100);
+    uint8_t* chunk = malloc(sizeof(data) + BLOSC2_MAX_OVERHEAD);
+    int csize = blosc2_compress_ctx(sc->cctx, data, sizeof(data), chunk, sizeof(data) + BLOSC2_MAX_OVERHEAD);
+    if (csize < 0 || blosc2_schunk_update_chunk(sc, 3, chunk, true) < 0 ||
+        blosc2_schunk_delete_chunk(sc, 5) < 0 ||
+        blosc2_schunk_append_buffer(sc, data, sizeof(data)) < 0) {
+      _exit(2);
+    }
+    // The frame file (or index) is torn
+    char path[1024];
+    snprintf(path, sizeof(path), contiguous ? "%s" : "%s/chunks.b2frame", urlpath);
+    FILE* f = fopen(path, "rb+");
+    if (f == NULL) {
+      _exit(3);
+    }
+    uint8_t garbage[64];
+    memset(garbage, 0xFF, sizeof(garbage));
+    fwrite(garbage, 1, sizeof(garbage), f);
+    fclose(f);
+    _exit(0);
+  }
+  int status;
+  mu_assert("ERROR: cannot wait for the child", waitpid(pid, &status, 0) == pid);
+  mu_assert("ERROR: the child failed", WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  mu_assert("ERROR: the journal should hold the transaction", journal_size() > 0);
+
+  // A record torn by the crash ends the journal
+  char path[1024];
+  snprintf(path, sizeof(path), contiguous ? "%s.b2journal" : "%s/.b2journal", urlpath);
+  FILE* f = fopen(path, "ab");
+  mu_assert("ERROR: cannot open the journal", f != NULL);
+  fwrite("torn record", 1, 11, f);
+  fclose(f);
+
+  char* msg = check_frame(values, NCHUNKS);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+  mu_assert("ERROR: the journal is not empty after the rollback", journal_size() == 0);
+  // And the frame is usable again
+  schunk = open_journaled();
+  mu_assert("ERROR: cannot open the frame", schunk != NULL);
+  mu_assert("ERROR: cannot delete", blosc2_schunk_delete_chunk(schunk, 0) == NCHUNKS - 1);
+  blosc2_schunk_free(schunk);
+  msg = check_frame(values + 1, NCHUNKS - 1);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+/* A child dies amid a batch of deferred appends (which overwrite the index of
+   contiguous frames); opening the frame again rolls the batch back */
+static char* test_crash_batch(void) {
+  int32_t values[NCHUNKS];
+  blosc2_schunk* schunk = create_frame(values);
+  mu_assert("ERROR: cannot create the frame", schunk != NULL);
+  blosc2_schunk_free(schunk);
+
+  pid_t pid = fork();
+  mu_assert("ERROR: cannot fork", pid >= 0);
+  if (pid == 0) {
+    static int32_t data[CHUNKSIZE];
+    blosc2_schunk* sc = open_journaled();
+    if (sc == NULL || blosc2_schunk_set_append_batch(sc, -1) < 0) {
+      _exit(1);
+    }
+    for (int i = 0; i < 3; i++) {
+      fill_data(data, 100 + i);
+      if (blosc2_schunk_append_buffer(sc, data, sizeof(data)) < 0) {
+        _exit(2);
+      }
+    }
+    _exit(0);
+  }
+  int status;
+  mu_assert("ERROR: cannot wait for the child", waitpid(pid, &status, 0) == pid);
+  mu_assert("ERROR: the child failed", WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  // Sparse frames only defer the update of their index file, which is untouched
+  mu_assert("ERROR: the journal should hold the batch", !contiguous || journal_size() > 0);
+
+  char* msg = check_frame(values, NCHUNKS);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+  mu_assert("ERROR: the journal is not empty after the rollback", journal_size() == 0);
+
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+#endif  /* !_WIN32 */
+
+
+static char *all_tests(void) {
+  const char* urlpaths[] = {"test_journal.b2frame", "test_journal_s.b2frame",
+                            "test_journal_p.b2frame"};
+  mu_run_test(test_in_memory);
+  for (int backend = 0; backend < 3; backend++) {
+    urlpath = (char*)urlpaths[backend];
+    contiguous = backend == 0;
+    packed = backend == 2;
+    mu_run_test(test_ops);
+#if !defined(_WIN32)
+    mu_run_test(test_crash);
+    mu_run_test(test_crash_batch);
+#endif
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char* result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  /* Run all the suite */
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
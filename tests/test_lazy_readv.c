@@ -0,0 +1,273 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Tests for reading the blocks of lazy chunks with vectored reads.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+
+#define CHUNKSHAPE (64 * 1000)
+#define CHUNKSIZE ((int)(CHUNKSHAPE * sizeof(int32_t)))
+#define BLOCKSIZE (16 * 1000)
+#define NBLOCKS ((int)(CHUNKSIZE / BLOCKSIZE))
+#define NCHUNKS 5
+#define IO_ID 245
+#define IO_ID_NOREADV 246
+
+/* Global vars */
+int tests_run = 0;
+char *urlpath;
+bool contiguous;
+int16_t nthreads;
+
+static int32_t data[NCHUNKS][CHUNKSHAPE];
+static int32_t data_dest[CHUNKSHAPE];
+
+typedef struct {
+  int32_t read;
+  int32_t readv;
+  int64_t nranges;
+} test_io_params;
+
+static test_io_params io_params;
+
+
+/* A filesystem backend that counts its reads */
+static void* test_open(const char *urlpath_, const char *mode, void *params) {
+  BLOSC_UNUSED_PARAM(params);
+  return blosc2_stdio_open(urlpath_, mode, NULL);
+}
+
+static int test_close(void *stream) {
+  return blosc2_stdio_close(stream);
+}
+
+static int64_t test_size(void *stream) {
+  return blosc2_stdio_size(stream);
+}
+
+static int64_t test_write(const void *ptr, int64_t size, int64_t nitems, int64_t position, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, position, stream);
+}
+
+static int64_t test_read(void **ptr, int64_t size, int64_t nitems, int64_t position, void *stream) {
+  io_params.read++;
+  return blosc2_stdio_read(ptr, size, nitems, position, stream);
+}
+
+static int64_t test_io_readv(const blosc2_io_range *ranges, int64_t nranges, void *stream) {
+  io_params.readv++;
+  io_params.nranges += nranges;
+  return blosc2_stdio_readv(ranges, nranges, stream);
+}
+
+static int test_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(stream, size);
+}
+
+static int test_destroy(void *params) {
+  BLOSC_UNUSED_PARAM(params);
+  return 0;
+}
+
+static void register_io(uint8_t id, blosc2_readv_cb readv) {
+  blosc2_io_cb io_cb = {0};
+  io_cb.id = id;
+  io_cb.is_allocation_necessary = true;
+  io_cb.open = (blosc2_open_cb) test_open;
+  io_cb.close = (blosc2_close_cb) test_close;
+  io_cb.read = (blosc2_read_cb) test_read;
+  io_cb.size = (blosc2_size_cb) test_size;
+  io_cb.write = (blosc2_write_cb) test_write;
+  io_cb.truncate = (blosc2_truncate_cb) test_truncate;
+  io_cb.destroy = (blosc2_destroy_cb) test_destroy;
+  blosc2_register_io_cb(&io_cb);
+  if (readv != NULL) {
+    blosc2_io_cb_ext io_ext = {0};
+    io_ext.readv = readv;
+    blosc2_register_io_cb_ext(id, &io_ext);
+  }
+}
+
+static blosc2_schunk* create_schunk(uint8_t io_id) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = BLOCKSIZE;
+  // Compressing with threads would lay the blocks out in any order
+  cparams.nthreads = 1;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_io io = {.id = io_id};
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams,
+                            .dparams=&dparams, .io=&io};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  if (schunk == NULL) {
+    return NULL;
+  }
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    if (blosc2_schunk_append_buffer(schunk, data[nchunk], CHUNKSIZE) != nchunk + 1) {
+      blosc2_schunk_free(schunk);
+      return NULL;
+    }
+  }
+  blosc2_schunk_free(schunk);
+
+  // Reopening makes the chunks lazy
+  blosc2_io io_open = {.id = io_id};
+  return blosc2_schunk_open_udio(urlpath, &io_open);
+}
+
+static bool check_schunk(blosc2_schunk *schunk) {
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int64_t start = (int64_t)nchunk * CHUNKSHAPE;
+    int rc = blosc2_schunk_get_slice_buffer(schunk, start, start + CHUNKSHAPE, data_dest);
+    if (rc < 0 || memcmp(data[nchunk], data_dest, CHUNKSIZE) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Decompress a lazy chunk with some blocks masked out */
+static int decompress_masked(blosc2_schunk *schunk, int64_t nchunk, bool *maskout) {
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_lazychunk(schunk, nchunk, &chunk, &needs_free);
+  if (cbytes < 0) {
+    return cbytes;
+  }
+  int rc = blosc2_set_maskout(schunk->dctx, maskout, NBLOCKS);
+  if (rc == 0) {
+    rc = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, data_dest, CHUNKSIZE);
+  }
+  if (needs_free) {
+    free(chunk);
+  }
+  return rc;
+}
+
+
+static char* test_readv(void) {
+  blosc2_schunk *schunk = create_schunk(IO_ID);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  // All the blocks of a chunk are adjacent, so they come in a single range
+  memset(&io_params, 0, sizeof(io_params));
+  mu_assert("ERROR: wrong data", check_schunk(schunk));
+  mu_assert("ERROR: every chunk should be read with a single readv", io_params.readv == NCHUNKS);
+  mu_assert("ERROR: adjacent blocks should be merged", io_params.nranges == NCHUNKS);
+  mu_assert("ERROR: blocks should not be read one by one", io_params.read < NCHUNKS * NBLOCKS);
+
+  // Masked out blocks are not read, and leave gaps between the ranges
+  bool maskout[NBLOCKS];
+  for (int i = 0; i < NBLOCKS; i++) {
+    maskout[i] = i % 2 == 0;
+  }
+  memset(&io_params, 0, sizeof(io_params));
+  memset(data_dest, 0, CHUNKSIZE);
+  int dsize = decompress_masked(schunk, 1, maskout);
+  mu_assert("ERROR: cannot decompress with a maskout", dsize == CHUNKSIZE);
+  for (int i = 0; i < NBLOCKS; i++) {
+    int32_t offset = i * BLOCKSIZE / (int32_t)sizeof(int32_t);
+    bool equal = memcmp(data[1] + offset, data_dest + offset, BLOCKSIZE) == 0;
+    mu_assert("ERROR: wrong data with a maskout", maskout[i] || equal);
+  }
+  mu_assert("ERROR: the chunk should be read with a single readv", io_params.readv == 1);
+  mu_assert("ERROR: distant blocks should not be merged", io_params.nranges == NBLOCKS / 2);
+
+  // A single block does not need a readv
+  for (int i = 0; i < NBLOCKS; i++) {
+    maskout[i] = i != 3;
+  }
+  memset(&io_params, 0, sizeof(io_params));
+  dsize = decompress_masked(schunk, 2, maskout);
+  mu_assert("ERROR: cannot decompress a single block", dsize == CHUNKSIZE);
+  mu_assert("ERROR: wrong data in a single block",
+            memcmp(data[2] + 3 * BLOCKSIZE / sizeof(int32_t), data_dest + 3 * BLOCKSIZE / sizeof(int32_t),
+                   BLOCKSIZE) == 0);
+  mu_assert("ERROR: a single block should not use readv", io_params.readv == 0);
+
+  // Slices spanning several blocks of a chunk read them in one go
+  int64_t start = 3 * CHUNKSHAPE + BLOCKSIZE / (int32_t)sizeof(int32_t) + 10;
+  int64_t stop = start + 3 * BLOCKSIZE / (int32_t)sizeof(int32_t);
+  memset(&io_params, 0, sizeof(io_params));
+  mu_assert("ERROR: cannot get a slice", blosc2_schunk_get_slice_buffer(schunk, start, stop, data_dest) == 0);
+  mu_assert("ERROR: wrong data in the slice",
+            memcmp(data[3] + start - 3 * CHUNKSHAPE, data_dest, (size_t)(stop - start) * sizeof(int32_t)) == 0);
+  mu_assert("ERROR: the slice should be read with a single readv", io_params.readv == 1);
+  mu_assert("ERROR: the blocks of the slice should be merged", io_params.nranges == 1);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_no_readv(void) {
+  // Backends without a readv hook get the ranges one by one
+  blosc2_schunk *schunk = create_schunk(IO_ID_NOREADV);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  memset(&io_params, 0, sizeof(io_params));
+  mu_assert("ERROR: wrong data without readv", check_schunk(schunk));
+  mu_assert("ERROR: readv should not be called", io_params.readv == 0);
+  mu_assert("ERROR: blocks should not be read one by one", io_params.read < NCHUNKS * NBLOCKS);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  char *urlpaths[] = {"test_lazy_readv.b2frame", "test_lazy_readv_s.b2frame"};
+  bool contiguous_[] = {true, false};
+  int16_t nthreads_[] = {1, 4};
+  for (int i = 0; i < (int)ARRAY_SIZE(urlpaths); i++) {
+    for (int j = 0; j < (int)ARRAY_SIZE(nthreads_); j++) {
+      urlpath = urlpaths[i];
+      contiguous = contiguous_[i];
+      nthreads = nthreads_[j];
+      mu_run_test(test_readv);
+      mu_run_test(test_no_readv);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+  register_io(IO_ID, (blosc2_readv_cb) test_io_readv);
+  register_io(IO_ID_NOREADV, NULL);
+
+  // Half of the bits are noise, so that the blocks do not compress too much
+  srand(1);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    for (int i = 0; i < CHUNKSHAPE; i++) {
+      data[nchunk][i] = (nchunk * CHUNKSHAPE + i) << 16 | (rand() & 0xffff);
+    }
+  }
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Chunks of memory-mapped frames are decompressed straight from the mapping.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSHAPE (50 * 1000)
+#define CHUNKSIZE ((int32_t)(CHUNKSHAPE * sizeof(int32_t)))
+#define NCHUNKS 5
+
+
+CUTEST_TEST_DATA(mmap_zerocopy) {
+  blosc2_cparams cparams;
+};
+
+CUTEST_TEST_SETUP(mmap_zerocopy) {
+  blosc2_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.blocksize = 16 * 1000;
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(1, 4));
+}
+
+CUTEST_TEST_TEST(mmap_zerocopy) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+
+  char* urlpath = "test_mmap_zerocopy.b2frame";
+  blosc2_remove_urlpath(urlpath);
+
+  data->cparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&data->cparams, .contiguous=true, .urlpath=urlpath};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Could not create the schunk", schunk != NULL);
+  int32_t *buffer = malloc(NCHUNKS * CHUNKSIZE);
+  for (int i = 0; i < NCHUNKS * CHUNKSHAPE; i++) {
+    buffer[i] = i;
+  }
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int64_t nchunks = blosc2_schunk_append_buffer(schunk, buffer + nchunk * CHUNKSHAPE, CHUNKSIZE);
+    CUTEST_ASSERT("Could not append a chunk", nchunks == nchunk + 1);
+  }
+  CUTEST_ASSERT("Could not free the schunk", blosc2_schunk_free(schunk) == 0);
+
+  blosc2_stdio_mmap mmap_file = BLOSC2_STDIO_MMAP_DEFAULTS;
+  mmap_file.mode = "r";
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_MMAP, .name = "filesystem_mmap", .params = &mmap_file};
+  schunk = blosc2_schunk_open_udio(urlpath, &io);
+  CUTEST_ASSERT("Could not open the schunk", schunk != NULL);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  dparams.schunk = schunk;
+  blosc2_free_ctx(schunk->dctx);
+  schunk->dctx = blosc2_create_dctx(dparams);
+
+  /* Lazy chunks are not built anymore: the chunks point into the mapping */
+  int32_t item;
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    uint8_t *chunk;
+    bool needs_free;
+    int cbytes = blosc2_schunk_get_lazychunk(schunk, nchunk, &chunk, &needs_free);
+    CUTEST_ASSERT("Could not get the chunk", cbytes > 0);
+    CUTEST_ASSERT("The chunk should not need a free", !needs_free);
+    CUTEST_ASSERT("The chunk should be in the mapping",
+                  (char *)chunk >= mmap_file.addr && (char *)chunk + cbytes <= mmap_file.addr + mmap_file.file_size);
+    CUTEST_ASSERT("The chunk should not be lazy", (chunk[BLOSC2_CHUNK_BLOSC2_FLAGS] & 0x08) == 0);
+    int nbytes = blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, CHUNKSHAPE - 7, 1, &item, sizeof(item));
+    CUTEST_ASSERT("Could not get an item", nbytes == sizeof(item));
+    CUTEST_ASSERT("Wrong item", item == nchunk * CHUNKSHAPE + CHUNKSHAPE - 7);
+  }
+
+  /* Slices over several chunks hint the next chunk to the kernel */
+  int32_t *slice = malloc(NCHUNKS * CHUNKSIZE);
+  int64_t start = CHUNKSHAPE / 2;
+  int64_t stop = NCHUNKS * CHUNKSHAPE - 11;
+  CUTEST_ASSERT("Could not get the slice", blosc2_schunk_get_slice_buffer(schunk, start, stop, slice) == 0);
+  CUTEST_ASSERT("Wrong data in the slice",
+                memcmp(slice, buffer + start, (size_t)(stop - start) * sizeof(int32_t)) == 0);
+
+  blosc2_io_range range = {NULL, CHUNKSIZE, 0};
+  blosc2_io_cb_ext *io_ext = blosc2_get_io_cb_ext(BLOSC2_IO_FILESYSTEM_MMAP);
+  CUTEST_ASSERT("The mmap I/O should prefetch", io_ext != NULL && io_ext->prefetch != NULL);
+#if !defined(_WIN32)
+  CUTEST_ASSERT("Could not prefetch a range", io_ext->prefetch(&range, 1, &mmap_file) == 1);
+  range.position = (int64_t)mmap_file.file_size;
+  CUTEST_ASSERT("Ranges past the end should be ignored", io_ext->prefetch(&range, 1, &mmap_file) == 0);
+#endif
+
+  free(slice);
+  free(buffer);
+  CUTEST_ASSERT("Could not free the schunk", blosc2_schunk_free(schunk) == 0);
+  blosc2_remove_urlpath(urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(mmap_zerocopy) {
+  BLOSC_UNUSED_PARAM(data);
+  blosc2_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(mmap_zerocopy);
+}
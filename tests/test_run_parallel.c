@@ -0,0 +1,235 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Tests for blosc2_run_parallel() on the shared thread pools.
+
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "test_common.h"
+#include "blosc-private.h"
+
+#define NJOBS      4
+#define NCALLS     2000
+#define NITEMS     (64 * 1024)
+
+/* Global vars */
+int tests_run = 0;
+
+typedef struct {
+  int32_t id;
+  int32_t runs;
+  int32_t nested_runs;
+  int rc;
+} job_state;
+
+
+/* The number of threads of the process (or -1 where it cannot be told) */
+static int count_process_threads(void) {
+  int nthreads = -1;
+#if defined(__linux__)
+  FILE *status = fopen("/proc/self/status", "r");
+  if (status == NULL) {
+    return -1;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), status) != NULL) {
+    if (strncmp(line, "Threads:", 8) == 0) {
+      nthreads = atoi(line + 8);
+      break;
+    }
+  }
+  fclose(status);
+#endif
+  return nthreads;
+}
+
+static void count_job(void *arg) {
+  job_state *job = (job_state *)arg;
+  job->runs++;
+}
+
+static void nested_count_job(void *arg) {
+  job_state *job = (job_state *)arg;
+  job->nested_runs++;
+}
+
+/* Every job runs a nested parallel loop and a multithreaded round-trip */
+static void nested_job(void *arg) {
+  static int32_t src[NJOBS][NITEMS];
+  static int32_t dest[NJOBS][NITEMS];
+  static uint8_t cdata[NJOBS][NITEMS * sizeof(int32_t) + BLOSC2_MAX_OVERHEAD];
+  job_state *job = (job_state *)arg;
+  const int32_t isize = NITEMS * (int32_t)sizeof(int32_t);
+
+  job_state nested[NJOBS];
+  memset(nested, 0, sizeof(nested));
+  job->rc = blosc2_run_parallel(NJOBS, NJOBS, nested_count_job, sizeof(job_state), nested);
+  for (int i = 0; i < NJOBS; i++) {
+    if (nested[i].nested_runs != 1) {
+      job->rc = -1;
+    }
+  }
+
+  for (int i = 0; i < NITEMS; i++) {
+    src[job->id][i] = i * (job->id + 1);
+  }
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = 16 * 1024;
+  cparams.nthreads = NJOBS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = NJOBS;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  int cbytes = blosc2_compress_ctx(cctx, src[job->id], isize, cdata[job->id],
+                                   (int32_t)sizeof(cdata[job->id]));
+  int dbytes = blosc2_decompress_ctx(dctx, cdata[job->id], cbytes, dest[job->id], isize);
+  if (cbytes <= 0 || dbytes != isize ||
+      memcmp(src[job->id], dest[job->id], (size_t)isize) != 0) {
+    job->rc = -1;
+  }
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+}
+
+
+static char *test_invalid_params(void)
+{
+  job_state jobs[NJOBS];
+  mu_assert("nthreads 0 should be rejected",
+            blosc2_run_parallel(0, NJOBS, count_job, sizeof(job_state), jobs) < 0);
+  mu_assert("njobs 0 should be rejected",
+            blosc2_run_parallel(NJOBS, 0, count_job, sizeof(job_state), jobs) < 0);
+  mu_assert("NULL job should be rejected",
+            blosc2_run_parallel(NJOBS, NJOBS, NULL, sizeof(job_state), jobs) < 0);
+  mu_assert("NULL job data should be rejected",
+            blosc2_run_parallel(NJOBS, NJOBS, count_job, sizeof(job_state), NULL) < 0);
+  return EXIT_SUCCESS;
+}
+
+
+static char *test_jobs_run_once(void)
+{
+  job_state jobs[NJOBS];
+  memset(jobs, 0, sizeof(jobs));
+  for (int n = 0; n < NCALLS; n++) {
+    int rc = blosc2_run_parallel(NJOBS, NJOBS, count_job, sizeof(job_state), jobs);
+    mu_assert("run_parallel failed", rc == 0);
+  }
+  for (int i = 0; i < NJOBS; i++) {
+    mu_assert("every job should run once per call", jobs[i].runs == NCALLS);
+  }
+  return EXIT_SUCCESS;
+}
+
+
+/* Any number of jobs runs on the pool of the given nthreads, so no new threads are left behind */
+static char *test_njobs_share_pool(void)
+{
+  job_state jobs[2 * NJOBS];
+  memset(jobs, 0, sizeof(jobs));
+  int rc = blosc2_run_parallel(NJOBS, NJOBS, count_job, sizeof(job_state), jobs);
+  mu_assert("run_parallel failed", rc == 0);
+  int nthreads_before = count_process_threads();
+  for (int16_t njobs = 1; njobs <= 2 * NJOBS; njobs++) {
+    memset(jobs, 0, sizeof(jobs));
+    rc = blosc2_run_parallel(NJOBS, njobs, count_job, sizeof(job_state), jobs);
+    mu_assert("run_parallel failed", rc == 0);
+    for (int i = 0; i < 2 * NJOBS; i++) {
+      mu_assert("every job should run once", jobs[i].runs == (i < njobs ? 1 : 0));
+    }
+  }
+  mu_assert("the job counts should share one pool", count_process_threads() == nthreads_before);
+  return EXIT_SUCCESS;
+}
+
+
+static char *test_nested(void)
+{
+  job_state jobs[NJOBS];
+  memset(jobs, 0, sizeof(jobs));
+  for (int i = 0; i < NJOBS; i++) {
+    jobs[i].id = i;
+  }
+  for (int n = 0; n < 20; n++) {
+    int rc = blosc2_run_parallel(NJOBS, NJOBS, nested_job, sizeof(job_state), jobs);
+    mu_assert("run_parallel failed", rc == 0);
+    for (int i = 0; i < NJOBS; i++) {
+      mu_assert("nested work failed", jobs[i].rc == 0);
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+
+static int callback_calls = 0;
+
+static void counting_threads_callback(void *callback_data, void (*dojob)(void *), int numjobs,
+                                      size_t jobdata_elsize, void *jobdata)
+{
+  (void) callback_data;
+  callback_calls++;
+  for (int i = 0; i < numjobs; ++i)
+    dojob(((char *) jobdata) + ((unsigned) i) * jobdata_elsize);
+}
+
+static char *test_threads_callback(void)
+{
+  job_state jobs[NJOBS];
+  memset(jobs, 0, sizeof(jobs));
+  blosc2_set_threads_callback(counting_threads_callback, NULL);
+  int rc = blosc2_run_parallel(NJOBS, NJOBS, count_job, sizeof(job_state), jobs);
+  blosc2_set_threads_callback(NULL, NULL);
+  install_blosc_callback_test();
+  mu_assert("run_parallel failed", rc == 0);
+  mu_assert("the threads callback should run the jobs", callback_calls == 1);
+  for (int i = 0; i < NJOBS; i++) {
+    mu_assert("every job should run once", jobs[i].runs == 1);
+  }
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void)
+{
+  mu_run_test(test_invalid_params);
+  mu_run_test(test_jobs_run_once);
+  mu_run_test(test_njobs_share_pool);
+  mu_run_test(test_nested);
+  mu_run_test(test_threads_callback);
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(int argc, char **argv)
+{
+  char *result;
+
+  if (argc > 0) {
+    printf("STARTING TESTS for %s", argv[0]);
+  }
+
+  install_blosc_callback_test();
+  blosc2_init();
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
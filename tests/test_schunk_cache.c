@@ -0,0 +1,259 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Tests for the cache of decompressed chunks of super-chunks.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+#include "b2nd.h"
+
+#define CHUNKSHAPE (50 * 1000)
+#define CHUNKSIZE (CHUNKSHAPE * sizeof(int32_t))
+#define NCHUNKS 10
+
+/* Global vars */
+int tests_run = 0;
+
+static int32_t data[CHUNKSHAPE];
+static int32_t data_dest[CHUNKSHAPE];
+static int32_t slice[2 * CHUNKSHAPE];
+
+
+static void fill_chunk(int64_t nchunk, int32_t offset) {
+  for (int i = 0; i < CHUNKSHAPE; i++) {
+    data[i] = (int32_t)(nchunk * CHUNKSHAPE + i) + offset;
+  }
+}
+
+static blosc2_schunk* create_schunk(char *urlpath, blosc2_io *io, int64_t cache_nbytes) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.cache_nbytes = cache_nbytes;
+  blosc2_storage storage = {.contiguous=true, .urlpath=urlpath, .cparams=&cparams, .dparams=&dparams,
+                            .io=io};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  for (int64_t nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_chunk(nchunk, 0);
+    if (blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE) != nchunk + 1) {
+      blosc2_schunk_free(schunk);
+      return NULL;
+    }
+  }
+  return schunk;
+}
+
+/* Whether chunk `nchunk` holds what fill_chunk(`content`, `offset`) produces */
+static bool check_chunk(blosc2_schunk *schunk, int64_t nchunk, int64_t content, int32_t offset) {
+  fill_chunk(content, offset);
+  return blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, CHUNKSIZE) == CHUNKSIZE &&
+         memcmp(data, data_dest, CHUNKSIZE) == 0;
+}
+
+static bool check_stats(blosc2_schunk *schunk, int64_t nhits, int64_t nmisses) {
+  int64_t nhits_, nmisses_;
+  return blosc2_schunk_get_cache_stats(schunk, &nhits_, &nmisses_) == 0 &&
+         nhits_ == nhits && nmisses_ == nmisses;
+}
+
+
+static char* test_hits(void) {
+  blosc2_schunk *schunk = create_schunk(NULL, NULL, 4 * CHUNKSIZE);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  mu_assert("ERROR: a new cache should be empty", check_stats(schunk, 0, 0));
+
+  mu_assert("ERROR: wrong data on a miss", check_chunk(schunk, 3, 3, 0));
+  mu_assert("ERROR: wrong data on a hit", check_chunk(schunk, 3, 3, 0));
+  mu_assert("ERROR: wrong stats after decompressing", check_stats(schunk, 1, 1));
+
+  // A slice straddling chunks 3 and 4 (the first one cached)
+  int64_t start = 3 * CHUNKSHAPE + CHUNKSHAPE / 2;
+  int64_t stop = start + CHUNKSHAPE;
+  mu_assert("ERROR: cannot get the slice",
+            blosc2_schunk_get_slice_buffer(schunk, start, stop, slice) == 0);
+  for (int64_t i = start; i < stop; i++) {
+    mu_assert("ERROR: wrong data in the slice", slice[i - start] == i);
+  }
+  mu_assert("ERROR: wrong stats after the slice", check_stats(schunk, 2, 2));
+
+  // Chunks larger than the budget are never cached
+  mu_assert("ERROR: cannot shrink the cache", blosc2_schunk_set_cache(schunk, CHUNKSIZE / 2) == 0);
+  mu_assert("ERROR: wrong data without caching", check_chunk(schunk, 3, 3, 0));
+  mu_assert("ERROR: uncacheable chunk counted", check_stats(schunk, 0, 0));
+
+  mu_assert("ERROR: cannot disable the cache", blosc2_schunk_set_cache(schunk, 0) == 0);
+  mu_assert("ERROR: stats without a cache", blosc2_schunk_get_cache_stats(schunk, NULL, NULL) < 0);
+
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_lru(void) {
+  blosc2_schunk *schunk = create_schunk(NULL, NULL, 2 * CHUNKSIZE);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  mu_assert("ERROR: wrong data", check_chunk(schunk, 0, 0, 0));
+  mu_assert("ERROR: wrong data", check_chunk(schunk, 1, 1, 0));
+  mu_assert("ERROR: wrong data", check_chunk(schunk, 0, 0, 0));
+  // Evicts chunk 1, the least recently used one
+  mu_assert("ERROR: wrong data", check_chunk(schunk, 2, 2, 0));
+  mu_assert("ERROR: wrong stats before eviction", check_stats(schunk, 1, 3));
+  mu_assert("ERROR: wrong data", check_chunk(schunk, 0, 0, 0));
+  mu_assert("ERROR: chunk 0 should still be cached", check_stats(schunk, 2, 3));
+  mu_assert("ERROR: wrong data", check_chunk(schunk, 1, 1, 0));
+  mu_assert("ERROR: chunk 1 should have been evicted", check_stats(schunk, 2, 4));
+
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_invalidation(void) {
+  blosc2_schunk *schunk = create_schunk(NULL, NULL, NCHUNKS * CHUNKSIZE);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  for (int64_t nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    mu_assert("ERROR: wrong data", check_chunk(schunk, nchunk, nchunk, 0));
+  }
+
+  // Update
+  uint8_t *chunk = malloc(CHUNKSIZE + BLOSC2_MAX_OVERHEAD);
+  fill_chunk(5, 1);
+  int cbytes = blosc2_compress_ctx(schunk->cctx, data, CHUNKSIZE, chunk, CHUNKSIZE + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot compress", cbytes > 0);
+  mu_assert("ERROR: cannot update", blosc2_schunk_update_chunk(schunk, 5, chunk, true) == NCHUNKS);
+  mu_assert("ERROR: updated chunk served from the cache", check_chunk(schunk, 5, 5, 1));
+  mu_assert("ERROR: other chunks should still be cached", check_chunk(schunk, 4, 4, 0));
+  mu_assert("ERROR: wrong stats after the update", check_stats(schunk, 1, NCHUNKS + 1));
+
+  // Insert: chunk 5 (updated) becomes chunk 6
+  fill_chunk(0, -1);
+  cbytes = blosc2_compress_ctx(schunk->cctx, data, CHUNKSIZE, chunk, CHUNKSIZE + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot insert", blosc2_schunk_insert_chunk(schunk, 0, chunk, true) == NCHUNKS + 1);
+  mu_assert("ERROR: inserted chunk served from the cache", check_chunk(schunk, 0, 0, -1));
+  mu_assert("ERROR: shifted chunk served from the cache", check_chunk(schunk, 6, 5, 1));
+
+  // Delete: back to the original numbering
+  mu_assert("ERROR: cannot delete", blosc2_schunk_delete_chunk(schunk, 0) == NCHUNKS);
+  mu_assert("ERROR: shifted chunk served from the cache", check_chunk(schunk, 5, 5, 1));
+  mu_assert("ERROR: shifted chunk served from the cache", check_chunk(schunk, 0, 0, 0));
+
+  free(chunk);
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+/* A reader handle must not serve chunks that another handle changed.  The
+   update may land in place, so locking is needed for the reader to notice. */
+static char* test_swmr(void) {
+  char *urlpath = "test_schunk_cache.b2frame";
+  blosc2_stdio_params ioparams = {.locking = true};
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM, .name = "filesystem", .params = &ioparams};
+  blosc2_schunk *writer = create_schunk(urlpath, &io, 0);
+  mu_assert("ERROR: cannot create the super-chunk", writer != NULL);
+  blosc2_schunk *reader = blosc2_schunk_open_udio(urlpath, &io);
+  mu_assert("ERROR: cannot open the reader", reader != NULL);
+  mu_assert("ERROR: cannot set the cache", blosc2_schunk_set_cache(reader, NCHUNKS * CHUNKSIZE) == 0);
+
+  mu_assert("ERROR: wrong data", check_chunk(reader, 2, 2, 0));
+  mu_assert("ERROR: wrong data", check_chunk(reader, 2, 2, 0));
+  mu_assert("ERROR: wrong stats before the update", check_stats(reader, 1, 1));
+
+  uint8_t *chunk = malloc(CHUNKSIZE + BLOSC2_MAX_OVERHEAD);
+  fill_chunk(2, 7);
+  int cbytes = blosc2_compress_ctx(writer->cctx, data, CHUNKSIZE, chunk, CHUNKSIZE + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot compress", cbytes > 0);
+  mu_assert("ERROR: cannot update", blosc2_schunk_update_chunk(writer, 2, chunk, true) == NCHUNKS);
+  free(chunk);
+
+  mu_assert("ERROR: cannot refresh", blosc2_schunk_refresh(reader) >= 0);
+  mu_assert("ERROR: stale chunk served from the cache", check_chunk(reader, 2, 2, 7));
+  mu_assert("ERROR: wrong stats after the update", check_stats(reader, 1, 2));
+
+  blosc2_schunk_free(reader);
+  blosc2_schunk_free(writer);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+/* b2nd slices are served from the cache too */
+static char* test_b2nd(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.cache_nbytes = 16 * 1024 * 1024;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams};
+  int64_t shape[] = {200, 200};
+  int32_t chunkshape[] = {100, 100};
+  int32_t blockshape[] = {20, 20};
+  b2nd_context_t *ctx = b2nd_create_ctx(&storage, 2, shape, chunkshape, blockshape, NULL, 0, NULL, 0);
+  mu_assert("ERROR: cannot create the context", ctx != NULL);
+  b2nd_array_t *array;
+  int32_t *values = malloc(200 * 200 * sizeof(int32_t));
+  for (int i = 0; i < 200 * 200; i++) {
+    values[i] = i;
+  }
+  mu_assert("ERROR: cannot create the array",
+            b2nd_from_cbuffer(ctx, &array, values, 200 * 200 * sizeof(int32_t)) == 0);
+
+  int64_t start[] = {50, 90};
+  int64_t stop[] = {60, 110};
+  int64_t buffershape[] = {10, 20};
+  int32_t buffer[10 * 20];
+  for (int round = 0; round < 2; round++) {
+    memset(buffer, 0, sizeof(buffer));
+    mu_assert("ERROR: cannot get the slice",
+              b2nd_get_slice_cbuffer(array, start, stop, buffer, buffershape, sizeof(buffer)) == 0);
+    for (int i = 0; i < 10; i++) {
+      for (int j = 0; j < 20; j++) {
+        mu_assert("ERROR: wrong data in the slice", buffer[i * 20 + j] == (50 + i) * 200 + 90 + j);
+      }
+    }
+  }
+  mu_assert("ERROR: the second slice should hit the cache", check_stats(array->sc, 2, 2));
+
+  free(values);
+  b2nd_free(array);
+  b2nd_free_ctx(ctx);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  mu_run_test(test_hits);
+  mu_run_test(test_lru);
+  mu_run_test(test_invalidation);
+  mu_run_test(test_swmr);
+  mu_run_test(test_b2nd);
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Tests for the read-ahead chunk iterator of super-chunks.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+
+#define CHUNKSHAPE (20 * 1000)
+#define CHUNKSIZE ((int)(CHUNKSHAPE * sizeof(int32_t)))
+#define NCHUNKS 12
+
+/* Global vars */
+int tests_run = 0;
+char *urlpath;
+bool contiguous;
+int16_t nthreads;
+
+static int32_t data[CHUNKSHAPE];
+
+
+static blosc2_schunk* create_schunk(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams,
+                            .dparams=&dparams};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  if (schunk == NULL) {
+    return NULL;
+  }
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    for (int i = 0; i < CHUNKSHAPE; i++) {
+      data[i] = nchunk * CHUNKSHAPE + i;
+    }
+    if (blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE) != nchunk + 1) {
+      blosc2_schunk_free(schunk);
+      return NULL;
+    }
+  }
+  if (urlpath == NULL) {
+    return schunk;
+  }
+  blosc2_schunk_free(schunk);
+  return blosc2_schunk_open(urlpath);
+}
+
+/* Iterate over [start, stop) and check that every chunk comes once, in order */
+static bool check_iter(blosc2_schunk *schunk, int64_t start, int64_t stop, int32_t depth) {
+  blosc2_schunk_iter *iter = blosc2_schunk_iter_new(schunk, start, stop, depth);
+  if (iter == NULL) {
+    return false;
+  }
+  int64_t expected = start;
+  int64_t nchunk;
+  void *dest;
+  int32_t nbytes;
+  int rc;
+  while ((rc = blosc2_schunk_iter_next(iter, &nchunk, &dest, &nbytes)) == 1) {
+    if (nchunk != expected || nbytes != CHUNKSIZE) {
+      break;
+    }
+    int32_t *items = (int32_t *)dest;
+    for (int i = 0; i < CHUNKSHAPE; i++) {
+      if (items[i] != nchunk * CHUNKSHAPE + i) {
+        rc = -1;
+        break;
+      }
+    }
+    if (rc < 0) {
+      break;
+    }
+    expected++;
+  }
+  // The end is sticky too
+  bool ok = rc == 0 && expected == stop && blosc2_schunk_iter_next(iter, &nchunk, &dest, &nbytes) == 0;
+  blosc2_schunk_iter_free(iter);
+  return ok;
+}
+
+
+static char* test_iter(void) {
+  blosc2_schunk *schunk = create_schunk();
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  int32_t depths[] = {0, 1, 3, 100};
+  for (int i = 0; i < (int)ARRAY_SIZE(depths); i++) {
+    mu_assert("ERROR: wrong chunks out of the whole super-chunk", check_iter(schunk, 0, NCHUNKS, depths[i]));
+    mu_assert("ERROR: wrong chunks out of a range", check_iter(schunk, 3, NCHUNKS - 2, depths[i]));
+    mu_assert("ERROR: wrong chunks out of an empty range", check_iter(schunk, 5, 5, depths[i]));
+  }
+
+  // Freeing the iterator halfway stops the read-ahead
+  blosc2_schunk_iter *iter = blosc2_schunk_iter_new(schunk, 0, NCHUNKS, 4);
+  mu_assert("ERROR: cannot create the iterator", iter != NULL);
+  int64_t nchunk;
+  void *dest;
+  int32_t nbytes;
+  mu_assert("ERROR: cannot get a chunk", blosc2_schunk_iter_next(iter, &nchunk, &dest, &nbytes) == 1);
+  mu_assert("ERROR: wrong first chunk", nchunk == 0 && ((int32_t *)dest)[1] == 1);
+  mu_assert("ERROR: cannot free the iterator", blosc2_schunk_iter_free(iter) == 0);
+
+  // The super-chunk is usable again afterwards
+  mu_assert("ERROR: cannot decompress after iterating",
+            blosc2_schunk_decompress_chunk(schunk, NCHUNKS - 1, data, CHUNKSIZE) == CHUNKSIZE);
+  mu_assert("ERROR: wrong data after iterating", data[0] == (NCHUNKS - 1) * CHUNKSHAPE);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_invalid(void) {
+  blosc2_schunk *schunk = create_schunk();
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  mu_assert("ERROR: negative start accepted", blosc2_schunk_iter_new(schunk, -1, 2, 1) == NULL);
+  mu_assert("ERROR: stop past the end accepted", blosc2_schunk_iter_new(schunk, 0, NCHUNKS + 1, 1) == NULL);
+  mu_assert("ERROR: reversed range accepted", blosc2_schunk_iter_new(schunk, 3, 2, 1) == NULL);
+  mu_assert("ERROR: negative depth accepted", blosc2_schunk_iter_new(schunk, 0, 2, -1) == NULL);
+  mu_assert("ERROR: freeing NULL failed", blosc2_schunk_iter_free(NULL) == 0);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  char *urlpaths[] = {NULL, "test_schunk_iter.b2frame", "test_schunk_iter_s.b2frame"};
+  bool contiguous_[] = {true, true, false};
+  int16_t nthreads_[] = {1, 4};
+  for (int i = 0; i < (int)ARRAY_SIZE(urlpaths); i++) {
+    for (int j = 0; j < (int)ARRAY_SIZE(nthreads_); j++) {
+      urlpath = urlpaths[i];
+      contiguous = contiguous_[i];
+      nthreads = nthreads_[j];
+      mu_run_test(test_iter);
+      mu_run_test(test_invalid);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Test the packed layout of sparse frames (chunks appended to shared segment
+  files), together with blosc2_schunk_compact().
+*/
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include "test_common.h"
+
+#define CHUNKSIZE (50 * 1000)
+#define NCHUNKS (20)
+#define NTHREADS (2)
+
+/* Global vars */
+int tests_run = 0;
+char* urlpath = "test_sframe_packed.b2frame";
+int nthreads;
+
+
+static bool file_exists(const char* name) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", urlpath, name);
+  struct stat st;
+  return stat(path, &st) == 0;
+}
+
+
+static void fill_data(int32_t* data, int64_t value) {
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data[i] = (int32_t)(value * CHUNKSIZE + i);
+  }
+}
+
+
+/* Check that chunk nchunk decompresses to the data of value, both in full and
+   through a lazy chunk (blosc2_getitem_ctx) */
+static char* check_chunk(blosc2_schunk* schunk, int64_t nchunk, int64_t value) {
+  static int32_t data[CHUNKSIZE];
+  static int32_t data_dest[CHUNKSIZE];
+  fill_data(data, value);
+  int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, CHUNKSIZE * sizeof(int32_t));
+  mu_assert("ERROR: cannot decompress chunk", dsize == CHUNKSIZE * sizeof(int32_t));
+  mu_assert("ERROR: bad roundtrip", memcmp(data, data_dest, CHUNKSIZE * sizeof(int32_t)) == 0);
+
+  uint8_t* lazy_chunk;
+  bool needs_free;
+  int csize = blosc2_schunk_get_lazychunk(schunk, nchunk, &lazy_chunk, &needs_free);
+  mu_assert("ERROR: cannot get lazy chunk", csize > 0);
+  int32_t item;
+  dsize = blosc2_getitem_ctx(schunk->dctx, lazy_chunk, csize, CHUNKSIZE - 1, 1, &item, sizeof(item));
+  if (needs_free) {
+    free(lazy_chunk);
+  }
+  mu_assert("ERROR: cannot get item from lazy chunk", dsize == sizeof(item));
+  mu_assert("ERROR: bad item from lazy chunk", item == data[CHUNKSIZE - 1]);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_packed(void) {
+  static int32_t data[CHUNKSIZE];
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = nthreads;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous=false, .urlpath=urlpath, .cparams=&cparams,
+                            .dparams=&dparams, .packed=true};
+  blosc2_remove_urlpath(urlpath);
+
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the packed sframe", schunk != NULL);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_data(data, nchunk);
+    int64_t nchunks = blosc2_schunk_append_buffer(schunk, data, isize);
+    mu_assert("ERROR: bad append", nchunks == nchunk + 1);
+  }
+  mu_assert("ERROR: chunks are not packed in a segment", file_exists("00000000.segment"));
+  mu_assert("ERROR: packed sframes should not have chunk files", !file_exists("00000000.chunk"));
+
+  // Update, insert and delete chunks
+  uint8_t* chunk = malloc(isize + BLOSC2_MAX_OVERHEAD);
+  fill_data(data, 100);
+  int csize = blosc2_compress_ctx(schunk->cctx, data, isize, chunk, isize + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot compress", csize > 0);
+  int64_t nchunks = blosc2_schunk_update_chunk(schunk, 3, chunk, true);
+  mu_assert("ERROR: cannot update chunk", nchunks == NCHUNKS);
+  fill_data(data, 200);
+  csize = blosc2_compress_ctx(schunk->cctx, data, isize, chunk, isize + BLOSC2_MAX_OVERHEAD);
+  mu_assert("ERROR: cannot compress", csize > 0);
+  nchunks = blosc2_schunk_insert_chunk(schunk, 5, chunk, true);
+  mu_assert("ERROR: cannot insert chunk", nchunks == NCHUNKS + 1);
+  free(chunk);
+  nchunks = blosc2_schunk_delete_chunk(schunk, 10);
+  mu_assert("ERROR: cannot delete chunk", nchunks == NCHUNKS);
+
+  // Expected values: 0 1 2 100 4 200 5 6 7 8 10 11 ...
+  int64_t values[NCHUNKS];
+  for (int i = 0; i < NCHUNKS; i++) {
+    values[i] = i < 5 ? i : (i == 5 ? 200 : (i < 10 ? i - 1 : i));
+  }
+  values[3] = 100;
+  for (int i = 0; i < NCHUNKS; i++) {
+    char* msg = check_chunk(schunk, i, values[i]);
+    if (msg != EXIT_SUCCESS) {
+      return msg;
+    }
+  }
+  blosc2_schunk_free(schunk);
+
+  // The layout is kept in the frame
+  schunk = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the packed sframe", schunk != NULL);
+  mu_assert("ERROR: the packed flag is lost on open", schunk->storage->packed);
+  for (int i = 0; i < NCHUNKS; i++) {
+    char* msg = check_chunk(schunk, i, values[i]);
+    if (msg != EXIT_SUCCESS) {
+      return msg;
+    }
+  }
+
+  // The updated and deleted chunks are reclaimed, and the rest is still there
+  int64_t reclaimed = blosc2_schunk_compact(schunk);
+  mu_assert("ERROR: compaction failed", reclaimed > 0);
+  mu_assert("ERROR: the old segment is still there", !file_exists("00000000.segment"));
+  for (int i = 0; i < NCHUNKS; i++) {
+    char* msg = check_chunk(schunk, i, values[i]);
+    if (msg != EXIT_SUCCESS) {
+      return msg;
+    }
+  }
+  // Nothing left to reclaim
+  reclaimed = blosc2_schunk_compact(schunk);
+  mu_assert("ERROR: a second compaction should not reclaim anything", reclaimed == 0);
+
+  // Appends go on after a compaction
+  fill_data(data, 300);
+  nchunks = blosc2_schunk_append_buffer(schunk, data, isize);
+  mu_assert("ERROR: bad append after compaction", nchunks == NCHUNKS + 1);
+  blosc2_schunk_free(schunk);
+
+  schunk = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot open the compacted sframe", schunk != NULL);
+  for (int i = 0; i < NCHUNKS; i++) {
+    char* msg = check_chunk(schunk, i, values[i]);
+    if (msg != EXIT_SUCCESS) {
+      return msg;
+    }
+  }
+  char* msg = check_chunk(schunk, NCHUNKS, 300);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+  blosc2_schunk_free(schunk);
+
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+/* Compacting anything else than a packed sframe is a no-op */
+static char* test_compact_unpacked(void) {
+  static int32_t data[CHUNKSIZE];
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  blosc2_storage storage = {.contiguous=false, .urlpath=urlpath, .cparams=&cparams};
+  blosc2_remove_urlpath(urlpath);
+
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the sframe", schunk != NULL);
+  fill_data(data, 0);
+  blosc2_schunk_append_buffer(schunk, data, CHUNKSIZE * sizeof(int32_t));
+  mu_assert("ERROR: compacting a regular sframe should be a no-op", blosc2_schunk_compact(schunk) == 0);
+  mu_assert("ERROR: the chunk file is gone", file_exists("00000000.chunk"));
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  nthreads = 1;
+  mu_run_test(test_packed);
+  nthreads = NTHREADS;
+  mu_run_test(test_packed);
+  mu_run_test(test_compact_unpacked);
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char* result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  /* Run all the suite */
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Tests for dictionaries shared by all the chunks of a super-chunk.
+*/
+
+#include <stdio.h>
+#include "blosc-private.h"
+#include "schunk-private.h"
+#include "test_common.h"
+
+#define CHUNKSIZE (16 * 1024)
+#define NCHUNKS 24
+#define NTRAIN 4
+
+/* Global vars */
+int tests_run = 0;
+char *urlpath;
+bool contiguous;
+int compcode;
+int16_t nthreads;
+
+static uint8_t data[NCHUNKS][CHUNKSIZE];
+static uint8_t data_dest[CHUNKSIZE];
+
+
+/* Many small chunks of JSON-ish telemetry */
+static void fill_chunk(uint8_t *chunk, int nchunk) {
+  int32_t len = 0;
+  int i = 0;
+  while (len < CHUNKSIZE) {
+    char line[256];
+    int nline = snprintf(line, sizeof(line),
+                         "{\"sensor\":\"probe-%03d\",\"ts\":%d,\"temperature\":%d.%02d,"
+                         "\"status\":\"%s\",\"unit\":\"celsius\",\"site\":\"north\"}\n",
+                         (nchunk * 7 + i) % 50, 1600000000 + nchunk * 1000 + i, 15 + (i * 13) % 20,
+                         (i * 37) % 100, i % 11 == 0 ? "degraded" : "ok");
+    if (len + nline > CHUNKSIZE) {
+      nline = CHUNKSIZE - len;
+    }
+    memcpy(chunk + len, line, (size_t)nline);
+    len += nline;
+    i++;
+  }
+}
+
+static blosc2_schunk* create_schunk(int32_t dict_nchunks) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = 1;
+  cparams.compcode = (uint8_t)compcode;
+  cparams.use_dict = 1;
+  cparams.dict_nchunks = dict_nchunks;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams,
+                            .dparams=&dparams};
+  blosc2_remove_urlpath(urlpath);
+  return blosc2_schunk_new(&storage);
+}
+
+static bool check_schunk(blosc2_schunk *schunk, int64_t nchunks) {
+  if (schunk->nchunks != nchunks) {
+    return false;
+  }
+  for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, CHUNKSIZE);
+    if (dsize != CHUNKSIZE || memcmp(data[nchunk % NCHUNKS], data_dest, CHUNKSIZE) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int64_t chunk_cbytes(blosc2_schunk *schunk, int64_t nchunk, uint8_t *flags) {
+  uint8_t *chunk;
+  bool needs_free;
+  int32_t cbytes = blosc2_schunk_get_chunk(schunk, nchunk, &chunk, &needs_free);
+  if (cbytes < 0) {
+    return cbytes;
+  }
+  *flags = chunk[BLOSC2_CHUNK_BLOSC2_FLAGS];
+  if ((*flags & BLOSC2_USEDICT) && (!(chunk[BLOSC2_CHUNK_BLOSC2_FLAGS2] & BLOSC2_SCHUNK_DICT) ||
+                                    chunk[BLOSC2_CHUNK_VERSION] != BLOSC2_VERSION_FORMAT_SCHUNK_DICT)) {
+    // Chunks using the shared dict are marked as such
+    *flags = 0;
+  }
+  if (needs_free) {
+    free(chunk);
+  }
+  return cbytes;
+}
+
+
+static char* test_shared_dict(void) {
+  blosc2_schunk *schunk = create_schunk(NTRAIN);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  for (int nchunk = 0; nchunk < NTRAIN; nchunk++) {
+    mu_assert("ERROR: the dict should not be there before the training chunks",
+              schunk_vlmeta_exists(schunk, BLOSC2_DICT_VLMETA) < 0);
+    mu_assert("ERROR: cannot append a training chunk",
+              blosc2_schunk_append_buffer(schunk, data[nchunk], CHUNKSIZE) == nchunk + 1);
+  }
+  mu_assert("ERROR: the dict should be there after the training chunks",
+            schunk_vlmeta_exists(schunk, BLOSC2_DICT_VLMETA) >= 0);
+  // ...but hidden from the vlmeta API
+  mu_assert("ERROR: the dict should not be visible", blosc2_vlmeta_exists(schunk, BLOSC2_DICT_VLMETA) < 0);
+  char *names[1];
+  mu_assert("ERROR: the dict should not be listed", blosc2_vlmeta_get_names(schunk, names) == 0);
+  uint8_t content = 0;
+  mu_assert("ERROR: the dict name should be reserved",
+            blosc2_vlmeta_add(schunk, BLOSC2_DICT_VLMETA, &content, 1, NULL) < 0);
+  mu_assert("ERROR: the dict should not be deleted", blosc2_vlmeta_delete(schunk, BLOSC2_DICT_VLMETA) < 0);
+
+  // The next chunks can be compressed in parallel with the shared dict
+  const void *srcs[NCHUNKS];
+  int32_t nbytes[NCHUNKS];
+  for (int i = 0; i < NCHUNKS - NTRAIN; i++) {
+    srcs[i] = data[NTRAIN + i];
+    nbytes[i] = CHUNKSIZE;
+  }
+  mu_assert("ERROR: cannot append the chunks",
+            blosc2_schunk_append_buffers(schunk, NCHUNKS - NTRAIN, srcs, nbytes) == NCHUNKS);
+  mu_assert("ERROR: wrong data", check_schunk(schunk, NCHUNKS));
+
+  // The training chunks have no dict, and the next ones just refer to the shared one
+  int64_t cbytes_shared = 0, cbytes_plain = 0;
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    uint8_t flags;
+    int64_t cbytes = chunk_cbytes(schunk, nchunk, &flags);
+    mu_assert("ERROR: cannot get a chunk", cbytes > 0);
+    if (nchunk < NTRAIN) {
+      mu_assert("ERROR: training chunks should not use a dict", !(flags & BLOSC2_USEDICT));
+      continue;
+    }
+    mu_assert("ERROR: chunks should use the shared dict", flags & BLOSC2_USEDICT);
+    cbytes_shared += cbytes;
+    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+    cparams.typesize = 1;
+    cparams.compcode = (uint8_t)compcode;
+    uint8_t chunk[CHUNKSIZE + BLOSC2_MAX_OVERHEAD];
+    blosc2_context *cctx = blosc2_create_cctx(cparams);
+    cbytes_plain += blosc2_compress_ctx(cctx, data[nchunk], CHUNKSIZE, chunk, sizeof(chunk));
+    blosc2_free_ctx(cctx);
+
+    // The chunk cannot be decompressed without its super-chunk, nor added to another one
+    uint8_t *schunk_chunk;
+    bool needs_free;
+    blosc2_schunk_get_chunk(schunk, nchunk, &schunk_chunk, &needs_free);
+    mu_assert("ERROR: decompressing without the super-chunk should fail",
+              blosc2_decompress(schunk_chunk, CHUNKSIZE + BLOSC2_MAX_OVERHEAD, data_dest, CHUNKSIZE) < 0);
+    blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
+    blosc2_schunk *other = blosc2_schunk_new(&storage);
+    mu_assert("ERROR: a foreign chunk should not be appended",
+              blosc2_schunk_append_chunk(other, schunk_chunk, true) < 0);
+    blosc2_schunk_free(other);
+    if (needs_free) {
+      free(schunk_chunk);
+    }
+  }
+  mu_assert("ERROR: the shared dict does not improve the compression ratio",
+            cbytes_shared < cbytes_plain);
+
+  // Nor in a super-chunk with a dict of its own
+  char *urlpath_ = urlpath;
+  urlpath = NULL;
+  blosc2_schunk *other = create_schunk(NTRAIN);
+  urlpath = urlpath_;
+  mu_assert("ERROR: cannot create the super-chunk", other != NULL);
+  for (int nchunk = 0; nchunk <= NTRAIN; nchunk++) {
+    mu_assert("ERROR: cannot append a chunk",
+              blosc2_schunk_append_buffer(other, data[NCHUNKS - 1 - nchunk], CHUNKSIZE) == nchunk + 1);
+  }
+  uint8_t *chunk;
+  bool needs_free;
+  blosc2_schunk_get_chunk(schunk, NTRAIN, &chunk, &needs_free);
+  mu_assert("ERROR: a chunk with another dict should not be inserted",
+            blosc2_schunk_insert_chunk(other, 0, chunk, true) < 0);
+  mu_assert("ERROR: a chunk with another dict should not be updated",
+            blosc2_schunk_update_chunk(other, 0, chunk, true) < 0);
+  if (needs_free) {
+    free(chunk);
+  }
+  blosc2_schunk_get_chunk(other, NTRAIN, &chunk, &needs_free);
+  mu_assert("ERROR: a chunk of its own should be updated",
+            blosc2_schunk_update_chunk(other, 0, chunk, true) == NTRAIN + 1);
+  if (needs_free) {
+    free(chunk);
+  }
+  blosc2_schunk_free(other);
+
+  blosc2_schunk_free(schunk);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_reopen(void) {
+  if (urlpath == NULL) {
+    return EXIT_SUCCESS;
+  }
+  blosc2_schunk *schunk = create_schunk(NTRAIN);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  for (int nchunk = 0; nchunk < NCHUNKS / 2; nchunk++) {
+    mu_assert("ERROR: cannot append a chunk",
+              blosc2_schunk_append_buffer(schunk, data[nchunk], CHUNKSIZE) == nchunk + 1);
+  }
+  blosc2_schunk_free(schunk);
+
+  // The dict is kept in the frame, both for reading and appending more chunks
+  schunk = blosc2_schunk_open(urlpath);
+  mu_assert("ERROR: cannot reopen the super-chunk", schunk != NULL);
+  mu_assert("ERROR: wrong data after reopening", check_schunk(schunk, NCHUNKS / 2));
+  for (int nchunk = NCHUNKS / 2; nchunk < NCHUNKS; nchunk++) {
+    mu_assert("ERROR: cannot append a chunk after reopening",
+              blosc2_schunk_append_buffer(schunk, data[nchunk], CHUNKSIZE) == nchunk + 1);
+    uint8_t flags;
+    mu_assert("ERROR: cannot get a chunk", chunk_cbytes(schunk, nchunk, &flags) > 0);
+    mu_assert("ERROR: chunks should use the shared dict after reopening", flags & BLOSC2_USEDICT);
+  }
+  mu_assert("ERROR: wrong data after appending", check_schunk(schunk, NCHUNKS));
+
+  // Copies keep the dict too
+  blosc2_storage storage = {.contiguous=true};
+  blosc2_schunk *copy = blosc2_schunk_copy(schunk, &storage);
+  mu_assert("ERROR: cannot copy the super-chunk", copy != NULL);
+  mu_assert("ERROR: wrong data in the copy", check_schunk(copy, NCHUNKS));
+  blosc2_schunk_free(copy);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  char *urlpaths[] = {NULL, "test_shared_dict.b2frame", "test_shared_dict_s.b2frame"};
+  bool contiguous_[] = {true, true, false};
+  int compcodes[] = {BLOSC_LZ4, BLOSC_LZ4HC, BLOSC_ZSTD};
+  int16_t nthreads_[] = {1, 4};
+  for (int i = 0; i < (int)ARRAY_SIZE(urlpaths); i++) {
+    for (int j = 0; j < (int)ARRAY_SIZE(compcodes); j++) {
+      for (int k = 0; k < (int)ARRAY_SIZE(nthreads_); k++) {
+        contiguous = contiguous_[i];
+        compcode = compcodes[j];
+        nthreads = nthreads_[k];
+        urlpath = urlpaths[i];
+        mu_run_test(test_shared_dict);
+        blosc2_remove_urlpath(urlpaths[i]);
+        urlpath = urlpaths[i];
+        mu_run_test(test_reopen);
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_chunk(data[nchunk], nchunk);
+  }
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}
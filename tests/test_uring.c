@@ -0,0 +1,154 @@
+/*
+  Copyright (c) 2021  Blosc Development Team <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Tests for the io_uring filesystem backend.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+
+#define CHUNKSHAPE (50 * 1000)
+#define CHUNKSIZE ((int)(CHUNKSHAPE * sizeof(int32_t)))
+#define NCHUNKS 10
+#define NRANGES 200
+
+/* Global vars */
+int tests_run = 0;
+char *urlpath;
+bool contiguous;
+int16_t nthreads;
+
+static int32_t data[NCHUNKS][CHUNKSHAPE];
+static int32_t data_dest[NCHUNKS * CHUNKSHAPE];
+
+
+static char* test_readv(void) {
+  char *path = "test_uring.bin";
+  FILE *file = fopen(path, "wb");
+  mu_assert("ERROR: cannot create the file", file != NULL);
+  fwrite(data, sizeof(data), 1, file);
+  fclose(file);
+
+  void *stream = blosc2_uring_open(path, "rb", NULL);
+  mu_assert("ERROR: cannot open the file", stream != NULL);
+  mu_assert("ERROR: wrong file size", blosc2_uring_size(stream) == (int64_t)sizeof(data));
+
+  // More ranges than entries in the ring, in no particular order
+  blosc2_io_range ranges[NRANGES];
+  int64_t nbytes = 0;
+  uint8_t *dest = (uint8_t *)data_dest;
+  for (int i = 0; i < NRANGES; i++) {
+    ranges[i].size = 1000 + (i * 37) % 3000;
+    ranges[i].position = ((int64_t)i * 7919 * 13) % ((int64_t)sizeof(data) - ranges[i].size);
+    ranges[i].ptr = dest + nbytes;
+    nbytes += ranges[i].size;
+  }
+  mu_assert("ERROR: prefetch failed", blosc2_uring_prefetch(ranges, NRANGES, stream) >= 0);
+  mu_assert("ERROR: wrong number of bytes read", blosc2_uring_readv(ranges, NRANGES, stream) == nbytes);
+  for (int i = 0; i < NRANGES; i++) {
+    mu_assert("ERROR: wrong data read",
+              memcmp(ranges[i].ptr, (uint8_t *)data + ranges[i].position, (size_t)ranges[i].size) == 0);
+  }
+
+  // Plain reads, and reads past the end of the file
+  void *ptr = data_dest;
+  mu_assert("ERROR: cannot read", blosc2_uring_read(&ptr, sizeof(int32_t), 10, 4, stream) == 10);
+  mu_assert("ERROR: wrong data read", memcmp(data_dest, (uint8_t *)data + 4, 10 * sizeof(int32_t)) == 0);
+  mu_assert("ERROR: short read not reported",
+            blosc2_uring_read(&ptr, 1, 100, (int64_t)sizeof(data) - 10, stream) == 10);
+  blosc2_io_range past = {data_dest, 100, (int64_t)sizeof(data) - 40};
+  mu_assert("ERROR: short readv not reported", blosc2_uring_readv(&past, 1, stream) == 40);
+
+  blosc2_uring_close(stream);
+  remove(path);
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_schunk(void) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_URING};
+  blosc2_storage storage = {.contiguous=contiguous, .urlpath=urlpath, .cparams=&cparams,
+                            .dparams=&dparams, .io=&io};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    mu_assert("ERROR: cannot append a chunk",
+              blosc2_schunk_append_buffer(schunk, data[nchunk], CHUNKSIZE) == nchunk + 1);
+  }
+  blosc2_schunk_free(schunk);
+
+  schunk = blosc2_schunk_open_udio(urlpath, &io);
+  mu_assert("ERROR: cannot reopen the super-chunk", schunk != NULL);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, CHUNKSIZE);
+    mu_assert("ERROR: cannot decompress a chunk", dsize == CHUNKSIZE);
+    mu_assert("ERROR: wrong data in a chunk", memcmp(data[nchunk], data_dest, CHUNKSIZE) == 0);
+  }
+
+  // Slices over many chunks prefetch the next chunk while decompressing the current one
+  int64_t start = CHUNKSHAPE / 3;
+  int64_t stop = NCHUNKS * CHUNKSHAPE - CHUNKSHAPE / 5;
+  mu_assert("ERROR: cannot get a slice", blosc2_schunk_get_slice_buffer(schunk, start, stop, data_dest) == 0);
+  mu_assert("ERROR: wrong data in the slice",
+            memcmp((int32_t *)data + start, data_dest, (size_t)(stop - start) * sizeof(int32_t)) == 0);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  return EXIT_SUCCESS;
+}
+
+
+static char *all_tests(void) {
+  mu_run_test(test_readv);
+
+  char *urlpaths[] = {"test_uring.b2frame", "test_uring_s.b2frame"};
+  bool contiguous_[] = {true, false};
+  int16_t nthreads_[] = {1, 4};
+  for (int i = 0; i < (int)ARRAY_SIZE(urlpaths); i++) {
+    for (int j = 0; j < (int)ARRAY_SIZE(nthreads_); j++) {
+      urlpath = urlpaths[i];
+      contiguous = contiguous_[i];
+      nthreads = nthreads_[j];
+      mu_run_test(test_schunk);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc2_init();
+
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    for (int i = 0; i < CHUNKSHAPE; i++) {
+      data[nchunk][i] = nchunk * CHUNKSHAPE + i;
+    }
+  }
+
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc2_destroy();
+
+  return result != EXIT_SUCCESS;
+}